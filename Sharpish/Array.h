@@ -38,9 +38,15 @@ namespace CS
     {
     public:
         /** Element container type. For ComObjects, this com_ptr<T>. For other types, it's just T. */
+#if defined(SHARPISH_OBJECT_MODEL)
         typedef T_STORE(T) ElementContainerType;
         typedef T_RAW(T) ElementType;
         typedef T_STORE(T) value_type;
+#else
+        typedef T ElementContainerType;
+        typedef T ElementType;
+        typedef T value_type;
+#endif
 
         /// Constructs a null array
         Array() : _ptr(nullptr), _length(0) { }
@@ -113,8 +119,8 @@ namespace CS
         ElementContainerType& operator [](unsigned short index) const { return _ptr[index]; }
         ElementContainerType& operator [](uint64_t index) const { return _ptr[index]; }
 
-        typedef T_STORE(T)* iterator;
-        typedef const T_STORE(T)* const_iterator;
+        typedef ElementContainerType* iterator;
+        typedef const ElementContainerType* const_iterator;
 
         /**  Gets an iterator at the beginning of the array. */
         iterator begin() { return _ptr; }
@@ -150,4 +156,6 @@ namespace CS
     };
 }
 
+#if defined(SHARPISH_OBJECT_MODEL)
 IS_GENERIC_VALUETYPE(1, ::CS::Array, "B5495742-AEDB-469E-A8C6-1BBDBF45E6D9");
+#endif
@@ -1,4 +1,6 @@
 #include "Sharpish.h"
+#include "MathDispatch.h"
+#include "MathParallel.h"
 
 // ::PUBLICLIB::
 
@@ -14,12 +16,132 @@
 using namespace CS;
 using namespace std;
 
+namespace
+{
+	// Boxes per piece of work in the batch transforms. A multiple of Float3Stream::LaneAlignment, so each piece
+	// starts on a whole register.
+	const size_t TransformGranularity = 4096;
+	// Points per partial box in the reductions
+	const size_t ReduceGranularity = 16384;
+
+	// Arvo's method: the center transforms as a point, and each half-extent of the result is the source
+	// half-extents weighted by the absolute values of the matrix's column, which is exactly the box around the
+	// eight transformed corners. Halves are taken before differences so boxes out to +-FLT_MAX don't overflow.
+	BoundingBoxA __vectorcall TransformCenterExtent(FXMVECTOR minima, FXMVECTOR maxima, const Float4x3A& mat)
+	{
+		XMMATRIX m = mat;
+		auto half = XMVectorReplicate(0.5f);
+		auto center = XMVectorMultiplyAdd(minima, half, XMVectorMultiply(maxima, half));
+		auto extent = XMVectorNegativeMultiplySubtract(minima, half, XMVectorMultiply(maxima, half));
+
+		center = XMVector3Transform(center, m);
+		extent = XMVectorMultiplyAdd(XMVectorSplatX(extent), XMVectorAbs(m.r[0]),
+			XMVectorMultiplyAdd(XMVectorSplatY(extent), XMVectorAbs(m.r[1]), XMVectorMultiply(XMVectorSplatZ(extent), XMVectorAbs(m.r[2]))));
+
+		return BoundingBoxA(XMVectorSubtract(center, extent), XMVectorAdd(center, extent));
+	}
+
+	struct BoxTransformJob
+	{
+		const float* MinX; const float* MinY; const float* MinZ;
+		const float* MaxX; const float* MaxY; const float* MaxZ;
+		float* OMinX; float* OMinY; float* OMinZ;
+		float* OMaxX; float* OMaxY; float* OMaxZ;
+		// One matrix as 16 floats, or Count of them if PerBox
+		const float* Matrices;
+		bool PerBox;
+		size_t Count;
+	};
+}
+
+#define SHARPISH_KERNELS "BoundingBoxKernels.inl"
+#include "MathKernels.h"
+
+namespace
+{
+	BoundingBoxA ReducePoints(const float* p, size_t count, int stride, bool parallel)
+	{
+		if (count == 0)
+			return BoundingBoxA();
+		if (!p)
+			throw ArgumentNullException("pts");
+
+		auto kernel = SHARPISH_KERNEL(ReducePointsKernel)::Get();
+
+		// One partial box per granule, folded in order
+		size_t granules = (count + ReduceGranularity - 1) / ReduceGranularity;
+		vector<float> partials(granules * 6);
+
+		auto body = [&](size_t begin, size_t end)
+		{
+			for (size_t g = begin; g < end; g += ReduceGranularity)
+			{
+				float* partial = partials.data() + g / ReduceGranularity * 6;
+				kernel(p + g * stride, min(end, g + ReduceGranularity) - g, stride, partial, partial + 3);
+			}
+		};
+
+		Details::ParallelFor(count, ReduceGranularity, parallel, body);
+
+		float lo[3] = { INFINITY, INFINITY, INFINITY }, hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+		for (size_t g = 0; g < granules; g++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				lo[k] = min(lo[k], partials[g * 6 + k]);
+				hi[k] = max(hi[k], partials[g * 6 + 3 + k]);
+			}
+		}
+
+		return BoundingBoxA(Float3A(lo[0], lo[1], lo[2]), Float3A(hi[0], hi[1], hi[2]));
+	}
+
+	void RunBoxTransform(const Float3Stream& minima, const Float3Stream& maxima, const float* matrices, bool perBox,
+		Float3Stream& outMinima, Float3Stream& outMaxima, bool parallel)
+	{
+		auto count = minima.size();
+
+		if (maxima.size() != count) throw ArgumentException("maxima", "Stream sizes differ");
+
+		if (outMinima.size() != count) outMinima = Float3Stream(count);
+		if (outMaxima.size() != count) outMaxima = Float3Stream(count);
+
+		if (count == 0)
+			return;
+
+		BoxTransformJob job = { };
+		job.MinX = minima.GetX(); job.MinY = minima.GetY(); job.MinZ = minima.GetZ();
+		job.MaxX = maxima.GetX(); job.MaxY = maxima.GetY(); job.MaxZ = maxima.GetZ();
+		job.OMinX = outMinima.GetX(); job.OMinY = outMinima.GetY(); job.OMinZ = outMinima.GetZ();
+		job.OMaxX = outMaxima.GetX(); job.OMaxY = outMaxima.GetY(); job.OMaxZ = outMaxima.GetZ();
+		job.Matrices = matrices;
+		job.PerBox = perBox;
+		job.Count = count;
+
+		// The streams are padded to whole registers, so the last chunk can run past count
+		auto kernel = SHARPISH_KERNEL(BoxTransformKernel)::Get();
+
+		Details::ParallelFor(count, TransformGranularity, parallel, [&](size_t begin, size_t end) { kernel(job, begin, end); });
+	}
+
+	template<typename F>
+	void RunBoxes(size_t count, bool parallel, const F& body)
+	{
+		auto run = [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+				body(i);
+		};
+
+		Details::ParallelFor(count, TransformGranularity, parallel, run);
+	}
+}
+
 Float3 BoundingBox::MaxVector(MaxFloat, MaxFloat, MaxFloat);
 Float3 BoundingBox::MinVector(-MaxFloat, -MaxFloat, -MaxFloat);
 Float3A BoundingBoxA::MaxVector(MaxFloat, MaxFloat, MaxFloat);
 Float3A BoundingBoxA::MinVector(-MaxFloat, -MaxFloat, -MaxFloat);
 
-
 BoundingBox::BoundingBox() :
 	Minima(MaxVector), Maxima(MinVector)
 {
@@ -51,40 +173,50 @@ BoundingBoxA::BoundingBoxA(const Float3A& min, const Float3A& max) :
 
 BoundingBox::BoundingBox(const Float3A* pts, int count)
 {
-	if(count == 0)
+	if(count <= 0)
 	{
 		Minima = MinVector;
 		Maxima = MaxVector;
 		return;
 	}
 
-	Minima = pts[0];
-	Maxima = pts[0];
-
-	for(int i = 1;i < count;i++)
-	{
-		Minima = Float3A::Min(Minima, pts[i]);
-		Maxima = Float3A::Max(Maxima, pts[i]);
-	}
+	BoundingBoxA box = BoundingBoxA::OfPoints(pts, (size_t)count);
+	Minima = box.Minima;
+	Maxima = box.Maxima;
 }
 
 BoundingBoxA::BoundingBoxA(const Float3A* pts, int count)
 {
-	if (count == 0)
+	if (count <= 0)
 	{
 		Minima = MinVector;
 		Maxima = MaxVector;
 		return;
 	}
 
-	Minima = pts[0];
-	Maxima = pts[0];
+	*this = OfPoints(pts, (size_t)count);
+}
+
+BoundingBoxA BoundingBoxA::OfPoints(const Float3A* pts, size_t count, bool parallel)
+{
+	return ReducePoints((const float*)pts, count, 4, parallel);
+}
 
-	for (int i = 1; i < count; i++)
-	{
-		Minima = Float3A::Min(Minima, pts[i]);
-		Maxima = Float3A::Max(Maxima, pts[i]);
-	}
+BoundingBoxA BoundingBoxA::OfPoints(const Float3* pts, size_t count, bool parallel)
+{
+	return ReducePoints((const float*)pts, count, 3, parallel);
+}
+
+BoundingBoxA BoundingBoxA::OfPoints(const Float3Stream& pts, bool parallel)
+{
+	if (pts.empty())
+		return BoundingBoxA();
+
+	// Each lane is its own 1-component array
+	BoundingBoxA x = ReducePoints(pts.GetX(), pts.size(), 1, parallel);
+	BoundingBoxA y = ReducePoints(pts.GetY(), pts.size(), 1, parallel);
+	BoundingBoxA z = ReducePoints(pts.GetZ(), pts.size(), 1, parallel);
+	return BoundingBoxA(Float3A(x.Minima.GetX(), y.Minima.GetX(), z.Minima.GetX()), Float3A(x.Maxima.GetX(), y.Maxima.GetX(), z.Maxima.GetX()));
 }
 
 void BoundingBox::Apply(Float3* v)
@@ -147,54 +279,69 @@ BoundingBoxA BoundingBoxA::AddPoints(Float3A* pts, int count) const
 
 BoundingBoxA BoundingBox::Transform(const Float4x3A &mat) const
 {
-	Float3A v[8];
+	if(!GetExists()) return BoundingBoxA();
 
-	if(!Exists) return BoundingBoxA();
+	return TransformCenterExtent(Float3A(Minima), Float3A(Maxima), mat);
+}
 
-	auto L = Minima;
-	auto H = Maxima;
+BoundingBoxA BoundingBoxA::Transform(const Float4x3A &mat) const
+{
+	if (!GetExists()) return BoundingBoxA();
 
-	v[0] = Float3A(L.X, L.Y, L.Z) * mat;
-	v[1] = Float3A(L.X, L.Y, H.Z) * mat;
-	v[2] = Float3A(L.X, H.Y, L.Z) * mat;
-	v[3] = Float3A(L.X, H.Y, H.Z) * mat;
-	v[4] = Float3A(H.X, L.Y, L.Z) * mat;
-	v[5] = Float3A(H.X, L.Y, H.Z) * mat;
-	v[6] = Float3A(H.X, H.Y, L.Z) * mat;
-	v[7] = Float3A(H.X, H.Y, H.Z) * mat;
+	return TransformCenterExtent(Minima, Maxima, mat);
+}
 
-	return BoundingBoxA(v, 8);
+void BoundingBoxA::Transform(const Float3Stream& minima, const Float3Stream& maxima, const Float4x3A& mat,
+	Float3Stream& outMinima, Float3Stream& outMaxima, bool parallel)
+{
+	XMFLOAT4X4 mf;
+	XMStoreFloat4x4(&mf, mat);
+	RunBoxTransform(minima, maxima, &mf.m[0][0], false, outMinima, outMaxima, parallel);
 }
 
-BoundingBoxA BoundingBoxA::Transform(const Float4x3A &mat) const
+void BoundingBoxA::Transform(const Float3Stream& minima, const Float3Stream& maxima, const Float4x3A* matrices,
+	Float3Stream& outMinima, Float3Stream& outMaxima, bool parallel)
 {
-	Float3A v[8];
+	if (!matrices && minima.size())
+		throw ArgumentNullException("matrices");
 
-	if (!Exists) return BoundingBoxA();
+	RunBoxTransform(minima, maxima, (const float*)matrices, true, outMinima, outMaxima, parallel);
+}
 
-	auto L = Minima;
-	auto H = Maxima;
+void BoundingBoxA::Transform(const BoundingBoxA* boxes, size_t count, const Float4x3A& mat, BoundingBoxA* outBoxes, bool parallel)
+{
+	if (count == 0)
+		return;
+	if (!boxes)
+		throw ArgumentNullException("boxes");
+	if (!outBoxes)
+		throw ArgumentNullException("outBoxes");
 
-	v[0] = Float3A(L.X, L.Y, L.Z) * mat;
-	v[1] = Float3A(L.X, L.Y, H.Z) * mat;
-	v[2] = Float3A(L.X, H.Y, L.Z) * mat;
-	v[3] = Float3A(L.X, H.Y, H.Z) * mat;
-	v[4] = Float3A(H.X, L.Y, L.Z) * mat;
-	v[5] = Float3A(H.X, L.Y, H.Z) * mat;
-	v[6] = Float3A(H.X, H.Y, L.Z) * mat;
-	v[7] = Float3A(H.X, H.Y, H.Z) * mat;
+	RunBoxes(count, parallel, [&](size_t i) { outBoxes[i] = boxes[i].Transform(mat); });
+}
 
-	return BoundingBoxA(v, 8);
+void BoundingBoxA::Transform(const BoundingBoxA* boxes, size_t count, const Float4x3A* matrices, BoundingBoxA* outBoxes, bool parallel)
+{
+	if (count == 0)
+		return;
+	if (!boxes)
+		throw ArgumentNullException("boxes");
+	if (!matrices)
+		throw ArgumentNullException("matrices");
+	if (!outBoxes)
+		throw ArgumentNullException("outBoxes");
+
+	RunBoxes(count, parallel, [&](size_t i) { outBoxes[i] = boxes[i].Transform(matrices[i]); });
 }
 
 bool BoundingBox::IsIntersecting(const BoundingBox &box) const
 {
-	return (Maxima.ComponentWise >= box.Maxima).All() && (Minima.ComponentWise <= box.Minima).All();
+	return (Maxima.GetComponentWise() >= box.Maxima).All() && (Minima.GetComponentWise() <= box.Minima).All();
 }
 
 bool BoundingBoxA::IsIntersecting(const BoundingBoxA &box) const
 {
-	return (Maxima.ComponentWise >= box.Maxima).All() && (Minima.ComponentWise <= box.Minima).All();
+	return (Maxima.GetComponentWise() >= box.Maxima).All() && (Minima.GetComponentWise() <= box.Minima).All();
 }
 
 bool BoundingBox::operator ==(const BoundingBox& rhs) const
@@ -234,15 +381,15 @@ bool BoundingBox::operator <(const BoundingBox& rhs) const
 
 bool BoundingBoxA::operator <(const BoundingBoxA& rhs) const
 {
-	if (Minima.X != rhs.Minima.X)
-		return Minima.X < rhs.Minima.X;
-	if (Minima.Y != rhs.Minima.Y)
-		return Minima.Y < rhs.Minima.Y;
-	if (Minima.Z != rhs.Minima.Z)
-		return Minima.Z < rhs.Minima.Z;
-	if (Maxima.X != rhs.Maxima.X)
-		return Maxima.X < rhs.Maxima.X;
-	if (Maxima.Y != rhs.Maxima.Y)
-		return Maxima.Y < rhs.Maxima.Y;
-	return Maxima.Z < rhs.Maxima.Z;
+	if (Minima.GetX() != rhs.Minima.GetX())
+		return Minima.GetX() < rhs.Minima.GetX();
+	if (Minima.GetY() != rhs.Minima.GetY())
+		return Minima.GetY() < rhs.Minima.GetY();
+	if (Minima.GetZ() != rhs.Minima.GetZ())
+		return Minima.GetZ() < rhs.Minima.GetZ();
+	if (Maxima.GetX() != rhs.Maxima.GetX())
+		return Maxima.GetX() < rhs.Maxima.GetX();
+	if (Maxima.GetY() != rhs.Maxima.GetY())
+		return Maxima.GetY() < rhs.Maxima.GetY();
+	return Maxima.GetZ() < rhs.Maxima.GetZ();
 }
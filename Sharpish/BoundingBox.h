@@ -86,6 +86,12 @@ namespace CS
 		BoundingBoxA(const BoundingBox &copy) { Minima = copy.Minima; Maxima = copy.Maxima; }
 		BoundingBoxA(const BoundingBoxA &copy) { Minima = copy.Minima; Maxima = copy.Maxima; }
 
+		// The box around count points, reduced a register at a time and split across worker threads unless parallel
+		// is false. Returns the default, empty box if count is 0.
+		static BoundingBoxA OfPoints(const Float3A* pts, size_t count, bool parallel = true);
+		static BoundingBoxA OfPoints(const Float3* pts, size_t count, bool parallel = true);
+		static BoundingBoxA OfPoints(const Float3Stream& pts, bool parallel = true);
+
 		bool operator ==(const BoundingBoxA& rhs) const;
 		bool operator !=(const BoundingBoxA& rhs) const;
 		bool operator <(const BoundingBoxA& rhs) const;
@@ -95,6 +101,16 @@ namespace CS
 		BoundingBoxA __vectorcall Combine(const BoundingBoxA &box) const;
 		BoundingBoxA Transform(const Float4x3A &mat) const;
 
+		// Transforms many boxes, by one matrix or by matrices[i] for box i, split across worker threads unless
+		// parallel is false. The SoA versions hold the boxes as minima and maxima streams; outMinima and outMaxima
+		// may be the input streams, and are reallocated if their sizes don't match. outBoxes may be boxes.
+		static void Transform(const Float3Stream& minima, const Float3Stream& maxima, const Float4x3A& mat,
+			Float3Stream& outMinima, Float3Stream& outMaxima, bool parallel = true);
+		static void Transform(const Float3Stream& minima, const Float3Stream& maxima, const Float4x3A* matrices,
+			Float3Stream& outMinima, Float3Stream& outMaxima, bool parallel = true);
+		static void Transform(const BoundingBoxA* boxes, size_t count, const Float4x3A& mat, BoundingBoxA* outBoxes, bool parallel = true);
+		static void Transform(const BoundingBoxA* boxes, size_t count, const Float4x3A* matrices, BoundingBoxA* outBoxes, bool parallel = true);
+
 		bool IsIntersecting(const BoundingBoxA &box) const;
 
 		void* operator new(size_t sz)
@@ -112,34 +128,34 @@ namespace CS
 		Float3A GetSize() const { return Maxima - Minima; }
 
 		PROPERTY_READONLY(float, Left);
-		float GetLeft() const{ return Minima.X; }
+		float GetLeft() const{ return Minima.GetX(); }
 
 		PROPERTY_READONLY(float, Right);
-		float GetRight() const { return Maxima.X; }
+		float GetRight() const { return Maxima.GetX(); }
 
 		PROPERTY_READONLY(float, Top);
-		float GetTop() const { return Maxima.Y; }
+		float GetTop() const { return Maxima.GetY(); }
 
 		PROPERTY_READONLY(float, Bottom);
-		float GetBottom() const { return Minima.Y; }
+		float GetBottom() const { return Minima.GetY(); }
 
 		PROPERTY_READONLY(float, Front);
-		float GetFront() const { return Maxima.Z; }
+		float GetFront() const { return Maxima.GetZ(); }
 
 		PROPERTY_READONLY(float, Back);
-		float GetBack() const { return Minima.Z; }
+		float GetBack() const { return Minima.GetZ(); }
 
 		PROPERTY_READONLY(float, Width);
-		float GetWidth() const { return Maxima.X - Minima.X; }
+		float GetWidth() const { return Maxima.GetX() - Minima.GetX(); }
 
 		PROPERTY_READONLY(float, Height);
-		float GetHeight() const { return Maxima.Y - Minima.Y; }
+		float GetHeight() const { return Maxima.GetY() - Minima.GetY(); }
 
 		PROPERTY_READONLY(float, Depth);
-		float GetDepth() const { return Maxima.Z - Minima.Z; }
+		float GetDepth() const { return Maxima.GetZ() - Minima.GetZ(); }
 
 		PROPERTY_READONLY(bool, Exists);
-		bool GetExists() const { return Maxima.X >= Minima.X; }
+		bool GetExists() const { return Maxima.GetX() >= Minima.GetX(); }
 
 	private:
 		static Float3A MinVector;
@@ -151,5 +167,3 @@ namespace CS
 
 DECLARE_HASHABLE(::CS::BoundingBox)
 DECLARE_HASHABLE(::CS::BoundingBoxA)
-IS_VALUETYPE(::CS::BoundingBox, "9C1D7D3E-9042-42F6-AF18-905A98F862FB");
-IS_VALUETYPE(::CS::BoundingBoxA, "179928A5-3F4D-41D5-959B-5D41C9A925D6");
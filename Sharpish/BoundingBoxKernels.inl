@@ -0,0 +1,132 @@
+// The batch kernels of BoundingBox.cpp, defined for each lane width by MathKernels.h
+
+	// The SoA form of TransformCenterExtent, a register of boxes at a time. Boxes holding nothing come out as
+	// the default, empty box, as the single-box Transform returns.
+	struct BoxTransformKernel
+	{
+		template<typename L>
+		static void Run(const BoxTransformJob& job, size_t begin, size_t end)
+		{
+			typedef typename L::V V;
+
+			// Offsets of m00 m01 m02 m10 ... m32 within a Float4x3A
+			static const int Elements[12] = { 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14 };
+			alignas(64) int32_t offsets[L::Width];
+
+			V m[12];
+			if (!job.PerBox)
+			{
+				for (int e = 0; e < 12; e++)
+					m[e] = L::Splat(job.Matrices[Elements[e]]);
+			}
+
+			auto half = L::Splat(0.5f);
+			auto emptyMin = L::Splat(FLT_MAX), emptyMax = L::Splat(-FLT_MAX);
+
+			for (size_t i = begin; i < end; i += L::Width)
+			{
+				if (job.PerBox)
+				{
+					// The streams are padded to whole registers but the matrices aren't, so lanes past the end
+					// repeat the first
+					for (int j = 0; j < L::Width; j++)
+						offsets[j] = i + j < job.Count ? j * 16 : 0;
+
+					const float* base = job.Matrices + i * 16;
+					for (int e = 0; e < 12; e++)
+						m[e] = L::Gather(base + Elements[e], offsets);
+				}
+
+				auto minX = L::Load(job.MinX + i), minY = L::Load(job.MinY + i), minZ = L::Load(job.MinZ + i);
+				auto maxX = L::Load(job.MaxX + i), maxY = L::Load(job.MaxY + i), maxZ = L::Load(job.MaxZ + i);
+				auto empty = L::Less(maxX, minX);
+
+				auto cx = L::MulAdd(minX, half, L::Mul(maxX, half));
+				auto cy = L::MulAdd(minY, half, L::Mul(maxY, half));
+				auto cz = L::MulAdd(minZ, half, L::Mul(maxZ, half));
+				auto ex = L::NegMulAdd(minX, half, L::Mul(maxX, half));
+				auto ey = L::NegMulAdd(minY, half, L::Mul(maxY, half));
+				auto ez = L::NegMulAdd(minZ, half, L::Mul(maxZ, half));
+
+				auto ox = L::MulAdd(cx, m[0], L::MulAdd(cy, m[3], L::MulAdd(cz, m[6], m[9])));
+				auto oy = L::MulAdd(cx, m[1], L::MulAdd(cy, m[4], L::MulAdd(cz, m[7], m[10])));
+				auto oz = L::MulAdd(cx, m[2], L::MulAdd(cy, m[5], L::MulAdd(cz, m[8], m[11])));
+				auto rx = L::MulAdd(ex, L::Abs(m[0]), L::MulAdd(ey, L::Abs(m[3]), L::Mul(ez, L::Abs(m[6]))));
+				auto ry = L::MulAdd(ex, L::Abs(m[1]), L::MulAdd(ey, L::Abs(m[4]), L::Mul(ez, L::Abs(m[7]))));
+				auto rz = L::MulAdd(ex, L::Abs(m[2]), L::MulAdd(ey, L::Abs(m[5]), L::Mul(ez, L::Abs(m[8]))));
+
+				L::Store(job.OMinX + i, L::Select(L::Sub(ox, rx), emptyMin, empty));
+				L::Store(job.OMinY + i, L::Select(L::Sub(oy, ry), emptyMin, empty));
+				L::Store(job.OMinZ + i, L::Select(L::Sub(oz, rz), emptyMin, empty));
+				L::Store(job.OMaxX + i, L::Select(L::Add(ox, rx), emptyMax, empty));
+				L::Store(job.OMaxY + i, L::Select(L::Add(oy, ry), emptyMax, empty));
+				L::Store(job.OMaxZ + i, L::Select(L::Add(oz, rz), emptyMax, empty));
+			}
+		}
+	};
+
+	// Minima and maxima of count points stride floats apart (1, 3 or 4, the fourth component being ignored). Each
+	// block of stride registers holds Width whole points, so the accumulators keep a fixed component in each
+	// lane, and are folded by component once the blocks are done.
+	struct ReducePointsKernel
+	{
+		template<typename L>
+		static void Run(const float* p, size_t count, int stride, float* outMin, float* outMax)
+		{
+			typedef typename L::V V;
+
+			V lo[4], hi[4];
+			for (int r = 0; r < stride; r++)
+			{
+				lo[r] = L::Splat(INFINITY);
+				hi[r] = L::Splat(-INFINITY);
+			}
+
+			size_t blocks = count / L::Width;
+			for (size_t b = 0; b < blocks; b++)
+			{
+				const float* block = p + b * stride * L::Width;
+				for (int r = 0; r < stride; r++)
+				{
+					auto v = L::LoadUnaligned(block + r * L::Width);
+					lo[r] = L::Min(lo[r], v);
+					hi[r] = L::Max(hi[r], v);
+				}
+			}
+
+			for (int k = 0; k < 3; k++)
+			{
+				outMin[k] = INFINITY;
+				outMax[k] = -INFINITY;
+			}
+
+			alignas(64) float lanes[L::Width];
+			for (int r = 0; r < stride; r++)
+			{
+				L::Store(lanes, lo[r]);
+				for (int j = 0; j < L::Width; j++)
+				{
+					int k = (r * L::Width + j) % stride;
+					if (k < 3)
+						outMin[k] = min(outMin[k], lanes[j]);
+				}
+
+				L::Store(lanes, hi[r]);
+				for (int j = 0; j < L::Width; j++)
+				{
+					int k = (r * L::Width + j) % stride;
+					if (k < 3)
+						outMax[k] = max(outMax[k], lanes[j]);
+				}
+			}
+
+			for (size_t i = blocks * L::Width; i < count; i++)
+			{
+				for (int k = 0; k < 3 && k < stride; k++)
+				{
+					outMin[k] = min(outMin[k], p[i * stride + k]);
+					outMax[k] = max(outMax[k], p[i * stride + k]);
+				}
+			}
+		}
+	};
@@ -1,15 +1,408 @@
 #include "Sharpish.h"
+#include "MathDispatch.h"
+#include "MathParallel.h"
+#include <algorithm>
 
 using namespace CS;
+using namespace std;
+
+#define SHARPISH_KERNELS "BoundingSphereKernels.inl"
+#include "MathKernels.h"
+
+namespace
+{
+	// Points per piece of work in the passes over all points
+	const size_t PassGranularity = 16384;
+	// Points the core set may gain before the best sphere so far is settled for
+	const int MaxRefinements = 64;
+	// A refined sphere is final once the furthest point is within this fraction of its radius
+	const double Convergence = 1e-6;
+	// Allowance on the squared distances FurthestPointKernel finds in float, which are within a few units in the
+	// last place of the exact ones
+	const double FloatSlack = 1e-6;
+
+	// The spheres are found in double precision, then rounded to floats
+	struct Point
+	{
+		double X, Y, Z;
+	};
+
+	inline Point operator +(const Point& a, const Point& b) { return Point { a.X + b.X, a.Y + b.Y, a.Z + b.Z }; }
+	inline Point operator -(const Point& a, const Point& b) { return Point { a.X - b.X, a.Y - b.Y, a.Z - b.Z }; }
+	inline Point operator *(const Point& a, double s) { return Point { a.X * s, a.Y * s, a.Z * s }; }
+	inline double Dot(const Point& a, const Point& b) { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
+	inline Point Cross(const Point& a, const Point& b) { return Point { a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X }; }
+	inline double DistanceSq(const Point& a, const Point& b) { return Dot(a - b, a - b); }
+
+
+	// Points stride floats apart, as Float3 or Float3A
+	struct Points
+	{
+		const float* Base;
+		size_t Stride;
+		size_t Count;
+
+		inline Point operator [](size_t i) const
+		{
+			const float* p = Base + i * Stride;
+			return Point { p[0], p[1], p[2] };
+		}
+	};
+
+	struct Ball
+	{
+		Point Center;
+		double RadiusSq;
+	};
+
+	// A sphere as the result will hold it: the center rounded to floats, and the squared distance from there to
+	// the furthest point
+	struct Rounded
+	{
+		float Center[3];
+		double RadiusSq;
+	};
+
+	inline Rounded Round(const Point& center) { return Rounded { { (float)center.X, (float)center.Y, (float)center.Z }, INFINITY }; }
+
+	inline bool Contains(const Ball& ball, const Point& p)
+	{
+		// A little slack, so the points a ball is built through count as inside it
+		return DistanceSq(ball.Center, p) <= ball.RadiusSq * (1 + 1e-10);
+	}
+
+	Ball BallOf(const Point* support, int n);
+
+	// The smallest ball through a proper subset of the points that holds them all, for points too close to
+	// collinear or coplanar to have a circumscribed ball of their own
+	Ball SmallestOfSubsets(const Point* support, int n)
+	{
+		Ball best = { support[0], -1 };
+		for (int mask = 1; mask < (1 << n) - 1; mask++)
+		{
+			Point subset[4];
+			int m = 0;
+			for (int k = 0; k < n; k++)
+				if (mask & (1 << k))
+					subset[m++] = support[k];
+			if (m < 2)
+				continue;
+
+			Ball ball = BallOf(subset, m);
+			if (best.RadiusSq >= 0 && ball.RadiusSq >= best.RadiusSq)
+				continue;
+			if (all_of(support, support + n, [&](const Point& p) { return Contains(ball, p); }))
+				best = ball;
+		}
+
+		if (best.RadiusSq < 0)
+		{
+			// Rounding kept every subset from holding the rest, so grow the first pair's ball to fit
+			best = BallOf(support, 2);
+			for (int k = 2; k < n; k++)
+				best.RadiusSq = max(best.RadiusSq, DistanceSq(best.Center, support[k]));
+		}
+		return best;
+	}
+
+	// The smallest ball with all of the support points, at most 4, on its surface
+	Ball BallOf(const Point* support, int n)
+	{
+		const Point& a = support[0];
+		switch (n)
+		{
+		case 0:
+			return Ball { Point { 0, 0, 0 }, -1 };
+
+		case 1:
+			return Ball { a, 0 };
+
+		case 2:
+		{
+			Point center = (a + support[1]) * 0.5;
+			return Ball { center, DistanceSq(center, a) };
+		}
+
+		case 3:
+		{
+			Point u = support[1] - a, v = support[2] - a;
+			Point w = Cross(u, v);
+			double d = 2 * Dot(w, w);
+			if (d <= 1e-12 * Dot(u, u) * Dot(v, v))
+				return SmallestOfSubsets(support, 3);
+
+			Point offset = (Cross(v, w) * Dot(u, u) + Cross(w, u) * Dot(v, v)) * (1 / d);
+			return Ball { a + offset, Dot(offset, offset) };
+		}
+
+		default:
+		{
+			Point u = support[1] - a, v = support[2] - a, w = support[3] - a;
+			double d = 2 * Dot(u, Cross(v, w));
+			if (d * d <= 1e-18 * Dot(u, u) * Dot(v, v) * Dot(w, w))
+				return SmallestOfSubsets(support, 4);
+
+			Point offset = (Cross(v, w) * Dot(u, u) + Cross(w, u) * Dot(v, v) + Cross(u, v) * Dot(w, w)) * (1 / d);
+			return Ball { a + offset, Dot(offset, offset) };
+		}
+		}
+	}
+
+	// Welzl's algorithm with the move-to-front heuristic: the smallest ball around the first n points that has
+	// the support points on its surface
+	Ball Welzl(vector<Point>& points, size_t n, Point* support, int s)
+	{
+		Ball ball = BallOf(support, s);
+		if (s == 4)
+			return ball;
+
+		for (size_t i = 0; i < n; i++)
+		{
+			if (Contains(ball, points[i]))
+				continue;
+
+			support[s] = points[i];
+			ball = Welzl(points, i, support, s + 1);
+			rotate(points.begin(), points.begin() + i, points.begin() + i + 1);
+		}
+
+		return ball;
+	}
+
+	// Runs body(begin, end) over granules of all the points. Each granule is its own call, so results kept per
+	// granule don't depend on how ParallelFor chunks them.
+	void RunGranules(size_t count, bool parallel, const function<void(size_t, size_t)>& body)
+	{
+		auto run = [&](size_t begin, size_t end)
+		{
+			for (size_t g = begin; g < end; g += PassGranularity)
+				body(g, min(end, g + PassGranularity));
+		};
+
+		Details::ParallelFor(count, PassGranularity, parallel, run);
+	}
+
+	struct FurthestPoint
+	{
+		// The exact squared distance to the point found, and at least that of every point
+		double DistanceSq;
+		double Bound;
+		size_t Index;
+	};
+
+	// The point furthest from center, found in float by FurthestPointKernel a granule at a time and folded in
+	// order, so ties go to the first whatever the threads did. Squared distances that overflow a float are
+	// measured again in double.
+	FurthestPoint Furthest(const Points& points, const float* roundedCenter, bool parallel)
+	{
+		auto kernel = SHARPISH_KERNEL(FurthestPointKernel)::Get();
+		vector<pair<float, size_t>> partials((points.Count + PassGranularity - 1) / PassGranularity);
+
+		RunGranules(points.Count, parallel, [&](size_t begin, size_t end)
+		{
+			auto& partial = partials[begin / PassGranularity];
+			kernel(points.Base + begin * points.Stride, end - begin, (int)points.Stride, roundedCenter, partial.first, partial.second);
+			partial.second += begin;
+		});
+
+		pair<float, size_t> best(-1.0f, 0);
+		for (auto& partial : partials)
+			if (partial.first > best.first)
+				best = partial;
+
+		Point center = { roundedCenter[0], roundedCenter[1], roundedCenter[2] };
+		if (!isinf(best.first))
+		{
+			double distanceSq = DistanceSq(points[best.second], center);
+			return FurthestPoint { distanceSq, max(distanceSq, best.first * (1 + FloatSlack)), best.second };
+		}
+
+		FurthestPoint furthest = { -1, -1, 0 };
+		for (size_t i = 0; i < points.Count; i++)
+		{
+			double d = DistanceSq(points[i], center);
+			if (d > furthest.DistanceSq)
+				furthest = FurthestPoint { d, d, i };
+		}
+		return furthest;
+	}
+
+	// The smallest ball around both
+	Ball Merge(const Ball& a, const Ball& b)
+	{
+		double ra = sqrt(a.RadiusSq), rb = sqrt(b.RadiusSq);
+		double d = sqrt(DistanceSq(a.Center, b.Center));
+		if (d + rb <= ra)
+			return a;
+		if (d + ra <= rb)
+			return b;
+
+		double r = (d + ra + rb) / 2;
+		return Ball { a.Center + (b.Center - a.Center) * ((r - ra) / d), r * r };
+	}
+
+	// Ritter's sphere: the ball on the furthest-apart pair of the core, grown to take in each point outside it.
+	// Each granule grows its own copy, and the copies are merged.
+	Ball Ritter(const Points& points, const vector<Point>& core, bool parallel)
+	{
+		Point ends[2] = { core[0], core[1] };
+		for (size_t a = 0; a < core.size(); a++)
+			for (size_t b = a + 1; b < core.size(); b++)
+				if (DistanceSq(core[a], core[b]) > DistanceSq(ends[0], ends[1]))
+					ends[0] = core[a], ends[1] = core[b];
+
+		Ball initial = BallOf(ends, 2);
+		vector<Ball> grown((points.Count + PassGranularity - 1) / PassGranularity, initial);
+		RunGranules(points.Count, parallel, [&](size_t begin, size_t end)
+		{
+			Ball& ball = grown[begin / PassGranularity];
+			double r = sqrt(ball.RadiusSq);
+
+			for (size_t i = begin; i < end; i++)
+			{
+				Point p = points[i];
+				double dSq = DistanceSq(p, ball.Center);
+				if (dSq <= r * r)
+					continue;
+
+				double d = sqrt(dSq);
+				double grownR = (r + d) / 2;
+				ball.Center = ball.Center + (p - ball.Center) * ((grownR - r) / d);
+				r = grownR;
+			}
+			ball.RadiusSq = r * r;
+		});
+
+		Ball ritter = grown[0];
+		for (size_t g = 1; g < grown.size(); g++)
+			ritter = Merge(ritter, grown[g]);
+		return ritter;
+	}
+
+	// A sphere around every point, whose center is exactly representable as floats
+	Rounded Bound(const Points& points, bool parallel)
+	{
+		// The extremes along the axes and the face and edge diagonals of a cube, found per granule and folded in
+		// order
+		static const double Directions[13][3] =
+		{
+			{ 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 },
+			{ 1, 1, 1 }, { 1, 1, -1 }, { 1, -1, 1 }, { 1, -1, -1 },
+			{ 1, 1, 0 }, { 1, -1, 0 }, { 1, 0, 1 }, { 1, 0, -1 }, { 0, 1, 1 }, { 0, 1, -1 },
+		};
+
+		struct Extremes
+		{
+			double Lo[13], Hi[13];
+			size_t LoIndex[13], HiIndex[13];
+		};
+
+		vector<Extremes> extremes((points.Count + PassGranularity - 1) / PassGranularity);
+		RunGranules(points.Count, parallel, [&](size_t begin, size_t end)
+		{
+			Extremes& e = extremes[begin / PassGranularity];
+			fill(e.Lo, e.Lo + 13, INFINITY);
+			fill(e.Hi, e.Hi + 13, -INFINITY);
+
+			for (size_t i = begin; i < end; i++)
+			{
+				Point p = points[i];
+				for (int k = 0; k < 13; k++)
+				{
+					double t = p.X * Directions[k][0] + p.Y * Directions[k][1] + p.Z * Directions[k][2];
+					if (t < e.Lo[k]) { e.Lo[k] = t; e.LoIndex[k] = i; }
+					if (t > e.Hi[k]) { e.Hi[k] = t; e.HiIndex[k] = i; }
+				}
+			}
+		});
+
+		vector<Point> core;
+		for (int k = 0; k < 13; k++)
+		{
+			const Extremes* lo = &extremes[0];
+			const Extremes* hi = &extremes[0];
+			for (const Extremes& e : extremes)
+			{
+				if (e.Lo[k] < lo->Lo[k]) lo = &e;
+				if (e.Hi[k] > hi->Hi[k]) hi = &e;
+			}
+			core.push_back(points[lo->LoIndex[k]]);
+			core.push_back(points[hi->HiIndex[k]]);
+		}
+
+		// Refinement, starting from the exact smallest sphere of the extremes. Each sphere tried is given the
+		// radius that reaches the furthest point from its rounded center, so every one holds all the points and
+		// the smallest can be kept.
+		Rounded best = { { 0, 0, 0 }, INFINITY };
+		for (int n = 0; n <= MaxRefinements; n++)
+		{
+			Point support[4];
+			Ball ball = Welzl(core, core.size(), support, 0);
+			Rounded tried = Round(ball.Center);
+			auto furthest = Furthest(points, tried.Center, parallel);
+			tried.RadiusSq = furthest.Bound;
+			if (tried.RadiusSq < best.RadiusSq)
+				best = tried;
+
+			// Rounding the center can move it off by up to its shift, which no refinement will remove
+			double shift = sqrt(DistanceSq(Point { tried.Center[0], tried.Center[1], tried.Center[2] }, ball.Center));
+			if (sqrt(furthest.DistanceSq) <= sqrt(ball.RadiusSq) * (1 + Convergence) + shift)
+				return best;
+
+			core.push_back(points[furthest.Index]);
+		}
+
+		// Still not converged, which only rounding should cause; Ritter's sphere may yet be smaller
+		Rounded fallback = Round(Ritter(points, core, parallel).Center);
+		fallback.RadiusSq = Furthest(points, fallback.Center, parallel).Bound;
+		return fallback.RadiusSq < best.RadiusSq ? fallback : best;
+	}
+
+	BoundingSphereA BoundPoints(const float* pts, size_t count, size_t stride, bool parallel)
+	{
+		if (!pts)
+			throw ArgumentNullException("pts");
+
+		Rounded sphere = Bound(Points { pts, stride, count }, parallel);
+
+		// The radius is rounded up, so the float sphere still holds every point
+		double r = sqrt(sphere.RadiusSq);
+		float radius = (float)r;
+		if ((double)radius < r)
+			radius = nextafterf(radius, INFINITY);
+		return BoundingSphereA(Float3(sphere.Center[0], sphere.Center[1], sphere.Center[2]), radius);
+	}
+}
 
 BoundingSphereA::BoundingSphereA(const BoundingSphere& copy) : _value(copy) { }
 
 BoundingSphereA BoundingSphereA::OfBox(const BoundingBoxA& box)
 {
-	return BoundingSphereA(box.Center, (box.Maxima - box.Minima).Length / 2);
+	return BoundingSphereA(box.GetCenter(), (box.Maxima - box.Minima).GetLength() / 2);
+}
+
+BoundingSphereA BoundingSphereA::OfPoints(const Float3A* pts, size_t count, bool parallel)
+{
+	if (count == 0)
+		return BoundingSphereA();
+
+	return BoundPoints((const float*)pts, count, 4, parallel);
+}
+
+BoundingSphereA BoundingSphereA::OfPoints(const Float3* pts, size_t count, bool parallel)
+{
+	if (count == 0)
+		return BoundingSphereA();
+
+	return BoundPoints((const float*)pts, count, 3, parallel);
 }
 
 BoundingSphere BoundingSphere::OfBox(const BoundingBox& box)
 {
-	return BoundingSphere(box.Center, (box.Maxima - box.Minima).Length / 2);
-}
\ No newline at end of file
+	return BoundingSphere(box.GetCenter(), (box.Maxima - box.Minima).GetLength() / 2);
+}
+
+BoundingSphere BoundingSphere::OfPoints(const Float3* pts, size_t count, bool parallel)
+{
+	return BoundingSphereA::OfPoints(pts, count, parallel);
+}
@@ -32,13 +32,21 @@ namespace CS
 		BoundingSphereA(const Float3& center, float radius) : _value(center.X, center.Y, center.Z, radius) { }
 
 		PROPERTY_READONLY(Float3A, Center);
-		const Float3A& GetCenter() const { return _value.XYZ; }
+		const Float3A& GetCenter() const { return _value.GetXYZ(); }
 
 		PROPERTY_READONLY(float, Radius);
-		float GetRadius() const { return _value.W; }
+		float GetRadius() const { return _value.GetW(); }
 
 		operator const Float4A&() const { return _value; }
 		static BoundingSphereA OfBox(const BoundingBoxA& box);
+
+		// The smallest sphere around count points, up to float rounding, for tighter culling than OfBox. The
+		// exact smallest sphere of a core set of points is found, the core starting as the extremes along 13
+		// directions and gaining the point furthest outside until every point is inside; Ritter's sphere is only
+		// tried if that fails to settle. The passes over the points are split across worker threads unless
+		// parallel is false. Returns a zero sphere if count is 0.
+		static BoundingSphereA OfPoints(const Float3A* pts, size_t count, bool parallel = true);
+		static BoundingSphereA OfPoints(const Float3* pts, size_t count, bool parallel = true);
 	};
 
 	struct BoundingSphere
@@ -54,19 +62,18 @@ namespace CS
 		BoundingSphere(const Float3& center, float radius) : _value(center.X, center.Y, center.Z, radius) { }
 
 		PROPERTY_READONLY(Float3, Center);
-		const Float3& GetCenter() const { return _value.XYZ; }
+		const Float3& GetCenter() const { return _value.GetXYZ(); }
 
 		PROPERTY_READONLY(float, Radius);
 		float GetRadius() const { return _value.W; }
 
 		operator const Float4&() const { return _value; }
 		static BoundingSphere OfBox(const BoundingBox& box);
+		static BoundingSphere OfPoints(const Float3* pts, size_t count, bool parallel = true);
 	};
 }
 
 DECLARE_HASHABLE(::CS::BoundingSphereA)
 DECLARE_HASHABLE(::CS::BoundingSphere)
-IS_VALUETYPE(::CS::BoundingSphereA, "AB7271AE-E3A7-4E14-8655-175B4FFAFDD4")
-IS_VALUETYPE(::CS::BoundingSphere, "AB7271AE-E3A7-4E14-8655-175B4FFAFDD4")
 
 #pragma pop_macro("max")
\ No newline at end of file
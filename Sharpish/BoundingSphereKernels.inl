@@ -0,0 +1,67 @@
+// The batch kernels of BoundingSphere.cpp, defined for each lane width by MathKernels.h
+
+	// The furthest of count points stride floats apart (3 or 4, the fourth component being ignored) from center,
+	// in float: outDistanceSq receives its squared distance and outIndex its position, the first on ties. Each
+	// register gathers Width whole points a component at a time and each lane keeps its own furthest, with its
+	// index counted in floats, so count must stay below 2^24.
+	struct FurthestPointKernel
+	{
+		template<typename L>
+		static void Run(const float* p, size_t count, int stride, const float* center, float& outDistanceSq, size_t& outIndex)
+		{
+			alignas(64) int32_t offsets[L::Width];
+			alignas(64) float lanes[L::Width];
+			for (int j = 0; j < L::Width; j++)
+			{
+				offsets[j] = j * stride;
+				lanes[j] = (float)j;
+			}
+
+			auto cx = L::Splat(center[0]), cy = L::Splat(center[1]), cz = L::Splat(center[2]);
+			auto best = L::Splat(-1.0f), bestIndex = L::Zero();
+			auto index = L::Load(lanes), step = L::Splat((float)L::Width);
+
+			size_t blocks = count / L::Width;
+			for (size_t b = 0; b < blocks; b++)
+			{
+				const float* block = p + b * stride * L::Width;
+				auto dx = L::Sub(L::Gather(block, offsets), cx);
+				auto dy = L::Sub(L::Gather(block + 1, offsets), cy);
+				auto dz = L::Sub(L::Gather(block + 2, offsets), cz);
+				auto distanceSq = L::Add(L::Add(L::Mul(dx, dx), L::Mul(dy, dy)), L::Mul(dz, dz));
+
+				auto further = L::Greater(distanceSq, best);
+				best = L::Select(best, distanceSq, further);
+				bestIndex = L::Select(bestIndex, index, further);
+				index = L::Add(index, step);
+			}
+
+			// Each lane holds its first furthest, so ties between lanes go to the lower index
+			alignas(64) float indices[L::Width];
+			L::Store(lanes, best);
+			L::Store(indices, bestIndex);
+			outDistanceSq = -1;
+			outIndex = 0;
+			for (int j = 0; j < L::Width; j++)
+			{
+				size_t i = (size_t)indices[j];
+				if (lanes[j] > outDistanceSq || (lanes[j] == outDistanceSq && i < outIndex))
+				{
+					outDistanceSq = lanes[j];
+					outIndex = i;
+				}
+			}
+
+			for (size_t i = blocks * L::Width; i < count; i++)
+			{
+				const float* q = p + i * stride;
+				float dx = q[0] - center[0], dy = q[1] - center[1], dz = q[2] - center[2];
+				float distanceSq = dx * dx + dy * dy + dz * dz;
+				if (distanceSq > outDistanceSq)
+				{
+					outDistanceSq = distanceSq;
+					outIndex = i;
+				}
+			}
+		}
+	};
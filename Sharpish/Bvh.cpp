@@ -0,0 +1,813 @@
+#include "Sharpish.h"
+#include "Bvh.h"
+#include "MathParallel.h"
+#include <algorithm>
+#include <numeric>
+
+// ::PUBLICLIB::
+
+using namespace CS;
+using namespace std;
+
+namespace
+{
+	// Nodes are four wide, so every query tests a node's children in one XMVECTOR per coordinate
+	typedef Details::Lanes4 L;
+	typedef Bvh::Node Node;
+
+	const int BinCount = 16;
+	// Ranges at most this large are built as one subtree on a worker thread
+	const uint32_t ParallelSubtreeSize = 4096;
+	// Past this depth ranges are halved instead of split by the heuristic, which bounds the depth of any tree
+	// (48 levels, then at most 16 of quartering) and so the traversal stacks: each level pushes at most 3 more
+	// nodes than it pops.
+	const int MaxSahDepth = 48;
+	const int StackSize = 256;
+	const size_t RayGranularity = 64;
+
+	struct Box
+	{
+		float Min[3];
+		float Max[3];
+
+		void Clear()
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				Min[k] = FLT_MAX;
+				Max[k] = -FLT_MAX;
+			}
+		}
+
+		void Grow(const Box& b)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				Min[k] = min(Min[k], b.Min[k]);
+				Max[k] = max(Max[k], b.Max[k]);
+			}
+		}
+
+		void Grow(const float* p)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				Min[k] = min(Min[k], p[k]);
+				Max[k] = max(Max[k], p[k]);
+			}
+		}
+
+		// Half the surface area, or 0 for a box holding nothing
+		float HalfArea() const
+		{
+			float dx = Max[0] - Min[0], dy = Max[1] - Min[1], dz = Max[2] - Min[2];
+			return dx < 0 || dy < 0 || dz < 0 ? 0 : dx * dy + dy * dz + dz * dx;
+		}
+	};
+
+	inline bool IsEmpty(const float* minima, const float* maxima)
+	{
+		return minima[0] > maxima[0] || minima[1] > maxima[1] || minima[2] > maxima[2];
+	}
+
+	inline const float* Minima(const BoundingBoxA& box) { return (const float*)&box.Minima; }
+	inline const float* Maxima(const BoundingBoxA& box) { return (const float*)&box.Maxima; }
+
+	// A range of slots waiting to become the node at nodes[Parent].Child[Slot], or the root if Parent is Empty
+	struct Job
+	{
+		uint32_t Begin;
+		uint32_t End;
+		int Depth;
+		int32_t Parent;
+		int Slot;
+	};
+
+	struct Builder
+	{
+		const Box* Prims;
+		const float* Centroids;
+		uint32_t* Indices;
+		uint32_t LeafSize;
+
+		// Splits [begin, end) in two by the surface area heuristic over BinCount bins of centroid position on
+		// each axis, reordering Indices, and returns where the second part starts
+		uint32_t Split(uint32_t begin, uint32_t end, int depth) const
+		{
+			Box centroidBounds;
+			centroidBounds.Clear();
+			for (uint32_t i = begin; i < end; i++)
+				centroidBounds.Grow(Centroids + 3 * Indices[i]);
+
+			float scale[3];
+			for (int k = 0; k < 3; k++)
+			{
+				float extent = centroidBounds.Max[k] - centroidBounds.Min[k];
+				scale[k] = extent > 0 ? BinCount * (1 - 1e-6f) / extent : 0;
+			}
+
+			auto binOf = [&](uint32_t index, int axis)
+			{
+				return min(BinCount - 1, (int)((Centroids[3 * index + axis] - centroidBounds.Min[axis]) * scale[axis]));
+			};
+
+			if (depth < MaxSahDepth)
+			{
+				Box bins[3][BinCount];
+				uint32_t counts[3][BinCount] = { };
+				for (int k = 0; k < 3; k++)
+					for (int b = 0; b < BinCount; b++)
+						bins[k][b].Clear();
+
+				for (uint32_t i = begin; i < end; i++)
+				{
+					uint32_t index = Indices[i];
+					for (int k = 0; k < 3; k++)
+					{
+						int b = binOf(index, k);
+						bins[k][b].Grow(Prims[index]);
+						counts[k][b]++;
+					}
+				}
+
+				float bestCost = FLT_MAX;
+				int bestAxis = -1, bestBin = 0;
+
+				for (int k = 0; k < 3; k++)
+				{
+					if (scale[k] == 0)
+						continue;
+
+					// rightCost[b]: count times area of bins b and above
+					float rightCost[BinCount];
+					Box right;
+					right.Clear();
+					uint32_t rightCount = 0;
+					for (int b = BinCount - 1; b > 0; b--)
+					{
+						right.Grow(bins[k][b]);
+						rightCount += counts[k][b];
+						rightCost[b] = rightCount * right.HalfArea();
+					}
+
+					Box left;
+					left.Clear();
+					uint32_t leftCount = 0;
+					for (int b = 0; b < BinCount - 1; b++)
+					{
+						left.Grow(bins[k][b]);
+						leftCount += counts[k][b];
+						float cost = leftCount * left.HalfArea() + rightCost[b + 1];
+						if (cost < bestCost)
+						{
+							bestCost = cost;
+							bestAxis = k;
+							bestBin = b;
+						}
+					}
+				}
+
+				if (bestAxis >= 0)
+				{
+					uint32_t mid = (uint32_t)(partition(Indices + begin, Indices + end,
+						[&](uint32_t index) { return binOf(index, bestAxis) <= bestBin; }) - Indices);
+					if (mid != begin && mid != end)
+						return mid;
+				}
+			}
+
+			// The centroids coincide or the tree is deep: halve the range along the widest axis
+			int axis = 0;
+			for (int k = 1; k < 3; k++)
+				if (centroidBounds.Max[k] - centroidBounds.Min[k] > centroidBounds.Max[axis] - centroidBounds.Min[axis])
+					axis = k;
+
+			uint32_t mid = begin + (end - begin) / 2;
+			nth_element(Indices + begin, Indices + mid, Indices + end,
+				[&](uint32_t a, uint32_t b) { return Centroids[3 * a + axis] < Centroids[3 * b + axis]; });
+			return mid;
+		}
+
+		// Appends a node for [begin, end) with up to four children, made by splitting the largest part until
+		// there are four or every part fits in a leaf. Parts too large for a leaf are added to jobs.
+		int32_t MakeNode(uint32_t begin, uint32_t end, int depth, vector<Node>& nodes, vector<Job>& jobs) const
+		{
+			uint32_t bounds[5] = { begin, end };
+			int parts = 1;
+
+			while (parts < 4)
+			{
+				int largest = -1;
+				for (int i = 0; i < parts; i++)
+					if (bounds[i + 1] - bounds[i] > LeafSize && (largest < 0 || bounds[i + 1] - bounds[i] > bounds[largest + 1] - bounds[largest]))
+						largest = i;
+				if (largest < 0)
+					break;
+
+				uint32_t mid = Split(bounds[largest], bounds[largest + 1], depth);
+				for (int i = parts; i > largest; i--)
+					bounds[i + 1] = bounds[i];
+				bounds[largest + 1] = mid;
+				parts++;
+			}
+
+			int32_t index = (int32_t)nodes.size();
+			nodes.emplace_back();
+			Node& node = nodes.back();
+
+			for (int k = 0; k < 4; k++)
+			{
+				Box box;
+				box.Clear();
+				node.Child[k] = Node::Empty;
+				node.Count[k] = 0;
+
+				if (k < parts)
+				{
+					for (uint32_t i = bounds[k]; i < bounds[k + 1]; i++)
+						box.Grow(Prims[Indices[i]]);
+
+					uint32_t count = bounds[k + 1] - bounds[k];
+					if (count <= LeafSize)
+					{
+						node.Child[k] = (int32_t)bounds[k];
+						node.Count[k] = count;
+					}
+					else
+					{
+						Job job = { bounds[k], bounds[k + 1], depth + 1, index, k };
+						jobs.push_back(job);
+					}
+				}
+
+				node.MinX[k] = box.Min[0];
+				node.MinY[k] = box.Min[1];
+				node.MinZ[k] = box.Min[2];
+				node.MaxX[k] = box.Max[0];
+				node.MaxY[k] = box.Max[1];
+				node.MaxZ[k] = box.Max[2];
+			}
+
+			return index;
+		}
+
+		// Builds the whole subtree for job in nodes
+		void Build(const Job& job, vector<Node>& nodes) const
+		{
+			vector<Job> jobs;
+			MakeNode(job.Begin, job.End, job.Depth, nodes, jobs);
+
+			while (!jobs.empty())
+			{
+				Job next = jobs.back();
+				jobs.pop_back();
+				int32_t index = MakeNode(next.Begin, next.End, next.Depth, nodes, jobs);
+				nodes[next.Parent].Child[next.Slot] = index;
+			}
+		}
+	};
+
+	struct Ray
+	{
+		float Origin[3];
+		float Inverse[3];
+		L::V OriginLanes[3];
+		L::V InverseLanes[3];
+
+		Ray(const Float3& origin, const Float3& direction)
+		{
+			const float d[3] = { direction.X, direction.Y, direction.Z };
+			Origin[0] = origin.X;
+			Origin[1] = origin.Y;
+			Origin[2] = origin.Z;
+
+			// Huge but finite in place of 1 / 0, so the slabs never compute 0 * infinity
+			for (int k = 0; k < 3; k++)
+			{
+				Inverse[k] = fabs(d[k]) < FLT_MIN ? (signbit(d[k]) ? -FLT_MAX : FLT_MAX) : 1 / d[k];
+				OriginLanes[k] = L::Splat(Origin[k]);
+				InverseLanes[k] = L::Splat(Inverse[k]);
+			}
+		}
+
+		// Slab test against the four children of node for t in [0, maxDistance]. Returns a bit per child hit and
+		// stores where the ray enters each.
+		uint32_t HitChildren(const Node& node, float maxDistance, XMFLOAT4A& enter) const
+		{
+			const float* minima[3] = { node.MinX, node.MinY, node.MinZ };
+			const float* maxima[3] = { node.MaxX, node.MaxY, node.MaxZ };
+			auto tNear = L::Zero();
+			auto tFar = L::Splat(maxDistance);
+
+			for (int k = 0; k < 3; k++)
+			{
+				auto t0 = L::Mul(L::Sub(L::Load(minima[k]), OriginLanes[k]), InverseLanes[k]);
+				auto t1 = L::Mul(L::Sub(L::Load(maxima[k]), OriginLanes[k]), InverseLanes[k]);
+				tNear = L::Max(L::Min(t0, t1), tNear);
+				tFar = L::Min(L::Max(t0, t1), tFar);
+			}
+
+			L::Store(&enter.x, tNear);
+			return L::MaskBits(L::LessOrEqual(tNear, tFar));
+		}
+
+		// The same for one box, which is missed if it holds nothing
+		bool Hit(const BoundingBoxA& box, float maxDistance, float& enter) const
+		{
+			const float* minima = Minima(box);
+			const float* maxima = Maxima(box);
+			if (IsEmpty(minima, maxima))
+				return false;
+
+			float tNear = 0, tFar = maxDistance;
+			for (int k = 0; k < 3; k++)
+			{
+				float t0 = (minima[k] - Origin[k]) * Inverse[k];
+				float t1 = (maxima[k] - Origin[k]) * Inverse[k];
+				tNear = max(min(t0, t1), tNear);
+				tFar = min(max(t0, t1), tFar);
+			}
+
+			enter = tNear;
+			return tNear <= tFar;
+		}
+	};
+
+	struct StackEntry
+	{
+		int32_t Node;
+		float Enter;
+	};
+
+	// Nearest-first traversal for the closest hit. hitLeaf(slot, best) tests the box in slot and returns true after
+	// lowering best to a hit at least as close.
+	template<typename F>
+	bool RaycastNearest(const vector<Node>& nodes, const Ray& ray, float maxDistance, const F& hitLeaf, uint32_t& outSlot, float& outDistance)
+	{
+		if (nodes.empty())
+			return false;
+
+		StackEntry stack[StackSize];
+		int top = 0;
+		stack[top++] = StackEntry { 0, 0 };
+
+		float best = maxDistance;
+		bool found = false;
+		XMFLOAT4A enter;
+
+		while (top > 0)
+		{
+			StackEntry entry = stack[--top];
+			if (entry.Enter > best)
+				continue;
+
+			const Node& node = nodes[entry.Node];
+			uint32_t hits = ray.HitChildren(node, best, enter);
+
+			// Children by entry distance, so leaves are tested nearest first and the nearest node pops next
+			int order[4], hitCount = 0;
+			for (int k = 0; k < 4; k++)
+			{
+				if (!(hits & (1u << k)) || node.Child[k] == Node::Empty)
+					continue;
+
+				int i = hitCount++;
+				for (; i > 0 && (&enter.x)[order[i - 1]] > (&enter.x)[k]; i--)
+					order[i] = order[i - 1];
+				order[i] = k;
+			}
+
+			int pushed = top;
+			for (int i = 0; i < hitCount; i++)
+			{
+				int k = order[i];
+				if ((&enter.x)[k] > best)
+					break;
+
+				if (node.Count[k])
+				{
+					for (uint32_t slot = node.Child[k], end = slot + node.Count[k]; slot < end; slot++)
+					{
+						if (hitLeaf(slot, best))
+						{
+							found = true;
+							outSlot = slot;
+						}
+					}
+				}
+				else
+				{
+					stack[top++] = StackEntry { node.Child[k], (&enter.x)[k] };
+				}
+			}
+
+			reverse(stack + pushed, stack + top);
+		}
+
+		if (found)
+			outDistance = best;
+		return found;
+	}
+
+	// Every slot in the subtree under child k of node, skipping boxes that hold nothing
+	void AddChild(const vector<Node>& nodes, const vector<uint32_t>& indices, const vector<BoundingBoxA>& boxes,
+		const Node& node, int k, vector<uint32_t>& outIndices)
+	{
+		if (node.Count[k])
+		{
+			for (uint32_t slot = node.Child[k], end = slot + node.Count[k]; slot < end; slot++)
+				if (!IsEmpty(Minima(boxes[slot]), Maxima(boxes[slot])))
+					outIndices.push_back(indices[slot]);
+			return;
+		}
+
+		for (int c = 0; c < 4; c++)
+			if (nodes[node.Child[k]].Child[c] != Node::Empty)
+				AddChild(nodes, indices, boxes, nodes[node.Child[k]], c, outIndices);
+	}
+
+	// Depth-first traversal. testNode(node) returns a bit per child to visit, testLeaf(slot) whether to report
+	// the box in slot.
+	template<typename N, typename B>
+	size_t Traverse(const vector<Node>& nodes, const vector<uint32_t>& indices, const N& testNode, const B& testLeaf, vector<uint32_t>& outIndices)
+	{
+		if (nodes.empty())
+			return 0;
+
+		size_t start = outIndices.size();
+		int32_t stack[StackSize];
+		int top = 0;
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			const Node& node = nodes[stack[--top]];
+			uint32_t hits = testNode(node);
+
+			for (int k = 0; k < 4; k++)
+			{
+				if (!(hits & (1u << k)) || node.Child[k] == Node::Empty)
+					continue;
+
+				if (node.Count[k])
+				{
+					for (uint32_t slot = node.Child[k], end = slot + node.Count[k]; slot < end; slot++)
+						if (testLeaf(slot))
+							outIndices.push_back(indices[slot]);
+				}
+				else
+				{
+					stack[top++] = node.Child[k];
+				}
+			}
+		}
+
+		return outIndices.size() - start;
+	}
+}
+
+Bvh::Bvh(const BoundingBoxA* boxes, size_t count, int leafSize, bool parallel)
+{
+	if (leafSize < 1 || leafSize > MaxLeafSize)
+		throw ArgumentException("leafSize", "Leaf size must be between 1 and MaxLeafSize");
+	if (count == 0)
+		return;
+	if (!boxes)
+		throw ArgumentNullException("boxes");
+	if (count > (size_t)INT32_MAX)
+		throw ArgumentException("count", "Too many boxes");
+
+	vector<Box> prims(count);
+	vector<float> centroids(3 * count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* minima = Minima(boxes[i]);
+		const float* maxima = Maxima(boxes[i]);
+		for (int k = 0; k < 3; k++)
+		{
+			prims[i].Min[k] = minima[k];
+			prims[i].Max[k] = maxima[k];
+			centroids[3 * i + k] = IsEmpty(minima, maxima) ? 0 : minima[k] * 0.5f + maxima[k] * 0.5f;
+		}
+	}
+
+	_indices.resize(count);
+	iota(_indices.begin(), _indices.end(), 0u);
+
+	Builder builder = { prims.data(), centroids.data(), _indices.data(), (uint32_t)leafSize };
+
+	// The top of the tree is built here, breadth first, until the ranges left are small enough to be subtrees
+	// for the workers. Each works on its own part of _indices into its own nodes, which are appended after.
+	vector<Job> jobs, subtrees;
+	jobs.push_back(Job { 0, (uint32_t)count, 0, Node::Empty, 0 });
+
+	for (size_t next = 0; next < jobs.size(); next++)
+	{
+		Job job = jobs[next];
+		if (parallel && job.End - job.Begin <= ParallelSubtreeSize)
+		{
+			subtrees.push_back(job);
+			continue;
+		}
+
+		int32_t index = builder.MakeNode(job.Begin, job.End, job.Depth, _nodes, jobs);
+		if (job.Parent != Node::Empty)
+			_nodes[job.Parent].Child[job.Slot] = index;
+	}
+
+	vector<vector<Node>> subtreeNodes(subtrees.size());
+	Details::ParallelFor(subtrees.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			builder.Build(subtrees[i], subtreeNodes[i]);
+	});
+
+	for (size_t i = 0; i < subtrees.size(); i++)
+	{
+		int32_t base = (int32_t)_nodes.size();
+		for (Node node : subtreeNodes[i])
+		{
+			for (int k = 0; k < 4; k++)
+				if (!node.Count[k] && node.Child[k] != Node::Empty)
+					node.Child[k] += base;
+			_nodes.push_back(node);
+		}
+
+		if (subtrees[i].Parent != Node::Empty)
+			_nodes[subtrees[i].Parent].Child[subtrees[i].Slot] = base;
+	}
+
+	_boxes.resize(count);
+	for (size_t i = 0; i < count; i++)
+		_boxes[i] = boxes[_indices[i]];
+}
+
+BoundingBoxA Bvh::GetBounds() const
+{
+	if (_nodes.empty())
+		return BoundingBoxA();
+
+	const Node& root = _nodes[0];
+	Box box;
+	box.Clear();
+	for (int k = 0; k < 4; k++)
+	{
+		if (root.Child[k] == Node::Empty)
+			continue;
+		Box child = { { root.MinX[k], root.MinY[k], root.MinZ[k] }, { root.MaxX[k], root.MaxY[k], root.MaxZ[k] } };
+		box.Grow(child);
+	}
+
+	return BoundingBox(Float3(box.Min[0], box.Min[1], box.Min[2]), Float3(box.Max[0], box.Max[1], box.Max[2]));
+}
+
+bool Bvh::RaycastFirst(const Float3A& origin, const Float3A& direction, float maxDistance, uint32_t& outIndex, float& outDistance) const
+{
+	Ray ray(origin, direction);
+	uint32_t hitSlot;
+
+	auto hitLeaf = [&](uint32_t slot, float& best)
+	{
+		float enter;
+		if (!ray.Hit(_boxes[slot], best, enter))
+			return false;
+		best = enter;
+		return true;
+	};
+
+	if (!RaycastNearest(_nodes, ray, maxDistance, hitLeaf, hitSlot, outDistance))
+		return false;
+
+	outIndex = _indices[hitSlot];
+	return true;
+}
+
+bool Bvh::RaycastFirst(const Float3A& origin, const Float3A& direction, float maxDistance, uint32_t& outIndex, float& outDistance,
+	const function<bool(uint32_t index, float& distance)>& hitTest) const
+{
+	Ray ray(origin, direction);
+	uint32_t hitSlot;
+
+	auto hitLeaf = [&](uint32_t slot, float& best)
+	{
+		float enter;
+		if (!ray.Hit(_boxes[slot], best, enter))
+			return false;
+
+		float distance = enter;
+		if (!hitTest(_indices[slot], distance) || distance > best)
+			return false;
+		best = max(distance, enter);
+		return true;
+	};
+
+	if (!RaycastNearest(_nodes, ray, maxDistance, hitLeaf, hitSlot, outDistance))
+		return false;
+
+	outIndex = _indices[hitSlot];
+	return true;
+}
+
+void Bvh::RaycastFirst(const Float3Stream& origins, const Float3Stream& directions, float maxDistance,
+	int32_t* outIndices, float* outDistances, bool parallel) const
+{
+	if (origins.size() != directions.size())
+		throw ArgumentException("directions", "Stream sizes differ");
+	if (!outIndices && origins.size())
+		throw ArgumentNullException("outIndices");
+
+	auto body = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			Float3 origin(origins.GetX()[i], origins.GetY()[i], origins.GetZ()[i]);
+			Float3 direction(directions.GetX()[i], directions.GetY()[i], directions.GetZ()[i]);
+			Ray ray(origin, direction);
+			uint32_t hitSlot;
+			float distance;
+
+			auto hitLeaf = [&](uint32_t slot, float& best)
+			{
+				float enter;
+				if (!ray.Hit(_boxes[slot], best, enter))
+					return false;
+				best = enter;
+				return true;
+			};
+
+			bool hit = RaycastNearest(_nodes, ray, maxDistance, hitLeaf, hitSlot, distance);
+			outIndices[i] = hit ? (int32_t)_indices[hitSlot] : -1;
+			if (outDistances)
+				outDistances[i] = hit ? distance : maxDistance;
+		}
+	};
+
+	Details::ParallelFor(origins.size(), RayGranularity, parallel, body);
+}
+
+size_t Bvh::RaycastAll(const Float3A& origin, const Float3A& direction, float maxDistance, vector<uint32_t>& outIndices) const
+{
+	Ray ray(origin, direction);
+	XMFLOAT4A enter;
+	float boxEnter;
+
+	return Traverse(_nodes, _indices,
+		[&](const Node& node) { return ray.HitChildren(node, maxDistance, enter); },
+		[&](uint32_t slot) { return ray.Hit(_boxes[slot], maxDistance, boxEnter); },
+		outIndices);
+}
+
+size_t Bvh::Overlap(const BoundingBoxA& box, vector<uint32_t>& outIndices) const
+{
+	const float* qMin = Minima(box);
+	const float* qMax = Maxima(box);
+	if (IsEmpty(qMin, qMax))
+		return 0;
+
+	L::V lanesMin[3], lanesMax[3];
+	for (int k = 0; k < 3; k++)
+	{
+		lanesMin[k] = L::Splat(qMin[k]);
+		lanesMax[k] = L::Splat(qMax[k]);
+	}
+
+	auto testNode = [&](const Node& node)
+	{
+		const float* minima[3] = { node.MinX, node.MinY, node.MinZ };
+		const float* maxima[3] = { node.MaxX, node.MaxY, node.MaxZ };
+		auto mask = L::MaskAnd(L::LessOrEqual(L::Load(minima[0]), lanesMax[0]), L::GreaterOrEqual(L::Load(maxima[0]), lanesMin[0]));
+		for (int k = 1; k < 3; k++)
+			mask = L::MaskAnd(mask, L::MaskAnd(L::LessOrEqual(L::Load(minima[k]), lanesMax[k]), L::GreaterOrEqual(L::Load(maxima[k]), lanesMin[k])));
+		return L::MaskBits(mask);
+	};
+
+	auto testLeaf = [&](uint32_t slot)
+	{
+		const float* minima = Minima(_boxes[slot]);
+		const float* maxima = Maxima(_boxes[slot]);
+		if (IsEmpty(minima, maxima))
+			return false;
+		for (int k = 0; k < 3; k++)
+			if (minima[k] > qMax[k] || maxima[k] < qMin[k])
+				return false;
+		return true;
+	};
+
+	return Traverse(_nodes, _indices, testNode, testLeaf, outIndices);
+}
+
+size_t Bvh::Overlap(const BoundingSphereA& sphere, vector<uint32_t>& outIndices) const
+{
+	Float3 center = sphere.GetCenter();
+	const float c[3] = { center.X, center.Y, center.Z };
+	float radiusSq = sphere.GetRadius() * sphere.GetRadius();
+	if (sphere.GetRadius() < 0)
+		return 0;
+
+	L::V lanesCenter[3] = { L::Splat(c[0]), L::Splat(c[1]), L::Splat(c[2]) };
+	auto lanesRadiusSq = L::Splat(radiusSq);
+
+	// Squared distance from the center to the nearest point of each box
+	auto testNode = [&](const Node& node)
+	{
+		const float* minima[3] = { node.MinX, node.MinY, node.MinZ };
+		const float* maxima[3] = { node.MaxX, node.MaxY, node.MaxZ };
+		auto distanceSq = L::Zero();
+		for (int k = 0; k < 3; k++)
+		{
+			auto d = L::Max(L::Max(L::Sub(L::Load(minima[k]), lanesCenter[k]), L::Sub(lanesCenter[k], L::Load(maxima[k]))), L::Zero());
+			distanceSq = L::MulAdd(d, d, distanceSq);
+		}
+		return L::MaskBits(L::LessOrEqual(distanceSq, lanesRadiusSq));
+	};
+
+	auto testLeaf = [&](uint32_t slot)
+	{
+		const float* minima = Minima(_boxes[slot]);
+		const float* maxima = Maxima(_boxes[slot]);
+		if (IsEmpty(minima, maxima))
+			return false;
+
+		float distanceSq = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			float d = max(max(minima[k] - c[k], c[k] - maxima[k]), 0.0f);
+			distanceSq += d * d;
+		}
+		return distanceSq <= radiusSq;
+	};
+
+	return Traverse(_nodes, _indices, testNode, testLeaf, outIndices);
+}
+
+size_t Bvh::Cull(const FrustumCuller& frustum, vector<uint32_t>& outIndices) const
+{
+	if (_nodes.empty())
+		return 0;
+
+	size_t start = outIndices.size();
+	Float4 planes[FrustumCuller::PlaneCount];
+	for (int i = 0; i < FrustumCuller::PlaneCount; i++)
+		planes[i] = frustum.GetPlane(i);
+
+	int32_t stack[StackSize];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = _nodes[stack[--top]];
+		const float* minima[3] = { node.MinX, node.MinY, node.MinZ };
+		const float* maxima[3] = { node.MaxX, node.MaxY, node.MaxZ };
+
+		// Outside a plane if the corner furthest along its normal is behind it; inside all if the nearest
+		// corner is in front of every plane
+		auto outside = L::Less(L::Zero(), L::Zero());
+		auto inside = L::LessOrEqual(L::Zero(), L::Zero());
+		for (int i = 0; i < FrustumCuller::PlaneCount; i++)
+		{
+			const float n[3] = { planes[i].X, planes[i].Y, planes[i].Z };
+			auto furthest = L::Splat(planes[i].W);
+			auto nearest = furthest;
+			for (int k = 0; k < 3; k++)
+			{
+				auto a = L::Splat(n[k]);
+				furthest = L::MulAdd(a, L::Load(n[k] > 0 ? maxima[k] : minima[k]), furthest);
+				nearest = L::MulAdd(a, L::Load(n[k] > 0 ? minima[k] : maxima[k]), nearest);
+			}
+			outside = L::MaskOr(outside, L::Less(furthest, L::Zero()));
+			inside = L::MaskAnd(inside, L::GreaterOrEqual(nearest, L::Zero()));
+		}
+
+		uint32_t culled = L::MaskBits(outside);
+		uint32_t contained = L::MaskBits(inside);
+
+		for (int k = 0; k < 4; k++)
+		{
+			if ((culled & (1u << k)) || node.Child[k] == Node::Empty)
+				continue;
+
+			if (contained & (1u << k))
+			{
+				AddChild(_nodes, _indices, _boxes, node, k, outIndices);
+			}
+			else if (node.Count[k])
+			{
+				for (uint32_t slot = node.Child[k], end = slot + node.Count[k]; slot < end; slot++)
+					if (!IsEmpty(Minima(_boxes[slot]), Maxima(_boxes[slot])) && frustum.IsVisible(_boxes[slot]))
+						outIndices.push_back(_indices[slot]);
+			}
+			else
+			{
+				stack[top++] = node.Child[k];
+			}
+		}
+	}
+
+	return outIndices.size() - start;
+}
+
+size_t Bvh::Cull(const Float4x4A& viewProjection, vector<uint32_t>& outIndices) const
+{
+	return Cull(FrustumCuller(viewProjection), outIndices);
+}
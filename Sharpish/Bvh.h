@@ -0,0 +1,79 @@
+#pragma once
+
+#include <functional>
+
+namespace CS
+{
+	// A bounding volume hierarchy over a fixed set of boxes, for ray casts and overlap queries against many
+	// objects. The tree is built top-down with the surface area heuristic evaluated over binned centroids, and
+	// stored as 4-wide nodes: each node holds the boxes of its four children as SoA lanes in two cache lines, so a
+	// query tests all four with one SIMD register per coordinate. Subtrees of large builds are built on worker
+	// threads unless parallel is false.
+	//
+	// Queries report the boxes' indices in the array the hierarchy was built from. Results are appended to
+	// outIndices in no particular order, and each query returns how many it appended. Leaves are tested box by
+	// box, so callers refine hits against the actual geometry themselves. The hierarchy doesn't keep a reference
+	// to the source array; rebuild it when the boxes change.
+	class Bvh
+	{
+	public:
+		static const int DefaultLeafSize = 4;
+		static const int MaxLeafSize = 64;
+
+		// Child k of a node is empty if Child[k] is Empty, a leaf holding Count[k] boxes from slot Child[k] if
+		// Count[k] is non-zero, and otherwise the node at index Child[k]. Empty children hold nothing, so no
+		// query reaches them.
+		struct __declspec(align(64)) Node
+		{
+			static const int32_t Empty = -1;
+
+			float MinX[4], MinY[4], MinZ[4];
+			float MaxX[4], MaxY[4], MaxZ[4];
+			int32_t Child[4];
+			uint32_t Count[4];
+		};
+
+		Bvh() { }
+		// Boxes holding nothing (a minimum above the maximum) are kept but never reported.
+		Bvh(const BoundingBoxA* boxes, size_t count, int leafSize = DefaultLeafSize, bool parallel = true);
+
+		inline size_t size() const { return _indices.size(); }
+		inline bool empty() const { return _indices.empty(); }
+
+		PROPERTY_READONLY(BoundingBoxA, Bounds);
+		BoundingBoxA GetBounds() const;
+
+		PROPERTY_READONLY(size_t, NodeCount);
+		inline size_t GetNodeCount() const { return _nodes.size(); }
+
+		// The nearest box hit by origin + t * direction for t in [0, maxDistance], and the t where the ray enters
+		// it (0 if it starts inside). Returns false if no box is hit.
+		bool RaycastFirst(const Float3A& origin, const Float3A& direction, float maxDistance, uint32_t& outIndex, float& outDistance) const;
+		// As above, with the leaves refined by hitTest. It's called, nearest boxes first, with the index of each
+		// box the ray enters before the closest hit so far and that entry distance; it returns false on a miss, or
+		// true with distance set to the exact hit, which must not be less than the entry distance it was given.
+		bool RaycastFirst(const Float3A& origin, const Float3A& direction, float maxDistance, uint32_t& outIndex, float& outDistance,
+			const std::function<bool(uint32_t index, float& distance)>& hitTest) const;
+		// Many rays at once, split across worker threads unless parallel is false. outIndices receives -1 for a
+		// miss. outDistances may be null.
+		void RaycastFirst(const Float3Stream& origins, const Float3Stream& directions, float maxDistance,
+			int32_t* outIndices, float* outDistances, bool parallel = true) const;
+
+		size_t RaycastAll(const Float3A& origin, const Float3A& direction, float maxDistance, std::vector<uint32_t>& outIndices) const;
+
+		// Boxes that touch the box or sphere
+		size_t Overlap(const BoundingBoxA& box, std::vector<uint32_t>& outIndices) const;
+		size_t Overlap(const BoundingSphereA& sphere, std::vector<uint32_t>& outIndices) const;
+
+		// Boxes that may be visible, as FrustumCuller::IsVisible decides. Subtrees wholly inside the frustum are
+		// reported without testing their boxes.
+		size_t Cull(const FrustumCuller& frustum, std::vector<uint32_t>& outIndices) const;
+		size_t Cull(const Float4x4A& viewProjection, std::vector<uint32_t>& outIndices) const;
+
+	private:
+		// The root is node 0. Leaves refer to slots, which list the source indices and boxes in leaf order.
+		std::vector<Node> _nodes;
+		std::vector<uint32_t> _indices;
+		std::vector<BoundingBoxA> _boxes;
+	};
+}
@@ -1,12 +1,11 @@
 #include "Sharpish.h"
-#include "StringHelper.h"
 
 using namespace CS;
 
-Exception::Exception() : std::exception(), HResult(S_OK) { }
-Exception::Exception(HRESULT hr) : std::exception(), HResult(hr) { }
-Exception::Exception(string msg) : std::exception(msg.c_str()), HResult(S_OK) { }
-Exception::Exception(HRESULT hr, string msg) : std::exception(msg.c_str()), HResult(hr) { }
+Exception::Exception() : std::exception(), HResult(S_OK), _message("Unknown exception") { }
+Exception::Exception(HRESULT hr) : std::exception(), HResult(hr), _message("Unknown exception") { }
+Exception::Exception(string msg) : std::exception(), HResult(S_OK), _message(msg) { }
+Exception::Exception(HRESULT hr, string msg) : std::exception(), HResult(hr), _message(msg) { }
 
 #ifdef _DEPRECATED_
 
@@ -15,6 +15,11 @@ namespace CS
 		Exception(HRESULT hr, string msg);
 		
 		const HRESULT HResult;
+
+		const char* what() const noexcept override { return _message.c_str(); }
+
+	private:
+		string _message;
 	};
 
 	class ArgumentException : public Exception
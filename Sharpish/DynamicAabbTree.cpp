@@ -0,0 +1,493 @@
+#include "Sharpish.h"
+#include "DynamicAabbTree.h"
+#include "MathParallel.h"
+#include <algorithm>
+
+using namespace CS;
+using namespace std;
+
+namespace
+{
+	// Proxies per piece of work when fat boxes are checked or pairs found across threads
+	const size_t MoveGranularity = 1024;
+	const size_t PairGranularity = 256;
+	const int QueryStackSize = 128;
+
+	// Half the surface area
+	inline float Area(const BoundingBoxA& box)
+	{
+		Float3A size = box.GetSize();
+		return size.GetX() * size.GetY() + size.GetY() * size.GetZ() + size.GetZ() * size.GetX();
+	}
+
+	inline bool Encloses(const BoundingBoxA& outer, const BoundingBoxA& inner)
+	{
+		return (outer.Minima.GetComponentWise() <= inner.Minima).All() && (outer.Maxima.GetComponentWise() >= inner.Maxima).All();
+	}
+
+	inline bool Touches(const BoundingBoxA& a, const BoundingBoxA& b)
+	{
+		return (a.Minima.GetComponentWise() <= b.Maxima).All() && (a.Maxima.GetComponentWise() >= b.Minima).All();
+	}
+}
+
+DynamicAabbTree::DynamicAabbTree(float margin) :
+	_root(None),
+	_free(None),
+	_count(0),
+	_margin(margin)
+{
+	if (!(margin >= 0))
+		throw ArgumentException("margin", "Margin must not be negative");
+}
+
+DynamicAabbTree::ProxyId DynamicAabbTree::Insert(const BoundingBoxA& box)
+{
+	if (!box.GetExists())
+		throw ArgumentException("box", "Box holds nothing");
+
+	int leaf = Allocate();
+	_nodes[leaf].Box = Fatten(box, Float3A::Zero);
+	InsertLeaf(leaf);
+	_count++;
+	return leaf;
+}
+
+void DynamicAabbTree::Remove(ProxyId proxy)
+{
+	Validate(proxy, "proxy");
+	RemoveLeaf(proxy);
+	Free(proxy);
+	_count--;
+}
+
+bool DynamicAabbTree::Move(ProxyId proxy, const BoundingBoxA& box)
+{
+	return Move(proxy, box, Float3A::Zero);
+}
+
+bool DynamicAabbTree::Move(ProxyId proxy, const BoundingBoxA& box, const Float3A& displacement)
+{
+	Validate(proxy, "proxy");
+	if (!box.GetExists())
+		throw ArgumentException("box", "Box holds nothing");
+
+	if (Encloses(_nodes[proxy].Box, box))
+		return false;
+
+	RemoveLeaf(proxy);
+	_nodes[proxy].Box = Fatten(box, displacement);
+	InsertLeaf(proxy);
+	return true;
+}
+
+size_t DynamicAabbTree::MoveMany(const ProxyId* proxies, const BoundingBoxA* boxes, size_t count,
+	vector<ProxyId>* outReinserted, bool parallel)
+{
+	if (count == 0)
+		return 0;
+	if (!proxies)
+		throw ArgumentNullException("proxies");
+	if (!boxes)
+		throw ArgumentNullException("boxes");
+
+	for (size_t i = 0; i < count; i++)
+	{
+		Validate(proxies[i], "proxies");
+		if (!boxes[i].GetExists())
+			throw ArgumentException("boxes", "Box holds nothing");
+	}
+
+	// Only the check is parallel; reinsertion changes the tree and is cheap for the few that escaped
+	vector<uint8_t> escaped(count);
+	auto check = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			escaped[i] = !Encloses(_nodes[proxies[i]].Box, boxes[i]);
+	};
+
+	Details::ParallelFor(count, MoveGranularity, parallel, check);
+
+	size_t reinserted = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		// Checked again in case the same proxy appears twice
+		ProxyId proxy = proxies[i];
+		if (!escaped[i] || Encloses(_nodes[proxy].Box, boxes[i]))
+			continue;
+
+		RemoveLeaf(proxy);
+		_nodes[proxy].Box = Fatten(boxes[i], Float3A::Zero);
+		InsertLeaf(proxy);
+		reinserted++;
+
+		if (outReinserted)
+			outReinserted->push_back(proxy);
+	}
+
+	return reinserted;
+}
+
+const BoundingBoxA& DynamicAabbTree::GetFatBox(ProxyId proxy) const
+{
+	Validate(proxy, "proxy");
+	return _nodes[proxy].Box;
+}
+
+template<typename F>
+void DynamicAabbTree::Query(const BoundingBoxA& box, const F& visit) const
+{
+	if (_root == None)
+		return;
+
+	// Balancing keeps proxies a few dozen levels deep at most; the overflow only guards against the unforeseen
+	int stack[QueryStackSize];
+	vector<int> overflow;
+	int top = 0;
+	stack[top++] = _root;
+
+	while (top > 0 || !overflow.empty())
+	{
+		int node;
+		if (!overflow.empty())
+		{
+			node = overflow.back();
+			overflow.pop_back();
+		}
+		else
+		{
+			node = stack[--top];
+		}
+
+		const Node& n = _nodes[node];
+		if (!Touches(n.Box, box))
+			continue;
+
+		if (n.Child1 == None)
+		{
+			visit(node);
+			continue;
+		}
+
+		for (int child : { n.Child1, n.Child2 })
+		{
+			if (top < QueryStackSize)
+				stack[top++] = child;
+			else
+				overflow.push_back(child);
+		}
+	}
+}
+
+size_t DynamicAabbTree::Overlap(const BoundingBoxA& box, vector<ProxyId>& outProxies) const
+{
+	size_t start = outProxies.size();
+	Query(box, [&](int leaf) { outProxies.push_back(leaf); });
+	return outProxies.size() - start;
+}
+
+size_t DynamicAabbTree::FindPairs(vector<pair<ProxyId, ProxyId>>& outPairs, bool parallel) const
+{
+	vector<ProxyId> leaves;
+	leaves.reserve(_count);
+	for (int i = 0; i < (int)_nodes.size(); i++)
+		if (_nodes[i].Height == 0)
+			leaves.push_back(i);
+
+	size_t start = outPairs.size();
+	Details::ParallelCollect(leaves.size(), PairGranularity, parallel, outPairs, [&](size_t begin, size_t end, vector<pair<ProxyId, ProxyId>>& pairs)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			ProxyId first = leaves[i];
+			size_t firstPair = pairs.size();
+			Query(_nodes[first].Box, [&](int other) { if (other > first) pairs.emplace_back(first, other); });
+			sort(pairs.begin() + firstPair, pairs.end());
+		}
+	});
+	return outPairs.size() - start;
+}
+
+size_t DynamicAabbTree::FindPairs(const ProxyId* proxies, size_t count, vector<pair<ProxyId, ProxyId>>& outPairs, bool parallel) const
+{
+	if (count == 0)
+		return 0;
+	if (!proxies)
+		throw ArgumentNullException("proxies");
+
+	for (size_t i = 0; i < count; i++)
+		Validate(proxies[i], "proxies");
+
+	vector<ProxyId> moved(proxies, proxies + count);
+	sort(moved.begin(), moved.end());
+	moved.erase(unique(moved.begin(), moved.end()), moved.end());
+
+	// A pair of two listed proxies is reported only from the query of the lower one
+	size_t start = outPairs.size();
+	Details::ParallelCollect(moved.size(), PairGranularity, parallel, outPairs, [&](size_t begin, size_t end, vector<pair<ProxyId, ProxyId>>& pairs)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			ProxyId proxy = moved[i];
+			Query(_nodes[proxy].Box, [&](int other)
+			{
+				if (other == proxy || (other < proxy && binary_search(moved.begin(), moved.end(), other)))
+					return;
+				pairs.emplace_back(min(proxy, other), max(proxy, other));
+			});
+		}
+	});
+	return outPairs.size() - start;
+}
+
+bool DynamicAabbTree::Contains(ProxyId proxy) const
+{
+	return proxy >= 0 && proxy < (int)_nodes.size() && _nodes[proxy].Height == 0;
+}
+
+int DynamicAabbTree::Allocate()
+{
+	int node;
+
+	if (_free == None)
+	{
+		node = (int)_nodes.size();
+		_nodes.emplace_back();
+	}
+	else
+	{
+		node = _free;
+		_free = _nodes[node].Parent;
+	}
+
+	Node& n = _nodes[node];
+	n.Parent = None;
+	n.Child1 = None;
+	n.Child2 = None;
+	n.Height = 0;
+	return node;
+}
+
+void DynamicAabbTree::Free(int node)
+{
+	_nodes[node].Height = -1;
+	_nodes[node].Parent = _free;
+	_free = node;
+}
+
+void DynamicAabbTree::Validate(ProxyId proxy, const char* argName) const
+{
+	if (!Contains(proxy))
+		throw ArgumentException(argName, "Not a proxy in this tree");
+}
+
+BoundingBoxA DynamicAabbTree::Fatten(const BoundingBoxA& box, const Float3A& displacement) const
+{
+	Float3A margin(_margin);
+	BoundingBoxA fat(box.Minima - margin, box.Maxima + margin);
+	return fat.Combine(BoundingBoxA(fat.Minima + displacement, fat.Maxima + displacement));
+}
+
+void DynamicAabbTree::InsertLeaf(int leaf)
+{
+	if (_root == None)
+	{
+		_root = leaf;
+		_nodes[leaf].Parent = None;
+		return;
+	}
+
+	// Descend to the sibling where the leaf adds the least area: the new parent's area plus the growth it causes
+	// in every ancestor
+	BoundingBoxA box = _nodes[leaf].Box;
+	int sibling = _root;
+
+	while (_nodes[sibling].Child1 != None)
+	{
+		const Node& node = _nodes[sibling];
+		float area = Area(node.Box);
+		float combinedArea = Area(node.Box.Combine(box));
+
+		// Making the leaf a sibling of this node, or pushing it further down
+		float cost = 2 * combinedArea;
+		float inheritedCost = 2 * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { node.Child1, node.Child2 };
+		for (int i = 0; i < 2; i++)
+		{
+			const Node& child = _nodes[children[i]];
+			float grown = Area(child.Box.Combine(box));
+			childCost[i] = (child.Child1 == None ? grown : grown - Area(child.Box)) + inheritedCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+
+		sibling = childCost[0] <= childCost[1] ? children[0] : children[1];
+	}
+
+	int oldParent = _nodes[sibling].Parent;
+	int newParent = Allocate();
+
+	Node& parent = _nodes[newParent];
+	parent.Parent = oldParent;
+	parent.Box = box.Combine(_nodes[sibling].Box);
+	parent.Height = _nodes[sibling].Height + 1;
+	parent.Child1 = sibling;
+	parent.Child2 = leaf;
+
+	if (oldParent == None)
+		_root = newParent;
+	else if (_nodes[oldParent].Child1 == sibling)
+		_nodes[oldParent].Child1 = newParent;
+	else
+		_nodes[oldParent].Child2 = newParent;
+
+	_nodes[sibling].Parent = newParent;
+	_nodes[leaf].Parent = newParent;
+
+	Refit(oldParent);
+}
+
+void DynamicAabbTree::RemoveLeaf(int leaf)
+{
+	if (leaf == _root)
+	{
+		_root = None;
+		return;
+	}
+
+	int parent = _nodes[leaf].Parent;
+	int grandParent = _nodes[parent].Parent;
+	int sibling = _nodes[parent].Child1 == leaf ? _nodes[parent].Child2 : _nodes[parent].Child1;
+
+	_nodes[sibling].Parent = grandParent;
+	if (grandParent == None)
+		_root = sibling;
+	else if (_nodes[grandParent].Child1 == parent)
+		_nodes[grandParent].Child1 = sibling;
+	else
+		_nodes[grandParent].Child2 = sibling;
+
+	Free(parent);
+	Refit(grandParent);
+}
+
+void DynamicAabbTree::Refit(int node)
+{
+	// Up to the root, balancing each ancestor and then recomputing its box and height from its children
+	while (node != None)
+	{
+		node = Balance(node);
+
+		Node& n = _nodes[node];
+		const Node& child1 = _nodes[n.Child1];
+		const Node& child2 = _nodes[n.Child2];
+		n.Height = 1 + max(child1.Height, child2.Height);
+		n.Box = child1.Box.Combine(child2.Box);
+
+		node = n.Parent;
+	}
+}
+
+int DynamicAabbTree::Balance(int iA)
+{
+	Node& a = _nodes[iA];
+	if (a.Child1 == None || a.Height < 2)
+		return iA;
+
+	int iB = a.Child1;
+	int iC = a.Child2;
+	Node& b = _nodes[iB];
+	Node& c = _nodes[iC];
+	int balance = c.Height - b.Height;
+
+	if (balance > 1)
+	{
+		// Rotate C up: A takes C's place and keeps B and the shorter of C's children
+		int iF = c.Child1;
+		int iG = c.Child2;
+		Node& f = _nodes[iF];
+		Node& g = _nodes[iG];
+
+		c.Child1 = iA;
+		c.Parent = a.Parent;
+		a.Parent = iC;
+
+		if (c.Parent == None)
+			_root = iC;
+		else if (_nodes[c.Parent].Child1 == iA)
+			_nodes[c.Parent].Child1 = iC;
+		else
+			_nodes[c.Parent].Child2 = iC;
+
+		if (f.Height > g.Height)
+		{
+			c.Child2 = iF;
+			a.Child2 = iG;
+			g.Parent = iA;
+			a.Box = b.Box.Combine(g.Box);
+			c.Box = a.Box.Combine(f.Box);
+			a.Height = 1 + max(b.Height, g.Height);
+			c.Height = 1 + max(a.Height, f.Height);
+		}
+		else
+		{
+			c.Child2 = iG;
+			a.Child2 = iF;
+			f.Parent = iA;
+			a.Box = b.Box.Combine(f.Box);
+			c.Box = a.Box.Combine(g.Box);
+			a.Height = 1 + max(b.Height, f.Height);
+			c.Height = 1 + max(a.Height, g.Height);
+		}
+
+		return iC;
+	}
+
+	if (balance < -1)
+	{
+		// Rotate B up, the mirror image
+		int iD = b.Child1;
+		int iE = b.Child2;
+		Node& d = _nodes[iD];
+		Node& e = _nodes[iE];
+
+		b.Child1 = iA;
+		b.Parent = a.Parent;
+		a.Parent = iB;
+
+		if (b.Parent == None)
+			_root = iB;
+		else if (_nodes[b.Parent].Child1 == iA)
+			_nodes[b.Parent].Child1 = iB;
+		else
+			_nodes[b.Parent].Child2 = iB;
+
+		if (d.Height > e.Height)
+		{
+			b.Child2 = iD;
+			a.Child1 = iE;
+			e.Parent = iA;
+			a.Box = c.Box.Combine(e.Box);
+			b.Box = a.Box.Combine(d.Box);
+			a.Height = 1 + max(c.Height, e.Height);
+			b.Height = 1 + max(a.Height, d.Height);
+		}
+		else
+		{
+			b.Child2 = iE;
+			a.Child1 = iD;
+			d.Parent = iA;
+			a.Box = c.Box.Combine(d.Box);
+			b.Box = a.Box.Combine(e.Box);
+			a.Height = 1 + max(c.Height, d.Height);
+			b.Height = 1 + max(a.Height, e.Height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
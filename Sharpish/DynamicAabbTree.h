@@ -0,0 +1,96 @@
+#pragma once
+
+namespace CS
+{
+	// A bounding volume hierarchy for moving objects, e.g. the broadphase of a physics simulation.
+	//
+	// Each object (a proxy) is stored as a fat box: its box grown by a margin on every side, and optionally
+	// stretched along its displacement. Moving an object costs nothing while its box stays inside the fat box;
+	// only objects that leave it are removed and reinserted, so the cost of an update follows how much moves rather
+	// than how many objects there are. Insertion descends to the sibling that adds the least surface area, and
+	// tree rotations keep the height balanced as proxies come and go.
+	//
+	// Queries and pairs are found against the fat boxes, so they are conservative by up to the margin.
+	class DynamicAabbTree
+	{
+	public:
+		typedef int ProxyId;
+		static const ProxyId None = -1;
+
+		explicit DynamicAabbTree(float margin = 0.1f);
+
+		// Ids stay valid until the proxy is removed and may be reused afterwards. Throws ArgumentException if box
+		// holds nothing.
+		ProxyId Insert(const BoundingBoxA& box);
+		void Remove(ProxyId proxy);
+
+		// Updates the proxy's box, reinserting it with a new fat box if box has left the current one. The fat box is
+		// stretched along displacement (e.g. the expected motion over the next few steps) so fast objects need
+		// reinserting less often. Returns whether the proxy was reinserted.
+		bool Move(ProxyId proxy, const BoundingBoxA& box);
+		bool Move(ProxyId proxy, const BoundingBoxA& box, const Float3A& displacement);
+
+		// Moves many proxies at once. The fat boxes are checked across worker threads unless parallel is false, and
+		// only the proxies that left theirs are reinserted. Their ids are appended to outReinserted, if given, in
+		// the order they appear in proxies; pass them to FindPairs to find the pairs that may have begun. Returns
+		// the number reinserted.
+		size_t MoveMany(const ProxyId* proxies, const BoundingBoxA* boxes, size_t count,
+			std::vector<ProxyId>* outReinserted = nullptr, bool parallel = true);
+
+		PROPERTY_INDEXABLE_READONLY(BoundingBoxA, FatBox);
+		const BoundingBoxA& GetFatBox(ProxyId proxy) const;
+
+		// Proxies whose fat boxes touch box, appended to outProxies. Returns how many were appended.
+		size_t Overlap(const BoundingBoxA& box, std::vector<ProxyId>& outProxies) const;
+
+		// Every pair of proxies whose fat boxes touch, each once with first < second, appended to outPairs in order
+		// of first. Proxies are queried against the tree across worker threads unless parallel is false. Returns
+		// how many were appended.
+		size_t FindPairs(std::vector<std::pair<ProxyId, ProxyId>>& outPairs, bool parallel = true) const;
+		// Only the pairs that involve at least one of proxies, such as those just reinserted, each once with first <
+		// second and in no particular order
+		size_t FindPairs(const ProxyId* proxies, size_t count, std::vector<std::pair<ProxyId, ProxyId>>& outPairs, bool parallel = true) const;
+
+		bool Contains(ProxyId proxy) const;
+
+		PROPERTY_READONLY(size_t, Count);
+		size_t GetCount() const { return _count; }
+
+		// The number of nodes on the longest path from the root to a proxy, or 0 when empty
+		PROPERTY_READONLY(int, Height);
+		int GetHeight() const { return _root == None ? 0 : _nodes[_root].Height + 1; }
+
+		PROPERTY_READONLY(float, Margin);
+		float GetMargin() const { return _margin; }
+
+	private:
+		// Leaves are proxies and have no children. Freed nodes have a negative Height and link the free list
+		// through Parent.
+		struct Node
+		{
+			BoundingBoxA Box;
+			int Parent;
+			int Child1;
+			int Child2;
+			int Height;
+		};
+
+		std::vector<Node> _nodes;
+		int _root;
+		int _free;
+		size_t _count;
+		float _margin;
+
+		int Allocate();
+		void Free(int node);
+		void Validate(ProxyId proxy, const char* argName) const;
+		BoundingBoxA Fatten(const BoundingBoxA& box, const Float3A& displacement) const;
+		void InsertLeaf(int leaf);
+		void RemoveLeaf(int leaf);
+		// Rotates node's taller child up if the children's heights differ by more than one. Returns the node now
+		// in its place.
+		int Balance(int node);
+		void Refit(int node);
+		template<typename F> void Query(const BoundingBoxA& box, const F& visit) const;
+	};
+}
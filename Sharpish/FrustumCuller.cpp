@@ -0,0 +1,271 @@
+#include "Sharpish.h"
+#include "FrustumCuller.h"
+#include "MathDispatch.h"
+#include "MathParallel.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// ::PUBLICLIB::
+
+using namespace CS;
+using namespace std;
+
+namespace
+{
+	// Batches at least this large are split across threads. A multiple of 32, so each thread writes whole words
+	// of the mask.
+	const size_t CullGranularity = 8192;
+
+	inline bool SphereVisible(const float* planes, float x, float y, float z, float r)
+	{
+		for (int p = 0; p < FrustumCuller::PlaneCount; p++, planes += 4)
+		{
+			if (planes[0] * x + planes[1] * y + planes[2] * z + planes[3] < -r)
+				return false;
+		}
+
+		return true;
+	}
+
+	// Culled if even the corner furthest along the plane's normal is outside it
+	inline bool BoxVisible(const float* planes, const float* minima, const float* maxima)
+	{
+		for (int p = 0; p < FrustumCuller::PlaneCount; p++, planes += 4)
+		{
+			float d = planes[3];
+			for (int k = 0; k < 3; k++)
+				d += planes[k] * (planes[k] > 0 ? maxima[k] : minima[k]);
+
+			if (d < 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	// Volume sources for CullKernel, loaded into lanes by CullSource. Padded sources are streams whose padding can
+	// be read as whole registers; the others test their last few volumes one at a time.
+	struct SphereArray
+	{
+		static const bool Padded = false;
+		const float* P;
+		size_t Stride;
+
+		inline void Offset(size_t n) { P += n * Stride; }
+
+		inline bool IsVisible(const float* planes, size_t i) const
+		{
+			auto s = P + i * Stride;
+			return SphereVisible(planes, s[0], s[1], s[2], s[3]);
+		}
+	};
+
+	struct SphereStream
+	{
+		static const bool Padded = true;
+		const float* X;
+		const float* Y;
+		const float* Z;
+		const float* R;
+
+		inline void Offset(size_t n) { X += n; Y += n; Z += n; R += n; }
+
+		inline bool IsVisible(const float*, size_t) const { return true; }
+	};
+
+	struct BoxArray
+	{
+		static const bool Padded = false;
+		const float* P;
+
+		inline void Offset(size_t n) { P += n * 8; }
+
+		inline bool IsVisible(const float* planes, size_t i) const { return BoxVisible(planes, P + i * 8, P + i * 8 + 4); }
+	};
+
+	struct BoxStream
+	{
+		static const bool Padded = true;
+		const float* MinX;
+		const float* MinY;
+		const float* MinZ;
+		const float* MaxX;
+		const float* MaxY;
+		const float* MaxZ;
+
+		inline void Offset(size_t n) { MinX += n; MinY += n; MinZ += n; MaxX += n; MaxY += n; MaxZ += n; }
+
+		inline bool IsVisible(const float*, size_t) const { return true; }
+	};
+
+	// Primitives given by two points per element (endpoints, or origin and direction) and a radius, or slope, per
+	// element. Radii may be null for zero; they're a plain array, so the last register is read through a copy.
+	struct SweptStream
+	{
+		static const bool Padded = true;
+		const float* AX;
+		const float* AY;
+		const float* AZ;
+		const float* BX;
+		const float* BY;
+		const float* BZ;
+		const float* Radii;
+		size_t Count;
+
+		inline void Offset(size_t n) { AX += n; AY += n; AZ += n; BX += n; BY += n; BZ += n; if (Radii) Radii += n; Count -= n; }
+
+		inline bool IsVisible(const float*, size_t) const { return true; }
+	};
+
+	enum class SweptKind { Line, Ray, Segment };
+
+	// The tests CullKernel applies, defined for lanes by CullTest
+	struct SphereTest { };
+	struct BoxTest { };
+	template<SweptKind K> struct SweptTest { };
+	struct ConeTest { };
+}
+
+#define SHARPISH_KERNELS "FrustumCullerKernels.inl"
+#include "MathKernels.h"
+
+namespace
+{
+	SweptStream MakeSwept(const Float3Stream& a, const Float3Stream& b, const float* radii)
+	{
+		if (a.size() != b.size()) throw ArgumentException("b", "Stream sizes differ");
+
+		SweptStream source = { a.GetX(), a.GetY(), a.GetZ(), b.GetX(), b.GetY(), b.GetZ(), radii, a.size() };
+		return source;
+	}
+
+	template<typename T, typename S>
+	void RunCull(const Float4A* planes, const S& source, size_t count, uint32_t* outVisible, bool parallel)
+	{
+		auto kernel = SHARPISH_KERNEL(CullKernel<T, S>)::Get();
+		auto p = (const float*)planes;
+
+		Details::ParallelFor(count, CullGranularity, parallel, [&](size_t begin, size_t end)
+		{
+			S offset = source;
+			offset.Offset(begin);
+			kernel(p, offset, end - begin, outVisible + begin / 32);
+		});
+	}
+}
+
+FrustumCuller::FrustumCuller()
+{
+	for (int p = 0; p < PlaneCount; p++)
+		_planes[p] = Float4A::Zero;
+}
+
+FrustumCuller::FrustumCuller(const Float4x4A& viewProjection)
+{
+	// Clip space is -w <= x <= w, -w <= y <= w, 0 <= z <= w, where each clip coordinate is the dot product of
+	// (x, y, z, 1) with a column of the matrix
+	XMMATRIX t = XMMatrixTranspose(viewProjection);
+	_planes[Left] = XMVectorAdd(t.r[3], t.r[0]);
+	_planes[Right] = XMVectorSubtract(t.r[3], t.r[0]);
+	_planes[Bottom] = XMVectorAdd(t.r[3], t.r[1]);
+	_planes[Top] = XMVectorSubtract(t.r[3], t.r[1]);
+	_planes[Near] = t.r[2];
+	_planes[Far] = XMVectorSubtract(t.r[3], t.r[2]);
+
+	for (int p = 0; p < PlaneCount; p++)
+	{
+		float length = XMVectorGetX(XMVector3Length(_planes[p]));
+		_planes[p] = length > 0 ? XMVectorScale(_planes[p], 1 / length) : XMVectorZero();
+	}
+}
+
+bool FrustumCuller::IsVisible(const BoundingSphereA& sphere) const
+{
+	Float4 s = (const Float4A&)sphere;
+	return SphereVisible((const float*)_planes, s.X, s.Y, s.Z, s.W);
+}
+
+bool FrustumCuller::IsVisible(const BoundingSphere& sphere) const
+{
+	const Float4& s = sphere;
+	return SphereVisible((const float*)_planes, s.X, s.Y, s.Z, s.W);
+}
+
+bool FrustumCuller::IsVisible(const BoundingBoxA& box) const
+{
+	return BoxVisible((const float*)_planes, (const float*)&box.Minima, (const float*)&box.Maxima);
+}
+
+void FrustumCuller::Cull(const BoundingSphere* spheres, size_t count, uint32_t* outVisible, bool parallel) const
+{
+	RunCull<SphereTest>(_planes, SphereArray { (const float*)spheres, sizeof(BoundingSphere) / sizeof(float) }, count, outVisible, parallel);
+}
+
+void FrustumCuller::Cull(const BoundingSphereA* spheres, size_t count, uint32_t* outVisible, bool parallel) const
+{
+	RunCull<SphereTest>(_planes, SphereArray { (const float*)spheres, sizeof(BoundingSphereA) / sizeof(float) }, count, outVisible, parallel);
+}
+
+void FrustumCuller::Cull(const BoundingBoxA* boxes, size_t count, uint32_t* outVisible, bool parallel) const
+{
+	RunCull<BoxTest>(_planes, BoxArray { (const float*)boxes }, count, outVisible, parallel);
+}
+
+void FrustumCuller::Cull(const Float4Stream& spheres, uint32_t* outVisible, bool parallel) const
+{
+	RunCull<SphereTest>(_planes, SphereStream { spheres.GetX(), spheres.GetY(), spheres.GetZ(), spheres.GetW() }, spheres.size(), outVisible, parallel);
+}
+
+void FrustumCuller::Cull(const Float3Stream& minima, const Float3Stream& maxima, uint32_t* outVisible, bool parallel) const
+{
+	if (minima.size() != maxima.size()) throw ArgumentException("maxima", "Stream sizes differ");
+
+	BoxStream source = { minima.GetX(), minima.GetY(), minima.GetZ(), maxima.GetX(), maxima.GetY(), maxima.GetZ() };
+	RunCull<BoxTest>(_planes, source, minima.size(), outVisible, parallel);
+}
+
+size_t FrustumCuller::Compact(const uint32_t* mask, size_t count, uint32_t* outIndices)
+{
+	size_t written = 0;
+
+	for (size_t w = 0; w * 32 < count; w++)
+	{
+		uint32_t bits = mask[w];
+		if (count - w * 32 < 32)
+			bits &= (1u << (count - w * 32)) - 1;
+
+		for (; bits; bits &= bits - 1)
+			outIndices[written++] = (uint32_t)(w * 32 + Details::LowestBit(bits));
+	}
+
+	return written;
+}
+
+void FrustumCuller::CullLineSegs(const Float3Stream& pointsA, const Float3Stream& pointsB, uint32_t* outVisible, bool parallel) const
+{
+	RunCull<SweptTest<SweptKind::Segment>>(_planes, MakeSwept(pointsA, pointsB, nullptr), pointsA.size(), outVisible, parallel);
+}
+
+void FrustumCuller::CullCylinders(const Float3Stream& pointsA, const Float3Stream& pointsB, const float* radii, uint32_t* outVisible, bool parallel) const
+{
+	RunCull<SweptTest<SweptKind::Segment>>(_planes, MakeSwept(pointsA, pointsB, radii), pointsA.size(), outVisible, parallel);
+}
+
+void FrustumCuller::CullThickLines(const Float3Stream& anchors, const Float3Stream& directions, const float* radii, uint32_t* outVisible, bool parallel) const
+{
+	RunCull<SweptTest<SweptKind::Line>>(_planes, MakeSwept(anchors, directions, radii), anchors.size(), outVisible, parallel);
+}
+
+void FrustumCuller::CullThickRays(const Float3Stream& origins, const Float3Stream& directions, const float* radii, uint32_t* outVisible, bool parallel) const
+{
+	RunCull<SweptTest<SweptKind::Ray>>(_planes, MakeSwept(origins, directions, radii), origins.size(), outVisible, parallel);
+}
+
+void FrustumCuller::CullCones(const Float3Stream& origins, const Float3Stream& directions, const float* slopes, uint32_t* outVisible, bool parallel) const
+{
+	if (!slopes) throw ArgumentNullException("slopes");
+
+	RunCull<ConeTest>(_planes, MakeSwept(origins, directions, slopes), origins.size(), outVisible, parallel);
+}
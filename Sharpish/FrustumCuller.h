@@ -0,0 +1,59 @@
+#pragma once
+
+namespace CS
+{
+	// Visibility testing of bounding volumes against a view frustum. The six planes are extracted from a
+	// view-projection matrix (row-vector convention, clip depth in [0, w] as DirectXMath builds them) and
+	// normalized once, so a plane's distance is in world units. Tests are conservative: a volume is culled only if
+	// it lies wholly outside one plane, so some volumes near the frustum's edges pass without being visible.
+	//
+	// The batch Cull methods test several volumes at a time in SIMD registers and split large batches across
+	// worker threads unless parallel is false. They write one bit per volume, set if it may be visible: bit i % 32
+	// of outVisible[i / 32], with (count + 31) / 32 words written and unused bits of the last word clear. Compact
+	// turns such a mask into a list of indices.
+	class FrustumCuller
+	{
+	public:
+		enum PlaneIndex { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+		FrustumCuller();
+		explicit FrustumCuller(const Float4x4A& viewProjection);
+
+		// (a, b, c, d) with a unit normal (a, b, c) facing into the frustum. A plane at infinity is all zero.
+		PROPERTY_INDEXABLE_READONLY(Float4A, Plane);
+		inline Float4A __vectorcall GetPlane(int i) const { assert(i >= 0 && i < PlaneCount); return _planes[i]; }
+
+		bool __vectorcall IsVisible(const BoundingSphereA& sphere) const;
+		bool IsVisible(const BoundingSphere& sphere) const;
+		bool __vectorcall IsVisible(const BoundingBoxA& box) const;
+
+		void Cull(const BoundingSphere* spheres, size_t count, uint32_t* outVisible, bool parallel = true) const;
+		void Cull(const BoundingSphereA* spheres, size_t count, uint32_t* outVisible, bool parallel = true) const;
+		void Cull(const BoundingBoxA* boxes, size_t count, uint32_t* outVisible, bool parallel = true) const;
+		// Spheres as centers in X, Y and Z and radii in W
+		void Cull(const Float4Stream& spheres, uint32_t* outVisible, bool parallel = true) const;
+		// Boxes as their minima and maxima
+		void Cull(const Float3Stream& minima, const Float3Stream& maxima, uint32_t* outVisible, bool parallel = true) const;
+
+		// Swept primitives as SoA streams, with a radius (or slope) per element in a plain array of the streams'
+		// size. The radius of thick lines, rays and cylinders may be null for zero. Lines, rays and segments are
+		// culled exactly; thick ones are culled as if the frustum's planes moved out by the radius, and cylinders
+		// as the capsules around them.
+		void CullLineSegs(const Float3Stream& pointsA, const Float3Stream& pointsB, uint32_t* outVisible, bool parallel = true) const;
+		void CullCylinders(const Float3Stream& pointsA, const Float3Stream& pointsB, const float* radii, uint32_t* outVisible, bool parallel = true) const;
+		// Points anchor + t * direction for any t
+		void CullThickLines(const Float3Stream& anchors, const Float3Stream& directions, const float* radii, uint32_t* outVisible, bool parallel = true) const;
+		// Points origin + t * direction for t >= 0
+		void CullThickRays(const Float3Stream& origins, const Float3Stream& directions, const float* radii, uint32_t* outVisible, bool parallel = true) const;
+		// Cones with their apex at origin and their base disc centered at origin + direction, with radius
+		// slope * |direction|, e.g. spotlight volumes. Tested as apex and base disc against each plane.
+		void CullCones(const Float3Stream& origins, const Float3Stream& directions, const float* slopes, uint32_t* outVisible, bool parallel = true) const;
+
+		// Writes the index of each set bit among the first count bits of mask to outIndices, in ascending order,
+		// and returns how many were written. outIndices needs room for count indices.
+		static size_t Compact(const uint32_t* mask, size_t count, uint32_t* outIndices);
+
+	private:
+		Float4A _planes[PlaneCount];
+	};
+}
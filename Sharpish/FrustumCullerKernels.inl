@@ -0,0 +1,246 @@
+// The batch kernels of FrustumCuller.cpp, defined for each lane width by MathKernels.h
+
+	// Loads a register of volumes from a source. Boxes are loaded as center and half size.
+	template<typename S>
+	struct CullSource;
+
+	template<typename L>
+	inline void ToCenterExtent(typename L::V minX, typename L::V minY, typename L::V minZ, typename L::V maxX, typename L::V maxY, typename L::V maxZ,
+		typename L::V& cx, typename L::V& cy, typename L::V& cz, typename L::V& ex, typename L::V& ey, typename L::V& ez)
+	{
+		auto half = L::Splat(0.5f);
+		cx = L::Mul(L::Add(minX, maxX), half); ex = L::Mul(L::Sub(maxX, minX), half);
+		cy = L::Mul(L::Add(minY, maxY), half); ey = L::Mul(L::Sub(maxY, minY), half);
+		cz = L::Mul(L::Add(minZ, maxZ), half); ez = L::Mul(L::Sub(maxZ, minZ), half);
+	}
+
+	template<>
+	struct CullSource<SphereArray>
+	{
+		template<typename L>
+		static inline void Load(const SphereArray& s, size_t i, typename L::V& x, typename L::V& y, typename L::V& z, typename L::V& r)
+		{
+			Details::AosLanes<L>::Load4(s.P + i * s.Stride, s.Stride, x, y, z, r);
+		}
+	};
+
+	template<>
+	struct CullSource<SphereStream>
+	{
+		template<typename L>
+		static inline void Load(const SphereStream& s, size_t i, typename L::V& x, typename L::V& y, typename L::V& z, typename L::V& r)
+		{
+			x = L::Load(s.X + i); y = L::Load(s.Y + i); z = L::Load(s.Z + i); r = L::Load(s.R + i);
+		}
+	};
+
+	template<>
+	struct CullSource<BoxArray>
+	{
+		template<typename L>
+		static inline void Load(const BoxArray& s, size_t i, typename L::V& cx, typename L::V& cy, typename L::V& cz, typename L::V& ex, typename L::V& ey, typename L::V& ez)
+		{
+			typename L::V minX, minY, minZ, maxX, maxY, maxZ, unused;
+			Details::AosLanes<L>::Load4(s.P + i * 8, 8, minX, minY, minZ, unused);
+			Details::AosLanes<L>::Load4(s.P + i * 8 + 4, 8, maxX, maxY, maxZ, unused);
+			ToCenterExtent<L>(minX, minY, minZ, maxX, maxY, maxZ, cx, cy, cz, ex, ey, ez);
+		}
+	};
+
+	template<>
+	struct CullSource<BoxStream>
+	{
+		template<typename L>
+		static inline void Load(const BoxStream& s, size_t i, typename L::V& cx, typename L::V& cy, typename L::V& cz, typename L::V& ex, typename L::V& ey, typename L::V& ez)
+		{
+			ToCenterExtent<L>(L::Load(s.MinX + i), L::Load(s.MinY + i), L::Load(s.MinZ + i), L::Load(s.MaxX + i), L::Load(s.MaxY + i), L::Load(s.MaxZ + i),
+				cx, cy, cz, ex, ey, ez);
+		}
+	};
+
+	template<>
+	struct CullSource<SweptStream>
+	{
+		template<typename L>
+		static inline void Load(const SweptStream& s, size_t i, typename L::V* a, typename L::V* b, typename L::V& r)
+		{
+			a[0] = L::Load(s.AX + i); a[1] = L::Load(s.AY + i); a[2] = L::Load(s.AZ + i);
+			b[0] = L::Load(s.BX + i); b[1] = L::Load(s.BY + i); b[2] = L::Load(s.BZ + i);
+
+			if (!s.Radii)
+				r = L::Zero();
+			else if (i + L::Width <= s.Count)
+				r = L::LoadUnaligned(s.Radii + i);
+			else
+			{
+				alignas(64) float tail[L::Width] = { };
+				memcpy(tail, s.Radii + i, sizeof(float) * (s.Count - i));
+				r = L::Load(tail);
+			}
+		}
+	};
+
+	template<typename L>
+	struct PlaneLanes
+	{
+		typename L::V X[FrustumCuller::PlaneCount], Y[FrustumCuller::PlaneCount], Z[FrustumCuller::PlaneCount], D[FrustumCuller::PlaneCount];
+
+		PlaneLanes(const float* planes)
+		{
+			for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+			{
+				X[p] = L::Splat(planes[p * 4]);
+				Y[p] = L::Splat(planes[p * 4 + 1]);
+				Z[p] = L::Splat(planes[p * 4 + 2]);
+				D[p] = L::Splat(planes[p * 4 + 3]);
+			}
+		}
+	};
+
+	// The lanes of a register of volumes that reach inside every plane
+	template<typename T>
+	struct CullTest;
+
+	template<>
+	struct CullTest<SphereTest>
+	{
+		template<typename L, typename S>
+		static inline uint32_t Run(const PlaneLanes<L>& planes, const S& source, size_t i)
+		{
+			typename L::V x, y, z, r;
+			CullSource<S>::template Load<L>(source, i, x, y, z, r);
+			auto outside = L::Less(L::Zero(), L::Zero());
+			auto limit = L::Negate(r);
+
+			for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+			{
+				auto d = L::MulAdd(planes.X[p], x, L::MulAdd(planes.Y[p], y, L::MulAdd(planes.Z[p], z, planes.D[p])));
+				outside = L::MaskOr(outside, L::Less(d, limit));
+			}
+
+			return ~L::MaskBits(outside) & ((1u << L::Width) - 1);
+		}
+	};
+
+	template<>
+	struct CullTest<BoxTest>
+	{
+		// The box reaches inside a plane if its center's distance plus its projected half size is positive
+		template<typename L, typename S>
+		static inline uint32_t Run(const PlaneLanes<L>& planes, const S& source, size_t i)
+		{
+			typename L::V cx, cy, cz, ex, ey, ez;
+			CullSource<S>::template Load<L>(source, i, cx, cy, cz, ex, ey, ez);
+			auto outside = L::Less(L::Zero(), L::Zero());
+
+			for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+			{
+				auto d = L::MulAdd(planes.X[p], cx, L::MulAdd(planes.Y[p], cy, L::MulAdd(planes.Z[p], cz, planes.D[p])));
+				auto reach = L::MulAdd(L::Abs(planes.X[p]), ex, L::MulAdd(L::Abs(planes.Y[p]), ey, L::Mul(L::Abs(planes.Z[p]), ez)));
+				outside = L::MaskOr(outside, L::Less(L::Add(d, reach), L::Zero()));
+			}
+
+			return ~L::MaskBits(outside) & ((1u << L::Width) - 1);
+		}
+	};
+
+	// Clips the primitive's parameter range against each plane moved out by the radius. The primitive is culled if
+	// nothing is left, which is exact for lines, rays and segments and conservative for thick ones: the moved
+	// planes bound everything within the radius of the frustum, and a cylinder lies inside its capsule.
+	template<SweptKind K>
+	struct CullTest<SweptTest<K>>
+	{
+		template<typename L, typename S>
+		static inline uint32_t Run(const PlaneLanes<L>& planes, const S& source, size_t i)
+		{
+			typename L::V a[3], d[3], r;
+			CullSource<S>::template Load<L>(source, i, a, d, r);
+			auto zero = L::Zero();
+
+			if (K == SweptKind::Segment)
+			{
+				for (int k = 0; k < 3; k++)
+					d[k] = L::Sub(d[k], a[k]);
+			}
+
+			auto tMin = K == SweptKind::Line ? L::Splat(-FLT_MAX) : zero;
+			auto tMax = K == SweptKind::Segment ? L::Splat(1) : L::Splat(FLT_MAX);
+			auto outside = L::Less(zero, zero);
+
+			for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+			{
+				// Inside where s + t v >= 0
+				auto s = L::Add(L::MulAdd(planes.X[p], a[0], L::MulAdd(planes.Y[p], a[1], L::MulAdd(planes.Z[p], a[2], planes.D[p]))), r);
+				auto v = L::MulAdd(planes.X[p], d[0], L::MulAdd(planes.Y[p], d[1], L::Mul(planes.Z[p], d[2])));
+				auto t = L::Div(L::Negate(s), v);
+
+				tMin = L::Select(tMin, L::Max(tMin, t), L::Greater(v, zero));
+				tMax = L::Select(tMax, L::Min(tMax, t), L::Less(v, zero));
+				outside = L::MaskOr(outside, L::MaskAnd(L::Less(s, zero), L::LessOrEqual(L::Abs(v), zero)));
+			}
+
+			return L::MaskBits(L::LessOrEqual(tMin, tMax)) & ~L::MaskBits(outside) & ((1u << L::Width) - 1);
+		}
+	};
+
+	// A cone is outside a plane if its apex is and so is the furthest point of its base disc along the normal. The
+	// disc's reach past its center is slope * |d| * sin(angle between n and d) = slope * sqrt(|d|^2 - (n.d)^2).
+	template<>
+	struct CullTest<ConeTest>
+	{
+		template<typename L, typename S>
+		static inline uint32_t Run(const PlaneLanes<L>& planes, const S& source, size_t i)
+		{
+			typename L::V o[3], d[3], slope;
+			CullSource<S>::template Load<L>(source, i, o, d, slope);
+			auto zero = L::Zero();
+			auto lengthSq = L::MulAdd(d[0], d[0], L::MulAdd(d[1], d[1], L::Mul(d[2], d[2])));
+			auto outside = L::Less(zero, zero);
+
+			for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+			{
+				auto apex = L::MulAdd(planes.X[p], o[0], L::MulAdd(planes.Y[p], o[1], L::MulAdd(planes.Z[p], o[2], planes.D[p])));
+				auto along = L::MulAdd(planes.X[p], d[0], L::MulAdd(planes.Y[p], d[1], L::Mul(planes.Z[p], d[2])));
+				auto reach = L::Mul(slope, L::Sqrt(L::Max(zero, L::NegMulAdd(along, along, lengthSq))));
+				auto base = L::Add(L::Add(apex, along), reach);
+				outside = L::MaskOr(outside, L::MaskAnd(L::Less(apex, zero), L::Less(base, zero)));
+			}
+
+			return ~L::MaskBits(outside) & ((1u << L::Width) - 1);
+		}
+	};
+
+	// Writes the visibility of volumes [0, count) of source to mask, which starts on a word boundary
+	template<typename T, typename S>
+	struct CullKernel
+	{
+		template<typename L>
+		static void Run(const float* planes, const S& source, size_t count, uint32_t* mask)
+		{
+			PlaneLanes<L> lanes(planes);
+			size_t blocks = S::Padded ? count : count - count % L::Width;
+			size_t i = 0;
+
+			for (; i < blocks; i += L::Width)
+			{
+				auto bits = CullTest<T>::template Run<L>(lanes, source, i);
+				if (i % 32 == 0)
+					mask[i / 32] = bits << (i % 32);
+				else
+					mask[i / 32] |= bits << (i % 32);
+			}
+
+			for (; i < count; i++)
+			{
+				uint32_t bit = source.IsVisible(planes, i) ? 1u << (i % 32) : 0;
+				if (i % 32 == 0)
+					mask[i / 32] = bit;
+				else
+					mask[i / 32] |= bit;
+			}
+
+			// Padded sources tested whole registers past count
+			if (count % 32)
+				mask[count / 32] &= (1u << (count % 32)) - 1;
+		}
+	};
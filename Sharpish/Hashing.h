@@ -4,7 +4,7 @@
 /// Default hash function provider. 
 ///////////////////////////////////
 
-template<class T, class U> T HashAppend(T& hash, U appendValue) { return hash = (T)(((((UINT64)hash) << 5) | (((UINT64)hash) >> (sizeof(T) * 8 - 5))) ^ (UINT64)appendValue); }
+template<class T, class U> T HashAppend(T& hash, U appendValue) { return hash = (T)(((((uint64_t)hash) << 5) | (((uint64_t)hash) >> (sizeof(T) * 8 - 5))) ^ (uint64_t)appendValue); }
 
 #define DECLARE_HASHABLE(type) namespace std { template<> struct hash<type> : public hash_EveStandard<type> { }; }
 #define DECLARE_HASHABLE_FUNC(type, argname, f) namespace std { template<> struct hash<type> : public hash_EveStandard<type> \
@@ -33,18 +33,4 @@ namespace std
 			return h;
 		}
 	};
-
-	template<>
-	struct hash<UUID>
-	{
-		size_t operator()(const UUID& id) const
-		{
-			auto arr = (const size_t*)&id;
-
-			if (sizeof(size_t) == 8)
-				return arr[0] ^ arr[1];
-			else
-				return arr[0] ^ arr[1] ^ arr[2] ^ arr[3];
-		}
-	};
 }
@@ -0,0 +1,372 @@
+#include "Sharpish.h"
+#include "KdTree.h"
+#include "MathParallel.h"
+#include <algorithm>
+#include <numeric>
+
+// ::PUBLICLIB::
+
+using namespace CS;
+using namespace std;
+
+namespace
+{
+	// Ranges at most this large are built whole by one worker; larger ones are split a level at a time, with the
+	// ranges of each level partitioned across the workers
+	const uint32_t ParallelSubtreeSize = 16384;
+	// Ranges halve at each level, so no search path is longer than 32 levels, and the stack holds at most one
+	// range per level
+	const int StackSize = 64;
+	const size_t BuildGranularity = 4096;
+	const size_t QueryGranularity = 64;
+
+	struct Entry
+	{
+		float P[3];
+		uint32_t Index;
+	};
+
+	struct EntryRange
+	{
+		uint32_t Begin;
+		uint32_t End;
+	};
+
+	// Splits [begin, end) at its median along its widest axis. Returns the median's position.
+	uint32_t Split(Entry* entries, uint8_t* axes, uint32_t begin, uint32_t end)
+	{
+		float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (uint32_t i = begin; i < end; i++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				lo[k] = min(lo[k], entries[i].P[k]);
+				hi[k] = max(hi[k], entries[i].P[k]);
+			}
+		}
+
+		int axis = 0;
+		for (int k = 1; k < 3; k++)
+			if (hi[k] - lo[k] > hi[axis] - lo[axis])
+				axis = k;
+
+		uint32_t mid = begin + (end - begin) / 2;
+		nth_element(entries + begin, entries + mid, entries + end, [axis](const Entry& a, const Entry& b) { return a.P[axis] < b.P[axis]; });
+		axes[mid] = (uint8_t)axis;
+		return mid;
+	}
+
+	void BuildRange(Entry* entries, uint8_t* axes, uint32_t begin, uint32_t end)
+	{
+		while (end - begin > (uint32_t)KdTree::LeafSize)
+		{
+			uint32_t mid = Split(entries, axes, begin, end);
+			BuildRange(entries, axes, begin, mid);
+			begin = mid + 1;
+		}
+	}
+
+	// The k nearest so far as a max-heap on (squared distance, source index), so ties resolve the same way
+	// whatever order the points are visited in
+	typedef pair<float, uint32_t> Candidate;
+}
+
+KdTree::KdTree(const Array<Float3>& points, bool parallel) : KdTree(points.begin(), points.size(), parallel) { }
+
+KdTree::KdTree(const Float3* points, size_t count, bool parallel)
+{
+	if (count == 0)
+		return;
+	if (!points)
+		throw ArgumentNullException("points");
+	if (count > UINT32_MAX)
+		throw ArgumentException("count", "Too many points");
+
+	vector<Entry> entries(count);
+	Details::ParallelFor(count, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			entries[i] = Entry { { points[i].X, points[i].Y, points[i].Z }, (uint32_t)i };
+	});
+
+	_axes.resize(count);
+	Entry* e = entries.data();
+	uint8_t* axes = _axes.data();
+
+	// Large ranges are split level by level, each level's ranges in parallel. The halves of one range are
+	// disjoint from every other's, so the workers never touch the same entries.
+	vector<EntryRange> level(1, EntryRange { 0, (uint32_t)count }), next, subtrees;
+	while (!level.empty())
+	{
+		next.clear();
+		for (const EntryRange& r : level)
+		{
+			if (r.End - r.Begin <= (parallel ? ParallelSubtreeSize : UINT32_MAX))
+				subtrees.push_back(r);
+			else
+				next.push_back(r);
+		}
+
+		vector<uint32_t> mids(next.size());
+		Details::ParallelFor(next.size(), 1, parallel, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+				mids[i] = Split(e, axes, next[i].Begin, next[i].End);
+		});
+
+		level.clear();
+		for (size_t i = 0; i < next.size(); i++)
+		{
+			level.push_back(EntryRange { next[i].Begin, mids[i] });
+			level.push_back(EntryRange { mids[i] + 1, next[i].End });
+		}
+	}
+
+	Details::ParallelFor(subtrees.size(), 1, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			BuildRange(e, axes, subtrees[i].Begin, subtrees[i].End);
+	});
+
+	_points.resize(count);
+	_indices.resize(count);
+	Details::ParallelFor(count, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			_points[i] = Float3(e[i].P[0], e[i].P[1], e[i].P[2]);
+			_indices[i] = e[i].Index;
+		}
+	});
+}
+
+// Calls visit(position, distanceSq) for each point no further than sqrt(rangeSq) from point, nearer side of
+// each split first. visit may shrink rangeSq to prune the rest of the search.
+template<typename F>
+void KdTree::Search(const float* point, float& rangeSq, const F& visit) const
+{
+	if (_points.empty())
+		return;
+
+	struct Pending
+	{
+		uint32_t Begin;
+		uint32_t End;
+		float DistanceSq;
+	};
+
+	Pending stack[StackSize];
+	int top = 0;
+	stack[top++] = Pending { 0, (uint32_t)_points.size(), 0 };
+
+	auto test = [&](uint32_t i)
+	{
+		const Float3& p = _points[i];
+		float dx = p.X - point[0], dy = p.Y - point[1], dz = p.Z - point[2];
+		float distanceSq = dx * dx + dy * dy + dz * dz;
+		if (distanceSq <= rangeSq)
+			visit(i, distanceSq);
+	};
+
+	while (top > 0)
+	{
+		Pending range = stack[--top];
+		if (range.DistanceSq > rangeSq)
+			continue;
+
+		uint32_t begin = range.Begin, end = range.End;
+		while (end - begin > (uint32_t)LeafSize)
+		{
+			uint32_t mid = begin + (end - begin) / 2;
+			int axis = _axes[mid];
+			float d = point[axis] - (&_points[mid].X)[axis];
+			test(mid);
+
+			// The far side is no nearer than the splitting plane
+			Pending far;
+			if (d < 0)
+			{
+				far = Pending { mid + 1, end, d * d };
+				end = mid;
+			}
+			else
+			{
+				far = Pending { begin, mid, d * d };
+				begin = mid + 1;
+			}
+
+			if (far.DistanceSq <= rangeSq)
+				stack[top++] = far;
+		}
+
+		for (uint32_t i = begin; i < end; i++)
+			test(i);
+	}
+}
+
+size_t KdTree::LeafOf(const float* point) const
+{
+	uint32_t begin = 0, end = (uint32_t)_points.size();
+	while (end - begin > (uint32_t)LeafSize)
+	{
+		uint32_t mid = begin + (end - begin) / 2;
+		int axis = _axes[mid];
+		if (point[axis] < (&_points[mid].X)[axis])
+			end = mid;
+		else
+			begin = mid + 1;
+	}
+	return begin;
+}
+
+size_t KdTree::FindNearest(const Float3A& point, size_t k, vector<uint32_t>& outIndices, vector<float>* outDistances, float maxDistance) const
+{
+	if (k == 0 || !(maxDistance >= 0))
+		return 0;
+
+	Float3 p = point;
+	float rangeSq = maxDistance * maxDistance;
+	vector<Candidate> heap;
+	heap.reserve(min(k, _points.size()));
+
+	Search(&p.X, rangeSq, [&](uint32_t i, float distanceSq)
+	{
+		Candidate c(distanceSq, _indices[i]);
+		if (heap.size() == k)
+		{
+			if (!(c < heap.front()))
+				return;
+			pop_heap(heap.begin(), heap.end());
+			heap.pop_back();
+		}
+
+		heap.push_back(c);
+		push_heap(heap.begin(), heap.end());
+		if (heap.size() == k)
+			rangeSq = heap.front().first;
+	});
+
+	sort_heap(heap.begin(), heap.end());
+	for (const Candidate& c : heap)
+	{
+		outIndices.push_back(c.second);
+		if (outDistances)
+			outDistances->push_back(sqrtf(c.first));
+	}
+	return heap.size();
+}
+
+size_t KdTree::FindInRadius(const Float3A& center, float radius, vector<uint32_t>& outIndices) const
+{
+	if (!(radius >= 0))
+		return 0;
+
+	Float3 c = center;
+	float rangeSq = radius * radius;
+	size_t start = outIndices.size();
+	Search(&c.X, rangeSq, [&](uint32_t i, float) { outIndices.push_back(_indices[i]); });
+	return outIndices.size() - start;
+}
+
+void KdTree::FindNearest(const Float3Stream& points, size_t k, int32_t* outIndices, float* outDistances, float maxDistance, bool parallel) const
+{
+	size_t count = points.size();
+	if (count == 0 || k == 0)
+		return;
+	if (!outIndices)
+		throw ArgumentNullException("outIndices");
+
+	vector<uint32_t> order = QueryOrder(points, parallel);
+
+	Details::ParallelFor(count, QueryGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		vector<uint32_t> indices;
+		vector<float> distances;
+
+		for (size_t n = begin; n < end; n++)
+		{
+			size_t i = order[n];
+			indices.clear();
+			distances.clear();
+			size_t found = FindNearest(points.Get(i), k, indices, outDistances ? &distances : nullptr, maxDistance);
+
+			for (size_t j = 0; j < k; j++)
+			{
+				outIndices[i * k + j] = j < found ? (int32_t)indices[j] : -1;
+				if (outDistances)
+					outDistances[i * k + j] = j < found ? distances[j] : maxDistance;
+			}
+		}
+	});
+}
+
+void KdTree::FindInRadius(const Float3Stream& centers, float radius, vector<uint32_t>& outIndices, vector<uint32_t>& outOffsets, bool parallel) const
+{
+	size_t count = centers.size();
+	outIndices.clear();
+	outOffsets.assign(count + 1, 0);
+	if (count == 0)
+		return;
+
+	vector<uint32_t> order = QueryOrder(centers, parallel);
+
+	// Each piece of work collects its rows in its own list, keyed by its first position in order. Where each row
+	// landed is kept so the rows can be copied out in query order once their sizes are known.
+	vector<vector<uint32_t>> found((count + QueryGranularity - 1) / QueryGranularity);
+	vector<uint32_t> listOf(count), startIn(count);
+
+	Details::ParallelFor(count, QueryGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		uint32_t list = (uint32_t)(begin / QueryGranularity);
+		auto& indices = found[list];
+
+		for (size_t n = begin; n < end; n++)
+		{
+			size_t i = order[n];
+			listOf[i] = list;
+			startIn[i] = (uint32_t)indices.size();
+			outOffsets[i + 1] = (uint32_t)FindInRadius(centers.Get(i), radius, indices);
+		}
+	});
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if ((uint64_t)outOffsets[i] + outOffsets[i + 1] > UINT32_MAX)
+			throw Exception("Too many results to index with 32-bit offsets");
+		outOffsets[i + 1] += outOffsets[i];
+	}
+	outIndices.resize(outOffsets[count]);
+
+	Details::ParallelFor(count, QueryGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const uint32_t* row = found[listOf[i]].data() + startIn[i];
+			copy(row, row + (outOffsets[i + 1] - outOffsets[i]), outIndices.begin() + outOffsets[i]);
+		}
+	});
+}
+
+// The queries ordered by the leaf each falls in, then by position in the stream
+vector<uint32_t> KdTree::QueryOrder(const Float3Stream& points, bool parallel) const
+{
+	size_t count = points.size();
+	vector<pair<uint32_t, uint32_t>> keys(count);
+
+	Details::ParallelFor(count, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			float p[3] = { points.GetX()[i], points.GetY()[i], points.GetZ()[i] };
+			keys[i] = make_pair(_points.empty() ? 0u : (uint32_t)LeafOf(p), (uint32_t)i);
+		}
+	});
+
+	sort(keys.begin(), keys.end());
+
+	vector<uint32_t> order(count);
+	for (size_t n = 0; n < count; n++)
+		order[n] = keys[n].second;
+	return order;
+}
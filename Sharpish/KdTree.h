@@ -0,0 +1,60 @@
+#pragma once
+
+namespace CS
+{
+	// A static KD-tree over a point cloud, for nearest-neighbor and radius queries against millions of points,
+	// e.g. matching scans for registration or finding duplicate vertices.
+	//
+	// The tree has no nodes of its own. The points are reordered so that every subtree is a contiguous range
+	// whose splitting point is the median at its middle, with the lower half before it and the upper half after,
+	// down to ranges of at most LeafSize points that are searched linearly. Besides the reordered points the tree
+	// keeps each one's source index and the axis it splits on, 17 bytes per point in all. Each range is split at
+	// the median along its widest axis, found with nth_element; ranges are partitioned across worker threads
+	// unless parallel is false.
+	//
+	// Queries report the points' indices in the array the tree was built from. The tree doesn't keep a reference
+	// to the source array; rebuild it when the points change.
+	class KdTree
+	{
+	public:
+		static const int LeafSize = 8;
+
+		KdTree() { }
+		explicit KdTree(const Array<Float3>& points, bool parallel = true);
+		KdTree(const Float3* points, size_t count, bool parallel = true);
+
+		inline size_t size() const { return _points.size(); }
+		inline bool empty() const { return _points.empty(); }
+
+		// The k points nearest to point and no further than maxDistance, appended to outIndices nearest first,
+		// with their distances appended to outDistances if it isn't null. Returns how many were appended.
+		size_t FindNearest(const Float3A& point, size_t k, std::vector<uint32_t>& outIndices,
+			std::vector<float>* outDistances = nullptr, float maxDistance = FLT_MAX) const;
+
+		// The points within radius of center, appended to outIndices in no particular order
+		size_t FindInRadius(const Float3A& center, float radius, std::vector<uint32_t>& outIndices) const;
+
+		// Many queries at once, split across worker threads unless parallel is false. The queries are visited in
+		// the order of the leaves they fall in, so neighboring queries run back to back and share the nodes they
+		// load. Row i of outIndices, k entries wide, receives the neighbors of points[i] nearest first, padded
+		// with -1 where fewer than k are found. outDistances may be null, and is laid out the same way.
+		void FindNearest(const Float3Stream& points, size_t k, int32_t* outIndices, float* outDistances,
+			float maxDistance = FLT_MAX, bool parallel = true) const;
+
+		// The points within radius of each center, in rows: those of centers[i] are
+		// outIndices[outOffsets[i]] to outIndices[outOffsets[i + 1]]. Both vectors are replaced.
+		void FindInRadius(const Float3Stream& centers, float radius, std::vector<uint32_t>& outIndices,
+			std::vector<uint32_t>& outOffsets, bool parallel = true) const;
+
+	private:
+		// In tree order
+		std::vector<Float3> _points;
+		std::vector<uint32_t> _indices;
+		// The splitting axis of the range whose median is at each position, and unused for leaf points
+		std::vector<uint8_t> _axes;
+
+		template<typename F> void Search(const float* point, float& rangeSq, const F& visit) const;
+		size_t LeafOf(const float* point) const;
+		std::vector<uint32_t> QueryOrder(const Float3Stream& points, bool parallel) const;
+	};
+}
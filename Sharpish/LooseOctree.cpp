@@ -0,0 +1,513 @@
+#include "Sharpish.h"
+#include "LooseOctree.h"
+#include "MathParallel.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace CS;
+using namespace std;
+
+namespace
+{
+	// Objects per piece of work when keys are computed, and node groups per piece when nodes are filled
+	const size_t KeyGranularity = 4096;
+	const size_t GroupGranularity = 64;
+
+	// Keys pack a node's level and the coordinates of its cell at that level, 19 bits each
+	const int CoordinateBits = 19;
+	const uint64_t CoordinateMask = (1ull << CoordinateBits) - 1;
+
+	inline uint64_t MakeKey(int level, uint32_t x, uint32_t y, uint32_t z)
+	{
+		return ((uint64_t)level << (3 * CoordinateBits)) | ((uint64_t)x << (2 * CoordinateBits)) | ((uint64_t)y << CoordinateBits) | z;
+	}
+
+	inline int KeyLevel(uint64_t key) { return (int)(key >> (3 * CoordinateBits)); }
+	inline uint32_t KeyX(uint64_t key) { return (uint32_t)((key >> (2 * CoordinateBits)) & CoordinateMask); }
+	inline uint32_t KeyY(uint64_t key) { return (uint32_t)((key >> CoordinateBits) & CoordinateMask); }
+	inline uint32_t KeyZ(uint64_t key) { return (uint32_t)(key & CoordinateMask); }
+
+	inline const float* Components(const BoundingSphere& sphere) { return (const float*)&sphere; }
+
+	// Squared distance from p to the cube about center with half size extent
+	inline float DistanceSq(const float* center, float extent, const float* p)
+	{
+		float distanceSq = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			float d = max(fabs(p[k] - center[k]) - extent, 0.0f);
+			distanceSq += d * d;
+		}
+		return distanceSq;
+	}
+
+	struct Ray
+	{
+		float Origin[3];
+		float Direction[3];
+		float Inverse[3];
+		float DirectionSq;
+
+		Ray(const Float3& origin, const Float3& direction)
+		{
+			const float o[3] = { origin.X, origin.Y, origin.Z };
+			const float d[3] = { direction.X, direction.Y, direction.Z };
+			for (int k = 0; k < 3; k++)
+			{
+				Origin[k] = o[k];
+				Direction[k] = d[k];
+				Inverse[k] = fabs(d[k]) < FLT_MIN ? (signbit(d[k]) ? -FLT_MAX : FLT_MAX) : 1 / d[k];
+			}
+			DirectionSq = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+		}
+
+		bool HitCube(const float* center, float extent, float maxDistance) const
+		{
+			float tNear = 0, tFar = maxDistance;
+			for (int k = 0; k < 3; k++)
+			{
+				float t0 = (center[k] - extent - Origin[k]) * Inverse[k];
+				float t1 = (center[k] + extent - Origin[k]) * Inverse[k];
+				tNear = max(min(t0, t1), tNear);
+				tFar = min(max(t0, t1), tFar);
+			}
+			return tNear <= tFar;
+		}
+
+		// |o + t d - c| = r for the smallest t in [0, maxDistance], or 0 if the ray starts inside
+		bool HitSphere(const float* sphere, float maxDistance, float& enter) const
+		{
+			float m[3] = { Origin[0] - sphere[0], Origin[1] - sphere[1], Origin[2] - sphere[2] };
+			float b = m[0] * Direction[0] + m[1] * Direction[1] + m[2] * Direction[2];
+			float c = m[0] * m[0] + m[1] * m[1] + m[2] * m[2] - sphere[3] * sphere[3];
+
+			if (c <= 0)
+			{
+				enter = 0;
+				return true;
+			}
+
+			float discriminant = b * b - DirectionSq * c;
+			if (b >= 0 || discriminant < 0 || DirectionSq == 0)
+				return false;
+
+			enter = (-b - sqrt(discriminant)) / DirectionSq;
+			return enter <= maxDistance;
+		}
+	};
+}
+
+const LooseOctree::ObjectId LooseOctree::None;
+
+LooseOctree::LooseOctree(const BoundingBoxA& worldBounds, int maxDepth) :
+	_maxDepth(maxDepth),
+	_count(0),
+	_free(None)
+{
+	if (maxDepth < 0 || maxDepth > MaxDepth)
+		throw ArgumentException("maxDepth", "Depth must be between 0 and MaxDepth");
+
+	Float3 minima = worldBounds.Minima;
+	Float3 maxima = worldBounds.Maxima;
+	_size = max(max(maxima.X - minima.X, maxima.Y - minima.Y), maxima.Z - minima.Z);
+	if (!(_size > 0) || isinf(_size))
+		throw ArgumentException("worldBounds", "World bounds must have a positive, finite size");
+
+	_origin[0] = (minima.X + maxima.X - _size) / 2;
+	_origin[1] = (minima.Y + maxima.Y - _size) / 2;
+	_origin[2] = (minima.Z + maxima.Z - _size) / 2;
+
+	// The root. It's always tested, so its loose extent is only informative.
+	_nodes.emplace_back();
+	Node& root = _nodes.back();
+	root.Key = MakeKey(0, 0, 0, 0);
+	root.Parent = None;
+	fill(begin(root.Children), end(root.Children), None);
+	root.Level = 0;
+	for (int k = 0; k < 3; k++)
+		root.Center[k] = _origin[k] + _size / 2;
+	root.LooseExtent = _size;
+	_nodeIndex[root.Key] = 0;
+}
+
+LooseOctree::ObjectId LooseOctree::Insert(const BoundingSphere& sphere)
+{
+	int node = FindOrAddNode(KeyOf(sphere));
+	ObjectId object = AllocateObject();
+	Attach(object, node, sphere);
+	_count++;
+	return object;
+}
+
+void LooseOctree::InsertMany(const BoundingSphere* spheres, size_t count, ObjectId* outObjects, bool parallel)
+{
+	if (count == 0)
+		return;
+	if (!spheres)
+		throw ArgumentNullException("spheres");
+
+	vector<uint64_t> keys(count);
+	auto computeKeys = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			keys[i] = KeyOf(spheres[i]);
+	};
+
+	Details::ParallelFor(count, KeyGranularity, parallel, computeKeys);
+
+	vector<ObjectId> objects(count);
+	for (size_t i = 0; i < count; i++)
+		objects[i] = AllocateObject();
+
+	// Group the objects by node. Every node is created here, so _nodes doesn't move while the groups fill.
+	vector<uint32_t> order(count);
+	iota(order.begin(), order.end(), 0u);
+	stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+	struct Group
+	{
+		size_t Begin;
+		size_t End;
+		int Node;
+	};
+
+	vector<Group> groups;
+	for (size_t i = 0; i < count;)
+	{
+		size_t end = i + 1;
+		while (end < count && keys[order[end]] == keys[order[i]])
+			end++;
+		groups.push_back(Group { i, end, FindOrAddNode(keys[order[i]]) });
+		i = end;
+	}
+
+	auto fillNodes = [&](size_t begin, size_t end)
+	{
+		for (size_t g = begin; g < end; g++)
+		{
+			Node& node = _nodes[groups[g].Node];
+			node.Spheres.reserve(node.Spheres.size() + groups[g].End - groups[g].Begin);
+			node.Objects.reserve(node.Objects.size() + groups[g].End - groups[g].Begin);
+
+			for (size_t i = groups[g].Begin; i < groups[g].End; i++)
+				Attach(objects[order[i]], groups[g].Node, spheres[order[i]]);
+		}
+	};
+
+	Details::ParallelFor(groups.size(), GroupGranularity, parallel, fillNodes);
+
+	_count += count;
+	if (outObjects)
+		copy(objects.begin(), objects.end(), outObjects);
+}
+
+void LooseOctree::Remove(ObjectId object)
+{
+	Validate(object, "object");
+	Detach(_objects[object].Node, _objects[object].Slot);
+	_objects[object].Node = None;
+	_objects[object].Slot = _free;
+	_free = object;
+	_count--;
+}
+
+bool LooseOctree::Move(ObjectId object, const BoundingSphere& sphere)
+{
+	Validate(object, "object");
+
+	int node = FindOrAddNode(KeyOf(sphere));
+	Object current = _objects[object];
+
+	if (node == current.Node)
+	{
+		_nodes[node].Spheres[current.Slot] = sphere;
+		return false;
+	}
+
+	// Attached first, so pruning the old node can't remove the new one
+	Attach(object, node, sphere);
+	Detach(current.Node, current.Slot);
+	return true;
+}
+
+BoundingSphere LooseOctree::GetSphere(ObjectId object) const
+{
+	Validate(object, "object");
+	return _nodes[_objects[object].Node].Spheres[_objects[object].Slot];
+}
+
+bool LooseOctree::Contains(ObjectId object) const
+{
+	return object >= 0 && object < (int)_objects.size() && _objects[object].Node != None;
+}
+
+template<typename N, typename O>
+size_t LooseOctree::Traverse(const N& testNode, const O& testObject, vector<ObjectId>& outObjects) const
+{
+	size_t start = outObjects.size();
+
+	// Each level pushes at most 8 nodes and pops one
+	int stack[8 * (MaxDepth + 1)];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = _nodes[stack[--top]];
+		if (node.Level > 0 && !testNode(node))
+			continue;
+
+		for (size_t i = 0; i < node.Spheres.size(); i++)
+			if (testObject(node.Spheres[i]))
+				outObjects.push_back(node.Objects[i]);
+
+		for (int child : node.Children)
+			if (child != None)
+				stack[top++] = child;
+	}
+
+	return outObjects.size() - start;
+}
+
+size_t LooseOctree::Overlap(const BoundingSphereA& sphere, vector<ObjectId>& outObjects) const
+{
+	Float3 center = sphere.GetCenter();
+	const float c[3] = { center.X, center.Y, center.Z };
+	float radius = sphere.GetRadius();
+
+	return Traverse(
+		[&](const Node& node) { return DistanceSq(node.Center, node.LooseExtent, c) <= radius * radius; },
+		[&](const BoundingSphere& s)
+		{
+			const float* p = Components(s);
+			float dx = p[0] - c[0], dy = p[1] - c[1], dz = p[2] - c[2], reach = p[3] + radius;
+			return dx * dx + dy * dy + dz * dz <= reach * reach;
+		},
+		outObjects);
+}
+
+size_t LooseOctree::Overlap(const BoundingBoxA& box, vector<ObjectId>& outObjects) const
+{
+	if (!box.GetExists())
+		return 0;
+
+	Float3 minima = box.Minima;
+	Float3 maxima = box.Maxima;
+	const float center[3] = { (minima.X + maxima.X) / 2, (minima.Y + maxima.Y) / 2, (minima.Z + maxima.Z) / 2 };
+	const float extent[3] = { (maxima.X - minima.X) / 2, (maxima.Y - minima.Y) / 2, (maxima.Z - minima.Z) / 2 };
+
+	return Traverse(
+		[&](const Node& node)
+		{
+			for (int k = 0; k < 3; k++)
+				if (fabs(node.Center[k] - center[k]) > node.LooseExtent + extent[k])
+					return false;
+			return true;
+		},
+		[&](const BoundingSphere& s)
+		{
+			const float* p = Components(s);
+			float distanceSq = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				float d = max(fabs(p[k] - center[k]) - extent[k], 0.0f);
+				distanceSq += d * d;
+			}
+			return distanceSq <= p[3] * p[3];
+		},
+		outObjects);
+}
+
+size_t LooseOctree::RaycastAll(const Float3A& origin, const Float3A& direction, float maxDistance, vector<ObjectId>& outObjects) const
+{
+	Ray ray(origin, direction);
+	float enter;
+
+	return Traverse(
+		[&](const Node& node) { return ray.HitCube(node.Center, node.LooseExtent, maxDistance); },
+		[&](const BoundingSphere& s) { return ray.HitSphere(Components(s), maxDistance, enter); },
+		outObjects);
+}
+
+bool LooseOctree::RaycastFirst(const Float3A& origin, const Float3A& direction, float maxDistance, ObjectId& outObject, float& outDistance) const
+{
+	Ray ray(origin, direction);
+	float best = maxDistance;
+	ObjectId found = None;
+
+	// Depth first, skipping nodes the ray only reaches beyond the closest hit so far
+	int stack[8 * (MaxDepth + 1)];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = _nodes[stack[--top]];
+		if (node.Level > 0 && !ray.HitCube(node.Center, node.LooseExtent, best))
+			continue;
+
+		for (size_t i = 0; i < node.Spheres.size(); i++)
+		{
+			float enter;
+			if (ray.HitSphere(Components(node.Spheres[i]), best, enter) && (found == None || enter < best))
+			{
+				best = enter;
+				found = node.Objects[i];
+			}
+		}
+
+		for (int child : node.Children)
+			if (child != None)
+				stack[top++] = child;
+	}
+
+	if (found == None)
+		return false;
+
+	outObject = found;
+	outDistance = best;
+	return true;
+}
+
+size_t LooseOctree::Cull(const FrustumCuller& frustum, vector<ObjectId>& outObjects) const
+{
+	return Traverse(
+		[&](const Node& node)
+		{
+			float e = node.LooseExtent;
+			const float* c = node.Center;
+			return frustum.IsVisible(BoundingBoxA(Float3A(c[0] - e, c[1] - e, c[2] - e), Float3A(c[0] + e, c[1] + e, c[2] + e)));
+		},
+		[&](const BoundingSphere& s) { return frustum.IsVisible(s); },
+		outObjects);
+}
+
+uint64_t LooseOctree::KeyOf(const BoundingSphere& sphere) const
+{
+	const float* s = Components(sphere);
+	float relative[3];
+	for (int k = 0; k < 3; k++)
+	{
+		relative[k] = (s[k] - _origin[k]) / _size;
+		if (!(relative[k] >= 0 && relative[k] < 1))
+			return MakeKey(0, 0, 0, 0);
+	}
+
+	// The deepest level whose cells, size / 2^level across, are at least the diameter: the center is then within
+	// half a cell of the cell's center, and the sphere within the loose bounds a cell beyond it
+	float diameter = 2 * max(s[3], 0.0f);
+	int level = _maxDepth;
+	if (diameter > 0)
+	{
+		level = (int)min((float)_maxDepth, max(0.0f, floorf(log2f(_size / diameter))));
+		while (level > 0 && diameter > ldexpf(_size, -level))
+			level--;
+		while (level < _maxDepth && diameter <= ldexpf(_size, -level - 1))
+			level++;
+	}
+
+	uint32_t cells = 1u << level;
+	uint32_t cell[3];
+	for (int k = 0; k < 3; k++)
+		cell[k] = min((uint32_t)(relative[k] * cells), cells - 1);
+
+	return MakeKey(level, cell[0], cell[1], cell[2]);
+}
+
+int LooseOctree::FindOrAddNode(uint64_t key)
+{
+	auto found = _nodeIndex.find(key);
+	if (found != _nodeIndex.end())
+		return found->second;
+
+	int level = KeyLevel(key);
+	uint32_t x = KeyX(key), y = KeyY(key), z = KeyZ(key);
+	int parent = FindOrAddNode(MakeKey(level - 1, x >> 1, y >> 1, z >> 1));
+
+	int index;
+	if (_freeNodes.empty())
+	{
+		index = (int)_nodes.size();
+		_nodes.emplace_back();
+	}
+	else
+	{
+		index = _freeNodes.back();
+		_freeNodes.pop_back();
+	}
+
+	Node& node = _nodes[index];
+	node.Key = key;
+	node.Parent = parent;
+	fill(begin(node.Children), end(node.Children), None);
+	node.Level = level;
+
+	float cellSize = ldexpf(_size, -level);
+	const uint32_t cell[3] = { x, y, z };
+	for (int k = 0; k < 3; k++)
+		node.Center[k] = _origin[k] + (cell[k] + 0.5f) * cellSize;
+	node.LooseExtent = cellSize;
+
+	_nodes[parent].Children[(x & 1) | (y & 1) << 1 | (z & 1) << 2] = index;
+	_nodeIndex[key] = index;
+	return index;
+}
+
+LooseOctree::ObjectId LooseOctree::AllocateObject()
+{
+	if (_free == None)
+	{
+		_objects.push_back(Object { None, 0 });
+		return (ObjectId)_objects.size() - 1;
+	}
+
+	ObjectId object = _free;
+	_free = _objects[object].Slot;
+	return object;
+}
+
+void LooseOctree::Validate(ObjectId object, const char* argName) const
+{
+	if (!Contains(object))
+		throw ArgumentException(argName, "Not an object in this octree");
+}
+
+void LooseOctree::Attach(ObjectId object, int node, const BoundingSphere& sphere)
+{
+	Node& n = _nodes[node];
+	_objects[object] = Object { node, (int)n.Spheres.size() };
+	n.Spheres.push_back(sphere);
+	n.Objects.push_back(object);
+}
+
+void LooseOctree::Detach(int node, int slot)
+{
+	Node& n = _nodes[node];
+	int last = (int)n.Spheres.size() - 1;
+
+	// Fill the gap with the node's last object
+	if (slot != last)
+	{
+		n.Spheres[slot] = n.Spheres[last];
+		n.Objects[slot] = n.Objects[last];
+		_objects[n.Objects[slot]].Slot = slot;
+	}
+
+	n.Spheres.pop_back();
+	n.Objects.pop_back();
+
+	// Unlink emptied nodes up to the first that still holds something. The root always stays.
+	while (node != 0)
+	{
+		Node& empty = _nodes[node];
+		if (!empty.Spheres.empty() || any_of(begin(empty.Children), end(empty.Children), [](int child) { return child != None; }))
+			break;
+
+		uint64_t key = empty.Key;
+		int parent = empty.Parent;
+		_nodes[parent].Children[(KeyX(key) & 1) | (KeyY(key) & 1) << 1 | (KeyZ(key) & 1) << 2] = None;
+		_nodeIndex.erase(key);
+		_freeNodes.push_back(node);
+		node = parent;
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <unordered_map>
+
+namespace CS
+{
+	// An octree for objects bounded by spheres of very different sizes, such as terrain chunks among small props.
+	//
+	// Each node's bounds are loose: its cell enlarged to twice the size about the same center. An object goes in
+	// the deepest node whose cell holds its center and is at least as wide as the object's diameter, so the
+	// level follows from the radius alone and the cell from the center alone. Moving an object only
+	// recomputes that cell and, if it changed, moves the object between two nodes, with no splitting, merging or
+	// rebalancing. Objects whose centers lie outside the world bounds go in the root, which queries always test.
+	//
+	// Each node keeps its objects' spheres and ids in contiguous arrays. Queries append the ids of the objects
+	// that pass to outObjects, in no particular order, and return how many they appended.
+	class LooseOctree
+	{
+	public:
+		typedef int ObjectId;
+		static const ObjectId None = -1;
+		static const int DefaultDepth = 8;
+		static const int MaxDepth = 19;
+
+		// The root's cell is the cube about worldBounds' center with worldBounds' largest extent
+		LooseOctree(const BoundingBoxA& worldBounds, int maxDepth = DefaultDepth);
+
+		// Ids stay valid until the object is removed and may be reused afterwards
+		ObjectId Insert(const BoundingSphere& sphere);
+		// Inserts many objects, with their levels and cells found and the nodes filled across worker threads
+		// unless parallel is false. outObjects, if not null, receives the id of each.
+		void InsertMany(const BoundingSphere* spheres, size_t count, ObjectId* outObjects = nullptr, bool parallel = true);
+		void Remove(ObjectId object);
+
+		// Returns whether the object changed nodes
+		bool Move(ObjectId object, const BoundingSphere& sphere);
+
+		PROPERTY_INDEXABLE_READONLY(BoundingSphere, Sphere);
+		BoundingSphere GetSphere(ObjectId object) const;
+
+		bool Contains(ObjectId object) const;
+
+		PROPERTY_READONLY(size_t, Count);
+		size_t GetCount() const { return _count; }
+
+		PROPERTY_READONLY(size_t, NodeCount);
+		size_t GetNodeCount() const { return _nodes.size() - _freeNodes.size(); }
+
+		size_t Overlap(const BoundingSphereA& sphere, std::vector<ObjectId>& outObjects) const;
+		size_t Overlap(const BoundingBoxA& box, std::vector<ObjectId>& outObjects) const;
+
+		// Objects hit by origin + t * direction for t in [0, maxDistance]
+		size_t RaycastAll(const Float3A& origin, const Float3A& direction, float maxDistance, std::vector<ObjectId>& outObjects) const;
+		// The object whose sphere the ray enters first, and where (0 if it starts inside). Returns false on a miss.
+		bool RaycastFirst(const Float3A& origin, const Float3A& direction, float maxDistance, ObjectId& outObject, float& outDistance) const;
+
+		// Objects that may be visible, as FrustumCuller::IsVisible decides
+		size_t Cull(const FrustumCuller& frustum, std::vector<ObjectId>& outObjects) const;
+
+	private:
+		// Nodes exist while they or their descendants hold objects; emptied ones are unlinked and their slots reused
+		struct Node
+		{
+			uint64_t Key;
+			int Parent;
+			int Children[8];
+			int Level;
+			// The center of the cell, and half the size of its loose bounds, which is the size of the cell
+			float Center[3];
+			float LooseExtent;
+			std::vector<BoundingSphere> Spheres;
+			std::vector<ObjectId> Objects;
+		};
+
+		// Free objects have Node None and link the free list through Slot
+		struct Object
+		{
+			int Node;
+			int Slot;
+		};
+
+		float _origin[3];
+		float _size;
+		int _maxDepth;
+		size_t _count;
+		int _free;
+		std::vector<Node> _nodes;
+		std::vector<int> _freeNodes;
+		std::vector<Object> _objects;
+		// Node index by level and cell
+		std::unordered_map<uint64_t, int> _nodeIndex;
+
+		uint64_t KeyOf(const BoundingSphere& sphere) const;
+		int FindOrAddNode(uint64_t key);
+		ObjectId AllocateObject();
+		void Validate(ObjectId object, const char* argName) const;
+		void Attach(ObjectId object, int node, const BoundingSphere& sphere);
+		// Removes the object in slot of node, pruning the node and its ancestors if that leaves them empty
+		void Detach(int node, int slot);
+		template<typename N, typename O> size_t Traverse(const N& testNode, const O& testObject, std::vector<ObjectId>& outObjects) const;
+	};
+}
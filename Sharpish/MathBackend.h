@@ -0,0 +1,89 @@
+#pragma once
+
+// Selects the SIMD backend underneath the math types (Vector, QuaternionA, Float4x3A, Float4x4A, the streams
+// and the batch kernels).
+//
+// The math types are thin wrappers over DirectXMath, which carries scalar, SSE4.1, AVX2 (with FMA3 and F16C)
+// and ARM NEON implementations of every XM** routine, chosen by its _XM_*_INTRINSICS_ macros. This header maps
+// one Sharpish setting onto those macros so every translation unit agrees on the backend:
+//
+//     SHARPISH_MATH_SCALAR - portable C++, no intrinsics
+//     SHARPISH_MATH_SSE2   - SSE2 (the x86/x64 baseline)
+//     SHARPISH_MATH_SSE4   - SSE4.1
+//     SHARPISH_MATH_AVX2   - AVX2 + FMA3 + F16C
+//     SHARPISH_MATH_NEON   - ARMv7/ARMv8 NEON
+//
+// Define at most one, before Sharpish.h is included (usually in the project settings). Otherwise the backend
+// follows the compiler's target flags: /arch:AVX2 or -mavx2 -mfma picks AVX2, -msse4.1 or /arch:AVX picks SSE4,
+// ARM targets pick NEON, other x86/x64 targets get SSE2 and anything else is scalar.
+//
+// Non-MSVC builds also get the few MSVC spellings the math headers use (__vectorcall, __forceinline,
+// __declspec(align), _aligned_malloc), and DirectXMath needs the sal.h stub that ships with its portable
+// release. Property syntax needs __declspec(property); see SharpishCore.h for builds without it.
+
+#if defined(SHARPISH_MATH_SCALAR) + defined(SHARPISH_MATH_SSE2) + defined(SHARPISH_MATH_SSE4) + defined(SHARPISH_MATH_AVX2) + defined(SHARPISH_MATH_NEON) > 1
+#error Only one SHARPISH_MATH_* backend may be defined
+#endif
+
+#if !defined(SHARPISH_MATH_SCALAR) && !defined(SHARPISH_MATH_SSE2) && !defined(SHARPISH_MATH_SSE4) && !defined(SHARPISH_MATH_AVX2) && !defined(SHARPISH_MATH_NEON)
+#if defined(_XM_NO_INTRINSICS_)
+#define SHARPISH_MATH_SCALAR
+#elif defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define SHARPISH_MATH_AVX2
+#elif defined(__SSE4_1__) || defined(__AVX__)
+#define SHARPISH_MATH_SSE4
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON) || defined(__aarch64__)
+#define SHARPISH_MATH_NEON
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SHARPISH_MATH_SSE2
+#else
+#define SHARPISH_MATH_SCALAR
+#endif
+#endif
+
+#if defined(SHARPISH_MATH_SCALAR)
+#ifndef _XM_NO_INTRINSICS_
+#define _XM_NO_INTRINSICS_
+#endif
+#elif defined(SHARPISH_MATH_SSE4)
+#ifndef _XM_SSE4_INTRINSICS_
+#define _XM_SSE4_INTRINSICS_
+#endif
+#elif defined(SHARPISH_MATH_AVX2)
+#if !defined(_MSC_VER) && !(defined(__AVX2__) && defined(__FMA__) && defined(__F16C__))
+#error SHARPISH_MATH_AVX2 requires compiling with -mavx2 -mfma -mf16c
+#endif
+#ifndef _XM_AVX2_INTRINSICS_
+#define _XM_AVX2_INTRINSICS_
+#endif
+#elif defined(SHARPISH_MATH_NEON)
+#ifndef _XM_ARM_NEON_INTRINSICS_
+#define _XM_ARM_NEON_INTRINSICS_
+#endif
+#endif
+
+#if !defined(_MSC_VER)
+#include <cstdlib>
+
+#ifndef __vectorcall
+#define __vectorcall
+#endif
+
+#ifndef __forceinline
+#define __forceinline inline __attribute__((always_inline))
+#endif
+
+#if !defined(__declspec) && !defined(_MSC_EXTENSIONS)
+#define __declspec(spec) SHARPISH_DECLSPEC_##spec
+#define SHARPISH_DECLSPEC_align(n) __attribute__((aligned(n)))
+#endif
+
+inline void* _aligned_malloc(size_t size, size_t alignment)
+{
+	void* p = nullptr;
+	if (alignment < sizeof(void*)) alignment = sizeof(void*);
+	return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+inline void _aligned_free(void* p) { free(p); }
+#endif
@@ -0,0 +1,138 @@
+#include "Sharpish.h"
+#include "MathDispatch.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define SHARPISH_CPUID_X86
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define SHARPISH_CPUID_X86
+#endif
+
+using namespace CS;
+using namespace std;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+std::atomic<int> Details::ActiveSimdLevel(0);
+
+namespace
+{
+#if defined(SHARPISH_CPUID_X86)
+	void Cpuid(int leaf, int subleaf, int regs[4])
+	{
+#if defined(_MSC_VER)
+		__cpuidex(regs, leaf, subleaf);
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	unsigned long long Xgetbv()
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return ((unsigned long long)edx << 32) | eax;
+#endif
+	}
+
+	SimdLevel ProbeCpu()
+	{
+		int regs[4];
+		Cpuid(0, 0, regs);
+		int maxLeaf = regs[0];
+
+		Cpuid(1, 0, regs);
+		bool osxsave = (regs[2] & (1 << 27)) != 0;
+		bool fma = (regs[2] & (1 << 12)) != 0;
+		bool f16c = (regs[2] & (1 << 29)) != 0;
+
+		if (!osxsave || maxLeaf < 7)
+			return SimdLevel::Baseline;
+
+		// The OS must save the YMM (and for AVX-512, opmask and ZMM) state across context switches.
+		auto xcr0 = Xgetbv();
+		bool ymmState = (xcr0 & 0x06) == 0x06;
+		bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+		Cpuid(7, 0, regs);
+		bool avx2 = (regs[1] & (1 << 5)) != 0;
+		bool avx512f = (regs[1] & (1 << 16)) != 0;
+
+		if (!(ymmState && avx2 && fma && f16c))
+			return SimdLevel::Baseline;
+
+		return (zmmState && avx512f) ? SimdLevel::AVX512 : SimdLevel::AVX2;
+	}
+#else
+	SimdLevel ProbeCpu() { return SimdLevel::Baseline; }
+#endif
+
+	SimdLevel CompiledSimdLevel()
+	{
+#if defined(SHARPISH_LANES16)
+		return SimdLevel::AVX512;
+#elif defined(SHARPISH_LANES8)
+		return SimdLevel::AVX2;
+#else
+		return SimdLevel::Baseline;
+#endif
+	}
+
+	// Reads SHARPISH_SIMD. Returns false if it is unset or unrecognized.
+	bool ReadSimdOverride(SimdLevel& outLevel)
+	{
+		string value;
+
+#if defined(_MSC_VER)
+		char* buffer = nullptr;
+		size_t length = 0;
+		if (_dupenv_s(&buffer, &length, "SHARPISH_SIMD") == 0 && buffer)
+		{
+			value = buffer;
+			free(buffer);
+		}
+#else
+		if (auto env = getenv("SHARPISH_SIMD"))
+			value = env;
+#endif
+
+		for (auto& c : value)
+			c = (char)tolower((unsigned char)c);
+
+		if (value == "baseline" || value == "sse" || value == "scalar")
+			outLevel = SimdLevel::Baseline;
+		else if (value == "avx2")
+			outLevel = SimdLevel::AVX2;
+		else if (value == "avx512")
+			outLevel = SimdLevel::AVX512;
+		else
+			return false;
+
+		return true;
+	}
+
+	SimdLevel SelectStartupLevel()
+	{
+		auto level = Details::DetectSimdLevel();
+		SimdLevel requested;
+
+		if (ReadSimdOverride(requested) && requested < level)
+			level = requested;
+
+		return level;
+	}
+
+	// Probes the CPU once, when the library loads.
+	const bool _simdLevelSelected = (Details::ActiveSimdLevel = (int)SelectStartupLevel(), true);
+}
+
+Help::Math::SimdLevel Details::DetectSimdLevel()
+{
+	auto cpu = ProbeCpu();
+	auto compiled = CompiledSimdLevel();
+	return cpu < compiled ? cpu : compiled;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// Runtime selection between the lane types in MathLanes.h.
+//
+// The widest level supported by both the build (SHARPISH_LANES8/SHARPISH_LANES16) and the running CPU is
+// detected once while the library loads. The SHARPISH_SIMD environment variable ("baseline", "avx2" or
+// "avx512") can lower it, and Help::Math::SetSimdLevel changes it at runtime.
+//
+// A batch kernel is a struct with a static member template Run<L>, instantiated for every compiled lane type.
+// Kernels are defined in a .inl file that MathKernels.h includes once per target, and SHARPISH_KERNEL names
+// the dispatcher over those copies:
+//
+//     struct ScaleKernel { template<typename L> static void Run(float* p, size_t count, float s); };
+//     SHARPISH_KERNEL(ScaleKernel)::Get()(p, count, s);
+//
+// This header is an implementation detail of the kernels and is not included by Sharpish.h.
+
+#include "MathLanes.h"
+#include <atomic>
+
+namespace CS
+{
+	namespace Details
+	{
+		static const int SimdLevelCount = 3;
+
+		// The active Help::Math::SimdLevel. Zero (Baseline) until the CPU has been probed, so kernels called
+		// during static initialization still run correctly.
+		extern std::atomic<int> ActiveSimdLevel;
+
+		// The widest level supported by both this build and the CPU/OS.
+		Help::Math::SimdLevel DetectSimdLevel();
+
+		// K8 and K16 are the copies of K compiled for AVX2 and AVX-512, which are K itself without target regions
+#if defined(SHARPISH_TARGET_REGIONS)
+		template<typename K, typename K8, typename K16>
+#else
+		template<typename K, typename K8 = K, typename K16 = K>
+#endif
+		struct Dispatch
+		{
+			typedef decltype(&K::template Run<Lanes4>) Fn;
+
+			static inline Fn Get() { return _table[ActiveSimdLevel.load(std::memory_order_relaxed)]; }
+
+		private:
+			static const Fn _table[SimdLevelCount];
+		};
+
+		template<typename K, typename K8, typename K16>
+		const typename Dispatch<K, K8, K16>::Fn Dispatch<K, K8, K16>::_table[SimdLevelCount] =
+		{
+			&K::template Run<Lanes4>,
+#if defined(SHARPISH_LANES8)
+			&K8::template Run<Lanes8>,
+#else
+			&K::template Run<Lanes4>,
+#endif
+#if defined(SHARPISH_LANES16)
+			&K16::template Run<Lanes16>,
+#elif defined(SHARPISH_LANES8)
+			&K8::template Run<Lanes8>,
+#else
+			&K::template Run<Lanes4>,
+#endif
+		};
+	}
+}
+
+#if defined(SHARPISH_TARGET_REGIONS)
+#define SHARPISH_KERNEL(...) ::CS::Details::Dispatch<::CS::Baseline::__VA_ARGS__, ::CS::Avx2::__VA_ARGS__, ::CS::Avx512::__VA_ARGS__>
+#else
+#define SHARPISH_KERNEL(...) ::CS::Details::Dispatch<::CS::Baseline::__VA_ARGS__>
+#endif
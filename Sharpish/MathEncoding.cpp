@@ -0,0 +1,121 @@
+#include "Sharpish.h"
+#include "MathDispatch.h"
+#include "MathParallel.h"
+
+// ::PUBLICLIB::
+
+using namespace CS;
+
+namespace
+{
+	template<typename T>
+	struct AosStride { static const int Value = sizeof(T) / sizeof(float); };
+
+	// Codes are little-endian in the first Bytes bytes, whatever the host's byte order
+	template<int Bytes>
+	inline uint64_t ReadCode(const uint8_t* p)
+	{
+		uint64_t code = 0;
+		for (int b = 0; b < Bytes; b++)
+			code |= (uint64_t)p[b] << (b * 8);
+		return code;
+	}
+
+	template<int Bytes>
+	inline void WriteCode(uint8_t* p, uint64_t code)
+	{
+		for (int b = 0; b < Bytes; b++)
+			p[b] = (uint8_t)(code >> (b * 8));
+	}
+
+	// Components are quantized to [0, MaxCode] with MaxCode even, so that zero has a code of its own and the axes
+	// and the identity rotation come back unchanged. The top code of each component is unused.
+	template<int ComponentBits>
+	inline uint32_t MaxCode() { return (1u << ComponentBits) - 2; }
+}
+
+// The codes must not depend on the instruction set, so no multiply and add may be fused into one rounding, as
+// GCC does by default wherever FMA is available (in the Avx2 and Avx512 copies, and in every copy of an AVX2
+// backend build). Clang only fuses within an expression unless built with -ffp-contract=fast, which overrides
+// this and must not be used here.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+
+#define SHARPISH_KERNELS "MathEncodingKernels.inl"
+#include "MathKernels.h"
+
+namespace
+{
+	// Batches at least this large are split across threads
+	const size_t EncodingGranularity = 16384;
+
+	// K is the SHARPISH_KERNEL of the conversion
+	template<typename K, typename S, typename D>
+	void RunEncoding(const S* src, D* dst, size_t count)
+	{
+		auto kernel = K::Get();
+		Details::ParallelFor(count, EncodingGranularity, [&](size_t begin, size_t end)
+		{
+			kernel(src + begin, dst + begin, end - begin);
+		});
+	}
+}
+
+template<int Bits>
+OctahedralNormal<Bits>::OctahedralNormal(const Float3A& direction)
+{
+	Baseline::OctahedralEncodeKernel<Bits, Float3A>::template Run<Details::Lanes4>(&direction, this, 1);
+}
+
+template<int Bits>
+OctahedralNormal<Bits>::operator Float3A() const
+{
+	Float3A result;
+	Baseline::OctahedralDecodeKernel<Bits, Float3A>::template Run<Details::Lanes4>(this, &result, 1);
+	return result;
+}
+
+template<int Bits>
+void OctahedralNormal<Bits>::Encode(const Float3* src, OctahedralNormal* dst, size_t count) { RunEncoding<SHARPISH_KERNEL(OctahedralEncodeKernel<Bits, Float3>)>(src, dst, count); }
+template<int Bits>
+void OctahedralNormal<Bits>::Encode(const Float3A* src, OctahedralNormal* dst, size_t count) { RunEncoding<SHARPISH_KERNEL(OctahedralEncodeKernel<Bits, Float3A>)>(src, dst, count); }
+template<int Bits>
+void OctahedralNormal<Bits>::Decode(const OctahedralNormal* src, Float3* dst, size_t count) { RunEncoding<SHARPISH_KERNEL(OctahedralDecodeKernel<Bits, Float3>)>(src, dst, count); }
+template<int Bits>
+void OctahedralNormal<Bits>::Decode(const OctahedralNormal* src, Float3A* dst, size_t count) { RunEncoding<SHARPISH_KERNEL(OctahedralDecodeKernel<Bits, Float3A>)>(src, dst, count); }
+
+template struct CS::OctahedralNormal<16>;
+template struct CS::OctahedralNormal<24>;
+template struct CS::OctahedralNormal<32>;
+
+template<int Bits>
+CompactQuaternion<Bits>::CompactQuaternion(const QuaternionA& q)
+{
+	Baseline::CompactQuaternionEncodeKernel<Bits, QuaternionA>::template Run<Details::Lanes4>(&q, this, 1);
+}
+
+template<int Bits>
+CompactQuaternion<Bits>::operator QuaternionA() const
+{
+	QuaternionA result;
+	Baseline::CompactQuaternionDecodeKernel<Bits, QuaternionA>::template Run<Details::Lanes4>(this, &result, 1);
+	return result;
+}
+
+template<int Bits>
+void CompactQuaternion<Bits>::Encode(const Quaternion* src, CompactQuaternion* dst, size_t count) { RunEncoding<SHARPISH_KERNEL(CompactQuaternionEncodeKernel<Bits, Quaternion>)>(src, dst, count); }
+template<int Bits>
+void CompactQuaternion<Bits>::Encode(const QuaternionA* src, CompactQuaternion* dst, size_t count) { RunEncoding<SHARPISH_KERNEL(CompactQuaternionEncodeKernel<Bits, QuaternionA>)>(src, dst, count); }
+template<int Bits>
+void CompactQuaternion<Bits>::Decode(const CompactQuaternion* src, Quaternion* dst, size_t count) { RunEncoding<SHARPISH_KERNEL(CompactQuaternionDecodeKernel<Bits, Quaternion>)>(src, dst, count); }
+template<int Bits>
+void CompactQuaternion<Bits>::Decode(const CompactQuaternion* src, QuaternionA* dst, size_t count) { RunEncoding<SHARPISH_KERNEL(CompactQuaternionDecodeKernel<Bits, QuaternionA>)>(src, dst, count); }
+
+template struct CS::CompactQuaternion<32>;
+template struct CS::CompactQuaternion<48>;
+template struct CS::CompactQuaternion<64>;
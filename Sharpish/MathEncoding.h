@@ -0,0 +1,97 @@
+#pragma once
+
+// Compact encodings of unit vectors and rotations, for storing or sending large numbers of them.
+//
+// OctahedralNormal<Bits> projects a direction onto the octahedron |x| + |y| + |z| = 1, unfolds the octahedron
+// onto a square and stores the two square coordinates with Bits / 2 bits each. Of the four grid points around
+// the projected direction, encoding keeps the one that decodes closest to it. Directions need not be unit
+// length; the zero vector encodes as +Z.
+//
+// CompactQuaternion<Bits> is the smallest-three encoding. The component of largest magnitude is dropped and its
+// index kept in 2 bits; since q and -q are the same rotation, the quaternion is negated where needed to make the
+// dropped component positive, so it can be rebuilt from the unit length. The other three lie within
+// [-1/sqrt(2), 1/sqrt(2)] and are stored with (Bits - 2) / 3 bits each. Quaternions are normalized before
+// encoding and the zero quaternion encodes as the identity.
+//
+// Maximum angular errors of a decode after an encode, and the size relative to a Float3 or Quaternion:
+//
+//     OctahedralNormal16      2 bytes    6x smaller    0.64 degrees
+//     OctahedralNormal24      3 bytes    4x smaller    0.040 degrees
+//     OctahedralNormal32      4 bytes    3x smaller    0.0025 degrees
+//
+//     CompactQuaternion32     4 bytes    4x smaller    0.28 degrees
+//     CompactQuaternion48     6 bytes    2.7x smaller  0.0086 degrees
+//     CompactQuaternion64     8 bytes    2x smaller    0.00031 degrees
+//
+// The quaternion error is the angle of the rotation between the original and decoded orientations. Its bound is
+// analytic, reached when all four components are near 1/2, plus float rounding. The normal errors are the largest
+// found over 3x10^7 random directions and dense sampling around the worst cases. Decoded normals and quaternions
+// are unit length to within float rounding.
+//
+// The Encode and Decode arrays run several vectors at a time in SIMD registers and split large batches across
+// worker threads. Codes are little-endian and the same for every instruction set, so they can be written to
+// files and sent between machines.
+
+namespace CS
+{
+	template<int Bits>
+	struct OctahedralNormal
+	{
+		static_assert(Bits == 16 || Bits == 24 || Bits == 32, "OctahedralNormal is 16, 24 or 32 bits");
+
+		static const int ComponentBits = Bits / 2;
+
+		uint8_t Bytes[Bits / 8];
+
+		OctahedralNormal() { }
+		explicit OctahedralNormal(const Float3A& direction);
+
+		operator Float3A() const;
+
+		inline bool operator ==(const OctahedralNormal& rhs) const { return memcmp(Bytes, rhs.Bytes, sizeof(Bytes)) == 0; }
+		inline bool operator !=(const OctahedralNormal& rhs) const { return !(*this == rhs); }
+
+		static void Encode(const Float3* src, OctahedralNormal* dst, size_t count);
+		static void Encode(const Float3A* src, OctahedralNormal* dst, size_t count);
+		static void Decode(const OctahedralNormal* src, Float3* dst, size_t count);
+		static void Decode(const OctahedralNormal* src, Float3A* dst, size_t count);
+	};
+
+	typedef OctahedralNormal<16> OctahedralNormal16;
+	typedef OctahedralNormal<24> OctahedralNormal24;
+	typedef OctahedralNormal<32> OctahedralNormal32;
+
+	template<int Bits>
+	struct CompactQuaternion
+	{
+		static_assert(Bits == 32 || Bits == 48 || Bits == 64, "CompactQuaternion is 32, 48 or 64 bits");
+
+		static const int ComponentBits = (Bits - 2) / 3;
+
+		uint8_t Bytes[Bits / 8];
+
+		CompactQuaternion() { }
+		explicit CompactQuaternion(const QuaternionA& q);
+
+		operator QuaternionA() const;
+
+		inline bool operator ==(const CompactQuaternion& rhs) const { return memcmp(Bytes, rhs.Bytes, sizeof(Bytes)) == 0; }
+		inline bool operator !=(const CompactQuaternion& rhs) const { return !(*this == rhs); }
+
+		static void Encode(const Quaternion* src, CompactQuaternion* dst, size_t count);
+		static void Encode(const QuaternionA* src, CompactQuaternion* dst, size_t count);
+		static void Decode(const CompactQuaternion* src, Quaternion* dst, size_t count);
+		static void Decode(const CompactQuaternion* src, QuaternionA* dst, size_t count);
+	};
+
+	typedef CompactQuaternion<32> CompactQuaternion32;
+	typedef CompactQuaternion<48> CompactQuaternion48;
+	typedef CompactQuaternion<64> CompactQuaternion64;
+}
+
+DECLARE_HASHABLE(::CS::OctahedralNormal16)
+DECLARE_HASHABLE(::CS::OctahedralNormal24)
+DECLARE_HASHABLE(::CS::OctahedralNormal32)
+DECLARE_HASHABLE(::CS::CompactQuaternion32)
+DECLARE_HASHABLE(::CS::CompactQuaternion48)
+DECLARE_HASHABLE(::CS::CompactQuaternion64)
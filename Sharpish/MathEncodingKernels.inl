@@ -0,0 +1,320 @@
+// The batch kernels of MathEncoding.cpp, defined for each lane width by MathKernels.h. They use only correctly
+// rounded operations, with no fused multiply-adds or reciprocal estimates, and MathEncoding.cpp stops the
+// compiler fusing any, so every lane width computes the same floats and so the same codes.
+
+	template<typename L>
+	inline typename L::V __vectorcall SumOfSquares(typename L::V x, typename L::V y, typename L::V z)
+	{
+		return L::Add(L::Add(L::Mul(x, x), L::Mul(y, y)), L::Mul(z, z));
+	}
+
+	template<typename L>
+	struct Octahedral
+	{
+		typedef typename L::V V;
+
+		// Projects a nonzero vector onto |x| + |y| + |z| = 1 and folds the lower half over the diagonals, giving
+		// u, v in [-1, 1]
+		static inline void __vectorcall Fold(V x, V y, V z, V& u, V& v)
+		{
+			auto zero = L::Zero(), one = L::Splat(1.0f);
+			auto scale = L::Reciprocal(L::Add(L::Abs(x), L::Add(L::Abs(y), L::Abs(z))));
+
+			u = L::Mul(x, scale);
+			v = L::Mul(y, scale);
+
+			auto lower = L::Less(z, zero);
+			auto fu = L::CopySign(L::Sub(one, L::Abs(v)), u);
+			auto fv = L::CopySign(L::Sub(one, L::Abs(u)), v);
+			u = L::Select(u, fu, lower);
+			v = L::Select(v, fv, lower);
+		}
+
+		// The inverse of Fold, to unit length
+		static inline void __vectorcall Unfold(V u, V v, V& x, V& y, V& z)
+		{
+			z = L::Sub(L::Sub(L::Splat(1.0f), L::Abs(u)), L::Abs(v));
+			auto t = L::Max(L::Negate(z), L::Zero());
+			x = L::Sub(u, L::CopySign(t, u));
+			y = L::Sub(v, L::CopySign(t, v));
+
+			auto scale = L::ReciprocalSqrt(SumOfSquares<L>(x, y, z));
+			x = L::Mul(x, scale);
+			y = L::Mul(y, scale);
+			z = L::Mul(z, scale);
+		}
+	};
+
+	template<int Bits, typename T>
+	struct OctahedralEncodeKernel
+	{
+		static const int K = OctahedralNormal<Bits>::ComponentBits;
+
+		template<typename L>
+		static void Run(const T* src, OctahedralNormal<Bits>* dst, size_t count)
+		{
+			typedef typename L::V V;
+			const int S = AosStride<T>::Value;
+
+			auto maxCode = (float)MaxCode<K>();
+			auto half = L::Splat(maxCode * 0.5f), toUnit = L::Splat(2.0f / maxCode);
+			auto one = L::Splat(1.0f), zero = L::Zero(), lastLow = L::Splat(maxCode - 1);
+
+			alignas(64) float padded[S * L::Width];
+			alignas(64) float codeU[L::Width], codeV[L::Width];
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				size_t n = count - i < L::Width ? count - i : L::Width;
+				auto p = (const float*)(src + i);
+
+				if (n < L::Width)
+				{
+					memset(padded, 0, sizeof(padded));
+					memcpy(padded, p, n * sizeof(T));
+					p = padded;
+				}
+
+				V x, y, z, u, v;
+				Details::AosLanes<L>::template Load3<S>(p, x, y, z);
+
+				auto lengthSq = SumOfSquares<L>(x, y, z);
+				auto nonZero = L::Greater(lengthSq, zero);
+				auto r = L::Select(zero, L::ReciprocalSqrt(lengthSq), nonZero);
+				x = L::Mul(x, r);
+				y = L::Mul(y, r);
+				z = L::Select(one, L::Mul(z, r), nonZero);
+
+				Octahedral<L>::Fold(x, y, z, u, v);
+
+				// Try the four grid points around (u, v) and keep the one that decodes closest to the input. Distance
+				// tells neighbouring grid points apart at every size, where their dot products can round to the same float.
+				auto u0 = L::Min(L::Max(L::Floor(L::Add(L::Mul(u, half), half)), zero), lastLow);
+				auto v0 = L::Min(L::Max(L::Floor(L::Add(L::Mul(v, half), half)), zero), lastLow);
+				V bestU = u0, bestV = v0, bestDistanceSq;
+
+				for (int c = 0; c < 4; c++)
+				{
+					auto cu = (c & 1) ? L::Add(u0, one) : u0;
+					auto cv = (c & 2) ? L::Add(v0, one) : v0;
+
+					V dx, dy, dz;
+					Octahedral<L>::Unfold(L::Mul(L::Sub(cu, half), toUnit), L::Mul(L::Sub(cv, half), toUnit), dx, dy, dz);
+					dx = L::Sub(dx, x);
+					dy = L::Sub(dy, y);
+					dz = L::Sub(dz, z);
+					auto distanceSq = SumOfSquares<L>(dx, dy, dz);
+
+					if (c == 0)
+					{
+						bestDistanceSq = distanceSq;
+					}
+					else
+					{
+						auto better = L::Less(distanceSq, bestDistanceSq);
+						bestDistanceSq = L::Select(bestDistanceSq, distanceSq, better);
+						bestU = L::Select(bestU, cu, better);
+						bestV = L::Select(bestV, cv, better);
+					}
+				}
+
+				L::Store(codeU, bestU);
+				L::Store(codeV, bestV);
+
+				for (size_t j = 0; j < n; j++)
+					WriteCode<Bits / 8>(dst[i + j].Bytes, (uint64_t)codeU[j] | ((uint64_t)codeV[j] << K));
+			}
+		}
+	};
+
+	template<int Bits, typename T>
+	struct OctahedralDecodeKernel
+	{
+		static const int K = OctahedralNormal<Bits>::ComponentBits;
+
+		template<typename L>
+		static void Run(const OctahedralNormal<Bits>* src, T* dst, size_t count)
+		{
+			typedef typename L::V V;
+			const int S = AosStride<T>::Value;
+			const uint64_t mask = (1ull << K) - 1;
+
+			auto half = L::Splat(MaxCode<K>() * 0.5f), toUnit = L::Splat(2.0f / MaxCode<K>());
+
+			alignas(64) float padded[S * L::Width];
+			alignas(64) float codeU[L::Width], codeV[L::Width];
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				size_t n = count - i < L::Width ? count - i : L::Width;
+
+				for (size_t j = 0; j < L::Width; j++)
+				{
+					auto code = j < n ? ReadCode<Bits / 8>(src[i + j].Bytes) : 0;
+					codeU[j] = (float)(code & mask);
+					codeV[j] = (float)((code >> K) & mask);
+				}
+
+				V x, y, z;
+				Octahedral<L>::Unfold(L::Mul(L::Sub(L::Load(codeU), half), toUnit), L::Mul(L::Sub(L::Load(codeV), half), toUnit), x, y, z);
+
+				auto p = n < L::Width ? padded : (float*)(dst + i);
+				Details::AosLanes<L>::template Store3<S>(p, x, y, z);
+
+				if (n < L::Width)
+					memcpy(dst + i, padded, n * sizeof(T));
+			}
+		}
+	};
+
+	// The index of the largest component and the other three in order, each as a float
+	template<typename L>
+	struct SmallestThree
+	{
+		typedef typename L::V V;
+
+		static inline void __vectorcall Split(V x, V y, V z, V w, V& index, V& a, V& b, V& c)
+		{
+			auto ax = L::Abs(x), ay = L::Abs(y), az = L::Abs(z), aw = L::Abs(w);
+			auto largestMagnitude = L::Max(L::Max(ax, ay), L::Max(az, aw));
+
+			// Later tests win, so ties go to the lowest index
+			auto largest = w;
+			index = L::Splat(3.0f); a = x; b = y; c = z;
+
+			auto m = L::GreaterOrEqual(az, largestMagnitude);
+			largest = L::Select(largest, z, m); index = L::Select(index, L::Splat(2.0f), m);
+			c = L::Select(c, w, m);
+
+			m = L::GreaterOrEqual(ay, largestMagnitude);
+			largest = L::Select(largest, y, m); index = L::Select(index, L::Splat(1.0f), m);
+			b = L::Select(b, z, m); c = L::Select(c, w, m);
+
+			m = L::GreaterOrEqual(ax, largestMagnitude);
+			largest = L::Select(largest, x, m); index = L::Select(index, L::Zero(), m);
+			a = L::Select(a, y, m); b = L::Select(b, z, m); c = L::Select(c, w, m);
+
+			// Negate so that the dropped component is positive
+			auto sign = L::CopySign(L::Splat(1.0f), largest);
+			a = L::Mul(a, sign);
+			b = L::Mul(b, sign);
+			c = L::Mul(c, sign);
+		}
+
+		static inline void __vectorcall Join(V index, V a, V b, V c, V& x, V& y, V& z, V& w)
+		{
+			auto largest = L::Sqrt(L::Max(L::Sub(L::Splat(1.0f), SumOfSquares<L>(a, b, c)), L::Zero()));
+
+			auto after0 = L::Greater(index, L::Splat(0.5f));
+			auto after1 = L::Greater(index, L::Splat(1.5f));
+			auto after2 = L::Greater(index, L::Splat(2.5f));
+
+			x = L::Select(largest, a, after0);
+			y = L::Select(a, L::Select(largest, b, after1), after0);
+			z = L::Select(b, L::Select(largest, c, after2), after1);
+			w = L::Select(c, largest, after2);
+		}
+	};
+
+	const float Sqrt2 = 1.41421356f;
+
+	template<int Bits, typename T>
+	struct CompactQuaternionEncodeKernel
+	{
+		static const int K = CompactQuaternion<Bits>::ComponentBits;
+
+		template<typename L>
+		static void Run(const T* src, CompactQuaternion<Bits>* dst, size_t count)
+		{
+			typedef typename L::V V;
+
+			auto maxCode = (float)MaxCode<K>();
+			auto half = L::Splat(maxCode * 0.5f), scale = L::Splat(maxCode * 0.5f * Sqrt2);
+			auto zero = L::Zero(), one = L::Splat(1.0f), top = L::Splat(maxCode);
+
+			alignas(64) float padded[4 * L::Width];
+			alignas(64) float codeIndex[L::Width], codeA[L::Width], codeB[L::Width], codeC[L::Width];
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				size_t n = count - i < L::Width ? count - i : L::Width;
+				auto p = (const float*)(src + i);
+
+				if (n < L::Width)
+				{
+					memset(padded, 0, sizeof(padded));
+					memcpy(padded, p, n * sizeof(T));
+					p = padded;
+				}
+
+				V x, y, z, w;
+				Details::AosLanes<L>::Load4(p, 4, x, y, z, w);
+
+				auto lengthSq = L::Add(SumOfSquares<L>(x, y, z), L::Mul(w, w));
+				auto nonZero = L::Greater(lengthSq, zero);
+				auto r = L::Select(zero, L::ReciprocalSqrt(lengthSq), nonZero);
+				x = L::Mul(x, r);
+				y = L::Mul(y, r);
+				z = L::Mul(z, r);
+				w = L::Select(one, L::Mul(w, r), nonZero);
+
+				V index, a, b, c;
+				SmallestThree<L>::Split(x, y, z, w, index, a, b, c);
+
+				L::Store(codeIndex, index);
+				L::Store(codeA, L::Min(L::Max(L::Round(L::Add(L::Mul(a, scale), half)), zero), top));
+				L::Store(codeB, L::Min(L::Max(L::Round(L::Add(L::Mul(b, scale), half)), zero), top));
+				L::Store(codeC, L::Min(L::Max(L::Round(L::Add(L::Mul(c, scale), half)), zero), top));
+
+				for (size_t j = 0; j < n; j++)
+				{
+					WriteCode<Bits / 8>(dst[i + j].Bytes, (uint64_t)codeIndex[j] | ((uint64_t)codeA[j] << 2) |
+						((uint64_t)codeB[j] << (2 + K)) | ((uint64_t)codeC[j] << (2 + K * 2)));
+				}
+			}
+		}
+	};
+
+	template<int Bits, typename T>
+	struct CompactQuaternionDecodeKernel
+	{
+		static const int K = CompactQuaternion<Bits>::ComponentBits;
+
+		template<typename L>
+		static void Run(const CompactQuaternion<Bits>* src, T* dst, size_t count)
+		{
+			typedef typename L::V V;
+			const uint64_t mask = (1ull << K) - 1;
+
+			auto half = L::Splat(MaxCode<K>() * 0.5f), scale = L::Splat(Sqrt2 / MaxCode<K>());
+
+			alignas(64) float padded[4 * L::Width];
+			alignas(64) float codeIndex[L::Width], codeA[L::Width], codeB[L::Width], codeC[L::Width];
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				size_t n = count - i < L::Width ? count - i : L::Width;
+
+				for (size_t j = 0; j < L::Width; j++)
+				{
+					auto code = j < n ? ReadCode<Bits / 8>(src[i + j].Bytes) : 0;
+					codeIndex[j] = (float)(code & 3);
+					codeA[j] = (float)((code >> 2) & mask);
+					codeB[j] = (float)((code >> (2 + K)) & mask);
+					codeC[j] = (float)((code >> (2 + K * 2)) & mask);
+				}
+
+				V x, y, z, w;
+				SmallestThree<L>::Join(L::Load(codeIndex),
+					L::Mul(L::Sub(L::Load(codeA), half), scale),
+					L::Mul(L::Sub(L::Load(codeB), half), scale),
+					L::Mul(L::Sub(L::Load(codeC), half), scale), x, y, z, w);
+
+				auto p = n < L::Width ? padded : (float*)(dst + i);
+				Details::AosLanes<L>::Store4(p, 4, x, y, z, w);
+
+				if (n < L::Width)
+					memcpy(dst + i, padded, n * sizeof(T));
+			}
+		}
+	};
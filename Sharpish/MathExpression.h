@@ -0,0 +1,124 @@
+#pragma once
+
+// Opt-in expression templates for float vector arithmetic.
+//
+// Fuse(v) wraps a Float2/3/4 (aligned or not) so that the arithmetic applied to it builds an expression instead
+// of evaluating one operator at a time. The expression is evaluated in registers when it is assigned to a vector,
+// with every a * b + c, c + a * b and c - a * b emitted as a single multiply-add, which is an FMA instruction on
+// backends that have one (see MathBackend.h). Operands are loaded once, when they join the expression, and the
+// result is stored once.
+//
+//     // Semi-implicit Euler: two FMAs, no intermediate stores
+//     v = Fuse(a) * dt + v;
+//     x = Fuse(v) * dt + x;
+//
+//     // Verlet: (2x - xPrev) + a * dt^2
+//     Float3A next = Fuse(x) * 2.0f - xPrev + Fuse(a) * (dt * dt);
+//
+// Vectors and floats combine with an expression into a larger expression, but only the operators applied to an
+// expression are deferred, so a product is fused only when one of its factors is already an expression: write
+// Fuse(a) * dt + v, not v + a * dt. Expressions convert to the aligned vector type; assign them to any vector or
+// initialize a Float2A/3A/4A with them. The order of operations is exactly as written, so results match the plain
+// operators except for the single rounding of each fused multiply-add.
+
+namespace CS
+{
+	namespace Details
+	{
+		// Expression nodes. Each holds its operands by value and evaluates to an XMVECTOR.
+		struct ValueNode
+		{
+			XMVECTOR Value;
+			inline XMVECTOR __vectorcall Eval() const { return Value; }
+		};
+
+		template<typename A, typename B> struct AddNode { A a; B b; inline XMVECTOR __vectorcall Eval() const { return EvalAdd(a, b); } };
+		template<typename A, typename B> struct SubtractNode { A a; B b; inline XMVECTOR __vectorcall Eval() const { return EvalSubtract(a, b); } };
+		template<typename A, typename B> struct MultiplyNode { A a; B b; inline XMVECTOR __vectorcall Eval() const { return XMVectorMultiply(a.Eval(), b.Eval()); } };
+		template<typename A, typename B> struct DivideNode { A a; B b; inline XMVECTOR __vectorcall Eval() const { return XMVectorDivide(a.Eval(), b.Eval()); } };
+		template<typename A> struct NegateNode { A a; inline XMVECTOR __vectorcall Eval() const { return XMVectorNegate(a.Eval()); } };
+
+		// Sums and differences that have a product on either side become multiply-adds
+		template<typename A, typename B>
+		inline XMVECTOR __vectorcall EvalAdd(const A& a, const B& b) { return XMVectorAdd(a.Eval(), b.Eval()); }
+
+		template<typename A, typename B, typename C>
+		inline XMVECTOR __vectorcall EvalAdd(const MultiplyNode<A, B>& m, const C& c) { return XMVectorMultiplyAdd(m.a.Eval(), m.b.Eval(), c.Eval()); }
+
+		template<typename A, typename B, typename C>
+		inline XMVECTOR __vectorcall EvalAdd(const C& c, const MultiplyNode<A, B>& m) { return XMVectorMultiplyAdd(m.a.Eval(), m.b.Eval(), c.Eval()); }
+
+		template<typename A, typename B, typename C, typename D>
+		inline XMVECTOR __vectorcall EvalAdd(const MultiplyNode<A, B>& m, const MultiplyNode<C, D>& n) { return XMVectorMultiplyAdd(m.a.Eval(), m.b.Eval(), n.Eval()); }
+
+		template<typename A, typename B>
+		inline XMVECTOR __vectorcall EvalSubtract(const A& a, const B& b) { return XMVectorSubtract(a.Eval(), b.Eval()); }
+
+		template<typename A, typename B, typename C>
+		inline XMVECTOR __vectorcall EvalSubtract(const MultiplyNode<A, B>& m, const C& c) { return XMVectorMultiplyAdd(m.a.Eval(), m.b.Eval(), XMVectorNegate(c.Eval())); }
+
+		template<typename A, typename B, typename C>
+		inline XMVECTOR __vectorcall EvalSubtract(const C& c, const MultiplyNode<A, B>& m) { return XMVectorNegativeMultiplySubtract(m.a.Eval(), m.b.Eval(), c.Eval()); }
+
+		template<typename A, typename B, typename C, typename D>
+		inline XMVECTOR __vectorcall EvalSubtract(const MultiplyNode<A, B>& m, const MultiplyNode<C, D>& n) { return XMVectorNegativeMultiplySubtract(n.a.Eval(), n.b.Eval(), m.Eval()); }
+	}
+
+	// A deferred float vector expression of the given rank. See Fuse.
+	template<int Rank, typename Node>
+	struct VectorExpression
+	{
+		Node _node;
+
+		inline Vector<float, Rank, true> __vectorcall Evaluate() const { return _node.Eval(); }
+		inline operator Vector<float, Rank, true>() const { return _node.Eval(); }
+	};
+
+	template<int Rank, bool Align>
+	inline VectorExpression<Rank, Details::ValueNode> __vectorcall Fuse(const Vector<float, Rank, Align>& v)
+	{
+		return { { (XMVECTOR)v } };
+	}
+
+#define VECTOR_EXPRESSION_OPERATOR(op, NodeType) \
+	template<int Rank, typename A, typename B> \
+	inline VectorExpression<Rank, Details::NodeType<A, B>> __vectorcall operator op(const VectorExpression<Rank, A>& a, const VectorExpression<Rank, B>& b) \
+		{ return { { a._node, b._node } }; } \
+	template<int Rank, typename A, bool Align> \
+	inline VectorExpression<Rank, Details::NodeType<A, Details::ValueNode>> __vectorcall operator op(const VectorExpression<Rank, A>& a, const Vector<float, Rank, Align>& b) \
+		{ return { { a._node, { (XMVECTOR)b } } }; } \
+	template<int Rank, typename B, bool Align> \
+	inline VectorExpression<Rank, Details::NodeType<Details::ValueNode, B>> __vectorcall operator op(const Vector<float, Rank, Align>& a, const VectorExpression<Rank, B>& b) \
+		{ return { { { (XMVECTOR)a }, b._node } }; }
+
+	VECTOR_EXPRESSION_OPERATOR(+, AddNode)
+	VECTOR_EXPRESSION_OPERATOR(-, SubtractNode)
+	VECTOR_EXPRESSION_OPERATOR(*, MultiplyNode)
+	VECTOR_EXPRESSION_OPERATOR(/, DivideNode)
+
+#undef VECTOR_EXPRESSION_OPERATOR
+
+	template<int Rank, typename A>
+	inline VectorExpression<Rank, Details::MultiplyNode<A, Details::ValueNode>> __vectorcall operator *(const VectorExpression<Rank, A>& a, float b)
+	{
+		return { { a._node, { XMVectorReplicate(b) } } };
+	}
+
+	template<int Rank, typename B>
+	inline VectorExpression<Rank, Details::MultiplyNode<Details::ValueNode, B>> __vectorcall operator *(float a, const VectorExpression<Rank, B>& b)
+	{
+		return { { { XMVectorReplicate(a) }, b._node } };
+	}
+
+	template<int Rank, typename A>
+	inline VectorExpression<Rank, Details::MultiplyNode<A, Details::ValueNode>> __vectorcall operator /(const VectorExpression<Rank, A>& a, float b)
+	{
+		return { { a._node, { XMVectorReplicate(1.0f / b) } } };
+	}
+
+	template<int Rank, typename A>
+	inline VectorExpression<Rank, Details::NegateNode<A>> __vectorcall operator -(const VectorExpression<Rank, A>& a)
+	{
+		return { { a._node } };
+	}
+}
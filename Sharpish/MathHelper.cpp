@@ -1,5 +1,7 @@
 #include "Sharpish.h"
 #include "MathHelper.h"
+#include "MathDispatch.h"
+#include "MathParallel.h"
 
 using namespace CS;
 using namespace std;
@@ -52,16 +54,16 @@ bool Help::Math::SRTDecomposition(const Float4x4A& m,
 {
 	Float4x4A residual = m;
 
-	float det = m.Determinant;
+	float det = m.GetDeterminant();
 
 	bool insideOut = det < 0;
 
 	if(fabs(det) < 1e-8)
 		return false;
 
-	Float3A xaxis = m.Row[0].XYZ;
-	Float3A yaxis = m.Row[1].XYZ;
-	Float3A zaxis = m.Row[2].XYZ;
+	Float3A xaxis = m.GetRow(0).GetXYZ();
+	Float3A yaxis = m.GetRow(1).GetXYZ();
+	Float3A zaxis = m.GetRow(2).GetXYZ();
 
 	if(insideOut)
 		xaxis *= -1;
@@ -71,16 +73,16 @@ bool Help::Math::SRTDecomposition(const Float4x4A& m,
 	zaxis = zaxis.Normalize();
 
 	if (outPosition)
-		*outPosition = m.Row[3].XYZ;
+		*outPosition = m.GetRow(3).GetXYZ();
 
-	residual.Row[3] = Float4A(0, 0, 0, 1);
+	residual.SetRow(3, Float4A(0, 0, 0, 1));
 
 	Float3A endmid = (xaxis + yaxis + zaxis).Normalize();
 	Float3A startmid = Float3A::One.Normalize();
 	QuaternionA midrotation = QuaternionA::Identity;
     Float3A midRotAxis = startmid.Cross(endmid);
 
-	if (midRotAxis.LengthSquared > 1e-8)
+	if (midRotAxis.GetLengthSquared() > 1e-8)
     {
         float angle = acos(max(-1.0f, min(1.0f, startmid.Dot(endmid))));
 		midRotAxis = midRotAxis.Normalize();
@@ -89,9 +91,9 @@ bool Help::Math::SRTDecomposition(const Float4x4A& m,
 
 	Float4x4A midRotMat = Float4x4A::RotationQuaternion(midrotation);
 		
-    float xRot = AngleAround(midRotMat.Row[0].XYZ, xaxis, endmid);
-    float yRot = AngleAround(midRotMat.Row[1].XYZ, yaxis, endmid);
-    float zRot = AngleAround(midRotMat.Row[2].XYZ, zaxis, endmid);
+    float xRot = AngleAround(midRotMat.GetRow(0).GetXYZ(), xaxis, endmid);
+    float yRot = AngleAround(midRotMat.GetRow(1).GetXYZ(), yaxis, endmid);
+    float zRot = AngleAround(midRotMat.GetRow(2).GetXYZ(), zaxis, endmid);
 
 	while(yRot - xRot > XM_PI) yRot -= XM_2PI;
 	while(xRot - yRot > XM_PI) yRot += XM_2PI;
@@ -101,7 +103,7 @@ bool Help::Math::SRTDecomposition(const Float4x4A& m,
 
 	QuaternionA orient = midrotation * QuaternionA::FromAxisAngle(endmid, (xRot + yRot + zRot) / 3.0f);
 
-	Float4x4A invRot = Float4x4A::RotationQuaternion(orient.Inverse);
+	Float4x4A invRot = Float4x4A::RotationQuaternion(orient.GetInverse());
 		
 	residual *= invRot;
 
@@ -110,9 +112,9 @@ bool Help::Math::SRTDecomposition(const Float4x4A& m,
 
 	if(outScale)
 	{
-		outScale->X = residual.Row[0].XYZ.Length;
-		outScale->Y = residual.Row[1].XYZ.Length;
-		outScale->Z = residual.Row[2].XYZ.Length;
+		outScale->X = residual.GetRow(0).GetXYZ().GetLength();
+		outScale->Y = residual.GetRow(1).GetXYZ().GetLength();
+		outScale->Z = residual.GetRow(2).GetXYZ().GetLength();
 
 		if(insideOut) outScale->X *= -1;
 
@@ -131,7 +133,7 @@ float Help::Math::MatrixNorm(const Float4x4A& mat)
 
 	for(int i = 0;i < 4;i++)
 	{
-		Float4A row = mat.Row[i];
+		Float4A row = mat.GetRow(i);
 		float rowsum = row.Abs().Dot(Float4A::One);
 		max = MAX(max, rowsum);
 	}
@@ -203,8 +205,8 @@ Float4x4 Help::Math::ComputeProjection(double fov, double aspect, const Range& d
 	return Float4x4(
 		(float)xscale, 0, 0, 0,
 		0, (float)yscale, 0, 0,
-		0, 0, depthRange.Maximum / depthRange.Span, 1,
-		0, 0, -depthRange.Minimum * depthRange.Maximum / depthRange.Span, 0);
+		0, 0, depthRange.Maximum / depthRange.GetSpan(), 1,
+		0, 0, -depthRange.Minimum * depthRange.Maximum / depthRange.GetSpan(), 0);
 }
 
 Float3x3 LookAt(const Float3& at, const Float3& up)
@@ -271,7 +273,7 @@ BoundingSphere Help::Math::GetFrustumBoundingSphere(const Float4x4A& frustum)
 	static Float3A Near(0,0,0);
 	static Float3A Far(0,0,1);
 
-	auto inv = frustum.Inverse;
+	auto inv = frustum.GetInverse();
 
 	auto cornerA = CornerA.Project(inv);
 	auto cornerB = CornerB.Project(inv);
@@ -295,11 +297,11 @@ BoundingSphere Help::Math::GetFrustumBoundingSphere(const Float4x4A& frustum)
 	//2k(An-Bn).Vc == Bn.Bn-An.An
 	//k = (Bn.Bn-An.An)/(2(Ab-Bn).Vc)
 	
-	float k = (nB.LengthSquared - nA.LengthSquared) / (2 * (nA - nB).Dot(disp));
+	float k = (nB.GetLengthSquared() - nA.GetLengthSquared()) / (2 * (nA - nB).Dot(disp));
 
 	auto center = n + disp * k;
 
-	float radius = (cornerA - center).Length;
+	float radius = (cornerA - center).GetLength();
 	return BoundingSphere(center, radius);
 }
 
@@ -369,11 +371,11 @@ bool Help::Math::IntersectLineSphere(const BoundingSphereA& sphere, const Float3
 {
 	Float4A spherev = sphere;
 
-	Float3A ctol = lineAnchor - spherev;
+	Float3A ctol = lineAnchor - spherev.GetXYZ();
 
-	float A = lineDirection.LengthSquared;
+	float A = lineDirection.GetLengthSquared();
 	float B = 2 * lineDirection.Dot(ctol);
-    float C = ctol.LengthSquared - (spherev.W * spherev.W);
+    float C = ctol.GetLengthSquared() - (spherev.GetW() * spherev.GetW());
 
 	float k1,k2;
 
@@ -393,11 +395,11 @@ bool Help::Math::IntersectThickLineSphere(const BoundingSphereA& sphere, const F
 
 int Help::Math::IntersectRaySphere(const BoundingSphereA& sphere, const Float3A& rayOrigin, const Float3A& rayDirection, Float3A& outPointA, Float3A& outPointB)
 {
-    Float3A ctol =  rayOrigin - sphere.Center;
+    Float3A ctol =  rayOrigin - sphere.GetCenter();
 
-	float A = rayDirection.LengthSquared;
+	float A = rayDirection.GetLengthSquared();
 	float B = 2 * rayDirection.Dot(ctol);
-    float C = ctol.LengthSquared - (sphere.Radius * sphere.Radius);
+    float C = ctol.GetLengthSquared() - (sphere.GetRadius() * sphere.GetRadius());
 
 	float k1,k2;
 
@@ -435,14 +437,14 @@ int Help::Math::IntersectLineSegSphere(const BoundingSphereA& sphere, const Floa
 {
 	Float4A spherev = sphere;
 
-	Float4 ctol = lineA - spherev;
+	Float4 ctol = (XMVECTOR)(lineA - spherev.GetXYZ());
 	auto lineDirection = lineB - lineA;
-	auto r = spherev.W;
+	auto r = spherev.GetW();
 
 	ctol.W = -r;
-	float A = lineDirection.LengthSquared;
-	float B = 2 * lineDirection.Dot(ctol.XYZ);
-	float C = ctol.XYZ.LengthSquared -  r*r;
+	float A = lineDirection.GetLengthSquared();
+	float B = 2 * lineDirection.Dot(ctol.GetXYZ());
+	float C = ctol.GetXYZ().GetLengthSquared() -  r*r;
 
 	float k1,k2;
 
@@ -632,7 +634,7 @@ bool Help::Math::ProjectPixelToRay(float ssx, float ssy, const Float4x4A& projec
 	auto nearVec = Float3A(ssx, ssy, 0);
 	auto farVec = Float3A(ssx, ssy, 1);
 
-	auto pinv = projection.Inverse;
+	auto pinv = projection.GetInverse();
 
 	auto rayOrigin = nearVec.Project(pinv);
 	auto rayEnd = farVec.Project(pinv);
@@ -642,3 +644,417 @@ bool Help::Math::ProjectPixelToRay(float ssx, float ssy, const Float4x4A& projec
 
 	return true;
 }
+
+Help::Math::SimdLevel Help::Math::GetSimdLevel() { return (SimdLevel)Details::ActiveSimdLevel.load(); }
+Help::Math::SimdLevel Help::Math::GetSupportedSimdLevel() { return Details::DetectSimdLevel(); }
+
+void Help::Math::SetSimdLevel(SimdLevel level)
+{
+	auto supported = Details::DetectSimdLevel();
+	Details::ActiveSimdLevel = (int)(level < supported ? level : supported);
+}
+
+namespace
+{
+	template<typename T>
+	struct AosStride { static const int Value = sizeof(T) / sizeof(float); };
+
+	// Scalar tail results go through this so Float3A outputs match the zero W written by the SIMD path.
+	inline XMVECTOR __vectorcall ClearW(XMVECTOR v) { return XMVectorSelect(XMVectorZero(), v, g_XMSelect1110); }
+
+	// The ops BinaryKernel applies, as they apply to one vector; BinaryLanes applies them to registers
+	struct CrossOp
+	{
+		XMVECTOR __vectorcall Apply(XMVECTOR a, XMVECTOR b) const { return XMVector3Cross(a, b); }
+	};
+
+	struct LerpOp
+	{
+		float u;
+
+		XMVECTOR __vectorcall Apply(XMVECTOR a, XMVECTOR b) const { return XMVectorLerp(a, b, u); }
+	};
+
+	struct MinOp
+	{
+		XMVECTOR __vectorcall Apply(XMVECTOR a, XMVECTOR b) const { return XMVectorMin(a, b); }
+	};
+
+	struct MaxOp
+	{
+		XMVECTOR __vectorcall Apply(XMVECTOR a, XMVECTOR b) const { return XMVectorMax(a, b); }
+	};
+
+	struct ScaleAddOp
+	{
+		float scale;
+
+		XMVECTOR __vectorcall Apply(XMVECTOR a, XMVECTOR b) const { return XMVectorMultiplyAdd(a, XMVectorReplicate(scale), b); }
+	};
+
+	inline size_t CountBits(uint32_t bits)
+	{
+		size_t n = 0;
+		for (; bits; bits &= bits - 1)
+			n++;
+		return n;
+	}
+
+	struct DecomposeJob
+	{
+		const float* M;
+		float* Position;
+		float* Orientation;
+		float* Scale;
+		float* Residual;
+		bool* Decomposed;
+	};
+
+	// The functions TranscendentalKernel evaluates, defined for lanes by TranscendentalLanes
+	struct SinOp { }; struct SinEstOp { };
+	struct CosOp { }; struct CosEstOp { };
+	struct ASinOp { }; struct ASinEstOp { };
+	struct ACosOp { }; struct ACosEstOp { };
+	struct ATanOp { }; struct ATanEstOp { };
+	struct ExpOp { }; struct ExpEstOp { };
+	struct LogOp { }; struct LogEstOp { };
+	struct SinCosOp { }; struct SinCosEstOp { };
+	struct ATan2Op { }; struct ATan2EstOp { };
+
+	// Sources of boxes, spheres and rays for PacketKernel, loaded into lanes by PacketSource
+	struct BoxArraySource
+	{
+		const BoundingBoxA* Boxes;
+
+		inline void Offset(size_t n) { Boxes += n; }
+	};
+
+	struct BoxStreamSource
+	{
+		const float* Minima[3];
+		const float* Maxima[3];
+
+		inline void Offset(size_t n) { for (int k = 0; k < 3; k++) { Minima[k] += n; Maxima[k] += n; } }
+	};
+
+	struct SphereArraySource
+	{
+		const BoundingSphereA* Spheres;
+
+		inline void Offset(size_t n) { Spheres += n; }
+	};
+
+	struct SphereStreamSource
+	{
+		const float* Center[3];
+		const float* Radius;
+
+		inline void Offset(size_t n) { for (int k = 0; k < 3; k++) Center[k] += n; Radius += n; }
+	};
+
+	struct RayStreamSource
+	{
+		const float* Origin[3];
+		const float* Direction[3];
+
+		inline void Offset(size_t n) { for (int k = 0; k < 3; k++) { Origin[k] += n; Direction[k] += n; } }
+	};
+
+	// One ray against a register of boxes
+	struct RayBoxesTest
+	{
+		struct Query
+		{
+			float Origin[3];
+			float Inverse[3];
+			float MaxDistance;
+		};
+	};
+
+	// A register of rays against one box
+	struct RaysBoxTest
+	{
+		struct Query
+		{
+			float Minima[3];
+			float Maxima[3];
+			float MaxDistance;
+		};
+	};
+
+	// One ray against a register of spheres: |o + t d - c|^2 = r^2 with a = d.d, b = (o - c).d (half the usual b)
+	struct RaySpheresTest
+	{
+		struct Query
+		{
+			float Origin[3];
+			float Direction[3];
+			float InverseA;
+			float MaxDistance;
+		};
+	};
+}
+
+#define SHARPISH_KERNELS "MathHelperKernels.inl"
+#include "MathKernels.h"
+
+namespace
+{
+	// Transcendentals cost more per element than the vector kernels, so smaller batches are worth splitting.
+	const size_t TranscendentalGranularity = 4096;
+
+	template<typename F>
+	void RunTranscendental(const float* a, const float* b, float* dst0, float* dst1, size_t count)
+	{
+		auto kernel = SHARPISH_KERNEL(TranscendentalKernel<F>)::Get();
+		Details::ParallelFor(count, TranscendentalGranularity, [&](size_t begin, size_t end)
+		{
+			kernel(a + begin, b ? b + begin : nullptr, dst0 + begin, dst1 ? dst1 + begin : nullptr, end - begin);
+		});
+	}
+
+	// Batches at least this large are split across threads. Multiples of 16 keep every chunk on whole registers.
+	const size_t MatrixBatchGranularity = 1024;
+
+	template<typename T, typename Op>
+	inline void RunBinary(const T* a, const T* b, T* dst, size_t count, const Op& op)
+	{
+		SHARPISH_KERNEL(BinaryKernel<T, Op>)::Get()(a, b, dst, count, op);
+	}
+}
+
+void Help::Math::Normalize(const Float3* src, Float3* dst, size_t count) { Normalize<Precision::Exact>(src, dst, count); }
+void Help::Math::Normalize(const Float3A* src, Float3A* dst, size_t count) { Normalize<Precision::Exact>(src, dst, count); }
+void Help::Math::Length(const Float3* src, float* dst, size_t count) { Length<Precision::Exact>(src, dst, count); }
+void Help::Math::Length(const Float3A* src, float* dst, size_t count) { Length<Precision::Exact>(src, dst, count); }
+
+template<Precision P> void Help::Math::Normalize(const Float3* src, Float3* dst, size_t count) { SHARPISH_KERNEL(NormalizeKernel<Float3, P>)::Get()(src, dst, count); }
+template<Precision P> void Help::Math::Normalize(const Float3A* src, Float3A* dst, size_t count) { SHARPISH_KERNEL(NormalizeKernel<Float3A, P>)::Get()(src, dst, count); }
+template<Precision P> void Help::Math::Length(const Float3* src, float* dst, size_t count) { SHARPISH_KERNEL(LengthKernel<Float3, P>)::Get()(src, dst, count); }
+template<Precision P> void Help::Math::Length(const Float3A* src, float* dst, size_t count) { SHARPISH_KERNEL(LengthKernel<Float3A, P>)::Get()(src, dst, count); }
+
+#define INSTANTIATE_PRECISION(P) \
+	template void Help::Math::Normalize<P>(const Float3* src, Float3* dst, size_t count); \
+	template void Help::Math::Normalize<P>(const Float3A* src, Float3A* dst, size_t count); \
+	template void Help::Math::Length<P>(const Float3* src, float* dst, size_t count); \
+	template void Help::Math::Length<P>(const Float3A* src, float* dst, size_t count);
+
+INSTANTIATE_PRECISION(Precision::Exact)
+INSTANTIATE_PRECISION(Precision::Refined)
+INSTANTIATE_PRECISION(Precision::Estimate)
+#undef INSTANTIATE_PRECISION
+
+void Help::Math::Dot(const Float3* src, const Float3A& v, float* dst, size_t count) { SHARPISH_KERNEL(DotKernel<Float3>)::Get()(src, v, dst, count); }
+void Help::Math::Dot(const Float3A* src, const Float3A& v, float* dst, size_t count) { SHARPISH_KERNEL(DotKernel<Float3A>)::Get()(src, v, dst, count); }
+void Help::Math::Cross(const Float3* a, const Float3* b, Float3* dst, size_t count) { RunBinary(a, b, dst, count, CrossOp()); }
+void Help::Math::Cross(const Float3A* a, const Float3A* b, Float3A* dst, size_t count) { RunBinary(a, b, dst, count, CrossOp()); }
+void Help::Math::Lerp(const Float3* a, const Float3* b, float u, Float3* dst, size_t count) { RunBinary(a, b, dst, count, LerpOp { u }); }
+void Help::Math::Lerp(const Float3A* a, const Float3A* b, float u, Float3A* dst, size_t count) { RunBinary(a, b, dst, count, LerpOp { u }); }
+void Help::Math::Min(const Float3* a, const Float3* b, Float3* dst, size_t count) { RunBinary(a, b, dst, count, MinOp()); }
+void Help::Math::Min(const Float3A* a, const Float3A* b, Float3A* dst, size_t count) { RunBinary(a, b, dst, count, MinOp()); }
+void Help::Math::Max(const Float3* a, const Float3* b, Float3* dst, size_t count) { RunBinary(a, b, dst, count, MaxOp()); }
+void Help::Math::Max(const Float3A* a, const Float3A* b, Float3A* dst, size_t count) { RunBinary(a, b, dst, count, MaxOp()); }
+void Help::Math::ScaleAdd(const Float3* a, float scale, const Float3* b, Float3* dst, size_t count) { RunBinary(a, b, dst, count, ScaleAddOp { scale }); }
+void Help::Math::ScaleAdd(const Float3A* a, float scale, const Float3A* b, Float3A* dst, size_t count) { RunBinary(a, b, dst, count, ScaleAddOp { scale }); }
+
+void Help::Math::Sin(const float* src, float* dst, size_t count) { RunTranscendental<SinOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::SinEst(const float* src, float* dst, size_t count) { RunTranscendental<SinEstOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::Cos(const float* src, float* dst, size_t count) { RunTranscendental<CosOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::CosEst(const float* src, float* dst, size_t count) { RunTranscendental<CosEstOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::ASin(const float* src, float* dst, size_t count) { RunTranscendental<ASinOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::ASinEst(const float* src, float* dst, size_t count) { RunTranscendental<ASinEstOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::ACos(const float* src, float* dst, size_t count) { RunTranscendental<ACosOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::ACosEst(const float* src, float* dst, size_t count) { RunTranscendental<ACosEstOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::ATan(const float* src, float* dst, size_t count) { RunTranscendental<ATanOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::ATanEst(const float* src, float* dst, size_t count) { RunTranscendental<ATanEstOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::Exp(const float* src, float* dst, size_t count) { RunTranscendental<ExpOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::ExpEst(const float* src, float* dst, size_t count) { RunTranscendental<ExpEstOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::Log(const float* src, float* dst, size_t count) { RunTranscendental<LogOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::LogEst(const float* src, float* dst, size_t count) { RunTranscendental<LogEstOp>(src, nullptr, dst, nullptr, count); }
+void Help::Math::SinCos(const float* src, float* outSin, float* outCos, size_t count) { RunTranscendental<SinCosOp>(src, nullptr, outSin, outCos, count); }
+void Help::Math::SinCosEst(const float* src, float* outSin, float* outCos, size_t count) { RunTranscendental<SinCosEstOp>(src, nullptr, outSin, outCos, count); }
+void Help::Math::ATan2(const float* y, const float* x, float* dst, size_t count) { RunTranscendental<ATan2Op>(y, x, dst, nullptr, count); }
+void Help::Math::ATan2Est(const float* y, const float* x, float* dst, size_t count) { RunTranscendental<ATan2EstOp>(y, x, dst, nullptr, count); }
+
+void Help::Math::MultiplyMany(const Float4x4A* a, const Float4x4A* b, Float4x4A* out, size_t count)
+{
+	auto kernel = SHARPISH_KERNEL(MatrixMultiplyKernel)::Get();
+	Details::ParallelFor(count, MatrixBatchGranularity, [&](size_t begin, size_t end)
+	{
+		kernel((const float*)(a + begin), (const float*)(b + begin), (float*)(out + begin), end - begin);
+	});
+}
+
+void Help::Math::MultiplyMany(const Float4x3A* a, const Float4x3A* b, Float4x3A* out, size_t count)
+{
+	auto kernel = SHARPISH_KERNEL(MatrixMultiplyKernel)::Get();
+	Details::ParallelFor(count, MatrixBatchGranularity, [&](size_t begin, size_t end)
+	{
+		kernel((const float*)(a + begin), (const float*)(b + begin), (float*)(out + begin), end - begin);
+	});
+}
+
+void Help::Math::MultiplyByOne(const Float4x4A* a, const Float4x4A& m, Float4x4A* out, size_t count)
+{
+	auto kernel = SHARPISH_KERNEL(MatrixMultiplyByOneKernel)::Get();
+	Float4x4A rhs = m;
+	Details::ParallelFor(count, MatrixBatchGranularity, [&](size_t begin, size_t end)
+	{
+		kernel((const float*)(a + begin), (const float*)&rhs, (float*)(out + begin), end - begin);
+	});
+}
+
+void Help::Math::MultiplyByOne(const Float4x3A* a, const Float4x3A& m, Float4x3A* out, size_t count)
+{
+	auto kernel = SHARPISH_KERNEL(MatrixMultiplyByOneKernel)::Get();
+	Float4x3A rhs = m;
+	Details::ParallelFor(count, MatrixBatchGranularity, [&](size_t begin, size_t end)
+	{
+		kernel((const float*)(a + begin), (const float*)&rhs, (float*)(out + begin), end - begin);
+	});
+}
+
+void Help::Math::MultiplyByParents(const Float4x3A* a, const int* parents, Float4x3A* out, size_t begin, size_t end)
+{
+	SHARPISH_KERNEL(MatrixMultiplyByParentKernel)::Get()((const float*)a, parents, (float*)out, begin, end);
+}
+
+void Help::Math::InverseMany(const Float4x4A* m, Float4x4A* out, size_t count, float* outDeterminants)
+{
+	auto kernel = SHARPISH_KERNEL(MatrixInverseKernel)::Get();
+	Details::ParallelFor(count, MatrixBatchGranularity, [&](size_t begin, size_t end)
+	{
+		kernel((const float*)(m + begin), (float*)(out + begin), outDeterminants ? outDeterminants + begin : nullptr, end - begin);
+	});
+}
+
+void Help::Math::InverseAffine(const Float4x3A* m, Float4x3A* out, size_t count)
+{
+	auto kernel = SHARPISH_KERNEL(AffineInverseKernel)::Get();
+	Details::ParallelFor(count, MatrixBatchGranularity, [&](size_t begin, size_t end)
+	{
+		kernel((const float*)(m + begin), (float*)(out + begin), end - begin);
+	});
+}
+
+void Help::Math::DeterminantMany(const Float4x4A* m, float* out, size_t count)
+{
+	auto kernel = SHARPISH_KERNEL(MatrixDeterminantKernel)::Get();
+	Details::ParallelFor(count, MatrixBatchGranularity, [&](size_t begin, size_t end)
+	{
+		kernel((const float*)(m + begin), out + begin, end - begin);
+	});
+}
+
+namespace
+{
+	size_t RunDecompose(const float* m, Float3* outPosition, Quaternion* outOrientation, Float3* outScale,
+		Float4x3A* outResidual, size_t count, bool* outDecomposed)
+	{
+		auto kernel = SHARPISH_KERNEL(DecomposeKernel)::Get();
+		std::atomic<size_t> decomposed(0);
+		Details::ParallelFor(count, MatrixBatchGranularity, [&](size_t begin, size_t end)
+		{
+			DecomposeJob job = { m + begin * 16,
+				outPosition ? (float*)(outPosition + begin) : nullptr,
+				outOrientation ? (float*)(outOrientation + begin) : nullptr,
+				outScale ? (float*)(outScale + begin) : nullptr,
+				outResidual ? (float*)(outResidual + begin) : nullptr,
+				outDecomposed ? outDecomposed + begin : nullptr };
+			decomposed += kernel(job, end - begin);
+		});
+		return decomposed;
+	}
+}
+
+size_t Help::Math::DecomposeMany(const Float4x4A* m, Float3* outPosition, Quaternion* outOrientation, Float3* outScale,
+	Float4x3A* outResidual, size_t count, bool* outDecomposed)
+{
+	return RunDecompose((const float*)m, outPosition, outOrientation, outScale, outResidual, count, outDecomposed);
+}
+
+size_t Help::Math::DecomposeMany(const Float4x3A* m, Float3* outPosition, Quaternion* outOrientation, Float3* outScale,
+	Float4x3A* outResidual, size_t count, bool* outDecomposed)
+{
+	return RunDecompose((const float*)m, outPosition, outOrientation, outScale, outResidual, count, outDecomposed);
+}
+
+namespace
+{
+	// Batches at least this large are split across threads. A multiple of 32, so each thread writes whole words
+	// of the hit mask.
+	const size_t RayBatchGranularity = 8192;
+
+	inline float SafeInverse(float d)
+	{
+		return fabs(d) < FLT_MIN ? (signbit(d) ? -FLT_MAX : FLT_MAX) : 1 / d;
+	}
+
+	template<typename T, typename S>
+	size_t RunPacket(const typename T::Query& query, const S& source, size_t count, uint32_t* outHits, float* outEnter)
+	{
+		auto kernel = SHARPISH_KERNEL(PacketKernel<T, S>)::Get();
+		std::atomic<size_t> total(0);
+		Details::ParallelFor(count, RayBatchGranularity, [&](size_t begin, size_t end)
+		{
+			S offset = source;
+			offset.Offset(begin);
+			total += kernel(query, offset, end - begin, outHits + begin / 32, outEnter ? outEnter + begin : nullptr);
+		});
+		return total;
+	}
+
+	RayBoxesTest::Query MakeRayBoxesQuery(const Float3A& rayOrigin, const Float3A& rayDirection, float maxDistance)
+	{
+		Float3 o = rayOrigin, d = rayDirection;
+		RayBoxesTest::Query q = { { o.X, o.Y, o.Z }, { SafeInverse(d.X), SafeInverse(d.Y), SafeInverse(d.Z) }, maxDistance };
+		return q;
+	}
+
+	RaySpheresTest::Query MakeRaySpheresQuery(const Float3A& rayOrigin, const Float3A& rayDirection, float maxDistance)
+	{
+		Float3 o = rayOrigin, d = rayDirection;
+		float a = d.X * d.X + d.Y * d.Y + d.Z * d.Z;
+		RaySpheresTest::Query q = { { o.X, o.Y, o.Z }, { d.X, d.Y, d.Z }, a > 0 ? 1 / a : 0, maxDistance };
+		return q;
+	}
+}
+
+size_t Help::Math::IntersectRayBoxes(const Float3A& rayOrigin, const Float3A& rayDirection, const BoundingBoxA* boxes, size_t count,
+	uint32_t* outHits, float* outEnter, float maxDistance)
+{
+	return RunPacket<RayBoxesTest>(MakeRayBoxesQuery(rayOrigin, rayDirection, maxDistance), BoxArraySource { boxes }, count, outHits, outEnter);
+}
+
+size_t Help::Math::IntersectRayBoxes(const Float3A& rayOrigin, const Float3A& rayDirection, const Float3Stream& minima, const Float3Stream& maxima,
+	uint32_t* outHits, float* outEnter, float maxDistance)
+{
+	if (minima.size() != maxima.size()) throw ArgumentException("maxima", "Stream sizes differ");
+
+	BoxStreamSource source = { { minima.GetX(), minima.GetY(), minima.GetZ() }, { maxima.GetX(), maxima.GetY(), maxima.GetZ() } };
+	return RunPacket<RayBoxesTest>(MakeRayBoxesQuery(rayOrigin, rayDirection, maxDistance), source, minima.size(), outHits, outEnter);
+}
+
+size_t Help::Math::IntersectRaysBox(const Float3Stream& rayOrigins, const Float3Stream& rayDirections, const BoundingBoxA& box,
+	uint32_t* outHits, float* outEnter, float maxDistance)
+{
+	if (rayOrigins.size() != rayDirections.size()) throw ArgumentException("rayDirections", "Stream sizes differ");
+
+	Float3 minima = box.Minima, maxima = box.Maxima;
+	RaysBoxTest::Query query = { { minima.X, minima.Y, minima.Z }, { maxima.X, maxima.Y, maxima.Z }, maxDistance };
+	RayStreamSource source = { { rayOrigins.GetX(), rayOrigins.GetY(), rayOrigins.GetZ() }, { rayDirections.GetX(), rayDirections.GetY(), rayDirections.GetZ() } };
+	return RunPacket<RaysBoxTest>(query, source, rayOrigins.size(), outHits, outEnter);
+}
+
+size_t Help::Math::IntersectRaySpheres(const Float3A& rayOrigin, const Float3A& rayDirection, const BoundingSphereA* spheres, size_t count,
+	uint32_t* outHits, float* outEnter, float maxDistance)
+{
+	return RunPacket<RaySpheresTest>(MakeRaySpheresQuery(rayOrigin, rayDirection, maxDistance), SphereArraySource { spheres }, count, outHits, outEnter);
+}
+
+size_t Help::Math::IntersectRaySpheres(const Float3A& rayOrigin, const Float3A& rayDirection, const Float4Stream& spheres,
+	uint32_t* outHits, float* outEnter, float maxDistance)
+{
+	SphereStreamSource source = { { spheres.GetX(), spheres.GetY(), spheres.GetZ() }, spheres.GetW() };
+	return RunPacket<RaySpheresTest>(MakeRaySpheresQuery(rayOrigin, rayDirection, maxDistance), source, spheres.size(), outHits, outEnter);
+}
@@ -10,6 +10,17 @@ namespace CS
 			static const float _ScaleUnitFromMeters[9];
 
 		public:
+			// Instruction set used by the batch kernels (the array overloads below, the streams, etc).
+			// Baseline is the XMVECTOR width of the compiled DirectXMath backend.
+			enum class SimdLevel { Baseline, AVX2, AVX512 };
+
+			// The active level is detected from the CPU when the library loads, lowered by the SHARPISH_SIMD
+			// environment variable ("baseline", "avx2" or "avx512") if set. SetSimdLevel forces a level for
+			// benchmarking; requests above GetSupportedSimdLevel() are clamped to it.
+			static SimdLevel GetSimdLevel();
+			static SimdLevel GetSupportedSimdLevel();
+			static void SetSimdLevel(SimdLevel level);
+
 			// TODO Remove this. It's a member of the matrix classes
 			static bool SRTDecomposition(const Float4x4A& m,
 				Float4x4A *outResidual, 
@@ -40,19 +51,90 @@ namespace CS
 
 			static uint32_t GCD(uint32_t a, uint32_t b);
 
+			// Batch operations over arrays of 3D vectors, processed several at a time in SIMD registers.
+			// Source and destination arrays may be the same array. The W component of Float3A results is zero.
+			static void Normalize(const Float3* src, Float3* dst, size_t count);
+			static void Normalize(const Float3A* src, Float3A* dst, size_t count);
+			static void Length(const Float3* src, float* dst, size_t count);
+			static void Length(const Float3A* src, float* dst, size_t count);
+			// Normalize and Length at precision P (see MathPrecision.h). The overloads above use Precision::Exact.
+			template<Precision P> static void Normalize(const Float3* src, Float3* dst, size_t count);
+			template<Precision P> static void Normalize(const Float3A* src, Float3A* dst, size_t count);
+			template<Precision P> static void Length(const Float3* src, float* dst, size_t count);
+			template<Precision P> static void Length(const Float3A* src, float* dst, size_t count);
+			static void Dot(const Float3* src, const Float3A& v, float* dst, size_t count);
+			static void Dot(const Float3A* src, const Float3A& v, float* dst, size_t count);
+			static void Cross(const Float3* a, const Float3* b, Float3* dst, size_t count);
+			static void Cross(const Float3A* a, const Float3A* b, Float3A* dst, size_t count);
+			static void Lerp(const Float3* a, const Float3* b, float u, Float3* dst, size_t count);
+			static void Lerp(const Float3A* a, const Float3A* b, float u, Float3A* dst, size_t count);
+			static void Min(const Float3* a, const Float3* b, Float3* dst, size_t count);
+			static void Min(const Float3A* a, const Float3A* b, Float3A* dst, size_t count);
+			static void Max(const Float3* a, const Float3* b, Float3* dst, size_t count);
+			static void Max(const Float3A* a, const Float3A* b, Float3A* dst, size_t count);
+
+			// dst[i] = a[i] * scale + b[i]
+			static void ScaleAdd(const Float3* a, float scale, const Float3* b, Float3* dst, size_t count);
+			static void ScaleAdd(const Float3A* a, float scale, const Float3A* b, Float3A* dst, size_t count);
+
+			// Transcendental functions over float arrays, using the implementations in MathTranscendental.h (whose
+			// header lists the error bounds). The Est versions use its cheaper tier. dst may equal a source. Large
+			// batches are split across worker threads.
+			static void Sin(const float* src, float* dst, size_t count);
+			static void SinEst(const float* src, float* dst, size_t count);
+			static void Cos(const float* src, float* dst, size_t count);
+			static void CosEst(const float* src, float* dst, size_t count);
+			static void SinCos(const float* src, float* outSin, float* outCos, size_t count);
+			static void SinCosEst(const float* src, float* outSin, float* outCos, size_t count);
+			static void ASin(const float* src, float* dst, size_t count);
+			static void ASinEst(const float* src, float* dst, size_t count);
+			static void ACos(const float* src, float* dst, size_t count);
+			static void ACosEst(const float* src, float* dst, size_t count);
+			static void ATan(const float* src, float* dst, size_t count);
+			static void ATanEst(const float* src, float* dst, size_t count);
+			// dst[i] = atan2(y[i], x[i])
+			static void ATan2(const float* y, const float* x, float* dst, size_t count);
+			static void ATan2Est(const float* y, const float* x, float* dst, size_t count);
+			static void Exp(const float* src, float* dst, size_t count);
+			static void ExpEst(const float* src, float* dst, size_t count);
+			static void Log(const float* src, float* dst, size_t count);
+			static void LogEst(const float* src, float* dst, size_t count);
+
+			// Batch matrix operations over arrays. out may be one of the inputs. Large batches are split across
+			// worker threads.
+			// out[i] = a[i] * b[i]
+			static void MultiplyMany(const Float4x4A* a, const Float4x4A* b, Float4x4A* out, size_t count);
+			static void MultiplyMany(const Float4x3A* a, const Float4x3A* b, Float4x3A* out, size_t count);
+			// out[i] = a[i] * m
+			static void MultiplyByOne(const Float4x4A* a, const Float4x4A& m, Float4x4A* out, size_t count);
+			static void MultiplyByOne(const Float4x3A* a, const Float4x3A& m, Float4x3A* out, size_t count);
+			// out[i] = a[i] * out[parents[i]], or a[i] where parents[i] is negative, for i in [begin, end) in order.
+			// Each parent must come before its children or lie outside the range, so this resolves a flattened
+			// transform hierarchy one contiguous range at a time. Runs on the calling thread.
+			static void MultiplyByParents(const Float4x3A* a, const int* parents, Float4x3A* out, size_t begin, size_t end);
+			// As Float4x4A::Inverse. If outDeterminants is given it receives each matrix's determinant.
+			static void InverseMany(const Float4x4A* m, Float4x4A* out, size_t count, float* outDeterminants = nullptr);
+			// Inverts transforms made of a 3x3 linear part and a translation, which is much cheaper than the
+			// general 4x4 inverse. Singular linear parts produce non-finite results, as Float4x3A::Inverse does.
+			static void InverseAffine(const Float4x3A* m, Float4x3A* out, size_t count);
+			static void DeterminantMany(const Float4x4A* m, float* out, size_t count);
+			// Batch SRT decomposition, much faster than Decompose or SRTDecomposition over large scenes. Each matrix
+			// splits as residual * scale * rotation + translation; the rotation is the one nearest the upper 3x3
+			// (its polar factor), and the residual is the shear left over: identity for matrices built from scale,
+			// rotation and translation alone. As in SRTDecomposition, a negative determinant negates the X scale.
+			// Matrices whose upper 3x3 determinant is below 1e-8 in magnitude are singular: they get the identity
+			// orientation, zero scale and a zero 3x3 residual, and false in outDecomposed. Only the upper 3x3 and the
+			// translation of a Float4x4A are used. Any output may be null. Returns the number decomposed.
+			static size_t DecomposeMany(const Float4x4A* m, Float3* outPosition, Quaternion* outOrientation, Float3* outScale,
+				Float4x3A* outResidual, size_t count, bool* outDecomposed = nullptr);
+			static size_t DecomposeMany(const Float4x3A* m, Float3* outPosition, Quaternion* outOrientation, Float3* outScale,
+				Float4x3A* outResidual, size_t count, bool* outDecomposed = nullptr);
+
 			static BoundingSphere GetFrustumBoundingSphere(const Float4x4A& frustum);
 			static bool ProjectPixelToRay(int x, int y, int width, int height, const Float4x4A& projection, Float3A& outOrigin, Float3A& outDirection);
 			static bool ProjectPixelToRay(float ssx, float ssy, const Float4x4A& projection, Float3A& outOrigin, Float3A& outDirection);
 
-			//static inline bool __vectorcall CullLine(const Float4x4A& projectionTransposed, const Float3A& lineAnchor, const Float3A& lineDirection);
-			//static inline bool __vectorcall CullThickLine(const Float4x4A& projectionTransposed, const Float3A& lineAnchor, const Float3A& lineDirection, float radius);
-			//static inline bool __vectorcall CullRay(const Float4x4A& projectionTransposed, const Float3A& rayOrigin, const Float3A& rayDirection);
-			//static inline bool __vectorcall CullThickRay(const Float4x4A& projectionTransposed, const Float3A& rayOrigin, const Float3A& rayDirection, float radius);
-			//static inline bool __vectorcall CullLineSeg(const Float4x4A& projectionTransposed, const Float3A& pointA, const Float3A& pointB);
-			//static inline bool __vectorcall CullCylinder(const Float4x4A& projectionTransposed, const Float3A& pointA, const Float3A& pointB, float radius);
-			//static inline bool __vectorcall CullSphere(const Float4x4A& projectionTransposed, const BoundingSphere& sphere);
-			//static inline bool __vectorcall CullBox(const Float4x4A& projectionTransposed, const Float3A& minima, const Float3A& maxima);
-			//static inline bool __vectorcall CullCone(const Float4x4A& projectionTransposed, const Float3A& origin, const Float3A& direction, float slope);
+			// Frustum culling of spheres, boxes, lines, rays, segments, cylinders and cones is in FrustumCuller.
 
 			//static bool IntersectLinePlane(const Float4A& plane, const Float3A& lineAnchor, const Float3A& lineDirection, Float3A& outPoint);
 			//static bool IntersectPlanePlane(const Float4A& planeA, const Float4A& planeB, Float3A& outLineAnchor, Float3A& outLineDirection);
@@ -70,6 +152,25 @@ namespace CS
 			static bool IntersectRayBoxLeave(const Float3A& rayOrigin, const Float3A& rayDirection, const BoundingBoxA& box);
 			static bool IntersectRayBoxLeave(const Float3A& rayOrigin, const Float3A& rayDirection, const Float3A& minima, const Float3A& maxima);
 
+			// Packet versions of IntersectRayBoxEnter and IntersectRaySphere: one ray against many boxes or spheres, or
+			// many rays against one box, a SIMD register at a time (8 with AVX2) without branches. Boxes use a slab
+			// test with the ray's inverse direction computed once. Hits are written as a mask, bit i % 32 of
+			// outHits[i / 32] (as FrustumCuller does), and outEnter[i], if given, receives the distance where the ray
+			// enters, in multiples of its direction: 0 if it starts inside, FLT_MAX if it misses. Only hits within
+			// maxDistance count, so a segment is origin + t * direction for t in [0, 1]. Returns the number of hits.
+			// Large batches are split across worker threads.
+			static size_t IntersectRayBoxes(const Float3A& rayOrigin, const Float3A& rayDirection, const BoundingBoxA* boxes, size_t count,
+				uint32_t* outHits, float* outEnter = nullptr, float maxDistance = FLT_MAX);
+			static size_t IntersectRayBoxes(const Float3A& rayOrigin, const Float3A& rayDirection, const Float3Stream& minima, const Float3Stream& maxima,
+				uint32_t* outHits, float* outEnter = nullptr, float maxDistance = FLT_MAX);
+			static size_t IntersectRaysBox(const Float3Stream& rayOrigins, const Float3Stream& rayDirections, const BoundingBoxA& box,
+				uint32_t* outHits, float* outEnter = nullptr, float maxDistance = FLT_MAX);
+			static size_t IntersectRaySpheres(const Float3A& rayOrigin, const Float3A& rayDirection, const BoundingSphereA* spheres, size_t count,
+				uint32_t* outHits, float* outEnter = nullptr, float maxDistance = FLT_MAX);
+			// Spheres as centers in X, Y and Z and radii in W
+			static size_t IntersectRaySpheres(const Float3A& rayOrigin, const Float3A& rayDirection, const Float4Stream& spheres,
+				uint32_t* outHits, float* outEnter = nullptr, float maxDistance = FLT_MAX);
+
 			static bool IntersectThickLineFrustum(const Float4x4A& projectionTransposed, const Float3A& lineAnchor, const Float3A& lineDirection, float lineRadius, Float3A& outPointA, Float3A& outPointB);
 			static bool IntersectThickRayFrustum(const Float4x4A& projectionTransposed, const Float3A& rayStart, const Float3A& rayDirection, float rayRadius, Float3A& outStartPoint, Float3A& outEndPoint);
 			static bool IntersectCylinderFrustum(const Float4x4A& projectionTransposed, const Float3A& pointA, const Float3A& pointB, float radius, Float3A& outPointA, Float3A& outPointB);
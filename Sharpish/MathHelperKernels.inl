@@ -0,0 +1,929 @@
+// The batch kernels of MathHelper.cpp, defined for each lane width by MathKernels.h
+
+	// The lanes of a register of each binary op
+	template<typename Op>
+	struct BinaryLanes;
+
+	template<>
+	struct BinaryLanes<CrossOp>
+	{
+		template<typename L>
+		static inline void Apply(const CrossOp&, typename L::V& ax, typename L::V& ay, typename L::V& az, typename L::V bx, typename L::V by, typename L::V bz)
+		{
+			auto x = L::NegMulAdd(az, by, L::Mul(ay, bz));
+			auto y = L::NegMulAdd(ax, bz, L::Mul(az, bx));
+			auto z = L::NegMulAdd(ay, bx, L::Mul(ax, by));
+			ax = x; ay = y; az = z;
+		}
+	};
+
+	template<>
+	struct BinaryLanes<LerpOp>
+	{
+		template<typename L>
+		static inline void Apply(const LerpOp& op, typename L::V& ax, typename L::V& ay, typename L::V& az, typename L::V bx, typename L::V by, typename L::V bz)
+		{
+			auto vu = L::Splat(op.u);
+			ax = L::MulAdd(L::Sub(bx, ax), vu, ax);
+			ay = L::MulAdd(L::Sub(by, ay), vu, ay);
+			az = L::MulAdd(L::Sub(bz, az), vu, az);
+		}
+	};
+
+	template<>
+	struct BinaryLanes<MinOp>
+	{
+		template<typename L>
+		static inline void Apply(const MinOp&, typename L::V& ax, typename L::V& ay, typename L::V& az, typename L::V bx, typename L::V by, typename L::V bz)
+		{
+			ax = L::Min(ax, bx);
+			ay = L::Min(ay, by);
+			az = L::Min(az, bz);
+		}
+	};
+
+	template<>
+	struct BinaryLanes<MaxOp>
+	{
+		template<typename L>
+		static inline void Apply(const MaxOp&, typename L::V& ax, typename L::V& ay, typename L::V& az, typename L::V bx, typename L::V by, typename L::V bz)
+		{
+			ax = L::Max(ax, bx);
+			ay = L::Max(ay, by);
+			az = L::Max(az, bz);
+		}
+	};
+
+	template<>
+	struct BinaryLanes<ScaleAddOp>
+	{
+		template<typename L>
+		static inline void Apply(const ScaleAddOp& op, typename L::V& ax, typename L::V& ay, typename L::V& az, typename L::V bx, typename L::V by, typename L::V bz)
+		{
+			auto vs = L::Splat(op.scale);
+			ax = L::MulAdd(ax, vs, bx);
+			ay = L::MulAdd(ay, vs, by);
+			az = L::MulAdd(az, vs, bz);
+		}
+	};
+
+	template<typename T, typename Op>
+	struct BinaryKernel
+	{
+		template<typename L>
+		static void Run(const T* a, const T* b, T* dst, size_t count, const Op& op)
+		{
+			typedef Details::AosLanes<L> A;
+			const int S = AosStride<T>::Value;
+			size_t blocks = count - count % L::Width;
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+			{
+				typename L::V ax, ay, az, bx, by, bz;
+				A::template Load3<S>((const float*)(a + i), ax, ay, az);
+				A::template Load3<S>((const float*)(b + i), bx, by, bz);
+				BinaryLanes<Op>::template Apply<L>(op, ax, ay, az, bx, by, bz);
+				A::template Store3<S>((float*)(dst + i), ax, ay, az);
+			}
+
+			for (size_t i = blocks; i < count; i++)
+				dst[i] = T(ClearW(op.Apply(a[i], b[i])));
+		}
+	};
+
+	template<typename T, Precision P>
+	struct NormalizeKernel
+	{
+		template<typename L>
+		static void Run(const T* src, T* dst, size_t count)
+		{
+			typedef Details::AosLanes<L> A;
+			const int S = AosStride<T>::Value;
+			size_t blocks = count - count % L::Width;
+			auto zero = L::Zero();
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+			{
+				typename L::V x, y, z;
+				A::template Load3<S>((const float*)(src + i), x, y, z);
+
+				auto lengthSq = L::MulAdd(x, x, L::MulAdd(y, y, L::Mul(z, z)));
+				auto nonZero = L::Greater(lengthSq, zero);
+
+				if (P == Precision::Exact)
+				{
+					auto length = L::Sqrt(lengthSq);
+					x = L::Select(zero, L::Div(x, length), nonZero);
+					y = L::Select(zero, L::Div(y, length), nonZero);
+					z = L::Select(zero, L::Div(z, length), nonZero);
+				}
+				else
+				{
+					auto scale = L::Select(zero, Details::Precise<L, P>::ReciprocalSqrt(lengthSq), nonZero);
+					x = L::Mul(x, scale);
+					y = L::Mul(y, scale);
+					z = L::Mul(z, scale);
+				}
+
+				A::template Store3<S>((float*)(dst + i), x, y, z);
+			}
+
+			for (size_t i = blocks; i < count; i++)
+				dst[i] = T(ClearW(Details::PreciseVector<3, P>::Normalize(src[i])));
+		}
+	};
+
+	template<typename T, Precision P>
+	struct LengthKernel
+	{
+		template<typename L>
+		static void Run(const T* src, float* dst, size_t count)
+		{
+			typedef Details::AosLanes<L> A;
+			const int S = AosStride<T>::Value;
+			size_t blocks = count - count % L::Width;
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+			{
+				typename L::V x, y, z;
+				A::template Load3<S>((const float*)(src + i), x, y, z);
+				L::StoreUnaligned(dst + i, Details::Precise<L, P>::Sqrt(L::MulAdd(x, x, L::MulAdd(y, y, L::Mul(z, z)))));
+			}
+
+			for (size_t i = blocks; i < count; i++)
+				dst[i] = XMVectorGetX(Details::PreciseVector<3, P>::Length(src[i]));
+		}
+	};
+
+	template<typename T>
+	struct DotKernel
+	{
+		template<typename L>
+		static void Run(const T* src, const Float3A& v, float* dst, size_t count)
+		{
+			typedef Details::AosLanes<L> A;
+			const int S = AosStride<T>::Value;
+			size_t blocks = count - count % L::Width;
+			auto vx = L::Splat(v.GetX());
+			auto vy = L::Splat(v.GetY());
+			auto vz = L::Splat(v.GetZ());
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+			{
+				typename L::V x, y, z;
+				A::template Load3<S>((const float*)(src + i), x, y, z);
+				L::StoreUnaligned(dst + i, L::MulAdd(x, vx, L::MulAdd(y, vy, L::Mul(z, vz))));
+			}
+
+			for (size_t i = blocks; i < count; i++)
+				dst[i] = XMVectorGetX(XMVector3Dot(src[i], v));
+		}
+	};
+
+	// Matrix kernels address each matrix as 16 floats, row-major, 16 floats apart.
+
+	// One or more rows of out = rows of a * b, where b0..b3 hold b's rows broadcast to every group
+	template<typename L>
+	inline typename L::V MultiplyRows(typename L::V rows, typename L::V b0, typename L::V b1, typename L::V b2, typename L::V b3)
+	{
+		auto result = L::Mul(L::template SplatGroupElement<0>(rows), b0);
+		result = L::MulAdd(L::template SplatGroupElement<1>(rows), b1, result);
+		result = L::MulAdd(L::template SplatGroupElement<2>(rows), b2, result);
+		return L::MulAdd(L::template SplatGroupElement<3>(rows), b3, result);
+	}
+
+	struct MatrixMultiplyKernel
+	{
+		template<typename L>
+		static void Run(const float* a, const float* b, float* o, size_t count)
+		{
+			for (size_t i = 0; i < count; i++, a += 16, b += 16, o += 16)
+			{
+				auto b0 = L::BroadcastGroup(b), b1 = L::BroadcastGroup(b + 4), b2 = L::BroadcastGroup(b + 8), b3 = L::BroadcastGroup(b + 12);
+
+				for (int r = 0; r < 16; r += L::Width)
+					L::StoreUnaligned(o + r, MultiplyRows<L>(L::LoadUnaligned(a + r), b0, b1, b2, b3));
+			}
+		}
+	};
+
+	struct MatrixMultiplyByOneKernel
+	{
+		template<typename L>
+		static void Run(const float* a, const float* m, float* o, size_t count)
+		{
+			auto b0 = L::BroadcastGroup(m), b1 = L::BroadcastGroup(m + 4), b2 = L::BroadcastGroup(m + 8), b3 = L::BroadcastGroup(m + 12);
+
+			for (size_t i = 0; i < count; i++, a += 16, o += 16)
+			{
+				for (int r = 0; r < 16; r += L::Width)
+					L::StoreUnaligned(o + r, MultiplyRows<L>(L::LoadUnaligned(a + r), b0, b1, b2, b3));
+			}
+		}
+	};
+
+	struct MatrixMultiplyByParentKernel
+	{
+		template<typename L>
+		static void Run(const float* a, const int* parents, float* o, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				auto src = a + i * 16;
+				auto dst = o + i * 16;
+				int parent = parents[i];
+
+				if (parent < 0)
+				{
+					for (int r = 0; r < 16; r += L::Width)
+						L::StoreUnaligned(dst + r, L::LoadUnaligned(src + r));
+					continue;
+				}
+
+				auto b = o + (size_t)parent * 16;
+				auto b0 = L::BroadcastGroup(b), b1 = L::BroadcastGroup(b + 4), b2 = L::BroadcastGroup(b + 8), b3 = L::BroadcastGroup(b + 12);
+
+				for (int r = 0; r < 16; r += L::Width)
+					L::StoreUnaligned(dst + r, MultiplyRows<L>(L::LoadUnaligned(src + r), b0, b1, b2, b3));
+			}
+		}
+	};
+
+	// a * b - c * d
+	template<typename L>
+	inline typename L::V Det2(typename L::V a, typename L::V b, typename L::V c, typename L::V d) { return L::NegMulAdd(c, d, L::Mul(a, b)); }
+
+	// x * p - y * q + z * r
+	template<typename L>
+	inline typename L::V Cofactor(typename L::V x, typename L::V p, typename L::V y, typename L::V q, typename L::V z, typename L::V r)
+	{
+		return L::MulAdd(z, r, L::NegMulAdd(y, q, L::Mul(x, p)));
+	}
+
+	// The 4x4 inverse and determinant expand along the 2x2 minors of the top two rows (s) and the bottom two (c),
+	// one matrix per lane.
+	template<typename L>
+	struct Minors
+	{
+		typedef typename L::V V;
+		V a00, a01, a02, a03, a10, a11, a12, a13, a20, a21, a22, a23, a30, a31, a32, a33;
+		V s0, s1, s2, s3, s4, s5, c0, c1, c2, c3, c4, c5;
+
+		inline void Load(const float* p)
+		{
+			typedef Details::AosLanes<L> A;
+			A::Load4(p, 16, a00, a01, a02, a03);
+			A::Load4(p + 4, 16, a10, a11, a12, a13);
+			A::Load4(p + 8, 16, a20, a21, a22, a23);
+			A::Load4(p + 12, 16, a30, a31, a32, a33);
+
+			s0 = Det2<L>(a00, a11, a10, a01); s1 = Det2<L>(a00, a12, a10, a02); s2 = Det2<L>(a00, a13, a10, a03);
+			s3 = Det2<L>(a01, a12, a11, a02); s4 = Det2<L>(a01, a13, a11, a03); s5 = Det2<L>(a02, a13, a12, a03);
+			c0 = Det2<L>(a20, a31, a30, a21); c1 = Det2<L>(a20, a32, a30, a22); c2 = Det2<L>(a20, a33, a30, a23);
+			c3 = Det2<L>(a21, a32, a31, a22); c4 = Det2<L>(a21, a33, a31, a23); c5 = Det2<L>(a22, a33, a32, a23);
+		}
+
+		inline V Determinant() const { return L::Add(Cofactor<L>(s0, c5, s1, c4, s2, c3), Cofactor<L>(s3, c2, s4, c1, s5, c0)); }
+	};
+
+	struct MatrixInverseKernel
+	{
+		template<typename L>
+		static void Run(const float* m, float* o, float* determinants, size_t count)
+		{
+			typedef Details::AosLanes<L> A;
+			size_t blocks = count - count % L::Width;
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+			{
+				Minors<L> n;
+				n.Load(m + i * 16);
+
+				auto det = n.Determinant();
+				auto pos = L::Reciprocal(det);
+				auto neg = L::Negate(pos);
+
+				A::Store4(o + i * 16, 16,
+					L::Mul(Cofactor<L>(n.a11, n.c5, n.a12, n.c4, n.a13, n.c3), pos),
+					L::Mul(Cofactor<L>(n.a01, n.c5, n.a02, n.c4, n.a03, n.c3), neg),
+					L::Mul(Cofactor<L>(n.a31, n.s5, n.a32, n.s4, n.a33, n.s3), pos),
+					L::Mul(Cofactor<L>(n.a21, n.s5, n.a22, n.s4, n.a23, n.s3), neg));
+				A::Store4(o + i * 16 + 4, 16,
+					L::Mul(Cofactor<L>(n.a10, n.c5, n.a12, n.c2, n.a13, n.c1), neg),
+					L::Mul(Cofactor<L>(n.a00, n.c5, n.a02, n.c2, n.a03, n.c1), pos),
+					L::Mul(Cofactor<L>(n.a30, n.s5, n.a32, n.s2, n.a33, n.s1), neg),
+					L::Mul(Cofactor<L>(n.a20, n.s5, n.a22, n.s2, n.a23, n.s1), pos));
+				A::Store4(o + i * 16 + 8, 16,
+					L::Mul(Cofactor<L>(n.a10, n.c4, n.a11, n.c2, n.a13, n.c0), pos),
+					L::Mul(Cofactor<L>(n.a00, n.c4, n.a01, n.c2, n.a03, n.c0), neg),
+					L::Mul(Cofactor<L>(n.a30, n.s4, n.a31, n.s2, n.a33, n.s0), pos),
+					L::Mul(Cofactor<L>(n.a20, n.s4, n.a21, n.s2, n.a23, n.s0), neg));
+				A::Store4(o + i * 16 + 12, 16,
+					L::Mul(Cofactor<L>(n.a10, n.c3, n.a11, n.c1, n.a12, n.c0), neg),
+					L::Mul(Cofactor<L>(n.a00, n.c3, n.a01, n.c1, n.a02, n.c0), pos),
+					L::Mul(Cofactor<L>(n.a30, n.s3, n.a31, n.s1, n.a32, n.s0), neg),
+					L::Mul(Cofactor<L>(n.a20, n.s3, n.a21, n.s1, n.a22, n.s0), pos));
+
+				if (determinants)
+					L::StoreUnaligned(determinants + i, det);
+			}
+
+			for (size_t i = blocks; i < count; i++)
+			{
+				XMVECTOR det;
+				XMStoreFloat4x4A((XMFLOAT4X4A*)(o + i * 16), XMMatrixInverse(&det, XMLoadFloat4x4A((const XMFLOAT4X4A*)(m + i * 16))));
+				if (determinants) determinants[i] = XMVectorGetX(det);
+			}
+		}
+	};
+
+	struct MatrixDeterminantKernel
+	{
+		template<typename L>
+		static void Run(const float* m, float* o, size_t count)
+		{
+			size_t blocks = count - count % L::Width;
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+			{
+				Minors<L> n;
+				n.Load(m + i * 16);
+				L::StoreUnaligned(o + i, n.Determinant());
+			}
+
+			for (size_t i = blocks; i < count; i++)
+				o[i] = XMVectorGetX(XMMatrixDeterminant(XMLoadFloat4x4A((const XMFLOAT4X4A*)(m + i * 16))));
+		}
+	};
+
+	// [R 0; t 1]^-1 = [R^-1 0; -t R^-1 1], with R^-1 from the adjugate of R
+	struct AffineInverseKernel
+	{
+		template<typename L>
+		static void Run(const float* m, float* o, size_t count)
+		{
+			typedef Details::AosLanes<L> A;
+			typedef typename L::V V;
+			size_t blocks = count - count % L::Width;
+			auto zero = L::Zero();
+			auto one = L::Splat(1);
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+			{
+				V a, b, c, d, e, f, g, h, k, tx, ty, tz, unused;
+				A::Load4(m + i * 16, 16, a, b, c, unused);
+				A::Load4(m + i * 16 + 4, 16, d, e, f, unused);
+				A::Load4(m + i * 16 + 8, 16, g, h, k, unused);
+				A::Load4(m + i * 16 + 12, 16, tx, ty, tz, unused);
+
+				auto i00 = Det2<L>(e, k, f, h), i01 = Det2<L>(c, h, b, k), i02 = Det2<L>(b, f, c, e);
+				auto i10 = Det2<L>(f, g, d, k), i11 = Det2<L>(a, k, c, g), i12 = Det2<L>(c, d, a, f);
+				auto i20 = Det2<L>(d, h, e, g), i21 = Det2<L>(b, g, a, h), i22 = Det2<L>(a, e, b, d);
+
+				auto invDet = L::Reciprocal(L::MulAdd(a, i00, L::MulAdd(b, i10, L::Mul(c, i20))));
+				i00 = L::Mul(i00, invDet); i01 = L::Mul(i01, invDet); i02 = L::Mul(i02, invDet);
+				i10 = L::Mul(i10, invDet); i11 = L::Mul(i11, invDet); i12 = L::Mul(i12, invDet);
+				i20 = L::Mul(i20, invDet); i21 = L::Mul(i21, invDet); i22 = L::Mul(i22, invDet);
+
+				auto ox = L::Negate(L::MulAdd(tx, i00, L::MulAdd(ty, i10, L::Mul(tz, i20))));
+				auto oy = L::Negate(L::MulAdd(tx, i01, L::MulAdd(ty, i11, L::Mul(tz, i21))));
+				auto oz = L::Negate(L::MulAdd(tx, i02, L::MulAdd(ty, i12, L::Mul(tz, i22))));
+
+				A::Store4(o + i * 16, 16, i00, i01, i02, zero);
+				A::Store4(o + i * 16 + 4, 16, i10, i11, i12, zero);
+				A::Store4(o + i * 16 + 8, 16, i20, i21, i22, zero);
+				A::Store4(o + i * 16 + 12, 16, ox, oy, oz, one);
+			}
+
+			for (size_t i = blocks; i < count; i++)
+			{
+				XMMATRIX src = XMLoadFloat4x4A((const XMFLOAT4X4A*)(m + i * 16));
+				src.r[0] = XMVectorSetW(src.r[0], 0);
+				src.r[1] = XMVectorSetW(src.r[1], 0);
+				src.r[2] = XMVectorSetW(src.r[2], 0);
+				src.r[3] = XMVectorSetW(src.r[3], 1);
+				XMStoreFloat4x4A((XMFLOAT4X4A*)(o + i * 16), XMMatrixInverse(nullptr, src));
+			}
+		}
+	};
+
+	// Splits the upper 3x3 of each matrix into residual * scale * rotation. The rotation is the orthogonal polar
+	// factor of the rows normalized (with the X row negated if the determinant is negative, as SRTDecomposition
+	// does), found by scaled Newton iteration: X' = (g X + X^-T / g) / 2, where X^-T is the cofactor matrix over
+	// the determinant. Shear-free matrices are already orthogonal after normalizing and converge at once.
+	struct DecomposeKernel
+	{
+		static const int MaxIterations = 16;
+
+		template<typename L>
+		static inline void __vectorcall Cofactors(const typename L::V* x, typename L::V* c)
+		{
+			c[0] = Det2<L>(x[4], x[8], x[7], x[5]); c[1] = Det2<L>(x[5], x[6], x[8], x[3]); c[2] = Det2<L>(x[3], x[7], x[6], x[4]);
+			c[3] = Det2<L>(x[7], x[2], x[1], x[8]); c[4] = Det2<L>(x[8], x[0], x[2], x[6]); c[5] = Det2<L>(x[6], x[1], x[0], x[7]);
+			c[6] = Det2<L>(x[1], x[5], x[4], x[2]); c[7] = Det2<L>(x[2], x[3], x[5], x[0]); c[8] = Det2<L>(x[0], x[4], x[3], x[1]);
+		}
+
+		template<typename L>
+		static inline typename L::V __vectorcall Dot3(const typename L::V* a, const typename L::V* b)
+		{
+			return L::MulAdd(a[0], b[0], L::MulAdd(a[1], b[1], L::Mul(a[2], b[2])));
+		}
+
+		// Decomposes L::Width matrices starting at m, returning the mask of those that weren't singular
+		template<typename L>
+		static uint32_t Block(const DecomposeJob& job, size_t i)
+		{
+			typedef Details::AosLanes<L> A;
+			typedef typename L::V V;
+			auto zero = L::Zero();
+			auto one = L::Splat(1);
+			auto half = L::Splat(0.5f);
+
+			V m[9], tx, ty, tz, unused;
+			A::Load4(job.M + i * 16, 16, m[0], m[1], m[2], unused);
+			A::Load4(job.M + i * 16 + 4, 16, m[3], m[4], m[5], unused);
+			A::Load4(job.M + i * 16 + 8, 16, m[6], m[7], m[8], unused);
+			A::Load4(job.M + i * 16 + 12, 16, tx, ty, tz, unused);
+
+			V c[9];
+			Cofactors<L>(m, c);
+			auto det = Dot3<L>(m, c);
+			auto valid = L::GreaterOrEqual(L::Abs(det), L::Splat(1e-8f));
+			auto insideOut = L::Less(det, zero);
+
+			V s[3];
+			for (int r = 0; r < 3; r++)
+				s[r] = L::Sqrt(Dot3<L>(m + r * 3, m + r * 3));
+			s[0] = L::Select(s[0], L::Negate(s[0]), insideOut);
+
+			// Singular lanes iterate on the identity and are zeroed at the end
+			V x[9];
+			for (int r = 0; r < 3; r++)
+			{
+				auto scale = L::Div(one, s[r]);
+				for (int k = 0; k < 3; k++)
+					x[r * 3 + k] = L::Select(r == k ? one : zero, L::Mul(m[r * 3 + k], scale), valid);
+			}
+
+			for (int iteration = 0; iteration < MaxIterations; iteration++)
+			{
+				Cofactors<L>(x, c);
+				auto d = Dot3<L>(x, c);
+				auto xNormSq = zero, cNormSq = zero;
+				for (int k = 0; k < 9; k++)
+				{
+					xNormSq = L::MulAdd(x[k], x[k], xNormSq);
+					cNormSq = L::MulAdd(c[k], c[k], cNormSq);
+				}
+
+				// g = sqrt(|X^-1| / |X|), which balances the two terms and speeds up convergence far from orthogonal
+				auto g = L::Sqrt(L::Div(L::Sqrt(L::Div(cNormSq, xNormSq)), d));
+				auto a = L::Mul(half, g);
+				auto b = L::Div(half, L::Mul(g, d));
+
+				auto change = zero;
+				for (int k = 0; k < 9; k++)
+				{
+					auto next = L::MulAdd(a, x[k], L::Mul(b, c[k]));
+					auto delta = L::Sub(next, x[k]);
+					change = L::MulAdd(delta, delta, change);
+					x[k] = next;
+				}
+
+				if (!L::MaskBits(L::Greater(change, L::Splat(1e-13f))))
+					break;
+			}
+
+			if (job.Position)
+				A::template Store3<3>(job.Position + i * 3, tx, ty, tz);
+
+			if (job.Orientation)
+			{
+				// Of w, x, y and z, recover the largest from the diagonal and the rest from sums and differences of
+				// the opposing elements, so the square root is never of a small number
+				auto dx = L::Sub(x[5], x[7]), dy = L::Sub(x[6], x[2]), dz = L::Sub(x[1], x[3]);
+				auto pxy = L::Add(x[1], x[3]), pxz = L::Add(x[2], x[6]), pyz = L::Add(x[5], x[7]);
+
+				auto bw = L::Add(one, L::Add(x[0], L::Add(x[4], x[8])));
+				auto bx = L::Add(one, L::Sub(x[0], L::Add(x[4], x[8])));
+				auto by = L::Add(one, L::Sub(x[4], L::Add(x[0], x[8])));
+				auto bz = L::Add(one, L::Sub(x[8], L::Add(x[0], x[4])));
+
+				auto useX = L::MaskAnd(L::Greater(bx, bw), L::MaskAnd(L::GreaterOrEqual(bx, by), L::GreaterOrEqual(bx, bz)));
+				auto useY = L::MaskAnd(L::Greater(by, bw), L::MaskAnd(L::Greater(by, bx), L::GreaterOrEqual(by, bz)));
+				auto useZ = L::MaskAnd(L::Greater(bz, bw), L::MaskAnd(L::Greater(bz, bx), L::Greater(bz, by)));
+
+				auto qx = L::Select(L::Select(L::Select(dx, bx, useX), pxy, useY), pxz, useZ);
+				auto qy = L::Select(L::Select(L::Select(dy, pxy, useX), by, useY), pyz, useZ);
+				auto qz = L::Select(L::Select(L::Select(dz, pxz, useX), pyz, useY), bz, useZ);
+				auto qw = L::Select(L::Select(L::Select(bw, dx, useX), dy, useY), dz, useZ);
+				auto big = L::Select(L::Select(L::Select(bw, bx, useX), by, useY), bz, useZ);
+
+				auto scale = L::Div(half, L::Sqrt(big));
+				A::Store4(job.Orientation + i * 4, 4, L::Mul(qx, scale), L::Mul(qy, scale), L::Mul(qz, scale), L::Mul(qw, scale));
+			}
+
+			if (job.Scale)
+				A::template Store3<3>(job.Scale + i * 3, L::Select(zero, s[0], valid), L::Select(zero, s[1], valid), L::Select(zero, s[2], valid));
+
+			if (job.Residual)
+			{
+				// M = Residual * Scale * Rotation, so Residual[r][k] = (row r of M) . (row k of Rotation) / scale k
+				V res[9];
+				for (int k = 0; k < 3; k++)
+				{
+					auto scale = L::Select(zero, L::Div(one, s[k]), valid);
+					for (int r = 0; r < 3; r++)
+						res[r * 3 + k] = L::Mul(Dot3<L>(m + r * 3, x + k * 3), scale);
+				}
+
+				A::Store4(job.Residual + i * 16, 16, res[0], res[1], res[2], zero);
+				A::Store4(job.Residual + i * 16 + 4, 16, res[3], res[4], res[5], zero);
+				A::Store4(job.Residual + i * 16 + 8, 16, res[6], res[7], res[8], zero);
+				A::Store4(job.Residual + i * 16 + 12, 16, zero, zero, zero, one);
+			}
+
+			auto bits = L::MaskBits(valid);
+
+			if (job.Decomposed)
+			{
+				for (int k = 0; k < L::Width; k++)
+					job.Decomposed[i + k] = (bits >> k) & 1;
+			}
+
+			return bits;
+		}
+
+		// The tail goes through identity-padded temporaries so it takes the same path. Returns the number of
+		// matrices decomposed.
+		template<typename L>
+		static size_t Run(const DecomposeJob& job, size_t count)
+		{
+			size_t blocks = count - count % L::Width;
+			size_t decomposed = 0;
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+				decomposed += CountBits(Block<L>(job, i));
+
+			if (blocks == count)
+				return decomposed;
+
+			alignas(64) float m[L::Width * 16], position[L::Width * 3], orientation[L::Width * 4], scale[L::Width * 3], residual[L::Width * 16];
+			bool flags[L::Width];
+			size_t tail = count - blocks;
+
+			for (int k = 0; k < L::Width; k++)
+				memcpy(m + k * 16, k < (int)tail ? job.M + (blocks + k) * 16 : (const float*)&Float4x4A::Identity, sizeof(float) * 16);
+
+			DecomposeJob padded = { m,
+				job.Position ? position : nullptr, job.Orientation ? orientation : nullptr, job.Scale ? scale : nullptr,
+				job.Residual ? residual : nullptr, job.Decomposed ? flags : nullptr };
+			auto bits = Block<L>(padded, 0) & ((1u << tail) - 1);
+
+			if (job.Position) memcpy(job.Position + blocks * 3, position, sizeof(float) * 3 * tail);
+			if (job.Orientation) memcpy(job.Orientation + blocks * 4, orientation, sizeof(float) * 4 * tail);
+			if (job.Scale) memcpy(job.Scale + blocks * 3, scale, sizeof(float) * 3 * tail);
+			if (job.Residual) memcpy(job.Residual + blocks * 16, residual, sizeof(float) * 16 * tail);
+			if (job.Decomposed) memcpy(job.Decomposed + blocks, flags, sizeof(bool) * tail);
+
+			return decomposed + CountBits(bits);
+		}
+	};
+
+	template<typename F>
+	struct TranscendentalLanes;
+
+	// Evaluates F over arrays a register at a time. The tail goes through a zero-padded register so every element
+	// gets the same approximation.
+	template<typename F>
+	struct TranscendentalKernel
+	{
+		template<typename L>
+		static void Run(const float* a, const float* b, float* dst0, float* dst1, size_t count)
+		{
+			size_t blocks = count - count % L::Width;
+			typename L::V r0, r1;
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+			{
+				TranscendentalLanes<F>::template Apply<L>(L::LoadUnaligned(a + i), b ? L::LoadUnaligned(b + i) : L::Zero(), r0, r1);
+				L::StoreUnaligned(dst0 + i, r0);
+				if (dst1) L::StoreUnaligned(dst1 + i, r1);
+			}
+
+			if (blocks == count)
+				return;
+
+			float ta[L::Width] = { }, tb[L::Width] = { }, t0[L::Width], t1[L::Width];
+			size_t rest = count - blocks;
+			memcpy(ta, a + blocks, rest * sizeof(float));
+			if (b) memcpy(tb, b + blocks, rest * sizeof(float));
+
+			TranscendentalLanes<F>::template Apply<L>(L::LoadUnaligned(ta), L::LoadUnaligned(tb), r0, r1);
+			L::StoreUnaligned(t0, r0);
+			L::StoreUnaligned(t1, r1);
+			memcpy(dst0 + blocks, t0, rest * sizeof(float));
+			if (dst1) memcpy(dst1 + blocks, t1, rest * sizeof(float));
+		}
+	};
+
+#define TRANSCENDENTAL_UNARY_OP(Name) \
+	template<> struct TranscendentalLanes<Name##Op> { template<typename L> static inline void Apply(typename L::V x, typename L::V, typename L::V& r, typename L::V&) \
+		{ r = Details::Transcendental<L>::Name(x); } };
+
+	TRANSCENDENTAL_UNARY_OP(Sin)
+	TRANSCENDENTAL_UNARY_OP(SinEst)
+	TRANSCENDENTAL_UNARY_OP(Cos)
+	TRANSCENDENTAL_UNARY_OP(CosEst)
+	TRANSCENDENTAL_UNARY_OP(ASin)
+	TRANSCENDENTAL_UNARY_OP(ASinEst)
+	TRANSCENDENTAL_UNARY_OP(ACos)
+	TRANSCENDENTAL_UNARY_OP(ACosEst)
+	TRANSCENDENTAL_UNARY_OP(ATan)
+	TRANSCENDENTAL_UNARY_OP(ATanEst)
+	TRANSCENDENTAL_UNARY_OP(Exp)
+	TRANSCENDENTAL_UNARY_OP(ExpEst)
+	TRANSCENDENTAL_UNARY_OP(Log)
+	TRANSCENDENTAL_UNARY_OP(LogEst)
+
+#undef TRANSCENDENTAL_UNARY_OP
+
+	template<> struct TranscendentalLanes<SinCosOp> { template<typename L> static inline void Apply(typename L::V x, typename L::V, typename L::V& s, typename L::V& c)
+		{ Details::Transcendental<L>::SinCos(x, s, c); } };
+	template<> struct TranscendentalLanes<SinCosEstOp> { template<typename L> static inline void Apply(typename L::V x, typename L::V, typename L::V& s, typename L::V& c)
+		{ Details::Transcendental<L>::SinCosEst(x, s, c); } };
+	template<> struct TranscendentalLanes<ATan2Op> { template<typename L> static inline void Apply(typename L::V y, typename L::V x, typename L::V& r, typename L::V&)
+		{ r = Details::Transcendental<L>::ATan2(y, x); } };
+	template<> struct TranscendentalLanes<ATan2EstOp> { template<typename L> static inline void Apply(typename L::V y, typename L::V x, typename L::V& r, typename L::V&)
+		{ r = Details::Transcendental<L>::ATan2Est(y, x); } };
+
+	// 1 / d, with zero (and denormal) components replaced by a huge value of the same sign. A slab test then
+	// never multiplies infinity by zero, so a ray parallel to a slab is inside it exactly when its origin is.
+	template<typename L>
+	inline typename L::V __vectorcall SafeInverse(typename L::V d)
+	{
+		return L::Select(L::Div(L::Splat(1), d), L::CopySign(L::Splat(FLT_MAX), d), L::Less(L::Abs(d), L::Splat(FLT_MIN)));
+	}
+
+	// Slab test of o + t d for t in [0, maxDistance], with inv = SafeInverse(d). enter receives the t where the ray
+	// enters the box, or 0 if it starts inside. Boxes with a minimum above their maximum (e.g. BoundingBoxA's
+	// default, which holds nothing) are never hit.
+	template<typename L>
+	inline typename L::M __vectorcall Slab(const typename L::V* o, const typename L::V* inv, const typename L::V* minima, const typename L::V* maxima,
+		typename L::V maxDistance, typename L::V& enter)
+	{
+		auto tNear = L::Zero();
+		auto tFar = maxDistance;
+
+		for (int k = 0; k < 3; k++)
+		{
+			auto t0 = L::Mul(L::Sub(minima[k], o[k]), inv[k]);
+			auto t1 = L::Mul(L::Sub(maxima[k], o[k]), inv[k]);
+			tNear = L::Max(L::Min(t0, t1), tNear);
+			tFar = L::Min(tFar, L::Max(t0, t1));
+			tFar = L::Select(tFar, L::Splat(-1), L::Greater(minima[k], maxima[k]));
+		}
+
+		enter = tNear;
+		return L::LessOrEqual(tNear, tFar);
+	}
+
+	// Load(source, i, n, ...) reads elements [i, i + n), n at most a register; arrays copy a short last block so
+	// nothing past the end is read, while streams read their padding.
+	template<typename S>
+	struct PacketSource;
+
+	template<>
+	struct PacketSource<BoxArraySource>
+	{
+		template<typename L>
+		static inline void Load(const BoxArraySource& s, size_t i, size_t n, typename L::V* minima, typename L::V* maxima)
+		{
+			typedef Details::AosLanes<L> A;
+			typename L::V unused;
+			auto p = (const float*)(s.Boxes + i);
+			alignas(64) float padded[L::Width * 8];
+
+			if (n < (size_t)L::Width)
+			{
+				zero(padded, L::Width * 8);
+				memcpy(padded, p, sizeof(BoundingBoxA) * n);
+				p = padded;
+			}
+
+			A::Load4(p, 8, minima[0], minima[1], minima[2], unused);
+			A::Load4(p + 4, 8, maxima[0], maxima[1], maxima[2], unused);
+		}
+	};
+
+	template<>
+	struct PacketSource<BoxStreamSource>
+	{
+		template<typename L>
+		static inline void Load(const BoxStreamSource& s, size_t i, size_t, typename L::V* minima, typename L::V* maxima)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				minima[k] = L::Load(s.Minima[k] + i);
+				maxima[k] = L::Load(s.Maxima[k] + i);
+			}
+		}
+	};
+
+	template<>
+	struct PacketSource<SphereArraySource>
+	{
+		template<typename L>
+		static inline void Load(const SphereArraySource& s, size_t i, size_t n, typename L::V* center, typename L::V& radius)
+		{
+			auto p = (const float*)(s.Spheres + i);
+			alignas(64) float padded[L::Width * 4];
+
+			if (n < (size_t)L::Width)
+			{
+				zero(padded, L::Width * 4);
+				memcpy(padded, p, sizeof(BoundingSphereA) * n);
+				p = padded;
+			}
+
+			Details::AosLanes<L>::Load4(p, 4, center[0], center[1], center[2], radius);
+		}
+	};
+
+	template<>
+	struct PacketSource<SphereStreamSource>
+	{
+		template<typename L>
+		static inline void Load(const SphereStreamSource& s, size_t i, size_t, typename L::V* center, typename L::V& radius)
+		{
+			for (int k = 0; k < 3; k++)
+				center[k] = L::Load(s.Center[k] + i);
+			radius = L::Load(s.Radius + i);
+		}
+	};
+
+	template<>
+	struct PacketSource<RayStreamSource>
+	{
+		template<typename L>
+		static inline void Load(const RayStreamSource& s, size_t i, size_t, typename L::V* origin, typename L::V* direction)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				origin[k] = L::Load(s.Origin[k] + i);
+				direction[k] = L::Load(s.Direction[k] + i);
+			}
+		}
+	};
+
+	template<typename T>
+	struct PacketTest;
+
+	template<>
+	struct PacketTest<RayBoxesTest>
+	{
+		template<typename L>
+		struct Prepared
+		{
+			typename L::V Origin[3], Inverse[3], MaxDistance;
+
+			Prepared(const RayBoxesTest::Query& q)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					Origin[k] = L::Splat(q.Origin[k]);
+					Inverse[k] = L::Splat(q.Inverse[k]);
+				}
+				MaxDistance = L::Splat(q.MaxDistance);
+			}
+		};
+
+		template<typename L, typename S>
+		static inline uint32_t Run(const Prepared<L>& ray, const S& source, size_t i, size_t n, typename L::V& enter)
+		{
+			typename L::V minima[3], maxima[3];
+			PacketSource<S>::template Load<L>(source, i, n, minima, maxima);
+			return L::MaskBits(Slab<L>(ray.Origin, ray.Inverse, minima, maxima, ray.MaxDistance, enter));
+		}
+	};
+
+	template<>
+	struct PacketTest<RaysBoxTest>
+	{
+		template<typename L>
+		struct Prepared
+		{
+			typename L::V Minima[3], Maxima[3], MaxDistance;
+
+			Prepared(const RaysBoxTest::Query& q)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					Minima[k] = L::Splat(q.Minima[k]);
+					Maxima[k] = L::Splat(q.Maxima[k]);
+				}
+				MaxDistance = L::Splat(q.MaxDistance);
+			}
+		};
+
+		template<typename L, typename S>
+		static inline uint32_t Run(const Prepared<L>& box, const S& source, size_t i, size_t n, typename L::V& enter)
+		{
+			typename L::V origin[3], inverse[3];
+			PacketSource<S>::template Load<L>(source, i, n, origin, inverse);
+			for (int k = 0; k < 3; k++)
+				inverse[k] = SafeInverse<L>(inverse[k]);
+
+			return L::MaskBits(Slab<L>(origin, inverse, box.Minima, box.Maxima, box.MaxDistance, enter));
+		}
+	};
+
+	template<>
+	struct PacketTest<RaySpheresTest>
+	{
+		template<typename L>
+		struct Prepared
+		{
+			typename L::V Origin[3], Direction[3], A, InverseA, MaxDistance;
+			bool IsPoint;
+
+			Prepared(const RaySpheresTest::Query& q)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					Origin[k] = L::Splat(q.Origin[k]);
+					Direction[k] = L::Splat(q.Direction[k]);
+				}
+				A = L::Splat(q.Direction[0] * q.Direction[0] + q.Direction[1] * q.Direction[1] + q.Direction[2] * q.Direction[2]);
+				InverseA = L::Splat(q.InverseA);
+				MaxDistance = L::Splat(q.MaxDistance);
+				IsPoint = q.InverseA == 0;
+			}
+		};
+
+		template<typename L, typename S>
+		static inline uint32_t Run(const Prepared<L>& ray, const S& source, size_t i, size_t n, typename L::V& enter)
+		{
+			typename L::V center[3], radius;
+			PacketSource<S>::template Load<L>(source, i, n, center, radius);
+			auto zero = L::Zero();
+
+			typename L::V m[3];
+			for (int k = 0; k < 3; k++)
+				m[k] = L::Sub(ray.Origin[k], center[k]);
+
+			auto b = L::MulAdd(m[0], ray.Direction[0], L::MulAdd(m[1], ray.Direction[1], L::Mul(m[2], ray.Direction[2])));
+			auto c = L::NegMulAdd(radius, radius, L::MulAdd(m[0], m[0], L::MulAdd(m[1], m[1], L::Mul(m[2], m[2]))));
+			auto discriminant = L::NegMulAdd(ray.A, c, L::Mul(b, b));
+			auto root = L::Sqrt(L::Max(discriminant, zero));
+
+			auto tExit = L::Mul(L::Sub(root, b), ray.InverseA);
+			enter = L::Max(L::Mul(L::Negate(L::Add(b, root)), ray.InverseA), zero);
+
+			auto hit = L::MaskAnd(L::GreaterOrEqual(discriminant, zero),
+				L::MaskAnd(L::GreaterOrEqual(tExit, zero), L::LessOrEqual(enter, ray.MaxDistance)));
+
+			// A zero direction hits the spheres its origin is inside
+			if (ray.IsPoint)
+				hit = L::MaskAnd(hit, L::LessOrEqual(c, zero));
+
+			return L::MaskBits(hit);
+		}
+	};
+
+	// Writes hits as a mask (bit i % 32 of hits[i / 32], which starts on a word boundary) and the entry distances,
+	// FLT_MAX where missed. Returns the number of hits.
+	template<typename T, typename S>
+	struct PacketKernel
+	{
+		template<typename L>
+		static size_t Run(const typename T::Query& query, const S& source, size_t count, uint32_t* hits, float* enter)
+		{
+			typename PacketTest<T>::template Prepared<L> prepared(query);
+			size_t total = 0;
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				size_t n = count - i < (size_t)L::Width ? count - i : (size_t)L::Width;
+				typename L::V t;
+				uint32_t bits = PacketTest<T>::template Run<L>(prepared, source, i, n, t) & ((1u << n) - 1);
+
+				if (i % 32 == 0)
+					hits[i / 32] = bits << (i % 32);
+				else
+					hits[i / 32] |= bits << (i % 32);
+
+				total += CountBits(bits);
+
+				if (enter)
+				{
+					alignas(64) float distances[L::Width];
+					L::Store(distances, t);
+					for (size_t k = 0; k < n; k++)
+						enter[i + k] = (bits >> k) & 1 ? distances[k] : FLT_MAX;
+				}
+			}
+
+			return total;
+		}
+	};
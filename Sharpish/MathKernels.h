@@ -0,0 +1,76 @@
+// Defines the batch kernels in the .inl file named by SHARPISH_KERNELS once for every lane width:
+//
+//     #define SHARPISH_KERNELS "ScaleKernels.inl"
+//     #include "MathKernels.h"
+//
+// The kernels land in CS::Baseline, in an anonymous namespace private to the including file. With target regions
+// (see MathLanes.h) they are defined again in CS::Avx2 and CS::Avx512, compiled for those instruction sets along
+// with their own copies of MathLanes.inl, MathPrecision.inl and MathTranscendental.inl. SHARPISH_KERNEL
+// (MathDispatch.h) puts the copies in the dispatch table. Every copy must share the types a kernel takes as
+// template arguments or parameters, so those are declared by the including file before this header; whatever
+// the kernels do with lanes belongs in the .inl.
+//
+// Included once by each file of kernels, so it has no include guard.
+
+#include "MathDispatch.h"
+
+namespace CS
+{
+	namespace Baseline
+	{
+		namespace
+		{
+#include SHARPISH_KERNELS
+		}
+	}
+}
+
+#if defined(SHARPISH_TARGET_REGIONS)
+SHARPISH_BEGIN_AVX2
+namespace CS
+{
+	namespace Avx2
+	{
+		namespace Details
+		{
+			using namespace CS::Details;
+
+#include "MathLanes.inl"
+			template<> struct AosLanes<Lanes4> : CS::Details::AosLanes<Lanes4> { };
+#include "MathPrecision.inl"
+#include "MathTranscendental.inl"
+		}
+
+		namespace
+		{
+#include SHARPISH_KERNELS
+		}
+	}
+}
+SHARPISH_END_AVX2
+
+SHARPISH_BEGIN_AVX512
+namespace CS
+{
+	namespace Avx512
+	{
+		namespace Details
+		{
+			using namespace CS::Details;
+
+#include "MathLanes.inl"
+			template<> struct AosLanes<Lanes4> : CS::Details::AosLanes<Lanes4> { };
+#include "MathPrecision.inl"
+#include "MathTranscendental.inl"
+		}
+
+		namespace
+		{
+#include SHARPISH_KERNELS
+		}
+	}
+}
+SHARPISH_END_AVX512
+#endif
+
+#undef SHARPISH_KERNELS
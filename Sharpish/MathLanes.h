@@ -0,0 +1,521 @@
+#pragma once
+
+// SIMD lane types used by the batch (structure-of-arrays) math kernels.
+//
+// A lane type wraps one register's worth of floats and exposes the same set of static operations,
+// so a kernel written as a template over the lane type compiles at every available width:
+//
+//     Lanes4  - XMVECTOR, 4 floats. Built on the XM** APIs, so it runs wherever DirectXMath does.
+//     Lanes8  - __m256, 8 floats. Requires AVX2, FMA3 and F16C.
+//     Lanes16 - __m512, 16 floats. Requires AVX-512F.
+//
+// Lanes8 and Lanes16 are compiled on every x86/x64 build with intrinsics (SHARPISH_LANES8/SHARPISH_LANES16),
+// whatever the target flags, and whether the running CPU supports them is decided at runtime (see
+// MathDispatch.h). MSVC emits any intrinsic anywhere. GCC and Clang only emit them in functions compiled for
+// the instruction set, and a template is compiled for the target in effect where it is defined, not where it
+// is used. There (SHARPISH_TARGET_REGIONS) the wide lane types are defined between SHARPISH_BEGIN_AVX2 and
+// SHARPISH_END_AVX2 (or the AVX512 pair), and MathKernels.h defines the code generic over lanes again inside
+// each region.
+// Sharpish.h includes this header through MathTranscendental.h so the vector types can share those functions,
+// but the lane types remain an implementation detail of the kernels.
+
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+#if !defined(_XM_NO_INTRINSICS_) && !defined(_XM_ARM_NEON_INTRINSICS_) && defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+#define SHARPISH_LANES8
+#define SHARPISH_LANES16
+#elif !defined(_XM_NO_INTRINSICS_) && !defined(_XM_ARM_NEON_INTRINSICS_) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SHARPISH_LANES8
+#define SHARPISH_LANES16
+#define SHARPISH_TARGET_REGIONS
+#endif
+
+#if defined(SHARPISH_TARGET_REGIONS) && defined(__clang__)
+#define SHARPISH_BEGIN_AVX2 _Pragma("clang attribute push(__attribute__((target(\"avx2,fma,f16c\"))), apply_to = function)")
+#define SHARPISH_END_AVX2 _Pragma("clang attribute pop")
+#define SHARPISH_BEGIN_AVX512 _Pragma("clang attribute push(__attribute__((target(\"avx512f,avx2,fma,f16c\"))), apply_to = function)")
+#define SHARPISH_END_AVX512 _Pragma("clang attribute pop")
+#elif defined(SHARPISH_TARGET_REGIONS)
+#define SHARPISH_BEGIN_AVX2 _Pragma("GCC push_options") _Pragma("GCC target(\"avx2,fma,f16c\")")
+#define SHARPISH_END_AVX2 _Pragma("GCC pop_options")
+#define SHARPISH_BEGIN_AVX512 _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx2,fma,f16c\")")
+#define SHARPISH_END_AVX512 _Pragma("GCC pop_options")
+#else
+#define SHARPISH_BEGIN_AVX2
+#define SHARPISH_END_AVX2
+#define SHARPISH_BEGIN_AVX512
+#define SHARPISH_END_AVX512
+#endif
+
+#if defined(SHARPISH_LANES8) || defined(SHARPISH_LANES16)
+#include <immintrin.h>
+#endif
+
+namespace CS
+{
+	namespace Details
+	{
+#if defined(_XM_SSE_INTRINSICS_) && !defined(_XM_F16C_INTRINSICS_)
+		// Half-precision conversion without F16C, after Fabian Giesen's float_to_half_SSE2 and half_to_float_SSE2.
+		// Both match the F16C instructions (round to nearest even, denormals kept), except that NaN payloads are not
+		// preserved. Halves are zero-extended into 32-bit lanes.
+		inline __m128 __vectorcall Float16ToFloatSse2(__m128i h)
+		{
+			auto expMantissa = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+			auto sign = _mm_slli_epi32(_mm_xor_si128(h, expMantissa), 16);
+
+			// Rebias by multiplying, which also normalizes denormals. Infinity and NaN need the exponent forced to 255.
+			auto scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMantissa, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+			auto infNan = _mm_and_si128(_mm_cmpgt_epi32(expMantissa, _mm_set1_epi32(0x7BFF)), _mm_set1_epi32(255 << 23));
+
+			return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan)));
+		}
+
+		// Returns the halves sign-extended, ready for _mm_packs_epi32
+		inline __m128i __vectorcall FloatToFloat16Sse2(__m128 f)
+		{
+			auto justSign = _mm_and_ps(f, _mm_castsi128_ps(_mm_set1_epi32(0x80000000)));
+			auto abs = _mm_xor_ps(f, justSign);
+			auto absInt = _mm_castps_si128(abs);
+
+			// At or above 65520 rounds to infinity; NaNs become quiet NaNs
+			auto regular = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), absInt);
+			auto infNan = _mm_or_si128(_mm_and_si128(_mm_castps_si128(_mm_cmpunord_ps(abs, abs)), _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+			// Results below the smallest normal half: adding the magic number rounds away the low mantissa bits
+			auto subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+			auto isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), absInt);
+			auto subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(abs, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+			// Normal results: rebias the exponent and round to nearest even on the 13 dropped bits
+			auto mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absInt, 31 - 13), 31);
+			auto normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absInt, _mm_set1_epi32(0xFFF - ((127 - 15) << 23))), mantissaOdd), 13);
+
+			auto finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+			auto joined = _mm_or_si128(_mm_and_si128(regular, finite), _mm_andnot_si128(regular, infNan));
+			return _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(justSign), 16));
+		}
+#endif
+
+		struct Lanes4
+		{
+			typedef XMVECTOR V;
+			typedef XMVECTOR M;
+			static const int Width = 4;
+
+			static inline V __vectorcall Load(const float* p) { return XMLoadFloat4A((const XMFLOAT4A*)p); }
+			static inline V __vectorcall LoadUnaligned(const float* p) { return XMLoadFloat4((const XMFLOAT4*)p); }
+			static inline void __vectorcall Store(float* p, V v) { XMStoreFloat4A((XMFLOAT4A*)p, v); }
+			static inline void __vectorcall StoreUnaligned(float* p, V v) { XMStoreFloat4((XMFLOAT4*)p, v); }
+
+			// Width half-precision floats from or to unaligned memory. Conversion rounds to nearest even.
+			static inline V __vectorcall LoadFloat16(const uint16_t* p)
+			{
+#if defined(_XM_F16C_INTRINSICS_)
+				return _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)p));
+#elif defined(_XM_SSE_INTRINSICS_)
+				return Float16ToFloatSse2(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128()));
+#else
+				return XMVectorSet(PackedVector::XMConvertHalfToFloat(p[0]), PackedVector::XMConvertHalfToFloat(p[1]),
+					PackedVector::XMConvertHalfToFloat(p[2]), PackedVector::XMConvertHalfToFloat(p[3]));
+#endif
+			}
+
+			static inline void __vectorcall StoreFloat16(uint16_t* p, V v)
+			{
+#if defined(_XM_F16C_INTRINSICS_)
+				_mm_storel_epi64((__m128i*)p, _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+#elif defined(_XM_SSE_INTRINSICS_)
+				auto h = FloatToFloat16Sse2(v);
+				_mm_storel_epi64((__m128i*)p, _mm_packs_epi32(h, h));
+#else
+				XMFLOAT4 f;
+				XMStoreFloat4(&f, v);
+				p[0] = PackedVector::XMConvertFloatToHalf(f.x);
+				p[1] = PackedVector::XMConvertFloatToHalf(f.y);
+				p[2] = PackedVector::XMConvertFloatToHalf(f.z);
+				p[3] = PackedVector::XMConvertFloatToHalf(f.w);
+#endif
+			}
+
+			// Lane i is base[indices[i]], with Width indices read from memory
+			static inline V __vectorcall Gather(const float* base, const int32_t* indices)
+			{
+				return XMVectorSet(base[indices[0]], base[indices[1]], base[indices[2]], base[indices[3]]);
+			}
+
+			static inline V __vectorcall Splat(float x) { return XMVectorReplicate(x); }
+			static inline V __vectorcall Zero() { return XMVectorZero(); }
+
+			static inline V __vectorcall Add(V a, V b) { return XMVectorAdd(a, b); }
+			static inline V __vectorcall Sub(V a, V b) { return XMVectorSubtract(a, b); }
+			static inline V __vectorcall Mul(V a, V b) { return XMVectorMultiply(a, b); }
+			static inline V __vectorcall Div(V a, V b) { return XMVectorDivide(a, b); }
+			// a * b + c
+			static inline V __vectorcall MulAdd(V a, V b, V c) { return XMVectorMultiplyAdd(a, b, c); }
+			// c - a * b
+			static inline V __vectorcall NegMulAdd(V a, V b, V c) { return XMVectorNegativeMultiplySubtract(a, b, c); }
+			static inline V __vectorcall Min(V a, V b) { return XMVectorMin(a, b); }
+			static inline V __vectorcall Max(V a, V b) { return XMVectorMax(a, b); }
+			static inline V __vectorcall Abs(V a) { return XMVectorAbs(a); }
+			static inline V __vectorcall Negate(V a) { return XMVectorNegate(a); }
+			static inline V __vectorcall Sqrt(V a) { return XMVectorSqrt(a); }
+			static inline V __vectorcall Reciprocal(V a) { return XMVectorReciprocal(a); }
+			static inline V __vectorcall ReciprocalEst(V a) { return XMVectorReciprocalEst(a); }
+			static inline V __vectorcall ReciprocalSqrt(V a) { return XMVectorReciprocalSqrt(a); }
+			static inline V __vectorcall ReciprocalSqrtEst(V a) { return XMVectorReciprocalSqrtEst(a); }
+			static inline V __vectorcall Round(V a) { return XMVectorRound(a); }
+			static inline V __vectorcall Floor(V a) { return XMVectorFloor(a); }
+
+			// 2^n for whole numbers n in [-126, 127]
+			static inline V __vectorcall Pow2(V n)
+			{
+#if defined(_XM_SSE_INTRINSICS_)
+				return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23));
+#else
+				return XMConvertVectorFloatToInt(XMVectorAdd(n, XMVectorReplicate(127.0f)), 23);
+#endif
+			}
+
+			// The unbiased exponent and the significand scaled into [1, 2) of positive normal numbers
+			static inline V __vectorcall Exponent(V a)
+			{
+				return XMVectorSubtract(XMConvertVectorIntToFloat(XMVectorAndInt(a, g_XMInfinity), 23), XMVectorReplicate(127.0f));
+			}
+			static inline V __vectorcall Mantissa(V a) { return XMVectorOrInt(XMVectorAndInt(a, g_XMQNaNTest), g_XMOne); }
+
+			static inline M __vectorcall Less(V a, V b) { return XMVectorLess(a, b); }
+			static inline M __vectorcall LessOrEqual(V a, V b) { return XMVectorLessOrEqual(a, b); }
+			static inline M __vectorcall Greater(V a, V b) { return XMVectorGreater(a, b); }
+			static inline M __vectorcall GreaterOrEqual(V a, V b) { return XMVectorGreaterOrEqual(a, b); }
+			static inline M __vectorcall IsNan(V a) { return XMVectorIsNaN(a); }
+			static inline M __vectorcall MaskAnd(M a, M b) { return XMVectorAndInt(a, b); }
+			static inline M __vectorcall MaskOr(M a, M b) { return XMVectorOrInt(a, b); }
+			// Picks b where the mask is set, a elsewhere
+			static inline V __vectorcall Select(V a, V b, M mask) { return XMVectorSelect(a, b, mask); }
+			static inline V __vectorcall CopySign(V magnitude, V sign)
+			{
+				return XMVectorOrInt(XMVectorAndCInt(magnitude, g_XMNegativeZero), XMVectorAndInt(sign, g_XMNegativeZero));
+			}
+
+			// Packs the mask into the low Width bits of an integer, lane 0 in bit 0
+			static inline uint32_t __vectorcall MaskBits(M mask)
+			{
+#if defined(_XM_SSE_INTRINSICS_)
+				return (uint32_t)_mm_movemask_ps(mask);
+#else
+				XMVECTORU32 u; u.v = mask;
+				return (u.u[0] >> 31) | ((u.u[1] >> 31) << 1) | ((u.u[2] >> 31) << 2) | ((u.u[3] >> 31) << 3);
+#endif
+			}
+
+			static inline float __vectorcall ReduceMin(V a)
+			{
+				a = XMVectorMin(a, XMVectorSwizzle<2, 3, 0, 1>(a));
+				return XMVectorGetX(XMVectorMin(a, XMVectorSwizzle<1, 0, 3, 2>(a)));
+			}
+
+			static inline float __vectorcall ReduceMax(V a)
+			{
+				a = XMVectorMax(a, XMVectorSwizzle<2, 3, 0, 1>(a));
+				return XMVectorGetX(XMVectorMax(a, XMVectorSwizzle<1, 0, 3, 2>(a)));
+			}
+
+			static inline float __vectorcall ReduceAdd(V a)
+			{
+				a = XMVectorAdd(a, XMVectorSwizzle<2, 3, 0, 1>(a));
+				return XMVectorGetX(XMVectorAdd(a, XMVectorSwizzle<1, 0, 3, 2>(a)));
+			}
+
+			// Group operations treat the register as Width / 4 independent groups of 4 floats, e.g. matrix rows.
+			// SplatGroupElement broadcasts element i of each group across that group; BroadcastGroup loads
+			// 4 floats into every group.
+			template<int i>
+			static inline V __vectorcall SplatGroupElement(V a) { return XMVectorSwizzle<i, i, i, i>(a); }
+			static inline V __vectorcall BroadcastGroup(const float* p) { return XMLoadFloat4((const XMFLOAT4*)p); }
+		};
+
+#if defined(SHARPISH_LANES8)
+	SHARPISH_BEGIN_AVX2
+		struct Lanes8
+		{
+			typedef __m256 V;
+			typedef __m256 M;
+			typedef Lanes4 Half;
+			static const int Width = 8;
+
+			static inline V __vectorcall Combine(Half::V low, Half::V high) { return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1); }
+			static inline Half::V __vectorcall Low(V v) { return _mm256_castps256_ps128(v); }
+			static inline Half::V __vectorcall High(V v) { return _mm256_extractf128_ps(v, 1); }
+
+			static inline V __vectorcall Load(const float* p) { return _mm256_load_ps(p); }
+			static inline V __vectorcall LoadUnaligned(const float* p) { return _mm256_loadu_ps(p); }
+			static inline void __vectorcall Store(float* p, V v) { _mm256_store_ps(p, v); }
+			static inline void __vectorcall StoreUnaligned(float* p, V v) { _mm256_storeu_ps(p, v); }
+			static inline V __vectorcall LoadFloat16(const uint16_t* p) { return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)p)); }
+			static inline void __vectorcall StoreFloat16(uint16_t* p, V v) { _mm_storeu_si128((__m128i*)p, _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT)); }
+			static inline V __vectorcall Gather(const float* base, const int32_t* indices) { return _mm256_i32gather_ps(base, _mm256_loadu_si256((const __m256i*)indices), 4); }
+			static inline V __vectorcall Splat(float x) { return _mm256_set1_ps(x); }
+			static inline V __vectorcall Zero() { return _mm256_setzero_ps(); }
+
+			static inline V __vectorcall Add(V a, V b) { return _mm256_add_ps(a, b); }
+			static inline V __vectorcall Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+			static inline V __vectorcall Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+			static inline V __vectorcall Div(V a, V b) { return _mm256_div_ps(a, b); }
+			static inline V __vectorcall MulAdd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+			static inline V __vectorcall NegMulAdd(V a, V b, V c) { return _mm256_fnmadd_ps(a, b, c); }
+			static inline V __vectorcall Min(V a, V b) { return _mm256_min_ps(a, b); }
+			static inline V __vectorcall Max(V a, V b) { return _mm256_max_ps(a, b); }
+			static inline V __vectorcall Abs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+			static inline V __vectorcall Negate(V a) { return _mm256_xor_ps(_mm256_set1_ps(-0.0f), a); }
+			static inline V __vectorcall Sqrt(V a) { return _mm256_sqrt_ps(a); }
+			static inline V __vectorcall Reciprocal(V a) { return _mm256_div_ps(_mm256_set1_ps(1.0f), a); }
+			static inline V __vectorcall ReciprocalEst(V a) { return _mm256_rcp_ps(a); }
+			static inline V __vectorcall ReciprocalSqrt(V a) { return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(a)); }
+			static inline V __vectorcall ReciprocalSqrtEst(V a) { return _mm256_rsqrt_ps(a); }
+
+			static inline V __vectorcall Round(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+			static inline V __vectorcall Floor(V a) { return _mm256_floor_ps(a); }
+			static inline V __vectorcall Pow2(V n)
+			{
+				return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23));
+			}
+			static inline V __vectorcall Exponent(V a)
+			{
+				auto biased = _mm256_srli_epi32(_mm256_and_si256(_mm256_castps_si256(a), _mm256_set1_epi32(0x7F800000)), 23);
+				return _mm256_sub_ps(_mm256_cvtepi32_ps(biased), _mm256_set1_ps(127.0f));
+			}
+			static inline V __vectorcall Mantissa(V a)
+			{
+				return _mm256_or_ps(_mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x007FFFFF))), _mm256_set1_ps(1.0f));
+			}
+
+			static inline M __vectorcall Less(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+			static inline M __vectorcall LessOrEqual(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+			static inline M __vectorcall Greater(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+			static inline M __vectorcall GreaterOrEqual(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+			static inline M __vectorcall IsNan(V a) { return _mm256_cmp_ps(a, a, _CMP_UNORD_Q); }
+			static inline M __vectorcall MaskAnd(M a, M b) { return _mm256_and_ps(a, b); }
+			static inline M __vectorcall MaskOr(M a, M b) { return _mm256_or_ps(a, b); }
+			static inline V __vectorcall Select(V a, V b, M mask) { return _mm256_blendv_ps(a, b, mask); }
+			static inline V __vectorcall CopySign(V magnitude, V sign)
+			{
+				auto signBit = _mm256_set1_ps(-0.0f);
+				return _mm256_or_ps(_mm256_andnot_ps(signBit, magnitude), _mm256_and_ps(signBit, sign));
+			}
+
+			static inline uint32_t __vectorcall MaskBits(M mask) { return (uint32_t)_mm256_movemask_ps(mask); }
+
+			static inline float __vectorcall ReduceMin(V a)
+			{
+				return Lanes4::ReduceMin(_mm_min_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+			}
+
+			static inline float __vectorcall ReduceMax(V a)
+			{
+				return Lanes4::ReduceMax(_mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+			}
+
+			static inline float __vectorcall ReduceAdd(V a)
+			{
+				return Lanes4::ReduceAdd(_mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+			}
+
+			template<int i>
+			static inline V __vectorcall SplatGroupElement(V a) { return _mm256_permute_ps(a, _MM_SHUFFLE(i, i, i, i)); }
+			static inline V __vectorcall BroadcastGroup(const float* p) { return _mm256_broadcast_ps((const __m128*)p); }
+		};
+	SHARPISH_END_AVX2
+#endif
+
+#if defined(SHARPISH_LANES16)
+	SHARPISH_BEGIN_AVX512
+		struct Lanes16
+		{
+			typedef __m512 V;
+			typedef __mmask16 M;
+			typedef Lanes8 Half;
+			static const int Width = 16;
+
+			static inline V __vectorcall Combine(Half::V low, Half::V high)
+			{
+				return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castps_pd(low)), _mm256_castps_pd(high), 1));
+			}
+			static inline Half::V __vectorcall Low(V v) { return _mm512_castps512_ps256(v); }
+			static inline Half::V __vectorcall High(V v) { return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)); }
+
+			static inline V __vectorcall Load(const float* p) { return _mm512_load_ps(p); }
+			static inline V __vectorcall LoadUnaligned(const float* p) { return _mm512_loadu_ps(p); }
+			static inline void __vectorcall Store(float* p, V v) { _mm512_store_ps(p, v); }
+			static inline void __vectorcall StoreUnaligned(float* p, V v) { _mm512_storeu_ps(p, v); }
+			static inline V __vectorcall LoadFloat16(const uint16_t* p) { return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)p)); }
+			static inline void __vectorcall StoreFloat16(uint16_t* p, V v) { _mm256_storeu_si256((__m256i*)p, _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT)); }
+			static inline V __vectorcall Gather(const float* base, const int32_t* indices) { return _mm512_i32gather_ps(_mm512_loadu_si512(indices), base, 4); }
+			static inline V __vectorcall Splat(float x) { return _mm512_set1_ps(x); }
+			static inline V __vectorcall Zero() { return _mm512_setzero_ps(); }
+
+			static inline V __vectorcall Add(V a, V b) { return _mm512_add_ps(a, b); }
+			static inline V __vectorcall Sub(V a, V b) { return _mm512_sub_ps(a, b); }
+			static inline V __vectorcall Mul(V a, V b) { return _mm512_mul_ps(a, b); }
+			static inline V __vectorcall Div(V a, V b) { return _mm512_div_ps(a, b); }
+			static inline V __vectorcall MulAdd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+			static inline V __vectorcall NegMulAdd(V a, V b, V c) { return _mm512_fnmadd_ps(a, b, c); }
+			static inline V __vectorcall Min(V a, V b) { return _mm512_min_ps(a, b); }
+			static inline V __vectorcall Max(V a, V b) { return _mm512_max_ps(a, b); }
+			static inline V __vectorcall Abs(V a) { return _mm512_abs_ps(a); }
+			static inline V __vectorcall Negate(V a) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x80000000))); }
+			static inline V __vectorcall Sqrt(V a) { return _mm512_sqrt_ps(a); }
+			static inline V __vectorcall Reciprocal(V a) { return _mm512_div_ps(_mm512_set1_ps(1.0f), a); }
+			static inline V __vectorcall ReciprocalEst(V a) { return _mm512_rcp14_ps(a); }
+			static inline V __vectorcall ReciprocalSqrt(V a) { return _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_sqrt_ps(a)); }
+			static inline V __vectorcall ReciprocalSqrtEst(V a) { return _mm512_rsqrt14_ps(a); }
+
+			static inline V __vectorcall Round(V a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+			static inline V __vectorcall Floor(V a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+			static inline V __vectorcall Pow2(V n)
+			{
+				return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23));
+			}
+			// The same bit extraction as the narrower lanes rather than getexp/getmant, which normalize denormals and
+			// treat zero specially, so results don't depend on the register width
+			static inline V __vectorcall Exponent(V a)
+			{
+				auto biased = _mm512_srli_epi32(_mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x7F800000)), 23);
+				return _mm512_sub_ps(_mm512_cvtepi32_ps(biased), _mm512_set1_ps(127.0f));
+			}
+			static inline V __vectorcall Mantissa(V a)
+			{
+				auto bits = _mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x007FFFFF));
+				return _mm512_castsi512_ps(_mm512_or_si512(bits, _mm512_castps_si512(_mm512_set1_ps(1.0f))));
+			}
+
+			static inline M __vectorcall Less(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+			static inline M __vectorcall LessOrEqual(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+			static inline M __vectorcall Greater(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+			static inline M __vectorcall GreaterOrEqual(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+			static inline M __vectorcall IsNan(V a) { return _mm512_cmp_ps_mask(a, a, _CMP_UNORD_Q); }
+			static inline M __vectorcall MaskAnd(M a, M b) { return (M)(a & b); }
+			static inline M __vectorcall MaskOr(M a, M b) { return (M)(a | b); }
+			static inline V __vectorcall Select(V a, V b, M mask) { return _mm512_mask_blend_ps(mask, a, b); }
+			static inline V __vectorcall CopySign(V magnitude, V sign)
+			{
+				auto signBit = _mm512_set1_epi32(0x80000000);
+				return _mm512_castsi512_ps(_mm512_or_si512(
+					_mm512_andnot_si512(signBit, _mm512_castps_si512(magnitude)),
+					_mm512_and_si512(signBit, _mm512_castps_si512(sign))));
+			}
+
+			static inline uint32_t __vectorcall MaskBits(M mask) { return (uint32_t)mask; }
+
+			static inline float __vectorcall ReduceMin(V a) { return _mm512_reduce_min_ps(a); }
+			static inline float __vectorcall ReduceMax(V a) { return _mm512_reduce_max_ps(a); }
+			static inline float __vectorcall ReduceAdd(V a) { return _mm512_reduce_add_ps(a); }
+
+			template<int i>
+			static inline V __vectorcall SplatGroupElement(V a) { return _mm512_permute_ps(a, _MM_SHUFFLE(i, i, i, i)); }
+			static inline V __vectorcall BroadcastGroup(const float* p) { return _mm512_broadcast_f32x4(_mm_loadu_ps(p)); }
+		};
+	SHARPISH_END_AVX512
+#endif
+
+#include "MathLanes.inl"
+
+		template<>
+		struct AosLanes<Lanes4>
+		{
+			typedef XMVECTOR V;
+
+			template<int Stride>
+			static inline void Load3(const float* p, V& x, V& y, V& z);
+
+			template<int Stride>
+			static inline void Store3(float* p, V x, V y, V z);
+
+			static inline void Load4(const float* p, size_t stride, V& x, V& y, V& z, V& w)
+			{
+				V r0 = XMLoadFloat4((const XMFLOAT4*)p);
+				V r1 = XMLoadFloat4((const XMFLOAT4*)(p + stride));
+				V r2 = XMLoadFloat4((const XMFLOAT4*)(p + stride * 2));
+				V r3 = XMLoadFloat4((const XMFLOAT4*)(p + stride * 3));
+
+				V t0 = XMVectorMergeXY(r0, r1);
+				V t1 = XMVectorMergeXY(r2, r3);
+				V t2 = XMVectorMergeZW(r0, r1);
+				V t3 = XMVectorMergeZW(r2, r3);
+
+				x = XMVectorPermute<0, 1, 4, 5>(t0, t1);
+				y = XMVectorPermute<2, 3, 6, 7>(t0, t1);
+				z = XMVectorPermute<0, 1, 4, 5>(t2, t3);
+				w = XMVectorPermute<2, 3, 6, 7>(t2, t3);
+			}
+
+			static inline void Store4(float* p, size_t stride, V x, V y, V z, V w)
+			{
+				V t0 = XMVectorMergeXY(x, y);
+				V t1 = XMVectorMergeZW(x, y);
+				V u0 = XMVectorMergeXY(z, w);
+				V u1 = XMVectorMergeZW(z, w);
+
+				XMStoreFloat4((XMFLOAT4*)p, XMVectorPermute<0, 1, 4, 5>(t0, u0));
+				XMStoreFloat4((XMFLOAT4*)(p + stride), XMVectorPermute<2, 3, 6, 7>(t0, u0));
+				XMStoreFloat4((XMFLOAT4*)(p + stride * 2), XMVectorPermute<0, 1, 4, 5>(t1, u1));
+				XMStoreFloat4((XMFLOAT4*)(p + stride * 3), XMVectorPermute<2, 3, 6, 7>(t1, u1));
+			}
+		};
+
+		// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+		template<>
+		inline void AosLanes<Lanes4>::Load3<3>(const float* p, V& x, V& y, V& z)
+		{
+			V v0 = XMLoadFloat4((const XMFLOAT4*)p);
+			V v1 = XMLoadFloat4((const XMFLOAT4*)(p + 4));
+			V v2 = XMLoadFloat4((const XMFLOAT4*)(p + 8));
+
+			x = XMVectorPermute<0, 1, 2, 5>(XMVectorPermute<0, 3, 6, 0>(v0, v1), v2);
+			y = XMVectorPermute<0, 1, 2, 6>(XMVectorPermute<1, 4, 7, 0>(v0, v1), v2);
+			z = XMVectorPermute<0, 1, 4, 7>(XMVectorPermute<2, 5, 0, 0>(v0, v1), v2);
+		}
+
+		template<>
+		inline void AosLanes<Lanes4>::Store3<3>(float* p, V x, V y, V z)
+		{
+			XMStoreFloat4((XMFLOAT4*)p, XMVectorPermute<0, 1, 4, 3>(XMVectorPermute<0, 4, 0, 1>(x, y), z));
+			XMStoreFloat4((XMFLOAT4*)(p + 4), XMVectorPermute<0, 1, 6, 3>(XMVectorPermute<1, 5, 0, 2>(y, z), x));
+			XMStoreFloat4((XMFLOAT4*)(p + 8), XMVectorPermute<0, 1, 7, 3>(XMVectorPermute<2, 7, 0, 3>(z, x), y));
+		}
+
+		// x0 y0 z0 w0 | x1 y1 z1 w1 | x2 y2 z2 w2 | x3 y3 z3 w3
+		template<>
+		inline void AosLanes<Lanes4>::Load3<4>(const float* p, V& x, V& y, V& z)
+		{
+			V r0 = XMLoadFloat4A((const XMFLOAT4A*)p);
+			V r1 = XMLoadFloat4A((const XMFLOAT4A*)(p + 4));
+			V r2 = XMLoadFloat4A((const XMFLOAT4A*)(p + 8));
+			V r3 = XMLoadFloat4A((const XMFLOAT4A*)(p + 12));
+
+			V t0 = XMVectorMergeXY(r0, r1);
+			V t1 = XMVectorMergeXY(r2, r3);
+			V t2 = XMVectorMergeZW(r0, r1);
+			V t3 = XMVectorMergeZW(r2, r3);
+
+			x = XMVectorPermute<0, 1, 4, 5>(t0, t1);
+			y = XMVectorPermute<2, 3, 6, 7>(t0, t1);
+			z = XMVectorPermute<0, 1, 4, 5>(t2, t3);
+		}
+
+		template<>
+		inline void AosLanes<Lanes4>::Store3<4>(float* p, V x, V y, V z)
+		{
+			V t0 = XMVectorMergeXY(x, y);
+			V t1 = XMVectorMergeZW(x, y);
+			V u0 = XMVectorMergeXY(z, XMVectorZero());
+			V u1 = XMVectorMergeZW(z, XMVectorZero());
+
+			XMStoreFloat4A((XMFLOAT4A*)p, XMVectorPermute<0, 1, 4, 5>(t0, u0));
+			XMStoreFloat4A((XMFLOAT4A*)(p + 4), XMVectorPermute<2, 3, 6, 7>(t0, u0));
+			XMStoreFloat4A((XMFLOAT4A*)(p + 8), XMVectorPermute<0, 1, 4, 5>(t1, u1));
+			XMStoreFloat4A((XMFLOAT4A*)(p + 12), XMVectorPermute<2, 3, 6, 7>(t1, u1));
+		}
+	}
+}
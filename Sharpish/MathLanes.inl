@@ -0,0 +1,49 @@
+// Lane-generic part of MathLanes.h, included inside CS::Details there and again for each wide target by
+// MathKernels.h. Holds no #includes of its own.
+
+		// Register transposes between array-of-structures vectors and lanes.
+		// Load3/Store3 move L::Width consecutive 3-component vectors into (out of) one register per component.
+		// Stride is the distance between vectors in floats: 3 for Float3, 4 for Float3A. Store3 writes zero to
+		// the fourth component when Stride is 4.
+		// Load4/Store4 do the same for 4-component vectors at any stride, e.g. one row of consecutive matrices.
+		template<typename L>
+		struct AosLanes
+		{
+			typedef typename L::V V;
+			typedef typename L::Half H;
+
+			template<int Stride>
+			static inline void Load3(const float* p, V& x, V& y, V& z)
+			{
+				typename H::V xl, yl, zl, xh, yh, zh;
+				AosLanes<H>::template Load3<Stride>(p, xl, yl, zl);
+				AosLanes<H>::template Load3<Stride>(p + Stride * H::Width, xh, yh, zh);
+				x = L::Combine(xl, xh);
+				y = L::Combine(yl, yh);
+				z = L::Combine(zl, zh);
+			}
+
+			template<int Stride>
+			static inline void Store3(float* p, V x, V y, V z)
+			{
+				AosLanes<H>::template Store3<Stride>(p, L::Low(x), L::Low(y), L::Low(z));
+				AosLanes<H>::template Store3<Stride>(p + Stride * H::Width, L::High(x), L::High(y), L::High(z));
+			}
+
+			static inline void Load4(const float* p, size_t stride, V& x, V& y, V& z, V& w)
+			{
+				typename H::V xl, yl, zl, wl, xh, yh, zh, wh;
+				AosLanes<H>::Load4(p, stride, xl, yl, zl, wl);
+				AosLanes<H>::Load4(p + stride * H::Width, stride, xh, yh, zh, wh);
+				x = L::Combine(xl, xh);
+				y = L::Combine(yl, yh);
+				z = L::Combine(zl, zh);
+				w = L::Combine(wl, wh);
+			}
+
+			static inline void Store4(float* p, size_t stride, V x, V y, V z, V w)
+			{
+				AosLanes<H>::Store4(p, stride, L::Low(x), L::Low(y), L::Low(z), L::Low(w));
+				AosLanes<H>::Store4(p + stride * H::Width, stride, L::High(x), L::High(y), L::High(z), L::High(w));
+			}
+		};
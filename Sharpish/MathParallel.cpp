@@ -0,0 +1,182 @@
+#include "Sharpish.h"
+#include "MathParallel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace CS;
+using namespace std;
+
+namespace
+{
+	thread_local bool _insideParallelFor = false;
+
+	class WorkerPool
+	{
+		struct Job
+		{
+			const function<void(size_t)>* task;
+			size_t chunks;
+			atomic<size_t> next;
+			unsigned workers; // Pool threads working on it, guarded by _lock
+			exception_ptr error;
+			mutex errorLock;
+
+			bool HasWork() const { return next.load(memory_order_relaxed) < chunks; }
+		};
+
+		vector<thread> _threads;
+		mutex _lock;
+		condition_variable _wake;
+		condition_variable _finished;
+		vector<Job*> _jobs;
+		bool _exit = false;
+
+		static void Work(Job& job)
+		{
+			size_t i;
+
+			while ((i = job.next++) < job.chunks)
+			{
+				try
+				{
+					(*job.task)(i);
+				}
+				catch (...)
+				{
+					lock_guard<mutex> lock(job.errorLock);
+					if (!job.error) job.error = current_exception();
+				}
+			}
+		}
+
+		// The oldest job with chunks left to start, or null. Called with _lock held.
+		Job* FindWork() const
+		{
+			for (auto job : _jobs)
+				if (job->HasWork())
+					return job;
+			return nullptr;
+		}
+
+		void WorkerMain()
+		{
+			_insideParallelFor = true;
+			unique_lock<mutex> lock(_lock);
+
+			for (;;)
+			{
+				Job* job = nullptr;
+				_wake.wait(lock, [&] { return _exit || (job = FindWork()) != nullptr; });
+				if (_exit) return;
+
+				job->workers++;
+				lock.unlock();
+
+				Work(*job);
+
+				lock.lock();
+				if (--job->workers == 0) _finished.notify_all();
+			}
+		}
+
+	public:
+		WorkerPool()
+		{
+			unsigned count = thread::hardware_concurrency();
+
+			for (unsigned i = 1; i < count; i++)
+				_threads.emplace_back([this] { WorkerMain(); });
+		}
+
+		~WorkerPool()
+		{
+			{
+				lock_guard<mutex> lock(_lock);
+				_exit = true;
+			}
+
+			_wake.notify_all();
+
+			for (auto& t : _threads)
+				t.join();
+		}
+
+		static WorkerPool& Instance()
+		{
+			static WorkerPool pool;
+			return pool;
+		}
+
+		unsigned ThreadCount() const { return (unsigned)_threads.size() + 1; }
+
+		void Run(size_t chunks, const function<void(size_t)>& task)
+		{
+			Job job;
+			job.task = &task;
+			job.chunks = chunks;
+			job.next = 0;
+			job.workers = 0;
+
+			{
+				lock_guard<mutex> lock(_lock);
+				_jobs.push_back(&job);
+			}
+
+			_wake.notify_all();
+
+			_insideParallelFor = true;
+			Work(job);
+			_insideParallelFor = false;
+
+			{
+				// Chunks still running belong to workers that joined; stop new ones joining and wait them out
+				unique_lock<mutex> lock(_lock);
+				_jobs.erase(find(_jobs.begin(), _jobs.end(), &job));
+				_finished.wait(lock, [&] { return job.workers == 0; });
+			}
+
+			if (job.error)
+				rethrow_exception(job.error);
+		}
+	};
+}
+
+unsigned Details::ParallelThreadCount()
+{
+	return WorkerPool::Instance().ThreadCount();
+}
+
+void Details::ParallelFor(size_t count, size_t granularity, const function<void(size_t, size_t)>& body)
+{
+	if (granularity == 0) granularity = 1;
+
+	if (count < granularity * 2 || _insideParallelFor)
+	{
+		if (count) body(0, count);
+		return;
+	}
+
+	auto& pool = WorkerPool::Instance();
+	unsigned threads = pool.ThreadCount();
+
+	if (threads == 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	// A few chunks per thread evens out uneven progress between threads
+	size_t chunkSize = (count + threads * 4 - 1) / (threads * 4);
+	chunkSize = (chunkSize + granularity - 1) / granularity * granularity;
+	size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+	pool.Run(chunks, [&](size_t chunk)
+	{
+		size_t begin = chunk * chunkSize;
+		size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+		body(begin, end);
+	});
+}
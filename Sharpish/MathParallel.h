@@ -0,0 +1,80 @@
+#pragma once
+
+// Splits batch work across a shared pool of worker threads, and the small helpers the batch code shares.
+// This header is an implementation detail of the kernels and is not included by Sharpish.h.
+
+#include <functional>
+#include <stdint.h>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace CS
+{
+	namespace Details
+	{
+		// Number of threads ParallelFor spreads work across, including the calling thread.
+		unsigned ParallelThreadCount();
+
+		// Runs body(begin, end) over [0, count) in chunks whose sizes are multiples of granularity (except the
+		// last), on the pool and the calling thread, and returns once every chunk has finished. The first
+		// exception thrown by body is rethrown on the calling thread. Runs body(0, count) inline when the work
+		// is under two chunks, the pool is a single thread, or the caller is already inside a ParallelFor.
+		// Calls from different threads run at the same time: each caller works on its own chunks, and free
+		// workers take chunks from the oldest call with any left.
+		void ParallelFor(size_t count, size_t granularity, const std::function<void(size_t, size_t)>& body);
+
+		// ParallelFor, or body(0, count) on the calling thread when parallel is false
+		inline void ParallelFor(size_t count, size_t granularity, bool parallel, const std::function<void(size_t, size_t)>& body)
+		{
+			if (parallel)
+				ParallelFor(count, granularity, body);
+			else if (count)
+				body(0, count);
+		}
+
+		// Runs body(begin, end, items) like ParallelFor, with a list of items for each granule, and appends the
+		// lists to outItems in order, so the result doesn't depend on how the work was split
+		template<typename T, typename F>
+		void ParallelCollect(size_t count, size_t granularity, bool parallel, std::vector<T>& outItems, const F& body)
+		{
+			if (granularity == 0) granularity = 1;
+
+			std::vector<std::vector<T>> found((count + granularity - 1) / granularity);
+			ParallelFor(count, granularity, parallel, [&](size_t begin, size_t end) { body(begin, end, found[begin / granularity]); });
+
+			for (auto& items : found)
+				outItems.insert(outItems.end(), items.begin(), items.end());
+		}
+
+		// Index of the lowest set bit of a nonzero mask
+		inline int LowestBit(uint32_t bits)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, bits);
+			return (int)index;
+#else
+			return __builtin_ctz(bits);
+#endif
+		}
+
+		inline int LowestBit(uint64_t bits)
+		{
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanForward64(&index, bits);
+			return (int)index;
+#elif defined(_MSC_VER)
+			unsigned long index;
+			if (_BitScanForward(&index, (unsigned long)bits))
+				return (int)index;
+			_BitScanForward(&index, (unsigned long)(bits >> 32));
+			return (int)index + 32;
+#else
+			return __builtin_ctzll(bits);
+#endif
+		}
+	}
+}
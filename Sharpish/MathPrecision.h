@@ -0,0 +1,103 @@
+#pragma once
+
+// Precision tiers for reciprocals, square roots and the operations built on them: division, length and
+// normalization. The tier is a template argument, so it is fixed at compile time and costs nothing to select:
+//
+//     Vector members   v.Normalize<Precision::Refined>(), v.GetLength<Precision::Estimate>(), a.Divide<P>(b)
+//     QuaternionA      q.Normalize<P>(), q.GetLength<P>(), q.GetInverse<P>()
+//     Vector types     WithPrecision<Float3A, Precision::Refined> (in MathTypes.h) makes P the default
+//     Batch kernels    Help::Math::Normalize<P>, Help::Math::Length<P>, QuaternionStream::Normalize<P>
+//
+// Exact uses the divide and square root instructions. Refined starts from the hardware estimate and applies one
+// Newton-Raphson step. Estimate uses the hardware estimate alone. Maximum relative errors over the normal float
+// range:
+//
+//     Tier       SSE, AVX2     AVX-512
+//     Exact      1 ULP         1 ULP
+//     Refined    2.4e-7        1.2e-7
+//     Estimate   3.3e-4        6.0e-5
+//
+// The AVX-512 column applies to whole 16-lane registers of a batch; the elements left over, and the vector
+// members, take the SSE path. The Precision_ tests and benchmark in SharpishTests check these bounds and measure
+// the throughput of the batch Normalize at each tier. The tiers pay off where the square root dominates: with SSE
+// the benchmark ran Refined at about 1.7x and Estimate at about 2.5x the speed of Exact, while at AVX2 and
+// AVX-512 loading the vectors costs more than the square root and the tiers are within 10% of each other.
+//
+// Exact division and square roots are correctly rounded; the errors above are those of ReciprocalSqrt, which
+// length and normalization are built on. Refined division and reciprocals are within 1.4e-7. All tiers give
+// zero for the length and normalization of a zero vector, and Refined and Estimate keep the IEEE results of
+// Exact for zero, infinite and NaN inputs. Where DirectXMath is built without intrinsics the estimates are
+// exact, so every tier gives the Exact result.
+
+#include "MathLanes.h"
+
+namespace CS
+{
+	enum class Precision { Exact, Refined, Estimate };
+
+	namespace Details
+	{
+#include "MathPrecision.inl"
+
+		// Length and normalization of 2, 3 and 4 component XMVECTORs at precision P. Results are splatted.
+		template<int Rank>
+		struct VectorLengthSq;
+
+		template<> struct VectorLengthSq<2> { static inline XMVECTOR __vectorcall Get(FXMVECTOR v) { return XMVector2LengthSq(v); } };
+		template<> struct VectorLengthSq<3> { static inline XMVECTOR __vectorcall Get(FXMVECTOR v) { return XMVector3LengthSq(v); } };
+		template<> struct VectorLengthSq<4> { static inline XMVECTOR __vectorcall Get(FXMVECTOR v) { return XMVector4LengthSq(v); } };
+
+		template<int Rank, Precision P>
+		struct PreciseVector
+		{
+			typedef Precise<Lanes4, P> Op;
+
+			static inline XMVECTOR __vectorcall Length(FXMVECTOR v) { return Op::Sqrt(VectorLengthSq<Rank>::Get(v)); }
+			static inline XMVECTOR __vectorcall ReciprocalLength(FXMVECTOR v) { return Op::ReciprocalSqrt(VectorLengthSq<Rank>::Get(v)); }
+
+			static inline XMVECTOR __vectorcall Normalize(FXMVECTOR v)
+			{
+				auto lengthSq = VectorLengthSq<Rank>::Get(v);
+				return XMVectorSelect(XMVectorZero(), XMVectorMultiply(v, Op::ReciprocalSqrt(lengthSq)), XMVectorGreater(lengthSq, XMVectorZero()));
+			}
+		};
+
+		// Exact defers to DirectXMath so that v.Normalize<Precision::Exact>() == v.Normalize()
+		template<int Rank> struct PreciseVectorExact;
+
+		template<> struct PreciseVectorExact<2>
+		{
+			static inline XMVECTOR __vectorcall Length(FXMVECTOR v) { return XMVector2Length(v); }
+			static inline XMVECTOR __vectorcall ReciprocalLength(FXMVECTOR v) { return XMVector2ReciprocalLength(v); }
+			static inline XMVECTOR __vectorcall Normalize(FXMVECTOR v) { return XMVector2Normalize(v); }
+		};
+
+		template<> struct PreciseVectorExact<3>
+		{
+			static inline XMVECTOR __vectorcall Length(FXMVECTOR v) { return XMVector3Length(v); }
+			static inline XMVECTOR __vectorcall ReciprocalLength(FXMVECTOR v) { return XMVector3ReciprocalLength(v); }
+			static inline XMVECTOR __vectorcall Normalize(FXMVECTOR v) { return XMVector3Normalize(v); }
+		};
+
+		template<> struct PreciseVectorExact<4>
+		{
+			static inline XMVECTOR __vectorcall Length(FXMVECTOR v) { return XMVector4Length(v); }
+			static inline XMVECTOR __vectorcall ReciprocalLength(FXMVECTOR v) { return XMVector4ReciprocalLength(v); }
+			static inline XMVECTOR __vectorcall Normalize(FXMVECTOR v) { return XMVector4Normalize(v); }
+		};
+
+		template<int Rank> struct PreciseVector<Rank, Precision::Exact> : PreciseVectorExact<Rank> { };
+
+		// As XMQuaternionInverse: conjugate / length^2, or zero if length^2 <= epsilon
+		template<Precision P>
+		inline XMVECTOR __vectorcall PreciseQuaternionInverse(FXMVECTOR q)
+		{
+			auto lengthSq = XMVector4LengthSq(q);
+			auto scaled = XMVectorMultiply(XMQuaternionConjugate(q), Precise<Lanes4, P>::Reciprocal(lengthSq));
+			return XMVectorSelect(XMVectorZero(), scaled, XMVectorGreater(lengthSq, g_XMEpsilon));
+		}
+
+		template<>
+		inline XMVECTOR __vectorcall PreciseQuaternionInverse<Precision::Exact>(FXMVECTOR q) { return XMQuaternionInverse(q); }
+	}
+}
@@ -0,0 +1,68 @@
+// Lane-generic part of MathPrecision.h, included inside CS::Details there and again for each wide target by
+// MathKernels.h.
+
+		template<typename L, Precision P>
+		struct Precise;
+
+		// sqrt(a) = a * (1 / sqrt(a)), except at 0 and infinity, where the product is NaN and a is the answer
+		template<typename L>
+		inline typename L::V __vectorcall SqrtFromReciprocalSqrt(typename L::V a, typename L::V r)
+		{
+			auto s = L::Mul(a, r);
+			return L::Select(s, a, L::MaskAnd(L::IsNan(s), L::GreaterOrEqual(a, L::Zero())));
+		}
+
+		template<typename L>
+		struct Precise<L, Precision::Exact>
+		{
+			typedef typename L::V V;
+
+			static inline V __vectorcall Reciprocal(V a) { return L::Reciprocal(a); }
+			static inline V __vectorcall ReciprocalSqrt(V a) { return L::ReciprocalSqrt(a); }
+			static inline V __vectorcall Sqrt(V a) { return L::Sqrt(a); }
+			static inline V __vectorcall Divide(V a, V b) { return L::Div(a, b); }
+		};
+
+		template<typename L>
+		struct Precise<L, Precision::Refined>
+		{
+			typedef typename L::V V;
+
+			// r' = r + r * (1 - a * r). The correction is NaN only where a * r is 0 * inf, when r is already exact.
+			static inline V __vectorcall Reciprocal(V a)
+			{
+				auto r = L::ReciprocalEst(a);
+				auto e = L::NegMulAdd(a, r, L::Splat(1.0f));
+				return L::Select(L::MulAdd(r, e, r), r, L::IsNan(e));
+			}
+
+			// r' = r + r / 2 * (1 - a * r^2)
+			static inline V __vectorcall ReciprocalSqrt(V a)
+			{
+				auto r = L::ReciprocalSqrtEst(a);
+				auto e = L::NegMulAdd(L::Mul(a, r), r, L::Splat(1.0f));
+				return L::Select(L::MulAdd(L::Mul(r, L::Splat(0.5f)), e, r), r, L::IsNan(e));
+			}
+
+			static inline V __vectorcall Sqrt(V a) { return SqrtFromReciprocalSqrt<L>(a, ReciprocalSqrt(a)); }
+
+			// q' = q + r * (a - b * q), which also absorbs the error of r
+			static inline V __vectorcall Divide(V a, V b)
+			{
+				auto r = L::ReciprocalEst(b);
+				auto q = L::Mul(a, r);
+				auto e = L::NegMulAdd(b, q, a);
+				return L::Select(L::MulAdd(r, e, q), q, L::IsNan(e));
+			}
+		};
+
+		template<typename L>
+		struct Precise<L, Precision::Estimate>
+		{
+			typedef typename L::V V;
+
+			static inline V __vectorcall Reciprocal(V a) { return L::ReciprocalEst(a); }
+			static inline V __vectorcall ReciprocalSqrt(V a) { return L::ReciprocalSqrtEst(a); }
+			static inline V __vectorcall Sqrt(V a) { return SqrtFromReciprocalSqrt<L>(a, L::ReciprocalSqrtEst(a)); }
+			static inline V __vectorcall Divide(V a, V b) { return L::Mul(a, L::ReciprocalEst(b)); }
+		};
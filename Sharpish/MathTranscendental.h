@@ -0,0 +1,33 @@
+#pragma once
+
+// Vectorized transcendental functions over any lane type in MathLanes.h, so the same code serves every register
+// width of the span functions in Help::Math (Help::Math::Sin and friends) and Vector's Estimate().Exp and Ln.
+// Vector's own Sin, Cos, ASin, ACos, ATan, ATan2, SinCos, Exp and Ln and their Estimate versions stay on
+// DirectXMath, so their results don't change with these.
+//
+// Every function comes in two tiers. The full tier is within a few ULP of the correctly rounded result; the
+// Est tier trades accuracy for fewer operations. Maximum errors, measured against double precision:
+//
+//     Function       Domain           Full                 Est
+//     Sin, Cos       |x| <= 8192      1.0e-7 absolute *    1.3e-5 absolute
+//     ASin, ACos     [-1, 1]          3 ULP                3.7e-6 relative
+//     ATan, ATan2    all              4 ULP                3.1e-5 relative
+//     Exp            [-87.3, 88.7]    1 ULP                5.4e-6 relative
+//     Log            (0, inf)         1 ULP                3.9e-6 relative
+//
+// * 3 ULP for |x| <= 100, and under 1.2e-7 absolute up to |x| = 1e6. Beyond that the argument reduction loses
+// all accuracy, though results stay within [-1, 1].
+//
+// Exp flushes results below FLT_MIN to zero and overflows to infinity. Log returns NaN below zero and -infinity
+// at zero. NaN inputs give NaN.
+
+#include "MathLanes.h"
+#include <cmath>
+
+namespace CS
+{
+	namespace Details
+	{
+#include "MathTranscendental.inl"
+	}
+}
@@ -0,0 +1,294 @@
+// Lane-generic part of MathTranscendental.h, included inside CS::Details there and again for each wide target
+// by MathKernels.h.
+
+		template<typename L>
+		struct Transcendental
+		{
+			typedef typename L::V V;
+			typedef typename L::M M;
+
+			static inline void __vectorcall SinCos(V x, V& outSin, V& outCos) { SinCosImpl<false>(x, outSin, outCos); }
+			static inline void __vectorcall SinCosEst(V x, V& outSin, V& outCos) { SinCosImpl<true>(x, outSin, outCos); }
+			static inline V __vectorcall Sin(V x) { V s, c; SinCosImpl<false>(x, s, c); return s; }
+			static inline V __vectorcall SinEst(V x) { V s, c; SinCosImpl<true>(x, s, c); return s; }
+			static inline V __vectorcall Cos(V x) { V s, c; SinCosImpl<false>(x, s, c); return c; }
+			static inline V __vectorcall CosEst(V x) { V s, c; SinCosImpl<true>(x, s, c); return c; }
+
+			static inline V __vectorcall ASin(V x) { return ASinImpl<false>(x); }
+			static inline V __vectorcall ASinEst(V x) { return ASinImpl<true>(x); }
+			static inline V __vectorcall ACos(V x) { return ACosImpl<false>(x); }
+			static inline V __vectorcall ACosEst(V x) { return ACosImpl<true>(x); }
+
+			static inline V __vectorcall ATan(V x)
+			{
+				auto a = L::Abs(x);
+				auto one = L::Splat(1.0f);
+
+				// atan(a) = pi/4 + atan((a - 1) / (a + 1)) above tan(pi/8), pi/2 + atan(-1 / a) above tan(3pi/8)
+				auto mid = L::Greater(a, L::Splat(0.414213562f));
+				auto big = L::Greater(a, L::Splat(2.414213562f));
+				auto num = L::Select(L::Select(a, L::Sub(a, one), mid), L::Splat(-1.0f), big);
+				auto den = L::Select(L::Select(one, L::Add(a, one), mid), a, big);
+				auto base = L::Select(L::Select(L::Zero(), L::Splat(XM_PIDIV4), mid), L::Splat(XM_PIDIV2), big);
+
+				return L::CopySign(L::Add(base, ATanPoly(L::Div(num, den))), x);
+			}
+
+			static inline V __vectorcall ATanEst(V x)
+			{
+				auto a = L::Abs(x);
+				auto big = L::Greater(a, L::Splat(1.0f));
+				auto t = L::Select(a, L::Reciprocal(a), big);
+				auto r = ATanEstPoly(t);
+				return L::CopySign(L::Select(r, L::Sub(L::Splat(XM_PIDIV2), r), big), x);
+			}
+
+			static inline V __vectorcall ATan2(V y, V x) { return ATan2Impl<false>(y, x); }
+			static inline V __vectorcall ATan2Est(V y, V x) { return ATan2Impl<true>(y, x); }
+
+			static inline V __vectorcall Exp(V x)
+			{
+				V r, n;
+				ExpReduce(x, r, n);
+				auto z = L::Mul(r, r);
+				auto p = L::MulAdd(L::Splat(1.9875691500e-4f), r, L::Splat(1.3981999507e-3f));
+				p = L::MulAdd(p, r, L::Splat(8.3334519073e-3f));
+				p = L::MulAdd(p, r, L::Splat(4.1665795894e-2f));
+				p = L::MulAdd(p, r, L::Splat(1.6666665459e-1f));
+				p = L::MulAdd(p, r, L::Splat(5.0000001201e-1f));
+				p = L::Add(L::MulAdd(p, z, r), L::Splat(1.0f));
+				return ExpScale(x, p, n);
+			}
+
+			static inline V __vectorcall ExpEst(V x)
+			{
+				V r, n;
+				ExpReduce(x, r, n);
+				auto p = L::MulAdd(L::MulAdd(L::Splat(0.04127764f), r, L::Splat(0.16753505f)), r, L::Splat(0.50005116f));
+				p = L::Add(L::MulAdd(L::Mul(p, r), r, r), L::Splat(1.0f));
+				return ExpScale(x, p, n);
+			}
+
+			static inline V __vectorcall Log(V x)
+			{
+				V f, e;
+				LogReduce(x, f, e);
+				auto z = L::Mul(f, f);
+				auto p = L::MulAdd(L::Splat(7.0376836292e-2f), f, L::Splat(-1.1514610310e-1f));
+				p = L::MulAdd(p, f, L::Splat(1.1676998740e-1f));
+				p = L::MulAdd(p, f, L::Splat(-1.2420140846e-1f));
+				p = L::MulAdd(p, f, L::Splat(1.4249322787e-1f));
+				p = L::MulAdd(p, f, L::Splat(-1.6668057665e-1f));
+				p = L::MulAdd(p, f, L::Splat(2.0000714765e-1f));
+				p = L::MulAdd(p, f, L::Splat(-2.4999993993e-1f));
+				p = L::MulAdd(p, f, L::Splat(3.3333331174e-1f));
+
+				auto y = L::Mul(L::Mul(f, z), p);
+				y = L::MulAdd(e, L::Splat(-2.12194440e-4f), y);
+				y = L::NegMulAdd(L::Splat(0.5f), z, y);
+				auto result = L::MulAdd(e, L::Splat(0.693359375f), L::Add(f, y));
+				return LogSpecialCases(x, result);
+			}
+
+			// log(m) = 2 atanh(s), s = (m - 1) / (m + 1)
+			static inline V __vectorcall LogEst(V x)
+			{
+				V f, e;
+				LogReduce(x, f, e);
+				auto s = L::Div(f, L::Add(f, L::Splat(2.0f)));
+				auto z = L::Mul(s, s);
+				auto p = L::MulAdd(L::MulAdd(L::Splat(0.4f), z, L::Splat(0.666666667f)), z, L::Splat(2.0f));
+				auto result = L::MulAdd(e, L::Splat(0.693147181f), L::Mul(s, p));
+				return LogSpecialCases(x, result);
+			}
+
+		private:
+			// Cody-Waite reduction by pi/2 onto [-pi/4, pi/4]. The leading part has few enough bits that q * part
+			// is exact without FMA for |q| < 2^16; Est drops the last correction term.
+			template<bool Est>
+			static inline void __vectorcall SinCosImpl(V x, V& outSin, V& outCos)
+			{
+				auto q = L::Round(L::Mul(x, L::Splat(0.636619772f)));
+				auto r = L::NegMulAdd(q, L::Splat(1.5703125f), x);
+
+				if (Est)
+				{
+					r = L::NegMulAdd(q, L::Splat(4.83826794896619e-4f), r);
+				}
+				else
+				{
+					r = L::NegMulAdd(q, L::Splat(4.837512969970703125e-4f), r);
+					r = L::NegMulAdd(q, L::Splat(7.54978995489188216e-8f), r);
+				}
+
+				// Keeps results within [-1, 1] once huge arguments have lost all accuracy. NaN passes through.
+				r = L::Max(L::Splat(-1.0f), L::Min(L::Splat(1.0f), r));
+
+				auto z = L::Mul(r, r);
+				V s, c;
+
+				if (Est)
+				{
+					s = L::MulAdd(L::Mul(r, z), L::MulAdd(L::Splat(0.00816329f), z, L::Splat(-0.16663391f)), r);
+					c = L::MulAdd(z, L::MulAdd(L::Splat(0.040489f), z, L::Splat(-0.49977633f)), L::Splat(1.0f));
+				}
+				else
+				{
+					auto sp = L::MulAdd(L::MulAdd(L::Splat(-1.9515295891e-4f), z, L::Splat(8.3321608736e-3f)), z, L::Splat(-1.6666654611e-1f));
+					s = L::MulAdd(L::Mul(r, z), sp, r);
+					auto cp = L::MulAdd(L::MulAdd(L::Splat(2.443315711809948e-5f), z, L::Splat(-1.388731625493765e-3f)), z, L::Splat(4.166664568298827e-2f));
+					c = L::MulAdd(L::Mul(z, z), cp, L::NegMulAdd(L::Splat(0.5f), z, L::Splat(1.0f)));
+				}
+
+				// Quadrant k = q mod 4 picks sin: s, c, -s, -c and cos: c, -s, -c, s
+				auto k = L::NegMulAdd(L::Splat(4.0f), L::Floor(L::Mul(q, L::Splat(0.25f))), q);
+				auto odd = L::Greater(L::NegMulAdd(L::Splat(2.0f), L::Floor(L::Mul(k, L::Splat(0.5f))), k), L::Splat(0.5f));
+				auto sinNegative = L::Greater(k, L::Splat(1.5f));
+				auto cosNegative = L::MaskAnd(L::Greater(k, L::Splat(0.5f)), L::Less(k, L::Splat(2.5f)));
+
+				auto sinValue = L::Select(s, c, odd);
+				auto cosValue = L::Select(c, s, odd);
+				outSin = L::Select(sinValue, L::Negate(sinValue), sinNegative);
+				outCos = L::Select(cosValue, L::Negate(cosValue), cosNegative);
+			}
+
+			// p = asin(|x|) for |x| <= 0.5; otherwise p = asin(sqrt((1 - |x|) / 2)), flagged by big
+			template<bool Est>
+			static inline void __vectorcall ASinCore(V x, V& p, M& big)
+			{
+				auto a = L::Abs(x);
+				big = L::Greater(a, L::Splat(0.5f));
+				auto z = L::Select(L::Mul(a, a), L::Mul(L::Splat(0.5f), L::Sub(L::Splat(1.0f), a)), big);
+				auto s = L::Select(a, L::Sqrt(z), big);
+				V poly;
+
+				if (Est)
+				{
+					poly = L::MulAdd(L::MulAdd(L::Splat(0.06410699f), z, L::Splat(0.07189989f)), z, L::Splat(0.16680125f));
+				}
+				else
+				{
+					poly = L::MulAdd(L::Splat(4.2163199048e-2f), z, L::Splat(2.4181311049e-2f));
+					poly = L::MulAdd(poly, z, L::Splat(4.5470025998e-2f));
+					poly = L::MulAdd(poly, z, L::Splat(7.4953002686e-2f));
+					poly = L::MulAdd(poly, z, L::Splat(1.6666752422e-1f));
+				}
+
+				p = L::MulAdd(L::Mul(s, z), poly, s);
+			}
+
+			// asin(x) = pi/2 - 2 asin(sqrt((1 - x) / 2)) above 0.5
+			template<bool Est>
+			static inline V __vectorcall ASinImpl(V x)
+			{
+				V p; M big;
+				ASinCore<Est>(x, p, big);
+				return L::CopySign(L::Select(p, L::NegMulAdd(L::Splat(2.0f), p, L::Splat(XM_PIDIV2)), big), x);
+			}
+
+			// acos(x) = 2 asin(sqrt((1 - x) / 2)) above 0.5, pi - 2 asin(sqrt((1 + x) / 2)) below -0.5
+			template<bool Est>
+			static inline V __vectorcall ACosImpl(V x)
+			{
+				V p; M big;
+				ASinCore<Est>(x, p, big);
+				auto small = L::Sub(L::Splat(XM_PIDIV2), L::CopySign(p, x));
+				auto twice = L::Add(p, p);
+				auto large = L::Select(twice, L::Sub(L::Splat(XM_PI), twice), L::Less(x, L::Zero()));
+				return L::Select(small, large, big);
+			}
+
+			// atan(t) for |t| <= tan(pi/8)
+			static inline V __vectorcall ATanPoly(V t)
+			{
+				auto z = L::Mul(t, t);
+				auto p = L::MulAdd(L::Splat(8.05374449538e-2f), z, L::Splat(-1.38776856032e-1f));
+				p = L::MulAdd(p, z, L::Splat(1.99777106478e-1f));
+				p = L::MulAdd(p, z, L::Splat(-3.33329491539e-1f));
+				return L::MulAdd(L::Mul(p, z), t, t);
+			}
+
+			// atan(t) for t in [0, 1]
+			static inline V __vectorcall ATanEstPoly(V t)
+			{
+				auto z = L::Mul(t, t);
+				auto p = L::MulAdd(L::Splat(0.02386338f), z, L::Splat(-0.09192654f));
+				p = L::MulAdd(p, z, L::Splat(0.18521566f));
+				p = L::MulAdd(p, z, L::Splat(-0.33170084f));
+				p = L::MulAdd(p, z, L::Splat(0.99997003f));
+				return L::Mul(p, t);
+			}
+
+			template<bool Est>
+			static inline V __vectorcall ATan2Impl(V y, V x)
+			{
+				auto ax = L::Abs(x);
+				auto ay = L::Abs(y);
+				auto lo = L::Min(ax, ay);
+				auto hi = L::Max(ax, ay);
+
+				// 0/0 and inf/inf are resolved by the quadrant logic below
+				auto t = L::Div(lo, hi);
+				t = L::Select(t, L::Zero(), L::LessOrEqual(hi, L::Zero()));
+				t = L::Select(t, L::Splat(1.0f), L::GreaterOrEqual(lo, L::Splat(INFINITY)));
+
+				V r;
+				if (Est)
+				{
+					r = ATanEstPoly(t);
+				}
+				else
+				{
+					auto one = L::Splat(1.0f);
+					auto mid = L::Greater(t, L::Splat(0.414213562f));
+					auto reduced = L::Select(t, L::Div(L::Sub(t, one), L::Add(t, one)), mid);
+					r = L::Add(L::Select(L::Zero(), L::Splat(XM_PIDIV4), mid), ATanPoly(reduced));
+				}
+
+				r = L::Select(r, L::Sub(L::Splat(XM_PIDIV2), r), L::Greater(ay, ax));
+				// Checks the sign bit so that x = -0 selects the left half-plane
+				r = L::Select(r, L::Sub(L::Splat(XM_PI), r), L::Less(L::CopySign(L::Splat(1.0f), x), L::Zero()));
+				r = L::CopySign(r, y);
+				return L::Select(r, L::Add(x, y), L::MaskOr(L::IsNan(x), L::IsNan(y)));
+			}
+
+			// x = n ln2 + r, |r| <= ln2 / 2, with ln2 split in two so n * 0.693359375 is exact
+			static inline void __vectorcall ExpReduce(V x, V& r, V& n)
+			{
+				auto clamped = L::Min(L::Max(x, L::Splat(-88.0f)), L::Splat(89.0f));
+				n = L::Round(L::Mul(clamped, L::Splat(1.44269504f)));
+				r = L::NegMulAdd(n, L::Splat(0.693359375f), x);
+				r = L::NegMulAdd(n, L::Splat(-2.12194440e-4f), r);
+			}
+
+			// p * 2^n, with n = 128 handled in two steps
+			static inline V __vectorcall ExpScale(V x, V p, V n)
+			{
+				auto high = L::Greater(n, L::Splat(127.0f));
+				auto result = L::Mul(p, L::Pow2(L::Select(n, L::Splat(127.0f), high)));
+				result = L::Select(result, L::Add(result, result), high);
+				result = L::Select(result, L::Splat(INFINITY), L::Greater(x, L::Splat(88.7228394f)));
+				return L::Select(result, L::Zero(), L::Less(x, L::Splat(-87.3365479f)));
+			}
+
+			// x = 2^e (1 + f) with 1 + f in [sqrt(1/2), sqrt(2)). Subnormals are scaled up first.
+			static inline void __vectorcall LogReduce(V x, V& f, V& e)
+			{
+				auto subnormal = L::Less(x, L::Splat(1.17549435e-38f));
+				auto scaled = L::Select(x, L::Mul(x, L::Splat(8388608.0f)), subnormal);
+				e = L::Sub(L::Exponent(scaled), L::Select(L::Zero(), L::Splat(23.0f), subnormal));
+				auto m = L::Mantissa(scaled);
+
+				auto high = L::Greater(m, L::Splat(1.41421356f));
+				m = L::Select(m, L::Mul(m, L::Splat(0.5f)), high);
+				e = L::Select(e, L::Add(e, L::Splat(1.0f)), high);
+				f = L::Sub(m, L::Splat(1.0f));
+			}
+
+			static inline V __vectorcall LogSpecialCases(V x, V result)
+			{
+				result = L::Select(result, L::Splat(-INFINITY), L::LessOrEqual(x, L::Zero()));
+				result = L::Select(result, L::Splat(NAN), L::Less(x, L::Zero()));
+				return L::Select(result, x, L::MaskOr(L::IsNan(x), L::GreaterOrEqual(x, L::Splat(INFINITY))));
+			}
+		};
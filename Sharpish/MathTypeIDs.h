@@ -0,0 +1,67 @@
+#pragma once
+
+// Registers the math and geometry value types with the object model, so they can be boxed and stored in
+// Array<T>. Included by Sharpish.h after the object model; SharpishMath.h leaves these out.
+
+IS_VALUETYPE(::CS::Float2, "BAF5E9F7-D626-4B94-9436-52A1CAB75E32");
+IS_VALUETYPE(::CS::Float3, "94014C8C-AEC8-492D-BBDF-64BF0CADEE36");
+IS_VALUETYPE(::CS::Float4, "F6701F12-A5BF-4809-A1B1-33EF405C2A04");
+
+IS_VALUETYPE(::CS::Float2A, "038E604C-626C-4CD3-AD30-E4FB33EB8795");
+IS_VALUETYPE(::CS::Float3A, "1F857758-4897-4BE0-A9F4-D0F75CC95CF9");
+IS_VALUETYPE(::CS::Float4A, "8B6DB859-ACB4-4F7A-94CB-11C0B6DF7CC2");
+
+IS_VALUETYPE(::CS::Int2, "8C379C01-31F8-410B-BBDE-EF29CF010FA2");
+IS_VALUETYPE(::CS::Int3, "A89E1D19-EC3C-45FE-876D-1AF67C5E7593");
+IS_VALUETYPE(::CS::Int4, "6D822D82-2AAF-4D45-9260-8568C41439E0");
+
+IS_VALUETYPE(::CS::Int2A, "74649EE4-FAE8-4285-AE20-730532B6AA79");
+IS_VALUETYPE(::CS::Int3A, "52F8ADEF-CF2C-4840-974B-9DD7D9AC63ED");
+IS_VALUETYPE(::CS::Int4A, "62840D4B-87D3-408B-B237-F4003AD7EEA6");
+
+IS_VALUETYPE(::CS::Bool2, "E82177F0-264B-484A-BC7F-8CA2C158D0F7");
+IS_VALUETYPE(::CS::Bool3, "E9296CD5-2634-45A9-B124-6B2657419D91");
+IS_VALUETYPE(::CS::Bool4, "F516D8CF-696C-4C4D-BCEC-026E0B73AC8A");
+
+IS_VALUETYPE(::CS::Bool2A, "8412C092-5178-498E-AA30-18A2A2CF0173");
+IS_VALUETYPE(::CS::Bool3A, "4A09E825-BBC0-43F9-ACC6-47A9D05D563E");
+IS_VALUETYPE(::CS::Bool4A, "3CBD364E-0E00-4063-B410-0A8AF48B2ACC");
+
+IS_VALUETYPE(::CS::Half2, "5B0E2F61-8C3A-4D97-9E24-71A3C6D05B18");
+IS_VALUETYPE(::CS::Half3, "C2D84A37-6F15-4E0B-A9C3-0D5E87B1F462");
+IS_VALUETYPE(::CS::Half4, "0E97B3D5-21C8-4A6F-8D40-B6F1529CE873");
+
+IS_VALUETYPE(::CS::QuaternionA, "1FB75604-3293-4168-A0FA-26468E7DF2B7");
+IS_VALUETYPE(::CS::Quaternion, "FEBDD969-AC96-4BF2-B8ED-106934A12140");
+
+IS_VALUETYPE(::CS::Float4x4A, "18D58019-8EF6-4243-A12E-C1EFFBC82F80");
+IS_VALUETYPE(::CS::Float4x3A, "490C1D72-8235-4415-8C9C-27EA73EBB606");
+IS_VALUETYPE(::CS::Float4x4, "AC3C94A7-9698-4A1E-8F67-60CA5E56EFCC");
+IS_VALUETYPE(::CS::Float4x3, "29C390B9-D5DB-468C-9A33-1C54051B49E2");
+IS_VALUETYPE(::CS::Float3x3, "C9576106-C9CB-49EB-BA7C-F3D1B0F254C0");
+
+IS_VALUETYPE(::CS::Float3Stream, "DF93B8B3-7257-461D-A8B4-98B4C4890AEA");
+IS_VALUETYPE(::CS::Float4Stream, "0AB3876C-453A-4D40-A3A6-3F8F97A9F5EA");
+IS_VALUETYPE(::CS::QuaternionStream, "DA544E25-4B12-423B-B305-6A18362D436F");
+
+IS_VALUETYPE(::CS::OctahedralNormal16, "A063CD9A-AE30-46EC-8BA6-3AEC0DA7B620");
+IS_VALUETYPE(::CS::OctahedralNormal24, "6D2F8E14-93B7-4C05-A1E8-57C0D3B96A2F");
+IS_VALUETYPE(::CS::OctahedralNormal32, "E4B71C09-5A2D-4F83-96E1-0C8D25F7B3A4");
+IS_VALUETYPE(::CS::CompactQuaternion32, "31C9A6E8-07F4-4B2D-8E5A-C96B140F7D23");
+IS_VALUETYPE(::CS::CompactQuaternion48, "9A5E03D7-C8B1-4E6F-B247-3F1D8A69C0E5");
+IS_VALUETYPE(::CS::CompactQuaternion64, "F08D42B6-1E7C-4A39-85D0-6B2E97C4A1F8");
+
+IS_VALUETYPE(::CS::Range, "34EB500D-A05B-4812-8DBE-56635CFAF264");
+
+IS_VALUETYPE(::CS::Rational, "60B9DC9A-BBEE-469B-8027-F7EE76B129C4");
+
+IS_VALUETYPE(::CS::Rect, "33FC5FE3-47E3-41D9-8367-B1A1A09C9D08");
+
+IS_VALUETYPE(::CS::Size, "BC8D3CDA-606B-4D75-9B12-922C74D78B91");
+IS_VALUETYPE(::CS::Size3D, "680674FA-DE60-479D-9454-F9D28E855291");
+
+IS_VALUETYPE(::CS::BoundingBox, "9C1D7D3E-9042-42F6-AF18-905A98F862FB");
+IS_VALUETYPE(::CS::BoundingBoxA, "179928A5-3F4D-41D5-959B-5D41C9A925D6");
+
+IS_VALUETYPE(::CS::BoundingSphereA, "AB7271AE-E3A7-4E14-8655-175B4FFAFDD4");
+IS_VALUETYPE(::CS::BoundingSphere, "AB7271AE-E3A7-4E14-8655-175B4FFAFDD4");
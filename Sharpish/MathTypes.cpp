@@ -1,4 +1,6 @@
 #include "Sharpish.h"
+#include "MathDispatch.h"
+#include "MathParallel.h"
 
 // ::PUBLICLIB::
 
@@ -202,3 +204,365 @@ bool Float4x4::operator ==(const Float4x4& r) const throw() { return memcmp(this
 bool Float3x3::operator !=(const Float3x3& r) const throw() { return memcmp(this, &r, sizeof(Float3x3)) != 0; }
 bool Float4x3::operator !=(const Float4x3& r) const throw() { return memcmp(this, &r, sizeof(Float4x3)) != 0; }
 bool Float4x4::operator !=(const Float4x4& r) const throw() { return memcmp(this, &r, sizeof(Float4x4)) != 0; }
+
+namespace
+{
+	float* AllocateLanes(int lanes, size_t length, size_t& outStride, std::shared_ptr<float>& outManager)
+	{
+		outStride = (length + Float3Stream::LaneAlignment - 1) & ~(size_t)(Float3Stream::LaneAlignment - 1);
+
+		if (outStride == 0)
+			return nullptr;
+
+		auto ptr = _aligned_malloc_array<float>(outStride * lanes, 64);
+
+		if (!ptr)
+			throw std::bad_alloc();
+
+		zero(ptr, outStride * lanes);
+		outManager = std::shared_ptr<float>(ptr, _aligned_free);
+		return ptr;
+	}
+}
+
+#define SHARPISH_KERNELS "MathTypesKernels.inl"
+#include "MathKernels.h"
+
+namespace
+{
+	// Conversion is bound by memory bandwidth, so only large arrays are worth splitting
+	const size_t HalfConversionGranularity = 65536;
+
+	void HalfToFloat(const uint16_t* src, float* dst, size_t count)
+	{
+		auto kernel = SHARPISH_KERNEL(HalfToFloatKernel)::Get();
+		Details::ParallelFor(count, HalfConversionGranularity, [&](size_t begin, size_t end)
+		{
+			kernel(src + begin, dst + begin, end - begin);
+		});
+	}
+
+	void FloatToHalf(const float* src, uint16_t* dst, size_t count)
+	{
+		auto kernel = SHARPISH_KERNEL(FloatToHalfKernel)::Get();
+		Details::ParallelFor(count, HalfConversionGranularity, [&](size_t begin, size_t end)
+		{
+			kernel(src + begin, dst + begin, end - begin);
+		});
+	}
+}
+
+Float3Stream::Float3Stream(size_t length) : _length(length)
+{
+	_ptr = AllocateLanes(3, length, _stride, _mgr);
+}
+
+Float3Stream::Float3Stream(const Float3* arr, size_t length) : Float3Stream(length)
+{
+	CopyFrom(arr);
+}
+
+Float3Stream::Float3Stream(const Float3A* arr, size_t length) : Float3Stream(length)
+{
+	CopyFrom(arr);
+}
+
+void Float3Stream::CopyFrom(const Float3* src)
+{
+	float* x = GetX(); float* y = GetY(); float* z = GetZ();
+
+	for (size_t i = 0; i < _length; i++)
+	{
+		x[i] = src[i].X;
+		y[i] = src[i].Y;
+		z[i] = src[i].Z;
+	}
+}
+
+void Float3Stream::CopyFrom(const Float3A* src)
+{
+	float* x = GetX(); float* y = GetY(); float* z = GetZ();
+
+	for (size_t i = 0; i < _length; i++)
+	{
+		Float3 v = src[i];
+		x[i] = v.X;
+		y[i] = v.Y;
+		z[i] = v.Z;
+	}
+}
+
+void Float3Stream::CopyTo(Float3* dst) const
+{
+	const float* x = GetX(); const float* y = GetY(); const float* z = GetZ();
+
+	for (size_t i = 0; i < _length; i++)
+		dst[i] = Float3(x[i], y[i], z[i]);
+}
+
+void Float3Stream::CopyTo(Float3A* dst) const
+{
+	const float* x = GetX(); const float* y = GetY(); const float* z = GetZ();
+
+	for (size_t i = 0; i < _length; i++)
+		dst[i] = Float3A(x[i], y[i], z[i]);
+}
+
+Array<Float3> Float3Stream::ToArray() const
+{
+	Array<Float3> output(_length);
+	CopyTo(output.begin());
+	return output;
+}
+
+Array<Float3A> Float3Stream::ToArrayA() const
+{
+	Array<Float3A> output(_length);
+	CopyTo(output.begin());
+	return output;
+}
+
+void Float3Stream::Transform(const Float4x3A& m, Float3Stream& out) const
+{
+	if (out.size() != _length) out = Float3Stream(_length);
+
+	XMFLOAT4X4 mf;
+	XMStoreFloat4x4(&mf, m);
+	SHARPISH_KERNEL(Transform3Kernel)::Get()(GetX(), GetY(), GetZ(), out.GetX(), out.GetY(), out.GetZ(), _length, mf, true);
+}
+
+void Float3Stream::TransformNormal(const Float4x3A& m, Float3Stream& out) const
+{
+	if (out.size() != _length) out = Float3Stream(_length);
+
+	XMFLOAT4X4 mf;
+	XMStoreFloat4x4(&mf, m);
+	SHARPISH_KERNEL(Transform3Kernel)::Get()(GetX(), GetY(), GetZ(), out.GetX(), out.GetY(), out.GetZ(), _length, mf, false);
+}
+
+void Float3Stream::TransformCoord(const Float4x4A& m, Float3Stream& out) const
+{
+	if (out.size() != _length) out = Float3Stream(_length);
+
+	XMFLOAT4X4 mf;
+	XMStoreFloat4x4(&mf, m);
+	SHARPISH_KERNEL(TransformCoord3Kernel)::Get()(GetX(), GetY(), GetZ(), out.GetX(), out.GetY(), out.GetZ(), _length, mf);
+}
+
+Float4Stream::Float4Stream(size_t length) : _length(length)
+{
+	_ptr = AllocateLanes(4, length, _stride, _mgr);
+}
+
+Float4Stream::Float4Stream(const Float4* arr, size_t length) : Float4Stream(length)
+{
+	CopyFrom(arr);
+}
+
+Float4Stream::Float4Stream(const Float4A* arr, size_t length) : Float4Stream(length)
+{
+	CopyFrom(arr);
+}
+
+void Float4Stream::CopyFrom(const Float4* src)
+{
+	float* x = GetX(); float* y = GetY(); float* z = GetZ(); float* w = GetW();
+
+	for (size_t i = 0; i < _length; i++)
+	{
+		x[i] = src[i].X;
+		y[i] = src[i].Y;
+		z[i] = src[i].Z;
+		w[i] = src[i].W;
+	}
+}
+
+void Float4Stream::CopyFrom(const Float4A* src)
+{
+	float* x = GetX(); float* y = GetY(); float* z = GetZ(); float* w = GetW();
+
+	for (size_t i = 0; i < _length; i++)
+	{
+		Float4 v = src[i];
+		x[i] = v.X;
+		y[i] = v.Y;
+		z[i] = v.Z;
+		w[i] = v.W;
+	}
+}
+
+void Float4Stream::CopyTo(Float4* dst) const
+{
+	const float* x = GetX(); const float* y = GetY(); const float* z = GetZ(); const float* w = GetW();
+
+	for (size_t i = 0; i < _length; i++)
+		dst[i] = Float4(x[i], y[i], z[i], w[i]);
+}
+
+void Float4Stream::CopyTo(Float4A* dst) const
+{
+	const float* x = GetX(); const float* y = GetY(); const float* z = GetZ(); const float* w = GetW();
+
+	for (size_t i = 0; i < _length; i++)
+		dst[i] = Float4A(x[i], y[i], z[i], w[i]);
+}
+
+Array<Float4> Float4Stream::ToArray() const
+{
+	Array<Float4> output(_length);
+	CopyTo(output.begin());
+	return output;
+}
+
+Array<Float4A> Float4Stream::ToArrayA() const
+{
+	Array<Float4A> output(_length);
+	CopyTo(output.begin());
+	return output;
+}
+
+void Float4Stream::Transform(const Float4x4A& m, Float4Stream& out) const
+{
+	if (out.size() != _length) out = Float4Stream(_length);
+
+	XMFLOAT4X4 mf;
+	XMStoreFloat4x4(&mf, m);
+	SHARPISH_KERNEL(Transform4Kernel)::Get()(GetX(), GetY(), GetZ(), GetW(), out.GetX(), out.GetY(), out.GetZ(), out.GetW(), _length, mf);
+}
+
+QuaternionStream::QuaternionStream(size_t length) : _length(length)
+{
+	_ptr = AllocateLanes(4, length, _stride, _mgr);
+}
+
+QuaternionStream::QuaternionStream(const Quaternion* arr, size_t length) : QuaternionStream(length)
+{
+	CopyFrom(arr);
+}
+
+QuaternionStream::QuaternionStream(const QuaternionA* arr, size_t length) : QuaternionStream(length)
+{
+	CopyFrom(arr);
+}
+
+void QuaternionStream::CopyFrom(const Quaternion* src)
+{
+	float* x = GetX(); float* y = GetY(); float* z = GetZ(); float* w = GetW();
+
+	for (size_t i = 0; i < _length; i++)
+	{
+		x[i] = src[i].X;
+		y[i] = src[i].Y;
+		z[i] = src[i].Z;
+		w[i] = src[i].W;
+	}
+}
+
+void QuaternionStream::CopyFrom(const QuaternionA* src)
+{
+	float* x = GetX(); float* y = GetY(); float* z = GetZ(); float* w = GetW();
+
+	for (size_t i = 0; i < _length; i++)
+	{
+		Quaternion q = src[i];
+		x[i] = q.X;
+		y[i] = q.Y;
+		z[i] = q.Z;
+		w[i] = q.W;
+	}
+}
+
+void QuaternionStream::CopyTo(Quaternion* dst) const
+{
+	const float* x = GetX(); const float* y = GetY(); const float* z = GetZ(); const float* w = GetW();
+
+	for (size_t i = 0; i < _length; i++)
+		dst[i] = Quaternion(x[i], y[i], z[i], w[i]);
+}
+
+void QuaternionStream::CopyTo(QuaternionA* dst) const
+{
+	const float* x = GetX(); const float* y = GetY(); const float* z = GetZ(); const float* w = GetW();
+
+	for (size_t i = 0; i < _length; i++)
+		dst[i] = QuaternionA(x[i], y[i], z[i], w[i]);
+}
+
+Array<Quaternion> QuaternionStream::ToArray() const
+{
+	Array<Quaternion> output(_length);
+	CopyTo(output.begin());
+	return output;
+}
+
+Array<QuaternionA> QuaternionStream::ToArrayA() const
+{
+	Array<QuaternionA> output(_length);
+	CopyTo(output.begin());
+	return output;
+}
+
+void QuaternionStream::Normalize(QuaternionStream& out) const
+{
+	Normalize<Precision::Exact>(out);
+}
+
+template<Precision P>
+void QuaternionStream::Normalize(QuaternionStream& out) const
+{
+	if (out.size() != _length) out = QuaternionStream(_length);
+
+	SHARPISH_KERNEL(QuaternionNormalizeKernel<P>)::Get()(GetX(), _stride, out.GetX(), out.GetStride(), _length);
+}
+
+template void QuaternionStream::Normalize<Precision::Exact>(QuaternionStream& out) const;
+template void QuaternionStream::Normalize<Precision::Refined>(QuaternionStream& out) const;
+template void QuaternionStream::Normalize<Precision::Estimate>(QuaternionStream& out) const;
+
+void QuaternionStream::Inverse(QuaternionStream& out) const
+{
+	if (out.size() != _length) out = QuaternionStream(_length);
+
+	SHARPISH_KERNEL(QuaternionInverseKernel)::Get()(GetX(), _stride, out.GetX(), out.GetStride(), _length);
+}
+
+void QuaternionStream::Multiply(const QuaternionStream& rhs, QuaternionStream& out) const
+{
+	if (rhs.size() != _length) throw ArgumentException("rhs", "Stream sizes differ");
+	if (out.size() != _length) out = QuaternionStream(_length);
+
+	SHARPISH_KERNEL(QuaternionMultiplyKernel)::Get()(GetX(), _stride, rhs.GetX(), rhs.GetStride(), out.GetX(), out.GetStride(), _length);
+}
+
+void QuaternionStream::RotateVectors(const Float3Stream& v, Float3Stream& out) const
+{
+	if (v.size() != _length) throw ArgumentException("v", "Stream sizes differ");
+	if (out.size() != _length) out = Float3Stream(_length);
+
+	SHARPISH_KERNEL(QuaternionRotateKernel)::Get()(GetX(), _stride, v.GetX(), v.GetStride(), out.GetX(), out.GetStride(), _length);
+}
+
+void QuaternionStream::Slerp(const QuaternionStream& q1, const QuaternionStream& q2, float u, QuaternionStream& out)
+{
+	if (q2.size() != q1.size()) throw ArgumentException("q2", "Stream sizes differ");
+	if (out.size() != q1.size()) out = QuaternionStream(q1.size());
+
+	SHARPISH_KERNEL(QuaternionBlendKernel)::Get()(q1.GetX(), q1.GetStride(), q2.GetX(), q2.GetStride(), out.GetX(), out.GetStride(), q1.size(), u, false);
+}
+
+void QuaternionStream::Nlerp(const QuaternionStream& q1, const QuaternionStream& q2, float u, QuaternionStream& out)
+{
+	if (q2.size() != q1.size()) throw ArgumentException("q2", "Stream sizes differ");
+	if (out.size() != q1.size()) out = QuaternionStream(q1.size());
+
+	SHARPISH_KERNEL(QuaternionBlendKernel)::Get()(q1.GetX(), q1.GetStride(), q2.GetX(), q2.GetStride(), out.GetX(), out.GetStride(), q1.size(), u, true);
+}
+
+void Half2::ToFloat(const Half2* src, Float2* dst, size_t count) { HalfToFloat(&src->XBits, &dst->X, count * 2); }
+void Half2::FromFloat(const Float2* src, Half2* dst, size_t count) { FloatToHalf(&src->X, &dst->XBits, count * 2); }
+void Half3::ToFloat(const Half3* src, Float3* dst, size_t count) { HalfToFloat(&src->XBits, &dst->X, count * 3); }
+void Half3::FromFloat(const Float3* src, Half3* dst, size_t count) { FloatToHalf(&src->X, &dst->XBits, count * 3); }
+void Half4::ToFloat(const Half4* src, Float4* dst, size_t count) { HalfToFloat(&src->XBits, &dst->X, count * 4); }
+void Half4::ToFloat(const Half4* src, Float4A* dst, size_t count) { HalfToFloat(&src->XBits, (float*)dst, count * 4); }
+void Half4::FromFloat(const Float4* src, Half4* dst, size_t count) { FloatToHalf(&src->X, &dst->XBits, count * 4); }
+void Half4::FromFloat(const Float4A* src, Half4* dst, size_t count) { FloatToHalf((const float*)src, &dst->XBits, count * 4); }
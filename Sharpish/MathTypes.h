@@ -15,14 +15,21 @@
 //     Bool2, Bool3, Bool4
 //     Bool2A, Bool3A, Bool4A  (!6-byte aligned)
 //
+// Half-precision vectors (storage only, convert to Float for arithmetic):
+//     Half2, Half3, Half4
+//
 // Matrices:
 //     Float3x3, Float4x3, Float4x4
 //     Float4x3A, Float4x4A  (16-byte aligned)
 //
+// Streams (structure-of-arrays, for batch processing):
+//     Float3Stream, Float4Stream, QuaternionStream
+//
 // The library is modeled after Unity and WPF's, and is built on top of the XM** APIs provided by DirectX.
 // Vector types are templatized as well, so Float3 == Vector<float,3> and Float2A == Vector<float,2,true>
 
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
 
 namespace CS
 {
@@ -52,6 +59,11 @@ namespace CS
 		template<typename T>
 		struct VectorAccess;
 
+		// V, named through a template argument so that its use in a member template waits for instantiation.
+		// The swizzles return vector types that are still incomplete where they are declared.
+		template<typename V, int>
+		struct Deferred { typedef V Type; };
+
 		inline XMVECTOR __vectorcall Replicate(int x) { return XMVectorReplicateInt((uint32_t)x); }
 		inline XMVECTOR __vectorcall Replicate(bool x) { return XMVectorReplicateInt(x ? 0xFFFFFFFF : 0); }
 		inline XMVECTOR __vectorcall Replicate(float x) { return XMVectorReplicate(x); }
@@ -136,16 +148,16 @@ namespace CS
 	}
 
 #define VectorSwizzleAligned(T,Rank) \
-			template<int c0, int c1> inline Vector<T, 2, true> __vectorcall Swizzle2() \
+			template<int c0, int c1> inline typename Details::Deferred<Vector<T, 2, true>, c0>::Type __vectorcall Swizzle2() \
 			{ static_assert(c0 < Rank, "c0 template parameter out of range"); \
 				static_assert(c1 < Rank, "c1 template parameter out of range"); \
 				return XMVectorSwizzle<c0, c1, 0, 0>(_xm);} \
-			template<int c0, int c1, int c2> inline Vector<T, 3, true> __vectorcall Swizzle3()\
+			template<int c0, int c1, int c2> inline typename Details::Deferred<Vector<T, 3, true>, c0>::Type __vectorcall Swizzle3()\
 			{ static_assert(c0 < Rank, "c0 template parameter out of range"); \
 				static_assert(c1 < Rank, "c1 template parameter out of range"); \
 				static_assert(c2 < Rank, "c2 template parameter out of range"); \
 				return XMVectorSwizzle<c0, c1, c2, 0>(_xm); } \
-			template<int c0, int c1, int c2, int c3> inline Vector<T, 4, true> __vectorcall Swizzle4() \
+			template<int c0, int c1, int c2, int c3> inline typename Details::Deferred<Vector<T, 4, true>, c0>::Type __vectorcall Swizzle4() \
 			{ static_assert(c0 < Rank, "c0 template parameter out of range"); \
 				static_assert(c1 < Rank, "c1 template parameter out of range"); \
 				static_assert(c2 < Rank, "c2 template parameter out of range"); \
@@ -200,22 +212,22 @@ namespace CS
 			{ return XMVectorRotateRight(*this, (uint32_t)count); }
 
 #define VectorSwizzleUnaligned(T,Rank) \
-		template<int c0> inline Vector<T, 1, true> __vectorcall Swizzle1() const \
+		template<int c0> inline typename Details::Deferred<Vector<T, 1, true>, c0>::Type __vectorcall Swizzle1() const \
 			{ static_assert(c0 < Rank, "c0 template parameter out of range"); \
 			auto aref = (T*)this; \
 			return XMVectorSet(aref[c0], 0, 0, 0); } \
-		template<int c0, int c1> inline Vector<T, 2, true> __vectorcall Swizzle2() const \
+		template<int c0, int c1> inline typename Details::Deferred<Vector<T, 2, true>, c0>::Type __vectorcall Swizzle2() const \
 			{ static_assert(c0 < Rank, "c0 template parameter out of range"); \
 			static_assert(c1 < Rank, "c1 template parameter out of range"); \
 			auto aref = (T*)this; \
 			return XMVectorSet(aref[c0], aref[c1], 0, 0); } \
-		template<int c0, int c1, int c2> inline Vector<T, 3, true> __vectorcall Swizzle3() const \
+		template<int c0, int c1, int c2> inline typename Details::Deferred<Vector<T, 3, true>, c0>::Type __vectorcall Swizzle3() const \
 			{ static_assert(c0 < Rank, "c0 template parameter out of range"); \
 			static_assert(c1 < Rank, "c1 template parameter out of range"); \
 			static_assert(c2 < Rank, "c2 template parameter out of range"); \
 			auto aref = (T*)this; \
 			return XMVectorSet(aref[c0], aref[c1], aref[c2], 0); } \
-		template<int c0, int c1, int c2, int c3> inline Vector<T, 4, true> __vectorcall Swizzle4() const \
+		template<int c0, int c1, int c2, int c3> inline typename Details::Deferred<Vector<T, 4, true>, c0>::Type __vectorcall Swizzle4() const \
 			{ static_assert(c0 < Rank, "c0 template parameter out of range"); \
 			static_assert(c1 < Rank, "c1 template parameter out of range"); \
 			static_assert(c2 < Rank, "c2 template parameter out of range"); \
@@ -531,6 +543,15 @@ namespace CS
 		inline Vector& __vectorcall operator/=(const AlignedType& rhs) { (*this) = (*this) / rhs; return *this; } \
 		inline Vector& __vectorcall operator*=(float rhs) { (*this) = (*this) * rhs; return *this; } \
 		inline Vector& __vectorcall operator/=(float rhs) { (*this) = (*this) / rhs; return *this; } \
+		template<Precision P> inline AlignedType __vectorcall Reciprocal() const { return Details::Precise<Details::Lanes4, P>::Reciprocal(*this); } \
+		template<Precision P> inline AlignedType __vectorcall Sqrt() const { return Details::Precise<Details::Lanes4, P>::Sqrt(*this); } \
+		template<Precision P> inline AlignedType __vectorcall ReciprocalSqrt() const { return Details::Precise<Details::Lanes4, P>::ReciprocalSqrt(*this); } \
+		template<Precision P = Precision::Exact> inline AlignedType __vectorcall Divide(const AlignedType& rhs) const { return Details::Precise<Details::Lanes4, P>::Divide(*this, rhs); } \
+		template<Precision P> inline AlignedType __vectorcall Normalize() const { return Details::PreciseVector<Rank, P>::Normalize(*this); } \
+		template<Precision P> inline float __vectorcall GetLength() const { return XMVectorGetX(Details::PreciseVector<Rank, P>::Length(*this)); } \
+		template<Precision P> inline AlignedType __vectorcall SplatLength() const { return Details::PreciseVector<Rank, P>::Length(*this); } \
+		template<Precision P> inline float __vectorcall GetReciprocalLength() const { return XMVectorGetX(Details::PreciseVector<Rank, P>::ReciprocalLength(*this)); } \
+		template<Precision P> inline AlignedType __vectorcall SplatReciprocalLength() const { return Details::PreciseVector<Rank, P>::ReciprocalLength(*this); } \
 		struct _Estimate { const Vector& _v; _Estimate(const Vector& v) : _v(v) { } \
 			inline AlignedType __vectorcall Reciprocal() const { return XMVectorReciprocalEst(_v); } \
 			inline AlignedType __vectorcall Sqrt() const { return XMVectorSqrtEst(_v); } \
@@ -542,6 +563,8 @@ namespace CS
 			inline AlignedType __vectorcall ACos() const { return XMVectorACosEst(_v); } \
 			inline AlignedType __vectorcall ATan() const { return XMVectorATanEst(_v); } \
 			static inline AlignedType __vectorcall ATan2(const AlignedType& y, const AlignedType& x) { return XMVectorATan2Est(y, x); } \
+			inline AlignedType __vectorcall Exp() const { return Details::Transcendental<Details::Lanes4>::ExpEst(_v); } \
+			inline AlignedType __vectorcall Ln() const { return Details::Transcendental<Details::Lanes4>::LogEst(_v); } \
 			inline float __vectorcall Length() const { return XMVectorGetX(XMVector##Rank##LengthEst(_v)); } \
 			inline AlignedType __vectorcall SplatLength() const { return XMVector##Rank##LengthEst(_v); } \
 			inline float __vectorcall ReciprocalLength() const { return XMVectorGetX(XMVector##Rank##ReciprocalLengthEst(_v)); } \
@@ -647,12 +670,12 @@ namespace CS
 	{
 		Vector() { }
 		Vector(XMVECTOR xm) : X(XMVectorGetIntX(xm) != 0), Y(XMVectorGetIntY(xm) != 0) { }
-		Vector(const AlignedType& a) : X(a.X), Y(a.Y) { }
+		Vector(const AlignedType& a) : X(a.GetX()), Y(a.GetY()) { }
 		Vector(bool repeat) : X(repeat), Y(repeat) { }
 		explicit Vector(const bool* arr) : X(arr[0]), Y(arr[1]) { }
 		Vector(bool x, bool y) : X(x), Y(y) { }
 		inline Vector& __vectorcall operator=(const Vector& rhs) { X = rhs.X; Y = rhs.Y; return *this; }
-		inline Vector& __vectorcall operator=(const AlignedType& rhs) { X = rhs.X; Y = rhs.Y; return *this; }
+		inline Vector& __vectorcall operator=(const AlignedType& rhs) { X = rhs.GetX(); Y = rhs.GetY(); return *this; }
 
 		inline bool Any() const { return X || Y; }
 		inline bool All() const { return X && Y; }
@@ -687,12 +710,12 @@ namespace CS
 	{
 		Vector() { }
 		Vector(XMVECTOR xm) : X(XMVectorGetIntX(xm) != 0), Y(XMVectorGetIntY(xm) != 0), Z(XMVectorGetIntZ(xm) != 0) { }
-		Vector(const AlignedType& a) : X(a.X), Y(a.Y), Z(a.Z) { }
+		Vector(const AlignedType& a) : X(a.GetX()), Y(a.GetY()), Z(a.GetZ()) { }
 		Vector(bool repeat) : X(repeat), Y(repeat), Z(repeat) { }
 		explicit Vector(const bool* arr) : X(arr[0]), Y(arr[1]), Z(arr[2]) { }
 		Vector(bool x, bool y, bool z) : X(x), Y(y), Z(z) { }
 		inline Vector& __vectorcall operator=(const Vector& rhs) { X = rhs.X; Y = rhs.Y; Z = rhs.Z; return *this; }
-		inline Vector& __vectorcall operator=(const AlignedType& rhs) { X = rhs.X; Y = rhs.Y; Z = rhs.Z; return *this; }
+		inline Vector& __vectorcall operator=(const AlignedType& rhs) { X = rhs.GetX(); Y = rhs.GetY(); Z = rhs.GetZ(); return *this; }
 
 		inline bool Any() const { return X || Y || Z; }
 		inline bool All() const { return X && Y && Z; }
@@ -727,12 +750,12 @@ namespace CS
 	{
 		Vector() { }
 		Vector(XMVECTOR xm) : X(XMVectorGetIntX(xm) != 0), Y(XMVectorGetIntY(xm) != 0), Z(XMVectorGetIntZ(xm) != 0), W(XMVectorGetIntW(xm) != 0) { }
-		Vector(const AlignedType& a) : X(a.X), Y(a.Y), Z(a.Z), W(a.W) { }
+		Vector(const AlignedType& a) : X(a.GetX()), Y(a.GetY()), Z(a.GetZ()), W(a.GetW()) { }
 		Vector(bool repeat) : X(repeat), Y(repeat), Z(repeat), W(repeat) { }
 		explicit Vector(const bool* arr) : X(arr[0]), Y(arr[1]), Z(arr[2]), W(arr[3]) { }
 		Vector(bool x, bool y, bool z, bool w) : X(x), Y(y), Z(z), W(w) { }
 		inline Vector& __vectorcall operator=(const Vector& rhs) { X = rhs.X; Y = rhs.Y; Z = rhs.Z; W = rhs.W; return *this; }
-		inline Vector& __vectorcall operator=(const AlignedType& rhs) { X = rhs.X; Y = rhs.Y; Z = rhs.Z; W = rhs.W; return *this; }
+		inline Vector& __vectorcall operator=(const AlignedType& rhs) { X = rhs.GetX(); Y = rhs.GetY(); Z = rhs.GetZ(); W = rhs.GetW(); return *this; }
 
 		inline bool Any() const { return X || Y || Z || W; }
 		inline bool All() const { return X && Y && Z && W; }
@@ -792,7 +815,7 @@ namespace CS
 	{
 		VectorAlignedFloatConstructors(3)
 
-			Vector(const Vector<float, 2, true>& xy, float z) : _xm(XMVectorSet(xy.X, xy.Y, z, 1)) { }
+			Vector(const Vector<float, 2, true>& xy, float z) : _xm(XMVectorSet(xy.GetX(), xy.GetY(), z, 1)) { }
 		Vector(const Vector<float, 2, false>& xy, float z) : _xm(XMVectorSet(xy.X, xy.Y, z, 1)) { }
 		Vector(float x, float y, float z) : _xm(XMVectorSet(x, y, z, 1)) { }
 		inline Vector& __vectorcall operator=(const Vector& rhs) { _xm = rhs; return *this; }
@@ -817,7 +840,7 @@ namespace CS
 		Vector(float repeat) : X(repeat), Y(repeat), Z(repeat) { }
 		explicit Vector(const float* arr) : X(arr[0]), Y(arr[1]), Z(arr[2]) { }
 		Vector(const Vector<float, 2, false>& xy, float z) : X(xy.X), Y(xy.Y), Z(z) { }
-		Vector(const Vector<float, 2, true>& xy, float z) : X(xy.X), Y(xy.Y), Z(z) { }
+		Vector(const Vector<float, 2, true>& xy, float z) : X(xy.GetX()), Y(xy.GetY()), Z(z) { }
 		Vector(float x, float y, float z) : X(x), Y(y), Z(z) { }
 		inline Vector& __vectorcall operator=(const Vector& rhs) { X = rhs.X; Y = rhs.Y; Z = rhs.Z;  return *this; }
 		inline Vector& __vectorcall operator=(const AlignedType& rhs) { XMStoreFloat3((XMFLOAT3*)this, rhs); return *this; }
@@ -864,7 +887,7 @@ namespace CS
 		Vector(float repeat) : X(repeat), Y(repeat), Z(repeat), W(repeat) { }
 		explicit Vector(const float* arr) : X(arr[0]), Y(arr[1]), Z(arr[2]), W(arr[3]) { }
 		Vector(const Vector<float, 3, false>& xyz, float w) : X(xyz.X), Y(xyz.Y), Z(xyz.Z), W(w) { }
-		Vector(const Vector<float, 3, true>& xyz, float w) : X(xyz.X), Y(xyz.Y), Z(xyz.Z), W(w) { }
+		Vector(const Vector<float, 3, true>& xyz, float w) : X(xyz.GetX()), Y(xyz.GetY()), Z(xyz.GetZ()), W(w) { }
 		Vector(float x, float y, float z, float w) : X(x), Y(y), Z(z), W(w) { }
 		inline Vector& __vectorcall operator=(const Vector& rhs) { X = rhs.X; Y = rhs.Y; Z = rhs.Z; W = rhs.W; return *this; }
 		inline Vector& __vectorcall operator=(const AlignedType& rhs) { XMStoreFloat4((XMFLOAT4*)this, rhs); return *this; }
@@ -1008,6 +1031,179 @@ namespace CS
 	typedef Vector<bool, 4, false> Bool4;
 	typedef Vector<bool, 4, true> Bool4A;
 
+	// Half-precision (16-bit float) vectors, for keeping large arrays of positions, normals, texture coordinates and
+	// the like at half the size of the Float types. They are storage formats: convert to Float2A/3A/4A to do math.
+	// Conversion rounds to nearest even, magnitudes of 65520 and up become infinity, and half has about three
+	// significant decimal digits. Equality compares bits, so it agrees with hashing.
+	//
+	// ToFloat and FromFloat convert whole arrays, using F16C where the CPU has it and an SSE2 fallback where it
+	// doesn't. dst must not overlap src.
+	struct Half2
+	{
+		PackedVector::HALF XBits;
+		PackedVector::HALF YBits;
+
+		Half2() { }
+		Half2(float x, float y) : XBits(PackedVector::XMConvertFloatToHalf(x)), YBits(PackedVector::XMConvertFloatToHalf(y)) { }
+		explicit Half2(XMVECTOR v) { PackedVector::XMStoreHalf2((PackedVector::XMHALF2*)this, v); }
+
+		PROPERTY(float, X);
+		inline float GetX() const { return PackedVector::XMConvertHalfToFloat(XBits); }
+		inline void SetX(float x) { XBits = PackedVector::XMConvertFloatToHalf(x); }
+
+		PROPERTY(float, Y);
+		inline float GetY() const { return PackedVector::XMConvertHalfToFloat(YBits); }
+		inline void SetY(float y) { YBits = PackedVector::XMConvertFloatToHalf(y); }
+
+		inline operator Float2A() const { return PackedVector::XMLoadHalf2((const PackedVector::XMHALF2*)this); }
+
+		inline bool operator ==(const Half2& rhs) const { return XBits == rhs.XBits && YBits == rhs.YBits; }
+		inline bool operator !=(const Half2& rhs) const { return !(*this == rhs); }
+
+		static void ToFloat(const Half2* src, Float2* dst, size_t count);
+		static void FromFloat(const Float2* src, Half2* dst, size_t count);
+	};
+
+	struct Half3
+	{
+		PackedVector::HALF XBits;
+		PackedVector::HALF YBits;
+		PackedVector::HALF ZBits;
+
+		Half3() { }
+		Half3(float x, float y, float z) :
+			XBits(PackedVector::XMConvertFloatToHalf(x)), YBits(PackedVector::XMConvertFloatToHalf(y)), ZBits(PackedVector::XMConvertFloatToHalf(z)) { }
+		explicit Half3(XMVECTOR v) { PackedVector::XMHALF4 h; PackedVector::XMStoreHalf4(&h, v); XBits = h.x; YBits = h.y; ZBits = h.z; }
+
+		PROPERTY(float, X);
+		inline float GetX() const { return PackedVector::XMConvertHalfToFloat(XBits); }
+		inline void SetX(float x) { XBits = PackedVector::XMConvertFloatToHalf(x); }
+
+		PROPERTY(float, Y);
+		inline float GetY() const { return PackedVector::XMConvertHalfToFloat(YBits); }
+		inline void SetY(float y) { YBits = PackedVector::XMConvertFloatToHalf(y); }
+
+		PROPERTY(float, Z);
+		inline float GetZ() const { return PackedVector::XMConvertHalfToFloat(ZBits); }
+		inline void SetZ(float z) { ZBits = PackedVector::XMConvertFloatToHalf(z); }
+
+		inline operator Float3A() const
+		{
+			PackedVector::XMHALF4 h(XBits, YBits, ZBits, 0);
+			return PackedVector::XMLoadHalf4(&h);
+		}
+
+		inline bool operator ==(const Half3& rhs) const { return XBits == rhs.XBits && YBits == rhs.YBits && ZBits == rhs.ZBits; }
+		inline bool operator !=(const Half3& rhs) const { return !(*this == rhs); }
+
+		static void ToFloat(const Half3* src, Float3* dst, size_t count);
+		static void FromFloat(const Float3* src, Half3* dst, size_t count);
+	};
+
+	struct Half4
+	{
+		PackedVector::HALF XBits;
+		PackedVector::HALF YBits;
+		PackedVector::HALF ZBits;
+		PackedVector::HALF WBits;
+
+		Half4() { }
+		Half4(float x, float y, float z, float w) :
+			XBits(PackedVector::XMConvertFloatToHalf(x)), YBits(PackedVector::XMConvertFloatToHalf(y)),
+			ZBits(PackedVector::XMConvertFloatToHalf(z)), WBits(PackedVector::XMConvertFloatToHalf(w)) { }
+		explicit Half4(XMVECTOR v) { PackedVector::XMStoreHalf4((PackedVector::XMHALF4*)this, v); }
+
+		PROPERTY(float, X);
+		inline float GetX() const { return PackedVector::XMConvertHalfToFloat(XBits); }
+		inline void SetX(float x) { XBits = PackedVector::XMConvertFloatToHalf(x); }
+
+		PROPERTY(float, Y);
+		inline float GetY() const { return PackedVector::XMConvertHalfToFloat(YBits); }
+		inline void SetY(float y) { YBits = PackedVector::XMConvertFloatToHalf(y); }
+
+		PROPERTY(float, Z);
+		inline float GetZ() const { return PackedVector::XMConvertHalfToFloat(ZBits); }
+		inline void SetZ(float z) { ZBits = PackedVector::XMConvertFloatToHalf(z); }
+
+		PROPERTY(float, W);
+		inline float GetW() const { return PackedVector::XMConvertHalfToFloat(WBits); }
+		inline void SetW(float w) { WBits = PackedVector::XMConvertFloatToHalf(w); }
+
+		inline operator Float4A() const { return PackedVector::XMLoadHalf4((const PackedVector::XMHALF4*)this); }
+
+		inline bool operator ==(const Half4& rhs) const { return XBits == rhs.XBits && YBits == rhs.YBits && ZBits == rhs.ZBits && WBits == rhs.WBits; }
+		inline bool operator !=(const Half4& rhs) const { return !(*this == rhs); }
+
+		static void ToFloat(const Half4* src, Float4* dst, size_t count);
+		static void ToFloat(const Half4* src, Float4A* dst, size_t count);
+		static void FromFloat(const Float4* src, Half4* dst, size_t count);
+		static void FromFloat(const Float4A* src, Half4* dst, size_t count);
+	};
+
+	// An aligned float vector type whose reciprocals, square roots, division, length and normalization use
+	// precision P (see MathPrecision.h), e.g. typedef WithPrecision<Float3A, Precision::Refined> FastFloat3A.
+	// Arithmetic returns the same wrapper, so whole expressions stay at that precision. The per-call forms
+	// (Normalize<P>() and so on) remain available, and the wrapper converts freely to and from V.
+	template<typename V, Precision P>
+	struct WithPrecision : V
+	{
+		typedef Details::Precise<Details::Lanes4, P> Op;
+		typedef Details::PreciseVector<V::TypeRank, P> VectorOp;
+
+		using V::V;
+		using V::Normalize;
+		using V::GetLength;
+		using V::SplatLength;
+		using V::GetReciprocalLength;
+		using V::SplatReciprocalLength;
+		using V::Reciprocal;
+		using V::Sqrt;
+		using V::ReciprocalSqrt;
+		using V::operator-;
+		using V::operator+;
+		using V::operator*;
+		using V::operator/;
+
+		WithPrecision() { }
+		WithPrecision(const V& v) : V(v) { }
+
+		inline WithPrecision __vectorcall Normalize() const { return VectorOp::Normalize(*this); }
+
+		PROPERTY_READONLY(float, Length);
+		inline float __vectorcall GetLength() const { return XMVectorGetX(VectorOp::Length(*this)); }
+		inline WithPrecision __vectorcall SplatLength() const { return VectorOp::Length(*this); }
+
+		PROPERTY_READONLY(float, ReciprocalLength);
+		inline float __vectorcall GetReciprocalLength() const { return XMVectorGetX(VectorOp::ReciprocalLength(*this)); }
+		inline WithPrecision __vectorcall SplatReciprocalLength() const { return VectorOp::ReciprocalLength(*this); }
+
+		inline WithPrecision __vectorcall Reciprocal() const { return Op::Reciprocal(*this); }
+		inline WithPrecision __vectorcall Sqrt() const { return Op::Sqrt(*this); }
+		inline WithPrecision __vectorcall ReciprocalSqrt() const { return Op::ReciprocalSqrt(*this); }
+
+		inline WithPrecision __vectorcall operator-() const { return XMVectorNegate(*this); }
+		inline WithPrecision __vectorcall operator+(const V& rhs) const { return XMVectorAdd(*this, rhs); }
+		inline WithPrecision __vectorcall operator-(const V& rhs) const { return XMVectorSubtract(*this, rhs); }
+		inline WithPrecision __vectorcall operator*(const V& rhs) const { return XMVectorMultiply(*this, rhs); }
+		inline WithPrecision __vectorcall operator*(float rhs) const { return XMVectorScale(*this, rhs); }
+		inline WithPrecision __vectorcall operator/(const V& rhs) const { return Op::Divide(*this, rhs); }
+		inline WithPrecision __vectorcall operator/(float rhs) const { return Op::Divide(*this, XMVectorReplicate(rhs)); }
+		inline WithPrecision& __vectorcall operator/=(const V& rhs) { (*this) = (*this) / rhs; return *this; }
+		inline WithPrecision& __vectorcall operator/=(float rhs) { (*this) = (*this) / rhs; return *this; }
+	};
+
+	template<typename V, Precision P>
+	inline WithPrecision<V, P> __vectorcall operator *(float lhs, const WithPrecision<V, P>& rhs)
+	{
+		return XMVectorScale(rhs, lhs);
+	}
+
+	template<typename V, Precision P>
+	inline WithPrecision<V, P> __vectorcall operator /(float lhs, const WithPrecision<V, P>& rhs)
+	{
+		return WithPrecision<V, P>::Op::Divide(XMVectorReplicate(lhs), rhs);
+	}
+
 	struct Quaternion;
 	struct QuaternionA
 	{
@@ -1086,6 +1282,12 @@ namespace CS
 
 		inline QuaternionA __vectorcall Normalize() const { return XMQuaternionNormalize(*this); }
 
+		// Counterparts of Normalize, Length, ReciprocalLength and Inverse at a given precision (see MathPrecision.h)
+		template<Precision P> inline QuaternionA __vectorcall Normalize() const { return Details::PreciseVector<4, P>::Normalize(*this); }
+		template<Precision P> inline float __vectorcall GetLength() const { return XMVectorGetX(Details::PreciseVector<4, P>::Length(*this)); }
+		template<Precision P> inline float __vectorcall GetReciprocalLength() const { return XMVectorGetX(Details::PreciseVector<4, P>::ReciprocalLength(*this)); }
+		template<Precision P> inline QuaternionA __vectorcall GetInverse() const { return Details::PreciseQuaternionInverse<P>(*this); }
+
 		PROPERTY_READONLY(QuaternionA, Conjugate);
 		inline QuaternionA __vectorcall GetConjugate() const { return XMQuaternionConjugate(*this); }
 
@@ -1127,8 +1329,8 @@ namespace CS
 		Quaternion() { }
 		Quaternion(float x, float y, float z, float w) : X(x), Y(y), Z(z), W(w) { }
 		explicit Quaternion(Float4 v) : X(v.X), Y(v.Y), Z(v.Z), W(v.W) { }
-		explicit Quaternion(const Float4A& v) : X(v.X), Y(v.Y), Z(v.Z), W(v.W) { }
-		Quaternion(const QuaternionA& q) : X(q.X), Y(q.Y), Z(q.Z), W(q.W) { }
+		explicit Quaternion(const Float4A& v) : X(v.GetX()), Y(v.GetY()), Z(v.GetZ()), W(v.GetW()) { }
+		Quaternion(const QuaternionA& q) : X(q.GetX()), Y(q.GetY()), Z(q.GetZ()), W(q.GetW()) { }
 
 		inline operator XMVECTOR() const { return XMVectorSet(X, Y, Z, W); }
 		inline Quaternion& __vectorcall operator=(const QuaternionA& rhs) { XMStoreFloat4((XMFLOAT4*)this, rhs); return *this; }
@@ -1171,6 +1373,12 @@ namespace CS
 
 		inline QuaternionA __vectorcall Normalize() const { return XMQuaternionNormalize(*this); }
 
+		// Counterparts of Normalize, Length, ReciprocalLength and Inverse at a given precision (see MathPrecision.h)
+		template<Precision P> inline QuaternionA __vectorcall Normalize() const { return Details::PreciseVector<4, P>::Normalize(*this); }
+		template<Precision P> inline float __vectorcall GetLength() const { return XMVectorGetX(Details::PreciseVector<4, P>::Length(*this)); }
+		template<Precision P> inline float __vectorcall GetReciprocalLength() const { return XMVectorGetX(Details::PreciseVector<4, P>::ReciprocalLength(*this)); }
+		template<Precision P> inline QuaternionA __vectorcall GetInverse() const { return Details::PreciseQuaternionInverse<P>(*this); }
+
 		PROPERTY_READONLY(QuaternionA, Conjugate);
 		inline QuaternionA __vectorcall GetConjugate() const { return XMQuaternionConjugate(*this); }
 
@@ -1359,7 +1567,7 @@ namespace CS
 		PROPERTY_READONLY(Float4x4A, Inverse);
 		inline Float4x4A __vectorcall GetInverse() const { return XMMatrixInverse(nullptr, *this); }
 
-		inline Float4x4A __vectorcall InverseWithHint(const Float4A& determinantSplat) { return XMMatrixInverse(&(XMVECTOR)determinantSplat, *this); }
+		inline Float4x4A __vectorcall InverseWithHint(const Float4A& determinantSplat) { XMVECTOR determinant = determinantSplat; return XMMatrixInverse(&determinant, *this); }
 
 		PROPERTY_READONLY(Float4x4A, Transpose);
 		inline Float4x4A __vectorcall GetTranspose() const { return XMMatrixTranspose(*this); }
@@ -1488,7 +1696,7 @@ namespace CS
 		PROPERTY_READONLY(Float4x4A, Inverse);
 		inline Float4x4A __vectorcall GetInverse() const { return XMMatrixInverse(nullptr, *this); }
 
-		inline Float4x4A __vectorcall InverseWithHint(const Float4A& determinantSplat) { return XMMatrixInverse(&(XMVECTOR)determinantSplat, *this); }
+		inline Float4x4A __vectorcall InverseWithHint(const Float4A& determinantSplat) { XMVECTOR determinant = determinantSplat; return XMMatrixInverse(&determinant, *this); }
 
 		PROPERTY_READONLY(Float4x4A, Transpose);
 		inline Float4x4A __vectorcall GetTranspose() const { return XMMatrixTranspose(*this); }
@@ -1623,7 +1831,7 @@ namespace CS
 		PROPERTY_READONLY(Float4x3A, Inverse);
 		inline Float4x3A __vectorcall GetInverse() const { return XMMatrixInverse(nullptr, *this); }
 
-		inline Float4x3A __vectorcall InverseWithHint(const Float4A& determinantSplat) { return XMMatrixInverse(&(XMVECTOR)determinantSplat, *this); }
+		inline Float4x3A __vectorcall InverseWithHint(const Float4A& determinantSplat) { XMVECTOR determinant = determinantSplat; return XMMatrixInverse(&determinant, *this); }
 
 		PROPERTY_READONLY(Float4x4A, Transpose);
 		inline Float4x4A __vectorcall GetTranspose() const { return XMMatrixTranspose(*this); }
@@ -1736,7 +1944,7 @@ namespace CS
 		PROPERTY_READONLY(Float4x3A, Inverse);
 		inline Float4x3A __vectorcall GetInverse() const { return XMMatrixInverse(nullptr, *this); }
 
-		inline Float4x3A __vectorcall InverseWithHint(const Float4A& determinantSplat) { return XMMatrixInverse(&(XMVECTOR)determinantSplat, *this); }
+		inline Float4x3A __vectorcall InverseWithHint(const Float4A& determinantSplat) { XMVECTOR determinant = determinantSplat; return XMMatrixInverse(&determinant, *this); }
 
 		PROPERTY_READONLY(Float4x4A, Transpose);
 		inline Float4x4A __vectorcall GetTranspose() const { return XMMatrixTranspose(*this); }
@@ -1880,6 +2088,197 @@ namespace CS
 	inline Float4x4A __vectorcall Float4x4A::MultiplyThenTranspose(const Float4x3A& m) const { return XMMatrixMultiplyTranspose(*this, m); }
 	inline Float4x4A __vectorcall Float4x4::MultiplyThenTranspose(const Float4x3A& m) const { return XMMatrixMultiplyTranspose(*this, m); }
 	inline Float4x3A __vectorcall Float4x3A::operator *(const Float4x3& rhs) const { return _xm * (XMMATRIX)rhs; }
+
+	// Structure-of-arrays storage for large sets of vectors.
+	// Each component lives in its own 64-byte aligned lane, padded to a multiple of LaneAlignment elements,
+	// so the batch kernels process 4, 8 or 16 vectors per instruction without a scalar tail.
+	// The contents of the padding are unspecified.
+	// Like Array<T>, streams are implicitly pass-by-reference.
+	struct Float3Stream
+	{
+		static const int LaneAlignment = 16;
+
+		Float3Stream() : _length(0), _stride(0), _ptr(nullptr) { }
+		Float3Stream(nullptr_t) : _length(0), _stride(0), _ptr(nullptr) { }
+		explicit Float3Stream(size_t length);
+		Float3Stream(const Float3* arr, size_t length);
+		Float3Stream(const Float3A* arr, size_t length);
+		explicit Float3Stream(const Array<Float3>& arr) : Float3Stream(arr.begin(), arr.size()) { }
+		explicit Float3Stream(const Array<Float3A>& arr) : Float3Stream(arr.begin(), arr.size()) { }
+
+		PROPERTY_READONLY(float*, X);
+		inline float* GetX() const { return _ptr; }
+
+		PROPERTY_READONLY(float*, Y);
+		inline float* GetY() const { return _ptr + _stride; }
+
+		PROPERTY_READONLY(float*, Z);
+		inline float* GetZ() const { return _ptr + _stride * 2; }
+
+		// Number of elements in each lane, including padding
+		PROPERTY_READONLY(size_t, Stride);
+		inline size_t GetStride() const { return _stride; }
+
+		inline size_t size() const { return _length; }
+		inline bool empty() const { return _length == 0; }
+		inline operator bool() const { return !!_ptr; }
+		inline bool operator !() const { return !_ptr; }
+
+		inline Float3A __vectorcall Get(size_t i) const { assert(i < _length); return Float3A(_ptr[i], _ptr[_stride + i], _ptr[_stride * 2 + i]); }
+		inline void __vectorcall Set(size_t i, const Float3A& v) { assert(i < _length); Float3 u = v; _ptr[i] = u.X; _ptr[_stride + i] = u.Y; _ptr[_stride * 2 + i] = u.Z; }
+
+		void CopyFrom(const Float3* src);
+		void CopyFrom(const Float3A* src);
+		void CopyTo(Float3* dst) const;
+		void CopyTo(Float3A* dst) const;
+		Array<Float3> ToArray() const;
+		Array<Float3A> ToArrayA() const;
+
+		// out may be this stream. out is reallocated if its size doesn't match.
+		void Transform(const Float4x3A& m, Float3Stream& out) const;
+		void TransformNormal(const Float4x3A& m, Float3Stream& out) const;
+		void TransformCoord(const Float4x4A& m, Float3Stream& out) const;
+
+		inline Float3Stream Transform(const Float4x3A& m) const { Float3Stream out; Transform(m, out); return out; }
+		inline Float3Stream TransformNormal(const Float4x3A& m) const { Float3Stream out; TransformNormal(m, out); return out; }
+		inline Float3Stream TransformCoord(const Float4x4A& m) const { Float3Stream out; TransformCoord(m, out); return out; }
+
+	private:
+		size_t _length;
+		size_t _stride;
+		float* _ptr;
+		std::shared_ptr<float> _mgr;
+	};
+
+	struct Float4Stream
+	{
+		static const int LaneAlignment = 16;
+
+		Float4Stream() : _length(0), _stride(0), _ptr(nullptr) { }
+		Float4Stream(nullptr_t) : _length(0), _stride(0), _ptr(nullptr) { }
+		explicit Float4Stream(size_t length);
+		Float4Stream(const Float4* arr, size_t length);
+		Float4Stream(const Float4A* arr, size_t length);
+		explicit Float4Stream(const Array<Float4>& arr) : Float4Stream(arr.begin(), arr.size()) { }
+		explicit Float4Stream(const Array<Float4A>& arr) : Float4Stream(arr.begin(), arr.size()) { }
+
+		PROPERTY_READONLY(float*, X);
+		inline float* GetX() const { return _ptr; }
+
+		PROPERTY_READONLY(float*, Y);
+		inline float* GetY() const { return _ptr + _stride; }
+
+		PROPERTY_READONLY(float*, Z);
+		inline float* GetZ() const { return _ptr + _stride * 2; }
+
+		PROPERTY_READONLY(float*, W);
+		inline float* GetW() const { return _ptr + _stride * 3; }
+
+		PROPERTY_READONLY(size_t, Stride);
+		inline size_t GetStride() const { return _stride; }
+
+		inline size_t size() const { return _length; }
+		inline bool empty() const { return _length == 0; }
+		inline operator bool() const { return !!_ptr; }
+		inline bool operator !() const { return !_ptr; }
+
+		inline Float4A __vectorcall Get(size_t i) const { assert(i < _length); return Float4A(_ptr[i], _ptr[_stride + i], _ptr[_stride * 2 + i], _ptr[_stride * 3 + i]); }
+		inline void __vectorcall Set(size_t i, const Float4A& v) { assert(i < _length); Float4 u = v; _ptr[i] = u.X; _ptr[_stride + i] = u.Y; _ptr[_stride * 2 + i] = u.Z; _ptr[_stride * 3 + i] = u.W; }
+
+		void CopyFrom(const Float4* src);
+		void CopyFrom(const Float4A* src);
+		void CopyTo(Float4* dst) const;
+		void CopyTo(Float4A* dst) const;
+		Array<Float4> ToArray() const;
+		Array<Float4A> ToArrayA() const;
+
+		// out may be this stream. out is reallocated if its size doesn't match.
+		void Transform(const Float4x4A& m, Float4Stream& out) const;
+
+		inline Float4Stream Transform(const Float4x4A& m) const { Float4Stream out; Transform(m, out); return out; }
+
+	private:
+		size_t _length;
+		size_t _stride;
+		float* _ptr;
+		std::shared_ptr<float> _mgr;
+	};
+
+	struct QuaternionStream
+	{
+		static const int LaneAlignment = 16;
+
+		QuaternionStream() : _length(0), _stride(0), _ptr(nullptr) { }
+		QuaternionStream(nullptr_t) : _length(0), _stride(0), _ptr(nullptr) { }
+		explicit QuaternionStream(size_t length);
+		QuaternionStream(const Quaternion* arr, size_t length);
+		QuaternionStream(const QuaternionA* arr, size_t length);
+		explicit QuaternionStream(const Array<Quaternion>& arr) : QuaternionStream(arr.begin(), arr.size()) { }
+		explicit QuaternionStream(const Array<QuaternionA>& arr) : QuaternionStream(arr.begin(), arr.size()) { }
+
+		PROPERTY_READONLY(float*, X);
+		inline float* GetX() const { return _ptr; }
+
+		PROPERTY_READONLY(float*, Y);
+		inline float* GetY() const { return _ptr + _stride; }
+
+		PROPERTY_READONLY(float*, Z);
+		inline float* GetZ() const { return _ptr + _stride * 2; }
+
+		PROPERTY_READONLY(float*, W);
+		inline float* GetW() const { return _ptr + _stride * 3; }
+
+		PROPERTY_READONLY(size_t, Stride);
+		inline size_t GetStride() const { return _stride; }
+
+		inline size_t size() const { return _length; }
+		inline bool empty() const { return _length == 0; }
+		inline operator bool() const { return !!_ptr; }
+		inline bool operator !() const { return !_ptr; }
+
+		inline QuaternionA __vectorcall Get(size_t i) const { assert(i < _length); return QuaternionA(_ptr[i], _ptr[_stride + i], _ptr[_stride * 2 + i], _ptr[_stride * 3 + i]); }
+		inline void __vectorcall Set(size_t i, const QuaternionA& q) { assert(i < _length); Quaternion u = q; _ptr[i] = u.X; _ptr[_stride + i] = u.Y; _ptr[_stride * 2 + i] = u.Z; _ptr[_stride * 3 + i] = u.W; }
+
+		void CopyFrom(const Quaternion* src);
+		void CopyFrom(const QuaternionA* src);
+		void CopyTo(Quaternion* dst) const;
+		void CopyTo(QuaternionA* dst) const;
+		Array<Quaternion> ToArray() const;
+		Array<QuaternionA> ToArrayA() const;
+
+		// Element-wise counterparts of the QuaternionA operations. Binary operations throw ArgumentException
+		// if the stream sizes differ. out may be one of the inputs. out is reallocated if its size doesn't match.
+		void Normalize(QuaternionStream& out) const;
+		void Inverse(QuaternionStream& out) const;
+
+		// Normalize at precision P (see MathPrecision.h). The overload above uses Precision::Exact.
+		template<Precision P> void Normalize(QuaternionStream& out) const;
+
+		// out[i] = this[i] * rhs[i], as QuaternionA::operator*
+		void Multiply(const QuaternionStream& rhs, QuaternionStream& out) const;
+
+		// Rotates v[i] by this[i], as Float3A::Rotate. The quaternions must be normalized.
+		void RotateVectors(const Float3Stream& v, Float3Stream& out) const;
+
+		// Both interpolate along the shorter arc, negating q2[i] where dot(q1[i], q2[i]) < 0.
+		// Slerp matches QuaternionA::Slerp. Nlerp normalizes the linear blend; it is cheaper but not constant speed.
+		static void Slerp(const QuaternionStream& q1, const QuaternionStream& q2, float u, QuaternionStream& out);
+		static void Nlerp(const QuaternionStream& q1, const QuaternionStream& q2, float u, QuaternionStream& out);
+
+		inline QuaternionStream Normalize() const { QuaternionStream out; Normalize(out); return out; }
+		template<Precision P> inline QuaternionStream Normalize() const { QuaternionStream out; Normalize<P>(out); return out; }
+		inline QuaternionStream Inverse() const { QuaternionStream out; Inverse(out); return out; }
+		inline QuaternionStream Multiply(const QuaternionStream& rhs) const { QuaternionStream out; Multiply(rhs, out); return out; }
+		inline Float3Stream RotateVectors(const Float3Stream& v) const { Float3Stream out; RotateVectors(v, out); return out; }
+		static inline QuaternionStream Slerp(const QuaternionStream& q1, const QuaternionStream& q2, float u) { QuaternionStream out; Slerp(q1, q2, u, out); return out; }
+		static inline QuaternionStream Nlerp(const QuaternionStream& q1, const QuaternionStream& q2, float u) { QuaternionStream out; Nlerp(q1, q2, u, out); return out; }
+
+	private:
+		size_t _length;
+		size_t _stride;
+		float* _ptr;
+		std::shared_ptr<float> _mgr;
+	};
 }
 
 DECLARE_HASHABLE(::CS::Float2)
@@ -1900,6 +2299,9 @@ DECLARE_HASHABLE(::CS::Bool4)
 DECLARE_HASHABLE(::CS::Bool2A)
 DECLARE_HASHABLE(::CS::Bool3A)
 DECLARE_HASHABLE(::CS::Bool4A)
+DECLARE_HASHABLE(::CS::Half2)
+DECLARE_HASHABLE(::CS::Half3)
+DECLARE_HASHABLE(::CS::Half4)
 DECLARE_HASHABLE(::CS::Quaternion)
 DECLARE_HASHABLE(::CS::QuaternionA)
 DECLARE_HASHABLE(::CS::Float3x3)
@@ -1907,36 +2309,3 @@ DECLARE_HASHABLE(::CS::Float4x3)
 DECLARE_HASHABLE(::CS::Float4x4)
 DECLARE_HASHABLE(::CS::Float4x3A)
 DECLARE_HASHABLE(::CS::Float4x4A)
-
-IS_VALUETYPE(::CS::Float2, "BAF5E9F7-D626-4B94-9436-52A1CAB75E32");
-IS_VALUETYPE(::CS::Float3, "94014C8C-AEC8-492D-BBDF-64BF0CADEE36");
-IS_VALUETYPE(::CS::Float4, "F6701F12-A5BF-4809-A1B1-33EF405C2A04");
-
-IS_VALUETYPE(::CS::Float2A, "038E604C-626C-4CD3-AD30-E4FB33EB8795");
-IS_VALUETYPE(::CS::Float3A, "1F857758-4897-4BE0-A9F4-D0F75CC95CF9");
-IS_VALUETYPE(::CS::Float4A, "8B6DB859-ACB4-4F7A-94CB-11C0B6DF7CC2");
-
-IS_VALUETYPE(::CS::Int2, "8C379C01-31F8-410B-BBDE-EF29CF010FA2");
-IS_VALUETYPE(::CS::Int3, "A89E1D19-EC3C-45FE-876D-1AF67C5E7593");
-IS_VALUETYPE(::CS::Int4, "6D822D82-2AAF-4D45-9260-8568C41439E0");
-
-IS_VALUETYPE(::CS::Int2A, "74649EE4-FAE8-4285-AE20-730532B6AA79");
-IS_VALUETYPE(::CS::Int3A, "52F8ADEF-CF2C-4840-974B-9DD7D9AC63ED");
-IS_VALUETYPE(::CS::Int4A, "62840D4B-87D3-408B-B237-F4003AD7EEA6");
-
-IS_VALUETYPE(::CS::Bool2, "E82177F0-264B-484A-BC7F-8CA2C158D0F7");
-IS_VALUETYPE(::CS::Bool3, "E9296CD5-2634-45A9-B124-6B2657419D91");
-IS_VALUETYPE(::CS::Bool4, "F516D8CF-696C-4C4D-BCEC-026E0B73AC8A");
-
-IS_VALUETYPE(::CS::Bool2A, "8412C092-5178-498E-AA30-18A2A2CF0173");
-IS_VALUETYPE(::CS::Bool3A, "4A09E825-BBC0-43F9-ACC6-47A9D05D563E");
-IS_VALUETYPE(::CS::Bool4A, "3CBD364E-0E00-4063-B410-0A8AF48B2ACC");
-
-IS_VALUETYPE(::CS::QuaternionA, "1FB75604-3293-4168-A0FA-26468E7DF2B7");
-IS_VALUETYPE(::CS::Quaternion, "FEBDD969-AC96-4BF2-B8ED-106934A12140");
-
-IS_VALUETYPE(::CS::Float4x4A, "18D58019-8EF6-4243-A12E-C1EFFBC82F80");
-IS_VALUETYPE(::CS::Float4x3A, "490C1D72-8235-4415-8C9C-27EA73EBB606");
-IS_VALUETYPE(::CS::Float4x4, "AC3C94A7-9698-4A1E-8F67-60CA5E56EFCC");
-IS_VALUETYPE(::CS::Float4x3, "29C390B9-D5DB-468C-9A33-1C54051B49E2");
-IS_VALUETYPE(::CS::Float3x3, "C9576106-C9CB-49EB-BA7C-F3D1B0F254C0");
@@ -0,0 +1,309 @@
+// The batch kernels of MathTypes.cpp, defined for each lane width by MathKernels.h
+
+	// Row-vector convention, matching XMVector3Transform: v' = x * r0 + y * r1 + z * r2 + w * r3
+	struct Transform3Kernel
+	{
+		template<typename L>
+		static void Run(
+			const float* x, const float* y, const float* z,
+			float* ox, float* oy, float* oz,
+			size_t count, const XMFLOAT4X4& m, bool translate)
+		{
+			auto m11 = L::Splat(m._11), m12 = L::Splat(m._12), m13 = L::Splat(m._13);
+			auto m21 = L::Splat(m._21), m22 = L::Splat(m._22), m23 = L::Splat(m._23);
+			auto m31 = L::Splat(m._31), m32 = L::Splat(m._32), m33 = L::Splat(m._33);
+			auto m41 = L::Splat(translate ? m._41 : 0), m42 = L::Splat(translate ? m._42 : 0), m43 = L::Splat(translate ? m._43 : 0);
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				auto vx = L::Load(x + i);
+				auto vy = L::Load(y + i);
+				auto vz = L::Load(z + i);
+
+				L::Store(ox + i, L::MulAdd(vx, m11, L::MulAdd(vy, m21, L::MulAdd(vz, m31, m41))));
+				L::Store(oy + i, L::MulAdd(vx, m12, L::MulAdd(vy, m22, L::MulAdd(vz, m32, m42))));
+				L::Store(oz + i, L::MulAdd(vx, m13, L::MulAdd(vy, m23, L::MulAdd(vz, m33, m43))));
+			}
+		}
+	};
+
+	// Matches XMVector3TransformCoord: transform with w = 1, then divide through by the resulting w
+	struct TransformCoord3Kernel
+	{
+		template<typename L>
+		static void Run(
+			const float* x, const float* y, const float* z,
+			float* ox, float* oy, float* oz,
+			size_t count, const XMFLOAT4X4& m)
+		{
+			auto m11 = L::Splat(m._11), m12 = L::Splat(m._12), m13 = L::Splat(m._13), m14 = L::Splat(m._14);
+			auto m21 = L::Splat(m._21), m22 = L::Splat(m._22), m23 = L::Splat(m._23), m24 = L::Splat(m._24);
+			auto m31 = L::Splat(m._31), m32 = L::Splat(m._32), m33 = L::Splat(m._33), m34 = L::Splat(m._34);
+			auto m41 = L::Splat(m._41), m42 = L::Splat(m._42), m43 = L::Splat(m._43), m44 = L::Splat(m._44);
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				auto vx = L::Load(x + i);
+				auto vy = L::Load(y + i);
+				auto vz = L::Load(z + i);
+
+				auto rw = L::Reciprocal(L::MulAdd(vx, m14, L::MulAdd(vy, m24, L::MulAdd(vz, m34, m44))));
+
+				L::Store(ox + i, L::Mul(L::MulAdd(vx, m11, L::MulAdd(vy, m21, L::MulAdd(vz, m31, m41))), rw));
+				L::Store(oy + i, L::Mul(L::MulAdd(vx, m12, L::MulAdd(vy, m22, L::MulAdd(vz, m32, m42))), rw));
+				L::Store(oz + i, L::Mul(L::MulAdd(vx, m13, L::MulAdd(vy, m23, L::MulAdd(vz, m33, m43))), rw));
+			}
+		}
+	};
+
+	struct Transform4Kernel
+	{
+		template<typename L>
+		static void Run(
+			const float* x, const float* y, const float* z, const float* w,
+			float* ox, float* oy, float* oz, float* ow,
+			size_t count, const XMFLOAT4X4& m)
+		{
+			auto m11 = L::Splat(m._11), m12 = L::Splat(m._12), m13 = L::Splat(m._13), m14 = L::Splat(m._14);
+			auto m21 = L::Splat(m._21), m22 = L::Splat(m._22), m23 = L::Splat(m._23), m24 = L::Splat(m._24);
+			auto m31 = L::Splat(m._31), m32 = L::Splat(m._32), m33 = L::Splat(m._33), m34 = L::Splat(m._34);
+			auto m41 = L::Splat(m._41), m42 = L::Splat(m._42), m43 = L::Splat(m._43), m44 = L::Splat(m._44);
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				auto vx = L::Load(x + i);
+				auto vy = L::Load(y + i);
+				auto vz = L::Load(z + i);
+				auto vw = L::Load(w + i);
+
+				L::Store(ox + i, L::MulAdd(vx, m11, L::MulAdd(vy, m21, L::MulAdd(vz, m31, L::Mul(vw, m41)))));
+				L::Store(oy + i, L::MulAdd(vx, m12, L::MulAdd(vy, m22, L::MulAdd(vz, m32, L::Mul(vw, m42)))));
+				L::Store(oz + i, L::MulAdd(vx, m13, L::MulAdd(vy, m23, L::MulAdd(vz, m33, L::Mul(vw, m43)))));
+				L::Store(ow + i, L::MulAdd(vx, m14, L::MulAdd(vy, m24, L::MulAdd(vz, m34, L::Mul(vw, m44)))));
+			}
+		}
+	};
+
+	// Quaternion kernels take each stream as its X lane plus the stride between lanes.
+
+	template<Precision P>
+	struct QuaternionNormalizeKernel
+	{
+		template<typename L>
+		static void Run(const float* q, size_t qs, float* o, size_t os, size_t count)
+		{
+			auto zero = L::Zero();
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				auto x = L::Load(q + i), y = L::Load(q + qs + i), z = L::Load(q + qs * 2 + i), w = L::Load(q + qs * 3 + i);
+
+				auto lengthSq = L::MulAdd(x, x, L::MulAdd(y, y, L::MulAdd(z, z, L::Mul(w, w))));
+				auto nonZero = L::Greater(lengthSq, zero);
+
+				if (P == Precision::Exact)
+				{
+					auto length = L::Sqrt(lengthSq);
+					x = L::Select(zero, L::Div(x, length), nonZero);
+					y = L::Select(zero, L::Div(y, length), nonZero);
+					z = L::Select(zero, L::Div(z, length), nonZero);
+					w = L::Select(zero, L::Div(w, length), nonZero);
+				}
+				else
+				{
+					auto scale = L::Select(zero, Details::Precise<L, P>::ReciprocalSqrt(lengthSq), nonZero);
+					x = L::Mul(x, scale);
+					y = L::Mul(y, scale);
+					z = L::Mul(z, scale);
+					w = L::Mul(w, scale);
+				}
+
+				L::Store(o + i, x);
+				L::Store(o + os + i, y);
+				L::Store(o + os * 2 + i, z);
+				L::Store(o + os * 3 + i, w);
+			}
+		}
+	};
+
+	// Matches XMQuaternionInverse: conjugate / length^2, or zero if length^2 <= epsilon
+	struct QuaternionInverseKernel
+	{
+		template<typename L>
+		static void Run(const float* q, size_t qs, float* o, size_t os, size_t count)
+		{
+			auto zero = L::Zero();
+			auto epsilon = L::Splat(g_XMEpsilon.f[0]);
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				auto x = L::Load(q + i), y = L::Load(q + qs + i), z = L::Load(q + qs * 2 + i), w = L::Load(q + qs * 3 + i);
+
+				auto lengthSq = L::MulAdd(x, x, L::MulAdd(y, y, L::MulAdd(z, z, L::Mul(w, w))));
+				auto valid = L::Greater(lengthSq, epsilon);
+				auto scale = L::Select(zero, L::Reciprocal(lengthSq), valid);
+
+				L::Store(o + i, L::Negate(L::Mul(x, scale)));
+				L::Store(o + os + i, L::Negate(L::Mul(y, scale)));
+				L::Store(o + os * 2 + i, L::Negate(L::Mul(z, scale)));
+				L::Store(o + os * 3 + i, L::Mul(w, scale));
+			}
+		}
+	};
+
+	// Matches XMQuaternionMultiply(a, b), i.e. the rotation a followed by b
+	struct QuaternionMultiplyKernel
+	{
+		template<typename L>
+		static void Run(const float* a, size_t as, const float* b, size_t bs, float* o, size_t os, size_t count)
+		{
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				auto ax = L::Load(a + i), ay = L::Load(a + as + i), az = L::Load(a + as * 2 + i), aw = L::Load(a + as * 3 + i);
+				auto bx = L::Load(b + i), by = L::Load(b + bs + i), bz = L::Load(b + bs * 2 + i), bw = L::Load(b + bs * 3 + i);
+
+				auto x = L::NegMulAdd(bz, ay, L::MulAdd(by, az, L::MulAdd(bx, aw, L::Mul(bw, ax))));
+				auto y = L::MulAdd(bz, ax, L::MulAdd(by, aw, L::NegMulAdd(bx, az, L::Mul(bw, ay))));
+				auto z = L::MulAdd(bz, aw, L::NegMulAdd(by, ax, L::MulAdd(bx, ay, L::Mul(bw, az))));
+				auto w = L::NegMulAdd(bz, az, L::NegMulAdd(by, ay, L::NegMulAdd(bx, ax, L::Mul(bw, aw))));
+
+				L::Store(o + i, x);
+				L::Store(o + os + i, y);
+				L::Store(o + os * 2 + i, z);
+				L::Store(o + os * 3 + i, w);
+			}
+		}
+	};
+
+	// v' = v + w * t + q.xyz x t, where t = 2 * (q.xyz x v). Equal to q * v * q^-1 for unit q.
+	struct QuaternionRotateKernel
+	{
+		template<typename L>
+		static void Run(const float* q, size_t qs, const float* v, size_t vs, float* o, size_t os, size_t count)
+		{
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				auto qx = L::Load(q + i), qy = L::Load(q + qs + i), qz = L::Load(q + qs * 2 + i), qw = L::Load(q + qs * 3 + i);
+				auto vx = L::Load(v + i), vy = L::Load(v + vs + i), vz = L::Load(v + vs * 2 + i);
+
+				auto tx = L::NegMulAdd(qz, vy, L::Mul(qy, vz));
+				auto ty = L::NegMulAdd(qx, vz, L::Mul(qz, vx));
+				auto tz = L::NegMulAdd(qy, vx, L::Mul(qx, vy));
+				tx = L::Add(tx, tx);
+				ty = L::Add(ty, ty);
+				tz = L::Add(tz, tz);
+
+				L::Store(o + i, L::Add(L::MulAdd(qw, tx, vx), L::NegMulAdd(qz, ty, L::Mul(qy, tz))));
+				L::Store(o + os + i, L::Add(L::MulAdd(qw, ty, vy), L::NegMulAdd(qx, tz, L::Mul(qz, tx))));
+				L::Store(o + os * 2 + i, L::Add(L::MulAdd(qw, tz, vz), L::NegMulAdd(qy, tx, L::Mul(qx, ty))));
+			}
+		}
+	};
+
+	// Follows XMQuaternionSlerpV: flip q2 onto q1's hemisphere, then weight by sin((1 - u) * omega) and
+	// sin(u * omega) over sin(omega), falling back to a linear blend when the two are nearly parallel.
+	// When nlerp is set the blend is always linear and the result is normalized.
+	struct QuaternionBlendKernel
+	{
+		template<typename L>
+		static void Run(const float* a, size_t as, const float* b, size_t bs, float* o, size_t os, size_t count, float u, bool nlerp)
+		{
+			auto zero = L::Zero();
+			auto one = L::Splat(1);
+			auto negOne = L::Splat(-1);
+			auto oneMinusEpsilon = L::Splat(1.0f - 0.00001f);
+			auto vu = L::Splat(u);
+			auto vu0 = L::Splat(1 - u);
+
+			for (size_t i = 0; i < count; i += L::Width)
+			{
+				auto ax = L::Load(a + i), ay = L::Load(a + as + i), az = L::Load(a + as * 2 + i), aw = L::Load(a + as * 3 + i);
+				auto bx = L::Load(b + i), by = L::Load(b + bs + i), bz = L::Load(b + bs * 2 + i), bw = L::Load(b + bs * 3 + i);
+
+				auto cosOmega = L::MulAdd(ax, bx, L::MulAdd(ay, by, L::MulAdd(az, bz, L::Mul(aw, bw))));
+				auto sign = L::Select(one, negOne, L::Less(cosOmega, zero));
+				cosOmega = L::Mul(cosOmega, sign);
+
+				auto s0 = vu0;
+				auto s1 = vu;
+
+				if (!nlerp)
+				{
+					auto useSlerp = L::Less(cosOmega, oneMinusEpsilon);
+					auto sinOmega = L::Sqrt(L::NegMulAdd(cosOmega, cosOmega, one));
+					auto omega = Details::Transcendental<L>::ACos(cosOmega);
+					auto invSinOmega = L::Reciprocal(sinOmega);
+
+					s0 = L::Select(vu0, L::Mul(Details::Transcendental<L>::Sin(L::Mul(vu0, omega)), invSinOmega), useSlerp);
+					s1 = L::Select(vu, L::Mul(Details::Transcendental<L>::Sin(L::Mul(vu, omega)), invSinOmega), useSlerp);
+				}
+
+				s1 = L::Mul(s1, sign);
+
+				auto x = L::MulAdd(ax, s0, L::Mul(bx, s1));
+				auto y = L::MulAdd(ay, s0, L::Mul(by, s1));
+				auto z = L::MulAdd(az, s0, L::Mul(bz, s1));
+				auto w = L::MulAdd(aw, s0, L::Mul(bw, s1));
+
+				if (nlerp)
+				{
+					auto length = L::Sqrt(L::MulAdd(x, x, L::MulAdd(y, y, L::MulAdd(z, z, L::Mul(w, w)))));
+					auto nonZero = L::Greater(length, zero);
+					auto scale = L::Select(zero, L::Reciprocal(length), nonZero);
+					x = L::Mul(x, scale);
+					y = L::Mul(y, scale);
+					z = L::Mul(z, scale);
+					w = L::Mul(w, scale);
+				}
+
+				L::Store(o + i, x);
+				L::Store(o + os + i, y);
+				L::Store(o + os * 2 + i, z);
+				L::Store(o + os * 3 + i, w);
+			}
+		}
+	};
+
+	// Half <-> float over flat arrays of scalars. Every HalfN and FloatN array is N scalars per element in the same
+	// order, so the element type doesn't matter here. The tail goes through a zero-padded register.
+	struct HalfToFloatKernel
+	{
+		template<typename L>
+		static void Run(const uint16_t* src, float* dst, size_t count)
+		{
+			size_t blocks = count - count % L::Width;
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+				L::StoreUnaligned(dst + i, L::LoadFloat16(src + i));
+
+			if (size_t rest = count - blocks)
+			{
+				uint16_t t[L::Width] = { };
+				float r[L::Width];
+				memcpy(t, src + blocks, rest * sizeof(uint16_t));
+				L::StoreUnaligned(r, L::LoadFloat16(t));
+				memcpy(dst + blocks, r, rest * sizeof(float));
+			}
+		}
+	};
+
+	struct FloatToHalfKernel
+	{
+		template<typename L>
+		static void Run(const float* src, uint16_t* dst, size_t count)
+		{
+			size_t blocks = count - count % L::Width;
+
+			for (size_t i = 0; i < blocks; i += L::Width)
+				L::StoreFloat16(dst + i, L::LoadUnaligned(src + i));
+
+			if (size_t rest = count - blocks)
+			{
+				float t[L::Width] = { };
+				uint16_t r[L::Width];
+				memcpy(t, src + blocks, rest * sizeof(float));
+				L::StoreFloat16(r, L::LoadUnaligned(t));
+				memcpy(dst + blocks, r, rest * sizeof(uint16_t));
+			}
+		}
+	};
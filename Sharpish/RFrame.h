@@ -62,13 +62,13 @@ namespace CS
         PROPERTY(float, NormSq);
         inline float GetNormSq() const
         {
-            return Position.LengthSquared * (1 + Float3(Rotation.X, Rotation.Y, Rotation.Z).LengthSquared);
+            return Position.GetLengthSquared() * (1 + Float3(Rotation.X, Rotation.Y, Rotation.Z).GetLengthSquared());
         }
 
         PROPERTY(float, Norm);
         inline float GetNorm() const
         {
-            return sqrtf(NormSq);
+            return sqrtf(GetNormSq());
         }
     };
 
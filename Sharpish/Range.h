@@ -20,5 +20,4 @@ namespace CS
 	};
 }
 
-IS_VALUETYPE(::CS::Range, "34EB500D-A05B-4812-8DBE-56635CFAF264");
 DECLARE_HASHABLE(::CS::Range)
@@ -80,11 +80,10 @@ namespace CS
 	private:
 		template<int Power> struct CompileTimePow 
 		{ static const int Of10 = 10 * CompileTimePow<Power - 1>::Of10; };
-
-		template<> struct CompileTimePow<0>
-		{ static const int Of10 = 1; };
 	};
+
+	template<> struct Rational::CompileTimePow<0>
+	{ static const int Of10 = 1; };
 }
 
-IS_VALUETYPE(::CS::Rational, "60B9DC9A-BBEE-469B-8027-F7EE76B129C4");
 DECLARE_HASHABLE(::CS::Rational);
@@ -9,7 +9,7 @@ namespace CS
 		Rect() : X(0), Y(0), Width(0), Height(0) { }
 		Rect(float x, float y, float width, float height) : X(x), Y(y), Width(width), Height(height) { }
 		Rect(const XMFLOAT4& copy) { *(XMFLOAT4*)this = copy; }
-		Rect(const Range& xrange, const Range& yrange) : X(xrange.Minimum), Y(yrange.Minimum), Width(xrange.Span), Height(yrange.Span) { }
+		Rect(const Range& xrange, const Range& yrange) : X(xrange.Minimum), Y(yrange.Minimum), Width(xrange.GetSpan()), Height(yrange.GetSpan()) { }
 			
 		PROPERTY_READONLY(float, Left);
 		float GetLeft() const { return X; }
@@ -32,5 +32,4 @@ namespace CS
 	};
 }
 
-IS_VALUETYPE(::CS::Rect, "33FC5FE3-47E3-41D9-8367-B1A1A09C9D08");
 DECLARE_HASHABLE(::CS::Rect)
@@ -72,73 +72,17 @@
 #define NOMINMAX
 #endif
 
+#if defined(_WIN32)
 #include <Windows.h>
-#include <DirectXMath.h>
 #include <dxgitype.h>
 #include <rpc.h>
-#include <string>
-#include <vector>
-
-namespace CS
-{
-    //using namespace std;
-    using namespace DirectX;
-#if !defined(_MSVC_LANG) || _MSVC_LANG < 201703L
-    typedef unsigned char byte;
-#else
-    typedef unsigned char byte;
-    //using byte = std::byte;
 #endif
-    using string = std::string;
-}
 
-#if !defined(MIN)
-#define MIN(x,y) (((x) < (y)) ? (x) : (y))
-#endif
-
-#if !defined(MAX)
-#define MAX(x,y) (((x) > (y)) ? (x) : (y))
-#endif
+#include "SharpishCore.h"
 
-// passes a macro argument containing commas as a single argument. Useful for using template types when passing types to a macro, like Dictionary<string,string>. 
-#define AsIs(...) __VA_ARGS__
-#define ASSTRING(...) #__VA_ARGS__
-#define ASWSTRING(...) L#__VA_ARGS__
-#define TOSTRING(...) ASSTRING(__VA_ARGS__)
-#define TOWSTRING(...) ASWSTRING(__VA_ARGS__)
-
-#define PROPERTY(type, prop) __declspec ( property ( put = Set##prop, get = Get##prop ) ) type prop
-#define PROPERTY_READONLY(type, prop) __declspec(property(get=Get##prop)) type prop
-#define PROPERTY_INDEXABLE(type, prop) __declspec ( property ( put = Set##prop, get = Get##prop ) ) type prop[]
-#define PROPERTY_INDEXABLE_READONLY(type, prop) __declspec(property(get=Get##prop)) type prop[]
-
-template<class T, size_t Size>
-__forceinline size_t ArrayLength(const T(&)[Size]) { return Size; }
-
-template<class T> T* malloc_array(size_t arrLength) { return (T*)malloc(sizeof(T) * arrLength); }
-template<class T> T* _aligned_malloc_array(size_t arrLength, size_t align) { return (T*)_aligned_malloc(sizeof(T) * arrLength, align); }
-template<class T> T* _aligned_malloc_array(size_t arrLength) { return (T*)_aligned_malloc(sizeof(T) * arrLength, __alignof(T)); }
-template<class T> void zero(T&& item) { memset((void*)&item, 0, sizeof(T)); }
-template<class T, int TSize> void zero(T itemarray[TSize]) { memset(itemarray, 0, sizeof(T) * TSize); }
-template<class T> void zero(T* itemarray, int elements) { memset(itemarray, 0, sizeof(T) * elements); }
-
-template<class T> void repeat(T* itemarray, int elements, const T& value)
-{
-    for (int i = 0; i < elements; i++)
-        itemarray[i] = value;
-}
-template<class T, int TSize> void repeat(T itemarray[TSize], const T& value, int startIndex = 0, int count = -1)
-{
-    if (count == -1) count = TSize - startIndex;
-    assert(startIndex + count <= TSize);
-
-    repeat(itemarray + startIndex, count, value);
-}
-
-#include "FlagsOps.h"
-#include "MacroRepeater.h"
-#include "Hashing.h"
-#include "CSException.h"
+// The object model is built on COM and needs Windows. Elsewhere Sharpish is the math layer alone.
+#if defined(_WIN32)
+#define SHARPISH_OBJECT_MODEL
 
 #include "BasicInterfaces.h"
 #include "ObjectModelTraits.h"
@@ -173,20 +117,16 @@ T Def() { static T _value; return _value; }
 
 #include "CriticalSection.h"
 #include "ThreadSignal.h"
-#include "Array.h"
-#include "MathTypes.h"
-#include "Range.h"
-#include "Rational.h"
-#include "Rect.h"
-#include "Size.h"
-#include "BoundingBox.h"
-#include "BoundingSphere.h"
-#include "RFrame.h"
+#endif
+
+#include "SharpishMath.h"
+
+#if defined(_WIN32)
+#include "MathTypeIDs.h"
 
 // Helpers
 #include "FileHelper.h"
 #include "StringHelper.h"
-#include "MathHelper.h"
 #include "ToString.h"
 
 ////////////////////////
@@ -204,3 +144,5 @@ typename const T* runtime_cast(const U* ptr) { return ptr ? reinterpret_cast<con
 
 template<typename T, typename U>
 typename T* runtime_cast(const CS::com_ptr<U>& ptr) { return ptr ? ptr.CastTo<T>() : (T*)nullptr; }
+
+#endif
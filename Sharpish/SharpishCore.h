@@ -0,0 +1,105 @@
+#pragma once
+
+// The core of Sharpish that the object model and the math layer share: the common macros, HRESULT, the
+// exceptions and hashing. It includes no Windows or COM headers.
+//
+// Compilers without __declspec(property) (anything but MSVC and Clang with -fms-extensions) get no property
+// syntax: v.X, m._41 and v.Length are spelled v.GetX(), m.Get_41() and v.GetLength() there, and setters
+// likewise. The library itself only uses the accessors, so it builds either way.
+
+#include "MathBackend.h"
+#include <DirectXMath.h>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// HRESULT and the codes the exceptions carry. winerror.h only defines the codes; HRESULT comes from winnt.h,
+// which this header avoids, and the typedef matches it.
+#if defined(_WIN32)
+typedef long HRESULT;
+#include <winerror.h>
+#else
+typedef int32_t HRESULT;
+#define S_OK ((HRESULT)0)
+#define E_NOTIMPL ((HRESULT)0x80004001)
+#define E_NOINTERFACE ((HRESULT)0x80004002)
+#define E_POINTER ((HRESULT)0x80004003)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_ACCESSDENIED ((HRESULT)0x80070005)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000E)
+#define E_INVALIDARG ((HRESULT)0x80070057)
+#endif
+
+namespace CS
+{
+    //using namespace std;
+    using namespace DirectX;
+#if !defined(_MSVC_LANG) || _MSVC_LANG < 201703L
+    typedef unsigned char byte;
+#else
+    typedef unsigned char byte;
+    //using byte = std::byte;
+#endif
+    using string = std::string;
+}
+
+#if !defined(MIN)
+#define MIN(x,y) (((x) < (y)) ? (x) : (y))
+#endif
+
+#if !defined(MAX)
+#define MAX(x,y) (((x) > (y)) ? (x) : (y))
+#endif
+
+// passes a macro argument containing commas as a single argument. Useful for using template types when passing types to a macro, like Dictionary<string,string>.
+#define AsIs(...) __VA_ARGS__
+#define ASSTRING(...) #__VA_ARGS__
+#define ASWSTRING(...) L#__VA_ARGS__
+#define TOSTRING(...) ASSTRING(__VA_ARGS__)
+#define TOWSTRING(...) ASWSTRING(__VA_ARGS__)
+
+#if defined(_MSC_VER) || defined(_MSC_EXTENSIONS)
+#define SHARPISH_PROPERTIES
+#endif
+
+#if defined(SHARPISH_PROPERTIES)
+#define PROPERTY(type, prop) __declspec ( property ( put = Set##prop, get = Get##prop ) ) type prop
+#define PROPERTY_READONLY(type, prop) __declspec(property(get=Get##prop)) type prop
+#define PROPERTY_INDEXABLE(type, prop) __declspec ( property ( put = Set##prop, get = Get##prop ) ) type prop[]
+#define PROPERTY_INDEXABLE_READONLY(type, prop) __declspec(property(get=Get##prop)) type prop[]
+#else
+#define PROPERTY(type, prop) static_assert(true, "")
+#define PROPERTY_READONLY(type, prop) static_assert(true, "")
+#define PROPERTY_INDEXABLE(type, prop) static_assert(true, "")
+#define PROPERTY_INDEXABLE_READONLY(type, prop) static_assert(true, "")
+#endif
+
+template<class T, size_t Size>
+__forceinline size_t ArrayLength(const T(&)[Size]) { return Size; }
+
+template<class T> T* malloc_array(size_t arrLength) { return (T*)malloc(sizeof(T) * arrLength); }
+template<class T> T* _aligned_malloc_array(size_t arrLength, size_t align) { return (T*)_aligned_malloc(sizeof(T) * arrLength, align); }
+template<class T> T* _aligned_malloc_array(size_t arrLength) { return (T*)_aligned_malloc(sizeof(T) * arrLength, __alignof(T)); }
+template<class T> void zero(T&& item) { memset((void*)&item, 0, sizeof(T)); }
+template<class T, int TSize> void zero(T itemarray[TSize]) { memset(itemarray, 0, sizeof(T) * TSize); }
+template<class T> void zero(T* itemarray, size_t elements) { memset(itemarray, 0, sizeof(T) * elements); }
+
+template<class T> void repeat(T* itemarray, int elements, const T& value)
+{
+    for (int i = 0; i < elements; i++)
+        itemarray[i] = value;
+}
+template<class T, int TSize> void repeat(T itemarray[TSize], const T& value, int startIndex = 0, int count = -1)
+{
+    if (count == -1) count = TSize - startIndex;
+    assert(startIndex + count <= TSize);
+
+    repeat(itemarray + startIndex, count, value);
+}
+
+#include "FlagsOps.h"
+#include "MacroRepeater.h"
+#include "Hashing.h"
+#include "CSException.h"
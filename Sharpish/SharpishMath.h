@@ -0,0 +1,32 @@
+#pragma once
+
+// The math layer of Sharpish on its own: the math types, bounding volumes, spatial indices and the batch
+// kernels, with Array<T> for their inputs and outputs. It includes no Windows or COM headers, so it builds
+// wherever DirectXMath does, with the backend chosen in MathBackend.h. Sharpish.h includes this header after
+// the object model, which needs Windows; without the object model Array<T> stores its elements as they are.
+
+#include "SharpishCore.h"
+#include "Array.h"
+
+#include "MathTranscendental.h"
+#include "MathPrecision.h"
+#include "MathTypes.h"
+#include "MathExpression.h"
+#include "MathEncoding.h"
+#include "Range.h"
+#include "Rational.h"
+#include "Rect.h"
+#include "Size.h"
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+#include "FrustumCuller.h"
+#include "Bvh.h"
+#include "DynamicAabbTree.h"
+#include "SpatialHashGrid.h"
+#include "LooseOctree.h"
+#include "KdTree.h"
+#include "SweepAndPrune.h"
+#include "RFrame.h"
+#include "TransformHierarchy.h"
+#include "Skinning.h"
+#include "MathHelper.h"
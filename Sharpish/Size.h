@@ -33,5 +33,3 @@ namespace CS
 
 DECLARE_HASHABLE(::CS::Size);
 DECLARE_HASHABLE(::CS::Size3D);
-IS_VALUETYPE(::CS::Size, "BC8D3CDA-606B-4D75-9B12-922C74D78B91");
-IS_VALUETYPE(::CS::Size3D, "680674FA-DE60-479D-9454-F9D28E855291");
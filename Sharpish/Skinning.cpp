@@ -0,0 +1,198 @@
+#include "Sharpish.h"
+#include "Skinning.h"
+#include "MathDispatch.h"
+#include "MathParallel.h"
+
+// ::PUBLICLIB::
+
+using namespace CS;
+using namespace std;
+
+DualQuaternionA::DualQuaternionA(const QuaternionA& rotation, const Float3A& translation)
+{
+	// Dual = t * r / 2, where XMQuaternionMultiply(a, b) is b * a
+	Real = rotation;
+	Dual = XMVectorScale(XMQuaternionMultiply(rotation, XMVectorSelect(g_XMZero, translation, g_XMSelect1110)), 0.5f);
+}
+
+DualQuaternionA::DualQuaternionA(const RFrame& frame) : DualQuaternionA(QuaternionA(frame.Rotation), Float3A(frame.Position))
+{
+}
+
+DualQuaternionA::DualQuaternionA(const Float4x3A& rigid) : DualQuaternionA(XMQuaternionRotationMatrix(rigid), rigid.GetRow(3))
+{
+}
+
+Float3A DualQuaternionA::GetTranslation() const
+{
+	// t = 2 * Dual * conjugate(Real)
+	return XMVectorSelect(g_XMZero, XMVectorScale(XMQuaternionMultiply(XMQuaternionConjugate(Real), Dual), 2), g_XMSelect1110);
+}
+
+Float3A DualQuaternionA::TransformPoint(const Float3A& p) const
+{
+	return XMVectorAdd(XMVector3Rotate(p, Real), GetTranslation());
+}
+
+Float3A DualQuaternionA::TransformNormal(const Float3A& n) const
+{
+	return XMVector3Rotate(n, Real);
+}
+
+namespace
+{
+	size_t AlignedStride(size_t length)
+	{
+		return (length + Float3Stream::LaneAlignment - 1) & ~(size_t)(Float3Stream::LaneAlignment - 1);
+	}
+}
+
+SkinInfluences::SkinInfluences(size_t vertexCount, int influencesPerVertex) :
+	_length(vertexCount), _stride(AlignedStride(vertexCount)), _count(influencesPerVertex), _weights(nullptr), _bones(nullptr)
+{
+	if (influencesPerVertex < 1 || influencesPerVertex > MaxInfluences)
+		throw ArgumentException("influencesPerVertex", "Must be between 1 and SkinInfluences::MaxInfluences");
+
+	if (_stride == 0)
+		return;
+
+	_weights = _aligned_malloc_array<float>(_stride * _count, 64);
+	if (!_weights)
+		throw std::bad_alloc();
+	_weightsMgr = std::shared_ptr<float>(_weights, _aligned_free);
+
+	_bones = _aligned_malloc_array<uint16_t>(_stride * _count, 64);
+	if (!_bones)
+		throw std::bad_alloc();
+	_bonesMgr = std::shared_ptr<uint16_t>(_bones, _aligned_free);
+
+	zero(_weights, _stride * _count);
+	zero(_bones, _stride * _count);
+	_boneUses = std::make_shared<std::vector<size_t>>(1, _length * _count);
+}
+
+SkinInfluences::SkinInfluences(const int* bones, const float* weights, size_t vertexCount, int influencesPerVertex) :
+	SkinInfluences(vertexCount, influencesPerVertex)
+{
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		for (int k = 0; k < influencesPerVertex; k++)
+			Set(v, k, bones[v * influencesPerVertex + k], weights[v * influencesPerVertex + k]);
+	}
+}
+
+void SkinInfluences::Set(size_t vertex, int influence, int bone, float weight)
+{
+	if (vertex >= _length) throw ArgumentException("vertex", "Out of range");
+	if (influence < 0 || influence >= _count) throw ArgumentException("influence", "Out of range");
+	if (bone < 0 || bone > 0xFFFF) throw ArgumentException("bone", "Bone indices must be between 0 and 65535");
+
+	// Overwriting the last use of the largest bone lowers the largest to the next one in use
+	auto& uses = *_boneUses;
+	auto& slot = _bones[_stride * influence + vertex];
+	if ((size_t)bone >= uses.size())
+		uses.resize(bone + 1, 0);
+	uses[bone]++;
+	uses[slot]--;
+	while (uses.back() == 0)
+		uses.pop_back();
+
+	_weights[_stride * influence + vertex] = weight;
+	slot = (uint16_t)bone;
+}
+
+namespace
+{
+	// Vertices at least this many are split across threads. A multiple of 16, so chunks stay on whole registers.
+	const size_t SkinningGranularity = 2048;
+
+	struct SkinJob
+	{
+		const float* X;
+		const float* Y;
+		const float* Z;
+		const float* NX;
+		const float* NY;
+		const float* NZ;
+		float* OX;
+		float* OY;
+		float* OZ;
+		float* ONX;
+		float* ONY;
+		float* ONZ;
+		const float* Weights;
+		const uint16_t* Bones;
+		size_t InfluenceStride;
+		int Influences;
+		const float* Palette;
+	};
+}
+
+#define SHARPISH_KERNELS "SkinningKernels.inl"
+#include "MathKernels.h"
+
+namespace
+{
+	// D is the SHARPISH_KERNEL of the blend
+	template<typename D>
+	void RunSkinning(const Float3Stream& positions, const Float3Stream* normals, const SkinInfluences& influences,
+		const float* palette, size_t boneCount, Float3Stream& outPositions, Float3Stream* outNormals, bool parallel)
+	{
+		auto count = positions.size();
+
+		if (influences.size() != count) throw ArgumentException("influences", "Influence count differs from vertex count");
+		if (normals && normals->size() != count) throw ArgumentException("normals", "Stream sizes differ");
+		if (influences.GetMaxBone() >= (int)boneCount) throw ArgumentException("palette", "An influence refers to a bone past the end of the palette");
+
+		if (outPositions.size() != count) outPositions = Float3Stream(count);
+		if (outNormals && outNormals->size() != count) *outNormals = Float3Stream(count);
+
+		if (count == 0)
+			return;
+
+		SkinJob job = { };
+		job.X = positions.GetX(); job.Y = positions.GetY(); job.Z = positions.GetZ();
+		job.OX = outPositions.GetX(); job.OY = outPositions.GetY(); job.OZ = outPositions.GetZ();
+
+		if (normals)
+		{
+			job.NX = normals->GetX(); job.NY = normals->GetY(); job.NZ = normals->GetZ();
+			job.ONX = outNormals->GetX(); job.ONY = outNormals->GetY(); job.ONZ = outNormals->GetZ();
+		}
+
+		job.Weights = influences.GetWeights(0);
+		job.Bones = influences.GetBones(0);
+		job.InfluenceStride = influences.GetStride();
+		job.Influences = influences.GetInfluenceCount();
+		job.Palette = palette;
+
+		// The streams are padded to whole registers, so the last chunk can run past count
+		auto kernel = D::Get();
+
+		Details::ParallelFor(count, SkinningGranularity, parallel, [&](size_t begin, size_t end) { kernel(job, begin, end); });
+	}
+}
+
+void Skinning::LinearBlend(const Float3Stream& positions, const SkinInfluences& influences,
+	const Float4x3A* palette, size_t boneCount, Float3Stream& outPositions, bool parallel)
+{
+	RunSkinning<SHARPISH_KERNEL(LinearBlendKernel)>(positions, nullptr, influences, (const float*)palette, boneCount, outPositions, nullptr, parallel);
+}
+
+void Skinning::LinearBlend(const Float3Stream& positions, const Float3Stream& normals, const SkinInfluences& influences,
+	const Float4x3A* palette, size_t boneCount, Float3Stream& outPositions, Float3Stream& outNormals, bool parallel)
+{
+	RunSkinning<SHARPISH_KERNEL(LinearBlendKernel)>(positions, &normals, influences, (const float*)palette, boneCount, outPositions, &outNormals, parallel);
+}
+
+void Skinning::DualQuaternionBlend(const Float3Stream& positions, const SkinInfluences& influences,
+	const DualQuaternionA* palette, size_t boneCount, Float3Stream& outPositions, bool parallel)
+{
+	RunSkinning<SHARPISH_KERNEL(DualQuaternionBlendKernel)>(positions, nullptr, influences, (const float*)palette, boneCount, outPositions, nullptr, parallel);
+}
+
+void Skinning::DualQuaternionBlend(const Float3Stream& positions, const Float3Stream& normals, const SkinInfluences& influences,
+	const DualQuaternionA* palette, size_t boneCount, Float3Stream& outPositions, Float3Stream& outNormals, bool parallel)
+{
+	RunSkinning<SHARPISH_KERNEL(DualQuaternionBlendKernel)>(positions, &normals, influences, (const float*)palette, boneCount, outPositions, &outNormals, parallel);
+}
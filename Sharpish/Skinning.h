@@ -0,0 +1,94 @@
+#pragma once
+
+namespace CS
+{
+	// A rigid transform (rotation then translation) as a unit dual quaternion. Real is the rotation and Dual is
+	// half the translation times the rotation. Dual quaternions blend without the volume loss of blended matrices,
+	// but carry no scale.
+	struct DualQuaternionA
+	{
+		QuaternionA Real;
+		QuaternionA Dual;
+
+		DualQuaternionA() { }
+		DualQuaternionA(const QuaternionA& rotation, const Float3A& translation);
+		explicit DualQuaternionA(const RFrame& frame);
+		// The rotation and translation of a rigid transform. The upper 3x3 must be a rotation.
+		explicit DualQuaternionA(const Float4x3A& rigid);
+
+		PROPERTY_READONLY(Float3A, Translation);
+		Float3A __vectorcall GetTranslation() const;
+
+		Float3A __vectorcall TransformPoint(const Float3A& p) const;
+		Float3A __vectorcall TransformNormal(const Float3A& n) const;
+	};
+
+	// Bone indices and weights for skinning, up to MaxInfluences per vertex, stored as one lane per influence:
+	// influence k of every vertex is contiguous, padded like the streams in MathTypes.h. Unused influences have
+	// zero weight. Weights of each vertex should add up to 1.
+	class SkinInfluences
+	{
+	public:
+		static const int MaxInfluences = 8;
+
+		SkinInfluences() : _length(0), _stride(0), _count(0), _weights(nullptr), _bones(nullptr) { }
+		// All weights zero
+		SkinInfluences(size_t vertexCount, int influencesPerVertex);
+		// From per-vertex arrays: bone and weight k of vertex v are at [v * influencesPerVertex + k]
+		SkinInfluences(const int* bones, const float* weights, size_t vertexCount, int influencesPerVertex);
+
+		void Set(size_t vertex, int influence, int bone, float weight);
+
+		PROPERTY_READONLY(int, InfluenceCount);
+		inline int GetInfluenceCount() const { return _count; }
+
+		// The largest bone index in use, counting unset influences as bone 0, or -1 if there are no vertices
+		PROPERTY_READONLY(int, MaxBone);
+		inline int GetMaxBone() const { return _boneUses ? (int)_boneUses->size() - 1 : -1; }
+
+		// Lane k: the weight of influence k for each vertex
+		inline const float* GetWeights(int influence) const { assert(influence < _count); return _weights + _stride * influence; }
+		inline const uint16_t* GetBones(int influence) const { assert(influence < _count); return _bones + _stride * influence; }
+
+		PROPERTY_READONLY(size_t, Stride);
+		inline size_t GetStride() const { return _stride; }
+
+		inline size_t size() const { return _length; }
+		inline bool empty() const { return _length == 0; }
+
+	private:
+		size_t _length;
+		size_t _stride;
+		int _count;
+		float* _weights;
+		uint16_t* _bones;
+		std::shared_ptr<float> _weightsMgr;
+		std::shared_ptr<uint16_t> _bonesMgr;
+		// How many influences refer to each bone, up to the largest in use. Shared with the lanes, so copies agree.
+		std::shared_ptr<std::vector<size_t>> _boneUses;
+	};
+
+	// CPU skinning of vertex streams. Positions and normals are read and written as Float3Streams, several
+	// vertices at a time in SIMD registers, and large meshes are split across worker threads unless parallel is
+	// false (e.g. when the caller already skins many meshes in parallel). Bone index b refers to palette[b];
+	// throws ArgumentException if an influence refers past the end of the palette or a stream size differs.
+	// Outputs are reallocated if their size doesn't match and may be the input streams.
+	class Skinning
+	{
+	public:
+		// Linear blend skinning: each vertex is transformed by the weighted sum of its bones' matrices. Normals
+		// use the upper 3x3 only and are renormalized, which is exact for rotations and uniform scale.
+		static void LinearBlend(const Float3Stream& positions, const SkinInfluences& influences,
+			const Float4x3A* palette, size_t boneCount, Float3Stream& outPositions, bool parallel = true);
+		static void LinearBlend(const Float3Stream& positions, const Float3Stream& normals, const SkinInfluences& influences,
+			const Float4x3A* palette, size_t boneCount, Float3Stream& outPositions, Float3Stream& outNormals, bool parallel = true);
+
+		// Dual quaternion skinning: each vertex is transformed by the normalized weighted sum of its bones' dual
+		// quaternions, taking each in the hemisphere of the running sum. Joints keep their volume under twist
+		// (no candy-wrapper collapse), but bones can't scale.
+		static void DualQuaternionBlend(const Float3Stream& positions, const SkinInfluences& influences,
+			const DualQuaternionA* palette, size_t boneCount, Float3Stream& outPositions, bool parallel = true);
+		static void DualQuaternionBlend(const Float3Stream& positions, const Float3Stream& normals, const SkinInfluences& influences,
+			const DualQuaternionA* palette, size_t boneCount, Float3Stream& outPositions, Float3Stream& outNormals, bool parallel = true);
+	};
+}
@@ -0,0 +1,167 @@
+// The batch kernels of Skinning.cpp, defined for each lane width by MathKernels.h
+
+	// Scales each bone index in the lanes at i by the palette entry size, as Gather offsets. Returns false if no
+	// lane has a nonzero weight, so the influence can be skipped.
+	template<typename L, int EntryFloats>
+	inline bool __vectorcall LoadInfluence(const SkinJob& job, int k, size_t i, typename L::V& weight, int32_t* offsets)
+	{
+		weight = L::Load(job.Weights + job.InfluenceStride * k + i);
+
+		if (!L::MaskBits(L::MaskOr(L::Greater(weight, L::Zero()), L::Less(weight, L::Zero()))))
+			return false;
+
+		auto bones = job.Bones + job.InfluenceStride * k + i;
+		for (int j = 0; j < L::Width; j++)
+			offsets[j] = (int32_t)bones[j] * EntryFloats;
+
+		return true;
+	}
+
+	template<typename L>
+	inline void __vectorcall StoreNormal(float* x, float* y, float* z, typename L::V nx, typename L::V ny, typename L::V nz)
+	{
+		auto zero = L::Zero();
+		auto lengthSq = L::MulAdd(nx, nx, L::MulAdd(ny, ny, L::Mul(nz, nz)));
+		auto scale = L::Select(zero, Details::Precise<L, Precision::Refined>::ReciprocalSqrt(lengthSq), L::Greater(lengthSq, zero));
+
+		L::Store(x, L::Mul(nx, scale));
+		L::Store(y, L::Mul(ny, scale));
+		L::Store(z, L::Mul(nz, scale));
+	}
+
+	// Row-vector convention: v' = x * r0 + y * r1 + z * r2 + r3, with the rows blended by weight
+	struct LinearBlendKernel
+	{
+		template<typename L>
+		static void Run(const SkinJob& job, size_t begin, size_t end)
+		{
+			typedef typename L::V V;
+
+			// Offsets of m00 m01 m02 m10 ... m32 within a Float4x3A
+			static const int Elements[12] = { 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14 };
+			alignas(64) int32_t offsets[L::Width];
+
+			for (size_t i = begin; i < end; i += L::Width)
+			{
+				V m[12];
+				for (int e = 0; e < 12; e++)
+					m[e] = L::Zero();
+
+				for (int k = 0; k < job.Influences; k++)
+				{
+					V w;
+					if (!LoadInfluence<L, 16>(job, k, i, w, offsets))
+						continue;
+
+					for (int e = 0; e < 12; e++)
+						m[e] = L::MulAdd(w, L::Gather(job.Palette + Elements[e], offsets), m[e]);
+				}
+
+				auto x = L::Load(job.X + i), y = L::Load(job.Y + i), z = L::Load(job.Z + i);
+				L::Store(job.OX + i, L::MulAdd(x, m[0], L::MulAdd(y, m[3], L::MulAdd(z, m[6], m[9]))));
+				L::Store(job.OY + i, L::MulAdd(x, m[1], L::MulAdd(y, m[4], L::MulAdd(z, m[7], m[10]))));
+				L::Store(job.OZ + i, L::MulAdd(x, m[2], L::MulAdd(y, m[5], L::MulAdd(z, m[8], m[11]))));
+
+				if (job.NX)
+				{
+					auto nx = L::Load(job.NX + i), ny = L::Load(job.NY + i), nz = L::Load(job.NZ + i);
+					StoreNormal<L>(job.ONX + i, job.ONY + i, job.ONZ + i,
+						L::MulAdd(nx, m[0], L::MulAdd(ny, m[3], L::Mul(nz, m[6]))),
+						L::MulAdd(nx, m[1], L::MulAdd(ny, m[4], L::Mul(nz, m[7]))),
+						L::MulAdd(nx, m[2], L::MulAdd(ny, m[5], L::Mul(nz, m[8]))));
+				}
+			}
+		}
+	};
+
+	// a x b
+	template<typename L>
+	inline void __vectorcall Cross(typename L::V ax, typename L::V ay, typename L::V az, typename L::V bx, typename L::V by, typename L::V bz,
+		typename L::V& x, typename L::V& y, typename L::V& z)
+	{
+		x = L::NegMulAdd(az, by, L::Mul(ay, bz));
+		y = L::NegMulAdd(ax, bz, L::Mul(az, bx));
+		z = L::NegMulAdd(ay, bx, L::Mul(ax, by));
+	}
+
+	// v + 2 r x (r x v + w v), the rotation of v by the unit quaternion (r, w)
+	template<typename L>
+	inline void __vectorcall Rotate(typename L::V rx, typename L::V ry, typename L::V rz, typename L::V rw,
+		typename L::V& x, typename L::V& y, typename L::V& z)
+	{
+		typename L::V cx, cy, cz, dx, dy, dz;
+		Cross<L>(rx, ry, rz, x, y, z, cx, cy, cz);
+		cx = L::MulAdd(rw, x, cx);
+		cy = L::MulAdd(rw, y, cy);
+		cz = L::MulAdd(rw, z, cz);
+		Cross<L>(rx, ry, rz, cx, cy, cz, dx, dy, dz);
+
+		auto two = L::Splat(2.0f);
+		x = L::MulAdd(two, dx, x);
+		y = L::MulAdd(two, dy, y);
+		z = L::MulAdd(two, dz, z);
+	}
+
+	struct DualQuaternionBlendKernel
+	{
+		template<typename L>
+		static void Run(const SkinJob& job, size_t begin, size_t end)
+		{
+			typedef typename L::V V;
+
+			alignas(64) int32_t offsets[L::Width];
+			auto zero = L::Zero();
+
+			for (size_t i = begin; i < end; i += L::Width)
+			{
+				V q[8];
+				for (int e = 0; e < 8; e++)
+					q[e] = zero;
+
+				for (int k = 0; k < job.Influences; k++)
+				{
+					V w;
+					if (!LoadInfluence<L, 8>(job, k, i, w, offsets))
+						continue;
+
+					V b[8];
+					for (int e = 0; e < 8; e++)
+						b[e] = L::Gather(job.Palette + e, offsets);
+
+					// q and -q are the same rotation; blend each bone from the side nearer the sum so far
+					auto dot = L::MulAdd(b[0], q[0], L::MulAdd(b[1], q[1], L::MulAdd(b[2], q[2], L::Mul(b[3], q[3]))));
+					w = L::Select(w, L::Negate(w), L::Less(dot, zero));
+
+					for (int e = 0; e < 8; e++)
+						q[e] = L::MulAdd(w, b[e], q[e]);
+				}
+
+				// Normalize by the length of the real part. Vertices with no weight are left where they are.
+				auto lengthSq = L::MulAdd(q[0], q[0], L::MulAdd(q[1], q[1], L::MulAdd(q[2], q[2], L::Mul(q[3], q[3]))));
+				auto scale = L::Select(zero, Details::Precise<L, Precision::Refined>::ReciprocalSqrt(lengthSq), L::Greater(lengthSq, zero));
+				for (int e = 0; e < 8; e++)
+					q[e] = L::Mul(q[e], scale);
+
+				// t = 2 (w d - dw r + r x d), the translation of the blended transform
+				V tx, ty, tz;
+				Cross<L>(q[0], q[1], q[2], q[4], q[5], q[6], tx, ty, tz);
+				auto two = L::Splat(2.0f);
+				tx = L::Mul(two, L::MulAdd(q[3], q[4], L::NegMulAdd(q[7], q[0], tx)));
+				ty = L::Mul(two, L::MulAdd(q[3], q[5], L::NegMulAdd(q[7], q[1], ty)));
+				tz = L::Mul(two, L::MulAdd(q[3], q[6], L::NegMulAdd(q[7], q[2], tz)));
+
+				auto x = L::Load(job.X + i), y = L::Load(job.Y + i), z = L::Load(job.Z + i);
+				Rotate<L>(q[0], q[1], q[2], q[3], x, y, z);
+				L::Store(job.OX + i, L::Add(x, tx));
+				L::Store(job.OY + i, L::Add(y, ty));
+				L::Store(job.OZ + i, L::Add(z, tz));
+
+				if (job.NX)
+				{
+					auto nx = L::Load(job.NX + i), ny = L::Load(job.NY + i), nz = L::Load(job.NZ + i);
+					Rotate<L>(q[0], q[1], q[2], q[3], nx, ny, nz);
+					StoreNormal<L>(job.ONX + i, job.ONY + i, job.ONZ + i, nx, ny, nz);
+				}
+			}
+		}
+	};
@@ -0,0 +1,308 @@
+#include "Sharpish.h"
+#include "SpatialHashGrid.h"
+#include "MathParallel.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace CS;
+using namespace CS::Details;
+using namespace std;
+
+namespace
+{
+	// Entries per piece of work in the passes of Build
+	const size_t BuildGranularity = 4096;
+	// Cells per piece of work when pairs are found
+	const size_t PairGranularity = 256;
+
+	inline bool SameCell(const Int3& a, const Int3& b)
+	{
+		return a.X == b.X && a.Y == b.Y && a.Z == b.Z;
+	}
+
+	inline bool InRange(int64_t coordinate)
+	{
+		return coordinate >= INT_MIN && coordinate <= INT_MAX;
+	}
+}
+
+SpatialHashIndex::SpatialHashIndex(float cellSize) :
+	_cellSize(cellSize),
+	_inverseCellSize(1 / cellSize)
+{
+	if (!(cellSize > 0) || isinf(cellSize))
+		throw ArgumentException("cellSize", "Cell size must be positive and finite");
+}
+
+void SpatialHashIndex::Clear()
+{
+	_cells.clear();
+	_table.clear();
+	_positions.clear();
+	_sources.clear();
+}
+
+void SpatialHashIndex::Build(const Float3A* positions, size_t count, bool parallel)
+{
+	Clear();
+	if (count == 0)
+		return;
+	if (!positions)
+		throw ArgumentNullException("positions");
+	if (count > UINT32_MAX)
+		throw ArgumentException("count", "Too many entries");
+
+	// Each entry's cell. Cells are clamped to the range of int, so only finite positions are meaningful.
+	vector<Int3> cells(count);
+	ParallelFor(count, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			Float3 p = positions[i];
+			if (!isfinite(p.X) || !isfinite(p.Y) || !isfinite(p.Z))
+				throw ArgumentException("positions", "Positions must be finite");
+			cells[i] = CellOf(p);
+		}
+	});
+
+	// Number the cells. Each entry finds its cell's slot in a table of every entry's cell, claiming it if it's
+	// empty, and lowers the slot to its own index, so every slot ends up holding its cell's first entry whatever
+	// order the threads ran in. EmptySlot is above every index, so claiming a slot is lowering it too.
+	size_t keyCapacity = 16;
+	while (keyCapacity < 2 * count)
+		keyCapacity *= 2;
+	size_t keyMask = keyCapacity - 1;
+
+	unique_ptr<atomic<uint32_t>[]> firsts(new atomic<uint32_t>[keyCapacity]);
+	ParallelFor(keyCapacity, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t slot = begin; slot < end; slot++)
+			firsts[slot].store(EmptySlot, memory_order_relaxed);
+	});
+
+	vector<uint32_t> keys(count);
+	ParallelFor(count, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			for (size_t slot = Hash(cells[i]) & keyMask;; slot = (slot + 1) & keyMask)
+			{
+				// A claimed slot only ever holds entries of one cell, so once it's this cell's it stays so
+				bool found = false;
+				uint32_t first = firsts[slot].load(memory_order_relaxed);
+				while (!found && (first == EmptySlot || SameCell(cells[first], cells[i])))
+					found = first <= i || firsts[slot].compare_exchange_weak(first, (uint32_t)i, memory_order_relaxed);
+
+				if (found)
+				{
+					keys[i] = (uint32_t)slot;
+					break;
+				}
+			}
+		}
+	});
+
+	// Cells are numbered in the order of their first entries
+	vector<uint32_t> starts;
+	ParallelCollect(count, BuildGranularity, parallel, starts, [&](size_t begin, size_t end, vector<uint32_t>& found)
+	{
+		for (size_t i = begin; i < end; i++)
+			if (firsts[keys[i]].load(memory_order_relaxed) == i)
+				found.push_back((uint32_t)i);
+	});
+
+	size_t cellCount = starts.size();
+	vector<uint32_t> numbers(keyCapacity);
+	ParallelFor(cellCount, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t c = begin; c < end; c++)
+			numbers[keys[starts[c]]] = (uint32_t)c;
+	});
+
+	ParallelFor(count, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+			keys[i] = numbers[keys[i]];
+	});
+
+	// Counting sort by cell number. The entries are split into one contiguous piece per thread, each piece counts
+	// its entries per cell, an exclusive prefix sum over cells and then pieces gives each piece its place in each
+	// cell, and each piece scatters its entries in order, so entries within a cell keep their source order.
+	size_t pieces = parallel ? min<size_t>(ParallelThreadCount(), (count + BuildGranularity - 1) / BuildGranularity) : 1;
+	auto pieceBegin = [&](size_t piece) { return count * piece / pieces; };
+	vector<uint32_t> counts(pieces * cellCount);
+
+	ParallelFor(pieces, 1, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t piece = begin; piece < end; piece++)
+		{
+			uint32_t* histogram = counts.data() + piece * cellCount;
+			for (size_t i = pieceBegin(piece); i < pieceBegin(piece + 1); i++)
+				histogram[keys[i]]++;
+		}
+	});
+
+	vector<uint32_t> cellSizes(cellCount);
+	ParallelFor(cellCount, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t c = begin; c < end; c++)
+		{
+			uint32_t sum = 0;
+			for (size_t piece = 0; piece < pieces; piece++)
+			{
+				uint32_t n = counts[piece * cellCount + c];
+				counts[piece * cellCount + c] = sum;
+				sum += n;
+			}
+			cellSizes[c] = sum;
+		}
+	});
+
+	vector<uint32_t> cellBegins(cellCount);
+	for (size_t c = 1; c < cellCount; c++)
+		cellBegins[c] = cellBegins[c - 1] + cellSizes[c - 1];
+
+	vector<uint32_t> order(count);
+	ParallelFor(pieces, 1, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t piece = begin; piece < end; piece++)
+		{
+			uint32_t* placed = counts.data() + piece * cellCount;
+			for (size_t i = pieceBegin(piece); i < pieceBegin(piece + 1); i++)
+				order[cellBegins[keys[i]] + placed[keys[i]]++] = (uint32_t)i;
+		}
+	});
+
+	_cells.resize(cellCount);
+	ParallelFor(cellCount, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t c = begin; c < end; c++)
+			_cells[c] = Cell { cells[starts[c]], cellBegins[c], cellSizes[c] };
+	});
+
+	// The keys are distinct, so a cell only has to claim the first free slot of its probe
+	size_t capacity = 16;
+	while (capacity < 2 * _cells.size())
+		capacity *= 2;
+	size_t mask = capacity - 1;
+
+	unique_ptr<atomic<uint32_t>[]> slots(new atomic<uint32_t>[capacity]);
+	ParallelFor(capacity, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t slot = begin; slot < end; slot++)
+			slots[slot].store(EmptySlot, memory_order_relaxed);
+	});
+
+	ParallelFor(_cells.size(), BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t c = begin; c < end; c++)
+		{
+			for (size_t slot = Hash(_cells[c].Key) & mask;; slot = (slot + 1) & mask)
+			{
+				uint32_t empty = EmptySlot;
+				if (slots[slot].compare_exchange_strong(empty, (uint32_t)c, memory_order_relaxed))
+					break;
+			}
+		}
+	});
+
+	_table.resize(capacity);
+	_positions.resize(count);
+	ParallelFor(capacity, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t slot = begin; slot < end; slot++)
+			_table[slot] = slots[slot].load(memory_order_relaxed);
+	});
+
+	ParallelFor(count, BuildGranularity, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t e = begin; e < end; e++)
+			_positions[e] = positions[order[e]];
+	});
+	_sources.swap(order);
+}
+
+void SpatialHashIndex::FindPairs(float radius, vector<pair<uint32_t, uint32_t>>& outPairs, bool parallel) const
+{
+	if (!(radius >= 0) || _cells.empty())
+		return;
+
+	float radiusSq = radius * radius;
+	// Whether two cells this far apart can hold a pair: the gap between their nearest points is within radius
+	auto reachable = [&](int64_t x, int64_t y, int64_t z)
+	{
+		float gx = (float)max<int64_t>(llabs(x) - 1, 0), gy = (float)max<int64_t>(llabs(y) - 1, 0), gz = (float)max<int64_t>(llabs(z) - 1, 0);
+		return (gx * gx + gy * gy + gz * gz) * _cellSize * _cellSize <= radiusSq;
+	};
+
+	// Each cell looks up its reachable neighbors after it in x, y, z order, so each pair of cells is searched
+	// once. With more offsets to probe than there are cells, as for a radius far above the cell size, each cell
+	// is instead tested against the cells after it in the list.
+	double reach = ceil((double)radius * _inverseCellSize);
+	double side = 2 * reach + 1;
+	bool walkCells = (side * side * side - 1) / 2 > (double)_cells.size();
+
+	vector<Int3> offsets;
+	if (!walkCells)
+	{
+		int r = (int)reach;
+		for (int x = 0; x <= r; x++)
+			for (int y = x == 0 ? 0 : -r; y <= r; y++)
+				for (int z = x == 0 && y == 0 ? 1 : -r; z <= r; z++)
+					if (reachable(x, y, z))
+						offsets.push_back(Int3(x, y, z));
+	}
+
+	ParallelCollect(_cells.size(), PairGranularity, parallel, outPairs, [&](size_t begin, size_t end, vector<pair<uint32_t, uint32_t>>& pairs)
+	{
+		auto close = [&](uint32_t a, uint32_t b)
+		{
+			const Float3& p = _positions[a];
+			const Float3& q = _positions[b];
+			float dx = p.X - q.X, dy = p.Y - q.Y, dz = p.Z - q.Z;
+			return dx * dx + dy * dy + dz * dz <= radiusSq;
+		};
+
+		for (size_t i = begin; i < end; i++)
+		{
+			const Cell& c = _cells[i];
+			uint32_t cellEnd = c.Begin + c.Count;
+
+			for (uint32_t a = c.Begin; a < cellEnd; a++)
+				for (uint32_t b = a + 1; b < cellEnd; b++)
+					if (close(a, b))
+						pairs.emplace_back(a, b);
+
+			auto pairWith = [&](uint32_t otherBegin, uint32_t otherEnd)
+			{
+				for (uint32_t a = c.Begin; a < cellEnd; a++)
+					for (uint32_t b = otherBegin; b < otherEnd; b++)
+						if (close(a, b))
+							pairs.emplace_back(a, b);
+			};
+
+			if (walkCells)
+			{
+				for (size_t j = i + 1; j < _cells.size(); j++)
+				{
+					const Cell& other = _cells[j];
+					if (reachable((int64_t)other.Key.X - c.Key.X, (int64_t)other.Key.Y - c.Key.Y, (int64_t)other.Key.Z - c.Key.Z))
+						pairWith(other.Begin, other.Begin + other.Count);
+				}
+				continue;
+			}
+
+			for (const Int3& offset : offsets)
+			{
+				// Cells at the clamped ends of the range have no neighbors beyond them
+				int64_t x = (int64_t)c.Key.X + offset.X, y = (int64_t)c.Key.Y + offset.Y, z = (int64_t)c.Key.Z + offset.Z;
+				if (!InRange(x) || !InRange(y) || !InRange(z))
+					continue;
+
+				uint32_t otherBegin, otherEnd;
+				if (FindCell(Int3((int)x, (int)y, (int)z), otherBegin, otherEnd))
+					pairWith(otherBegin, otherEnd);
+			}
+		}
+	});
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <climits>
+
+namespace CS
+{
+	namespace Details
+	{
+		// The part of SpatialHashGrid that doesn't depend on the value type: the occupied cells in the order of
+		// their first entries, a hash table of their indices, and the positions of the entries, sorted so each
+		// cell's entries are contiguous. Entry e was built from index GetSource(e) of the caller's arrays; entries within a cell keep
+		// their source order.
+		//
+		// The table uses open addressing with linear probing and is kept at most half full. Cells are hashed with
+		// a 64-bit multiply-xorshift mix of their coordinates, since neighboring cells differ in only a few low
+		// bits and a weak hash would cluster them into the same probe runs.
+		class SpatialHashIndex
+		{
+		public:
+			explicit SpatialHashIndex(float cellSize);
+
+			void Build(const Float3A* positions, size_t count, bool parallel);
+			void Clear();
+
+			inline size_t size() const { return _positions.size(); }
+			inline float GetCellSize() const { return _cellSize; }
+			inline size_t GetCellCount() const { return _cells.size(); }
+			inline uint32_t GetSource(size_t entry) const { return _sources[entry]; }
+			inline const Float3& GetPosition(size_t entry) const { return _positions[entry]; }
+
+			// Cells beyond the range of int are clamped to its ends, and NaN goes to the lowest
+			inline Int3 CellOf(const Float3& p) const
+			{
+				return Int3(Coordinate(p.X), Coordinate(p.Y), Coordinate(p.Z));
+			}
+
+			static inline uint32_t Hash(const Int3& cell)
+			{
+				uint64_t h = (uint64_t)(uint32_t)cell.X * 0x9E3779B97F4A7C15ull;
+				h ^= (uint64_t)(uint32_t)cell.Y * 0xC2B2AE3D27D4EB4Full;
+				h ^= (uint64_t)(uint32_t)cell.Z * 0x165667B19E3779F9ull;
+				h ^= h >> 32;
+				h *= 0xD6E8FEB86659FD93ull;
+				h ^= h >> 32;
+				return (uint32_t)h;
+			}
+
+			// The entries in cell as [outBegin, outEnd). Returns false if the cell is empty.
+			inline bool FindCell(const Int3& cell, uint32_t& outBegin, uint32_t& outEnd) const
+			{
+				if (_table.empty())
+					return false;
+
+				size_t mask = _table.size() - 1;
+				for (size_t slot = Hash(cell) & mask;; slot = (slot + 1) & mask)
+				{
+					if (_table[slot] == EmptySlot)
+						return false;
+					const Cell& c = _cells[_table[slot]];
+					if (c.Key.X == cell.X && c.Key.Y == cell.Y && c.Key.Z == cell.Z)
+					{
+						outBegin = c.Begin;
+						outEnd = c.Begin + c.Count;
+						return true;
+					}
+				}
+			}
+
+			// Calls visit(entry) for each entry whose position lies in the box. Walks the box's cells, or the whole
+			// list of cells when that's shorter.
+			template<typename F>
+			void ForEachInBox(const Float3& minima, const Float3& maxima, const F& visit) const
+			{
+				if (_cells.empty() || minima.X > maxima.X || minima.Y > maxima.Y || minima.Z > maxima.Z)
+					return;
+
+				auto visitCell = [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t e = begin; e < end; e++)
+					{
+						const Float3& p = _positions[e];
+						if (p.X >= minima.X && p.Y >= minima.Y && p.Z >= minima.Z && p.X <= maxima.X && p.Y <= maxima.Y && p.Z <= maxima.Z)
+							visit(e);
+					}
+				};
+
+				Int3 lo = CellOf(minima);
+				Int3 hi = CellOf(maxima);
+				double span = ((double)hi.X - lo.X + 1) * ((double)hi.Y - lo.Y + 1) * ((double)hi.Z - lo.Z + 1);
+
+				if (span > (double)_cells.size())
+				{
+					for (const Cell& c : _cells)
+					{
+						if (c.Key.X >= lo.X && c.Key.Y >= lo.Y && c.Key.Z >= lo.Z && c.Key.X <= hi.X && c.Key.Y <= hi.Y && c.Key.Z <= hi.Z)
+							visitCell(c.Begin, c.Begin + c.Count);
+					}
+					return;
+				}
+
+				// Counted in 64 bits, so a box reaching INT_MAX doesn't overflow the loop
+				uint32_t begin, end;
+				for (int64_t x = lo.X; x <= hi.X; x++)
+					for (int64_t y = lo.Y; y <= hi.Y; y++)
+						for (int64_t z = lo.Z; z <= hi.Z; z++)
+							if (FindCell(Int3((int)x, (int)y, (int)z), begin, end))
+								visitCell(begin, end);
+			}
+
+			// Calls visit(entry) for each entry within radius of center
+			template<typename F>
+			void ForEachInRadius(const Float3& center, float radius, const F& visit) const
+			{
+				if (!(radius >= 0))
+					return;
+
+				float radiusSq = radius * radius;
+				Float3 minima(center.X - radius, center.Y - radius, center.Z - radius);
+				Float3 maxima(center.X + radius, center.Y + radius, center.Z + radius);
+
+				ForEachInBox(minima, maxima, [&](uint32_t e)
+				{
+					const Float3& p = _positions[e];
+					float dx = p.X - center.X, dy = p.Y - center.Y, dz = p.Z - center.Z;
+					if (dx * dx + dy * dy + dz * dz <= radiusSq)
+						visit(e);
+				});
+			}
+
+			// Appends each pair of entries within radius of each other, once, in no particular order
+			void FindPairs(float radius, std::vector<std::pair<uint32_t, uint32_t>>& outPairs, bool parallel) const;
+
+		private:
+			struct Cell
+			{
+				Int3 Key;
+				uint32_t Begin;
+				uint32_t Count;
+			};
+
+			// A slot of _table that holds no cell
+			static const uint32_t EmptySlot = UINT32_MAX;
+
+			inline int Coordinate(float x) const
+			{
+				float scaled = floorf(x * _inverseCellSize);
+				if (scaled >= 2147483648.0f)
+					return INT_MAX;
+				return scaled >= -2147483648.0f ? (int)scaled : INT_MIN;
+			}
+
+			float _cellSize;
+			float _inverseCellSize;
+			std::vector<Cell> _cells;
+			// Indices into _cells
+			std::vector<uint32_t> _table;
+			std::vector<Float3> _positions;
+			std::vector<uint32_t> _sources;
+		};
+	}
+
+	// A uniform grid over 3D space that stores a value at each of a set of positions, for finding the values near
+	// a point in constant time, e.g. the neighbors of particles or agents in a crowd. Positions are quantized to
+	// Int3 cells of CellSize on a side, and only occupied cells are stored, in a hash table, so the grid is
+	// unbounded. It suits many objects spread roughly evenly; for very uneven densities prefer Bvh.
+	//
+	// Build replaces the contents with a counting sort of the entries by cell: each thread counts its share of the
+	// entries per cell, a prefix sum places the counts, and each thread scatters its share in order. Every pass,
+	// including numbering the cells and filling the hash table, is split across worker threads unless parallel is
+	// false. Positions must be finite. Queries are cheapest when the cell size is about the usual query radius.
+	template<typename T>
+	class SpatialHashGrid
+	{
+	public:
+		explicit SpatialHashGrid(float cellSize) : _index(cellSize) { }
+
+		void Build(const Float3A* positions, const T* values, size_t count, bool parallel = true)
+		{
+			if (count && !values)
+				throw ArgumentNullException("values");
+
+			_values.clear();
+			_index.Build(positions, count, parallel);
+			_values.resize(count);
+			for (size_t e = 0; e < count; e++)
+				_values[e] = values[_index.GetSource(e)];
+		}
+
+		void Clear()
+		{
+			_index.Clear();
+			_values.clear();
+		}
+
+		inline size_t size() const { return _values.size(); }
+		inline bool empty() const { return _values.empty(); }
+
+		PROPERTY_READONLY(float, CellSize);
+		inline float GetCellSize() const { return _index.GetCellSize(); }
+
+		PROPERTY_READONLY(size_t, CellCount);
+		inline size_t GetCellCount() const { return _index.GetCellCount(); }
+
+		inline Int3 __vectorcall CellOf(const Float3A& position) const { return _index.CellOf(position); }
+
+		// Calls visit(value, position) for each entry within radius of center, or inside box
+		template<typename F>
+		void ForEachInRadius(const Float3A& center, float radius, const F& visit) const
+		{
+			_index.ForEachInRadius(center, radius, [&](uint32_t e) { visit(_values[e], _index.GetPosition(e)); });
+		}
+
+		template<typename F>
+		void ForEachInBox(const BoundingBoxA& box, const F& visit) const
+		{
+			_index.ForEachInBox(box.Minima, box.Maxima, [&](uint32_t e) { visit(_values[e], _index.GetPosition(e)); });
+		}
+
+		// The values within radius of center, or inside box, appended to outValues. Returns how many were appended.
+		size_t QueryRadius(const Float3A& center, float radius, std::vector<T>& outValues) const
+		{
+			size_t start = outValues.size();
+			_index.ForEachInRadius(center, radius, [&](uint32_t e) { outValues.push_back(_values[e]); });
+			return outValues.size() - start;
+		}
+
+		size_t QueryBox(const BoundingBoxA& box, std::vector<T>& outValues) const
+		{
+			size_t start = outValues.size();
+			_index.ForEachInBox(box.Minima, box.Maxima, [&](uint32_t e) { outValues.push_back(_values[e]); });
+			return outValues.size() - start;
+		}
+
+		// Every pair of values whose positions are within radius of each other, each once, appended to outPairs.
+		// Cells are searched across worker threads unless parallel is false. Returns how many were appended.
+		size_t FindPairs(float radius, std::vector<std::pair<T, T>>& outPairs, bool parallel = true) const
+		{
+			std::vector<std::pair<uint32_t, uint32_t>> entries;
+			_index.FindPairs(radius, entries, parallel);
+
+			outPairs.reserve(outPairs.size() + entries.size());
+			for (auto& pair : entries)
+				outPairs.emplace_back(_values[pair.first], _values[pair.second]);
+			return entries.size();
+		}
+
+	private:
+		Details::SpatialHashIndex _index;
+		// In entry order
+		std::vector<T> _values;
+	};
+}
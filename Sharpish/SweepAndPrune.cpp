@@ -0,0 +1,457 @@
+#include "Sharpish.h"
+#include "SweepAndPrune.h"
+#include "MathParallel.h"
+#include <algorithm>
+#include <cstring>
+
+// ::PUBLICLIB::
+
+using namespace CS;
+using namespace std;
+
+namespace
+{
+	// The sweep tests four candidates per XMVECTOR
+	typedef Details::Lanes4 L;
+
+	// Proxies per piece of work when the sweep is split across threads
+	const size_t SweepGranularity = 1024;
+
+	const uint32_t FreeMarker = UINT32_MAX;
+
+	// The radix sort of the endpoints takes 11 bits of their 33-bit keys per pass
+	const int RadixBits = 11;
+	const int RadixPasses = 3;
+	const uint32_t RadixBuckets = 1u << RadixBits;
+
+	// The bits of value as an unsigned number that orders as the float does: negatives have every bit flipped
+	// so larger magnitudes come first, and positives the sign bit set to follow them. Zeros of either sign, which
+	// compare equal, share a key.
+	inline uint32_t OrderedBits(float value)
+	{
+		uint32_t bits = 0;
+		if (value != 0)
+			memcpy(&bits, &value, sizeof(bits));
+		return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+	}
+
+	inline bool Overlaps(const Range& a, const Range& b)
+	{
+		return a.Minimum <= b.Maximum && b.Minimum <= a.Maximum;
+	}
+
+	inline uint64_t PairKey(int a, int b)
+	{
+		return a < b ? (uint64_t)a << 32 | (uint32_t)b : (uint64_t)b << 32 | (uint32_t)a;
+	}
+
+	inline pair<int, int> PairOf(uint64_t key)
+	{
+		return make_pair((int)(key >> 32), (int)(uint32_t)key);
+	}
+}
+
+SweepAndPrune::SweepAndPrune() :
+	_free(None),
+	_count(0)
+{
+}
+
+SweepAndPrune::ProxyId SweepAndPrune::Insert(const BoundingBoxA& box)
+{
+	if (!box.GetExists())
+		throw ArgumentException("box", "Box holds nothing");
+
+	ProxyId proxy = AllocateProxy();
+	SetExtents(proxy, box);
+
+	// Start past every other endpoint, where the proxy overlaps nothing, and sort into place
+	for (int k = 0; k < 3; k++)
+	{
+		auto& endpoints = _endpoints[k];
+		Proxy& p = _proxies[proxy];
+		p.Min[k] = (uint32_t)endpoints.size();
+		endpoints.push_back(Endpoint { p.Extents[k].Minimum, (uint32_t)proxy << 1 });
+		p.Max[k] = (uint32_t)endpoints.size();
+		endpoints.push_back(Endpoint { p.Extents[k].Maximum, (uint32_t)proxy << 1 | 1 });
+
+		SortDown(k, _proxies[proxy].Min[k]);
+		SortDown(k, _proxies[proxy].Max[k]);
+	}
+
+	return proxy;
+}
+
+void SweepAndPrune::InsertMany(const BoundingBoxA* boxes, size_t count, ProxyId* outProxies, bool parallel)
+{
+	if (count == 0)
+		return;
+	if (!boxes)
+		throw ArgumentNullException("boxes");
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!boxes[i].GetExists())
+			throw ArgumentException("boxes", "Box holds nothing");
+	}
+
+	vector<ProxyId> added(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		added[i] = AllocateProxy();
+		SetExtents(added[i], boxes[i]);
+		if (outProxies)
+			outProxies[i] = added[i];
+	}
+
+	vector<uint8_t> isNew(_proxies.size());
+	for (ProxyId proxy : added)
+		isNew[proxy] = 1;
+
+	// Many insertions each passing most of the array would make insertion sort quadratic, so the axes are radix
+	// sorted afresh, one per thread
+	Details::ParallelFor(3, 1, parallel, [&](size_t begin, size_t end)
+	{
+		for (size_t k = begin; k < end; k++)
+		{
+			auto& endpoints = _endpoints[k];
+			for (ProxyId proxy : added)
+			{
+				endpoints.push_back(Endpoint { _proxies[proxy].Extents[k].Minimum, (uint32_t)proxy << 1 });
+				endpoints.push_back(Endpoint { _proxies[proxy].Extents[k].Maximum, (uint32_t)proxy << 1 | 1 });
+			}
+
+			SortEndpoints(endpoints);
+			for (uint32_t i = 0; i < (uint32_t)endpoints.size(); i++)
+				PositionOf(endpoints[i], k) = i;
+		}
+	});
+
+	// The sweep: proxies in order of their x minima, with their other ranges alongside as SoA lanes padded to a
+	// whole vector. Each proxy is tested against those that start before it ends on x, four at a time.
+	size_t n = _count;
+	size_t padded = n + L::Width;
+	vector<ProxyId> order;
+	vector<float> maxX(n);
+	vector<float> lanes(5 * padded, 0.0f);
+	float* minX = lanes.data();
+	float* minY = minX + padded;
+	float* maxY = minY + padded;
+	float* minZ = maxY + padded;
+	float* maxZ = minZ + padded;
+
+	order.reserve(n);
+	for (const Endpoint& e : _endpoints[0])
+	{
+		if (e.Owner & 1)
+			continue;
+
+		const Proxy& p = _proxies[e.Owner >> 1];
+		size_t i = order.size();
+		order.push_back((ProxyId)(e.Owner >> 1));
+		minX[i] = p.Extents[0].Minimum;
+		maxX[i] = p.Extents[0].Maximum;
+		minY[i] = p.Extents[1].Minimum;
+		maxY[i] = p.Extents[1].Maximum;
+		minZ[i] = p.Extents[2].Minimum;
+		maxZ[i] = p.Extents[2].Maximum;
+	}
+
+	vector<uint64_t> found;
+	Details::ParallelCollect(n, SweepGranularity, parallel, found, [&](size_t begin, size_t end, vector<uint64_t>& pairs)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			auto xi = L::Splat(maxX[i]);
+			auto loY = L::Splat(minY[i]), hiY = L::Splat(maxY[i]);
+			auto loZ = L::Splat(minZ[i]), hiZ = L::Splat(maxZ[i]);
+
+			for (size_t j = i + 1; j < n && minX[j] <= maxX[i]; j += L::Width)
+			{
+				auto mask = L::MaskAnd(L::LessOrEqual(L::LoadUnaligned(minX + j), xi),
+					L::MaskAnd(L::MaskAnd(L::LessOrEqual(L::LoadUnaligned(minY + j), hiY), L::GreaterOrEqual(L::LoadUnaligned(maxY + j), loY)),
+						L::MaskAnd(L::LessOrEqual(L::LoadUnaligned(minZ + j), hiZ), L::GreaterOrEqual(L::LoadUnaligned(maxZ + j), loZ))));
+
+				uint32_t bits = L::MaskBits(mask);
+				if (n - j < (size_t)L::Width)
+					bits &= (1u << (n - j)) - 1;
+
+				for (; bits; bits &= bits - 1)
+				{
+					ProxyId a = order[i], b = order[j + Details::LowestBit(bits)];
+					if (isNew[a] || isNew[b])
+						pairs.push_back(PairKey(a, b));
+				}
+			}
+		}
+	});
+
+	for (uint64_t key : found)
+		AddPair(PairOf(key).first, PairOf(key).second);
+}
+
+void SweepAndPrune::Remove(ProxyId proxy)
+{
+	Validate(proxy, "proxy");
+
+	// Carrying the minimum past every maximum after it ends each pair the proxy is in. The endpoints are then
+	// the last two and can be dropped.
+	for (int k = 0; k < 3; k++)
+	{
+		SortUp(k, _proxies[proxy].Max[k], true);
+		SortUp(k, _proxies[proxy].Min[k], true);
+		_endpoints[k].resize(_endpoints[k].size() - 2);
+	}
+
+	Proxy& p = _proxies[proxy];
+	p.Min[0] = FreeMarker;
+	p.Max[0] = (uint32_t)_free;
+	_free = proxy;
+	_count--;
+}
+
+void SweepAndPrune::Move(ProxyId proxy, const BoundingBoxA& box)
+{
+	Validate(proxy, "proxy");
+	if (!box.GetExists())
+		throw ArgumentException("box", "Box holds nothing");
+
+	Range old[3] = { _proxies[proxy].Extents[0], _proxies[proxy].Extents[1], _proxies[proxy].Extents[2] };
+	SetExtents(proxy, box);
+
+	for (int k = 0; k < 3; k++)
+	{
+		const Range& extent = _proxies[proxy].Extents[k];
+		auto& endpoints = _endpoints[k];
+		endpoints[_proxies[proxy].Min[k]].Value = extent.Minimum;
+		endpoints[_proxies[proxy].Max[k]].Value = extent.Maximum;
+
+		// Growing before shrinking, so the minimum never passes the proxy's own maximum
+		if (extent.Minimum < old[k].Minimum)
+			SortDown(k, _proxies[proxy].Min[k]);
+		if (extent.Maximum > old[k].Maximum)
+			SortUp(k, _proxies[proxy].Max[k]);
+		if (extent.Minimum > old[k].Minimum)
+			SortUp(k, _proxies[proxy].Min[k]);
+		if (extent.Maximum < old[k].Maximum)
+			SortDown(k, _proxies[proxy].Max[k]);
+	}
+}
+
+BoundingBoxA SweepAndPrune::GetBox(ProxyId proxy) const
+{
+	Validate(proxy, "proxy");
+	const Range* e = _proxies[proxy].Extents;
+	return BoundingBoxA(Float3A(e[0].Minimum, e[1].Minimum, e[2].Minimum), Float3A(e[0].Maximum, e[1].Maximum, e[2].Maximum));
+}
+
+Range SweepAndPrune::GetExtent(ProxyId proxy, int axis) const
+{
+	Validate(proxy, "proxy");
+	if (axis < 0 || axis > 2)
+		throw ArgumentException("axis", "Axis must be 0, 1 or 2");
+	return _proxies[proxy].Extents[axis];
+}
+
+bool SweepAndPrune::Contains(ProxyId proxy) const
+{
+	return proxy >= 0 && proxy < (int)_proxies.size() && _proxies[proxy].Min[0] != FreeMarker;
+}
+
+size_t SweepAndPrune::GetPairs(vector<pair<ProxyId, ProxyId>>& outPairs) const
+{
+	vector<uint64_t> keys(_pairs.begin(), _pairs.end());
+	sort(keys.begin(), keys.end());
+
+	outPairs.reserve(outPairs.size() + keys.size());
+	for (uint64_t key : keys)
+		outPairs.push_back(PairOf(key));
+	return keys.size();
+}
+
+size_t SweepAndPrune::TakePairChanges(vector<pair<ProxyId, ProxyId>>* outBegun, vector<pair<ProxyId, ProxyId>>* outEnded)
+{
+	vector<uint64_t> keys(_changed.begin(), _changed.end());
+	sort(keys.begin(), keys.end());
+	_changed.clear();
+
+	for (uint64_t key : keys)
+	{
+		auto* out = _pairs.count(key) ? outBegun : outEnded;
+		if (out)
+			out->push_back(PairOf(key));
+	}
+	return keys.size();
+}
+
+SweepAndPrune::ProxyId SweepAndPrune::AllocateProxy()
+{
+	ProxyId proxy;
+	if (_free != None)
+	{
+		proxy = _free;
+		_free = (int)_proxies[proxy].Max[0];
+	}
+	else
+	{
+		if (_proxies.size() >= (size_t)INT32_MAX)
+			throw Exception("Too many proxies");
+		proxy = (ProxyId)_proxies.size();
+		_proxies.emplace_back();
+	}
+
+	_proxies[proxy].Min[0] = 0;
+	_count++;
+	return proxy;
+}
+
+void SweepAndPrune::Validate(ProxyId proxy, const char* argName) const
+{
+	if (!Contains(proxy))
+		throw ArgumentException(argName, "Not a proxy in this broadphase");
+}
+
+void SweepAndPrune::SetExtents(ProxyId proxy, const BoundingBoxA& box)
+{
+	const float* minima = (const float*)&box.Minima;
+	const float* maxima = (const float*)&box.Maxima;
+	for (int k = 0; k < 3; k++)
+		_proxies[proxy].Extents[k] = Range(minima[k], maxima[k]);
+}
+
+void SweepAndPrune::AddPair(ProxyId a, ProxyId b)
+{
+	uint64_t key = PairKey(a, b);
+	if (_pairs.insert(key).second && !_changed.erase(key))
+		_changed.insert(key);
+}
+
+void SweepAndPrune::RemovePair(ProxyId a, ProxyId b)
+{
+	uint64_t key = PairKey(a, b);
+	if (_pairs.erase(key) && !_changed.erase(key))
+		_changed.insert(key);
+}
+
+// A minimum moving down past another proxy's maximum may begin a pair, and a maximum moving down past a minimum
+// ends one. Moving up is the reverse. A pair only begins if the boxes overlap on every axis.
+uint64_t SweepAndPrune::SortKey(const Endpoint& e)
+{
+	return (uint64_t)OrderedBits(e.Value) << 1 | (e.Owner & 1);
+}
+
+void SweepAndPrune::SortEndpoints(vector<Endpoint>& endpoints)
+{
+	size_t n = endpoints.size();
+	if (n < 2)
+		return;
+
+	// One read of the array counts the digits of every pass
+	vector<size_t> counts(RadixPasses * RadixBuckets);
+	for (const Endpoint& e : endpoints)
+	{
+		uint64_t key = SortKey(e);
+		for (int pass = 0; pass < RadixPasses; pass++)
+			counts[pass * RadixBuckets + (key >> (pass * RadixBits) & (RadixBuckets - 1))]++;
+	}
+
+	// Each pass scatters stably by one digit, lowest first, so earlier digits break the ties of later ones
+	vector<Endpoint> scratch(n);
+	Endpoint* from = endpoints.data();
+	Endpoint* to = scratch.data();
+	for (int pass = 0; pass < RadixPasses; pass++)
+	{
+		int shift = pass * RadixBits;
+		size_t* offsets = &counts[pass * RadixBuckets];
+
+		// A digit every key shares leaves the order as it is, as for the upper bits of values close together
+		if (offsets[SortKey(from[0]) >> shift & (RadixBuckets - 1)] == n)
+			continue;
+
+		size_t sum = 0;
+		for (uint32_t b = 0; b < RadixBuckets; b++)
+		{
+			size_t c = offsets[b];
+			offsets[b] = sum;
+			sum += c;
+		}
+		for (size_t i = 0; i < n; i++)
+			to[offsets[SortKey(from[i]) >> shift & (RadixBuckets - 1)]++] = from[i];
+		swap(from, to);
+	}
+
+	if (from != endpoints.data())
+		endpoints.swap(scratch);
+}
+
+void SweepAndPrune::SortDown(int axis, uint32_t position)
+{
+	auto& endpoints = _endpoints[axis];
+	Endpoint moving = endpoints[position];
+	ProxyId self = (ProxyId)(moving.Owner >> 1);
+	bool isMax = (moving.Owner & 1) != 0;
+	const Proxy& p = _proxies[self];
+
+	for (; position > 0 && Before(moving, endpoints[position - 1]); position--)
+	{
+		const Endpoint& other = endpoints[position - 1];
+		ProxyId o = (ProxyId)(other.Owner >> 1);
+		bool otherMax = (other.Owner & 1) != 0;
+
+		if (o != self && isMax != otherMax)
+		{
+			if (!isMax)
+			{
+				const Proxy& q = _proxies[o];
+				if (Overlaps(p.Extents[0], q.Extents[0]) && Overlaps(p.Extents[1], q.Extents[1]) && Overlaps(p.Extents[2], q.Extents[2]))
+					AddPair(self, o);
+			}
+			else
+			{
+				RemovePair(self, o);
+			}
+		}
+
+		endpoints[position] = other;
+		PositionOf(other, axis) = position;
+	}
+
+	endpoints[position] = moving;
+	PositionOf(moving, axis) = position;
+}
+
+void SweepAndPrune::SortUp(int axis, uint32_t position, bool toEnd)
+{
+	auto& endpoints = _endpoints[axis];
+	Endpoint moving = endpoints[position];
+	ProxyId self = (ProxyId)(moving.Owner >> 1);
+	bool isMax = (moving.Owner & 1) != 0;
+	const Proxy& p = _proxies[self];
+	uint32_t last = (uint32_t)endpoints.size() - 1;
+
+	for (; position < last && (toEnd || Before(endpoints[position + 1], moving)); position++)
+	{
+		const Endpoint& other = endpoints[position + 1];
+		ProxyId o = (ProxyId)(other.Owner >> 1);
+		bool otherMax = (other.Owner & 1) != 0;
+
+		if (o != self && isMax != otherMax)
+		{
+			if (!isMax)
+			{
+				RemovePair(self, o);
+			}
+			else if (!toEnd)
+			{
+				const Proxy& q = _proxies[o];
+				if (Overlaps(p.Extents[0], q.Extents[0]) && Overlaps(p.Extents[1], q.Extents[1]) && Overlaps(p.Extents[2], q.Extents[2]))
+					AddPair(self, o);
+			}
+		}
+
+		endpoints[position] = other;
+		PositionOf(other, axis) = position;
+	}
+
+	endpoints[position] = moving;
+	PositionOf(moving, axis) = position;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <unordered_set>
+
+namespace CS
+{
+	// A sweep-and-prune broadphase: the Range each box spans on each axis, with the endpoints of every axis kept
+	// in a sorted array. It suits scenes that are mostly static, or move a little each step, where it's cheaper
+	// than a tree.
+	//
+	// Moving a box re-sorts its endpoints with insertion sort, so the cost follows how many other endpoints
+	// they pass, which is few when motion is coherent. A pair of boxes starts or stops overlapping only when the
+	// endpoints of one pass those of the other, so the set of overlapping pairs is kept up to date as they do.
+	// InsertMany instead radix sorts the arrays afresh, one axis per thread, on keys made from the bits of each
+	// endpoint's value, and finds the new pairs with a sweep along x that tests the candidates' y and z ranges
+	// several at a time.
+	//
+	// Boxes that only touch overlap.
+	class SweepAndPrune
+	{
+	public:
+		typedef int ProxyId;
+		static const ProxyId None = -1;
+
+		SweepAndPrune();
+
+		// Ids stay valid until the proxy is removed and may be reused afterwards. Throws ArgumentException if box
+		// holds nothing.
+		ProxyId Insert(const BoundingBoxA& box);
+		// Inserts many proxies, re-sorting the three axes and sweeping for pairs across worker threads unless
+		// parallel is false. outProxies, if not null, receives the id of each.
+		void InsertMany(const BoundingBoxA* boxes, size_t count, ProxyId* outProxies = nullptr, bool parallel = true);
+		void Remove(ProxyId proxy);
+
+		void Move(ProxyId proxy, const BoundingBoxA& box);
+
+		PROPERTY_INDEXABLE_READONLY(BoundingBoxA, Box);
+		BoundingBoxA GetBox(ProxyId proxy) const;
+
+		// The range the proxy spans on axis 0 (x), 1 (y) or 2 (z)
+		Range GetExtent(ProxyId proxy, int axis) const;
+
+		bool Contains(ProxyId proxy) const;
+
+		PROPERTY_READONLY(size_t, Count);
+		size_t GetCount() const { return _count; }
+
+		PROPERTY_READONLY(size_t, PairCount);
+		size_t GetPairCount() const { return _pairs.size(); }
+
+		// Every overlapping pair, each once with first < second, appended to outPairs in order. Returns how many
+		// were appended.
+		size_t GetPairs(std::vector<std::pair<ProxyId, ProxyId>>& outPairs) const;
+
+		// The pairs that began or ended overlapping since the last call, each in order, with first < second. A pair
+		// that began and ended in between is in neither; pairs ended by Remove are included. Returns the number
+		// of changes.
+		size_t TakePairChanges(std::vector<std::pair<ProxyId, ProxyId>>* outBegun, std::vector<std::pair<ProxyId, ProxyId>>* outEnded);
+
+	private:
+		// Endpoints sort by value, with minima before maxima of the same value so touching ranges overlap
+		struct Endpoint
+		{
+			float Value;
+			// The proxy in the upper bits, and whether this is its maximum in bit 0
+			uint32_t Owner;
+		};
+
+		// Free proxies have UINT32_MAX in Min[0] and link the free list through Max[0]
+		struct Proxy
+		{
+			Range Extents[3];
+			// Where the proxy's endpoints are in each axis' array
+			uint32_t Min[3];
+			uint32_t Max[3];
+		};
+
+		std::vector<Endpoint> _endpoints[3];
+		std::vector<Proxy> _proxies;
+		int _free;
+		size_t _count;
+		// Pairs as first in the upper 32 bits and second in the lower
+		std::unordered_set<uint64_t> _pairs;
+		// Pairs whose overlap has changed an odd number of times since the last TakePairChanges
+		std::unordered_set<uint64_t> _changed;
+
+		static inline bool Before(const Endpoint& a, const Endpoint& b)
+		{
+			return a.Value < b.Value || (a.Value == b.Value && (a.Owner & 1) < (b.Owner & 1));
+		}
+
+		// A key whose unsigned order is that of Before: the value's bits made to order as the float does, then
+		// the maximum bit. Values must not be NaN, which boxes that hold something can't have.
+		static uint64_t SortKey(const Endpoint& e);
+		// Sorts the endpoints into the order of Before with a stable LSD radix sort of their SortKeys
+		static void SortEndpoints(std::vector<Endpoint>& endpoints);
+
+		// The field of the endpoint's proxy that records where it is on axis
+		inline uint32_t& PositionOf(const Endpoint& e, int axis)
+		{
+			return (e.Owner & 1) ? _proxies[e.Owner >> 1].Max[axis] : _proxies[e.Owner >> 1].Min[axis];
+		}
+
+		ProxyId AllocateProxy();
+		void Validate(ProxyId proxy, const char* argName) const;
+		void SetExtents(ProxyId proxy, const BoundingBoxA& box);
+		void AddPair(ProxyId a, ProxyId b);
+		void RemovePair(ProxyId a, ProxyId b);
+		// Insertion sort of one endpoint towards the start or end of its array. Moving to the end regardless of
+		// value is how Remove takes a proxy out.
+		void SortDown(int axis, uint32_t position);
+		void SortUp(int axis, uint32_t position, bool toEnd = false);
+	};
+}
@@ -0,0 +1,392 @@
+#include "Sharpish.h"
+#include "TransformHierarchy.h"
+#include "MathParallel.h"
+#include <algorithm>
+#include <climits>
+
+using namespace CS;
+using namespace std;
+
+namespace
+{
+	// Subtrees at most this large are recomputed as one piece of work. Larger ones are split at their children.
+	const int ParallelSubtreeSize = 2048;
+
+	Float4x3A ToMatrix(const RFrame& frame)
+	{
+		XMMATRIX m = XMMatrixRotationQuaternion(frame.Rotation);
+		m.r[3] = XMVectorSetW(frame.Position, 1);
+		return m;
+	}
+
+	// Appends [begin, end), merging it into the previous range when they touch and the result stays under limit
+	void AddRange(vector<pair<int, int>>& ranges, int begin, int end, int limit)
+	{
+		if (!ranges.empty() && ranges.back().second == begin && end - ranges.back().first <= limit)
+			ranges.back().second = end;
+		else
+			ranges.emplace_back(begin, end);
+	}
+}
+
+TransformHierarchy::TransformHierarchy() :
+	_firstRoot(None),
+	_lastRoot(None),
+	_count(0),
+	_layoutCurrent(true)
+{
+}
+
+TransformHierarchy::NodeId TransformHierarchy::AddNode(NodeId parent, const Float4x3A& local)
+{
+	if (parent != None)
+		Validate(parent, "parent");
+
+	NodeId id;
+
+	if (_freeIds.empty())
+	{
+		id = (NodeId)_nodes.size();
+		_nodes.emplace_back();
+	}
+	else
+	{
+		id = _freeIds.back();
+		_freeIds.pop_back();
+	}
+
+	_nodes[id] = Node { None, None, None, None, None, -1 };
+	Link(id, parent);
+
+	int index = (int)_ids.size();
+	int parentIndex = parent == None ? -1 : _nodes[parent].Index;
+	_nodes[id].Index = index;
+
+	_ids.push_back(id);
+	_parents.push_back(parentIndex);
+	_ends.push_back(index + 1);
+	_locals.push_back(local);
+	_worlds.push_back(Float4x3A::Identity);
+
+	if ((index & 63) == 0)
+		_dirty.push_back(0);
+	MarkDirty(index);
+
+	// A new root, or a child of the node whose subtree ends the storage, keeps the depth-first layout intact
+	if (_layoutCurrent && parentIndex >= 0)
+	{
+		if (_ends[parentIndex] == index)
+		{
+			for (NodeId p = parent; p != None; p = _nodes[p].Parent)
+				_ends[_nodes[p].Index] = index + 1;
+		}
+		else
+		{
+			_layoutCurrent = false;
+		}
+	}
+
+	_count++;
+	return id;
+}
+
+TransformHierarchy::NodeId TransformHierarchy::AddNode(NodeId parent, const RFrame& local)
+{
+	return AddNode(parent, ToMatrix(local));
+}
+
+void TransformHierarchy::RemoveNode(NodeId node)
+{
+	Validate(node, "node");
+	Unlink(node);
+
+	// Free the subtree depth-first. The links are still intact below node.
+	NodeId id = node;
+
+	for (;;)
+	{
+		if (_nodes[id].FirstChild != None)
+		{
+			id = _nodes[id].FirstChild;
+			continue;
+		}
+
+		for (;;)
+		{
+			NodeId next = id == node ? None : _nodes[id].NextSibling;
+			NodeId parent = _nodes[id].Parent;
+
+			_ids[_nodes[id].Index] = None;
+			_nodes[id].Index = -1;
+			_freeIds.push_back(id);
+			_count--;
+
+			if (id == node)
+			{
+				_layoutCurrent = false;
+				return;
+			}
+
+			if (next != None)
+			{
+				id = next;
+				break;
+			}
+
+			id = parent;
+		}
+	}
+}
+
+void TransformHierarchy::SetParent(NodeId node, NodeId parent)
+{
+	Validate(node, "node");
+
+	if (parent != None)
+	{
+		Validate(parent, "parent");
+
+		for (NodeId p = parent; p != None; p = _nodes[p].Parent)
+		{
+			if (p == node)
+				throw ArgumentException("parent", "A node cannot be parented to itself or its descendants");
+		}
+	}
+
+	Unlink(node);
+	Link(node, parent);
+
+	int index = _nodes[node].Index;
+	_parents[index] = parent == None ? -1 : _nodes[parent].Index;
+	MarkDirty(index);
+	_layoutCurrent = false;
+}
+
+TransformHierarchy::NodeId TransformHierarchy::GetParent(NodeId node) const
+{
+	Validate(node, "node");
+	return _nodes[node].Parent;
+}
+
+void TransformHierarchy::SetLocal(NodeId node, const Float4x3A& local)
+{
+	Validate(node, "node");
+	int index = _nodes[node].Index;
+	_locals[index] = local;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocal(NodeId node, const RFrame& local)
+{
+	SetLocal(node, ToMatrix(local));
+}
+
+Float4x3A TransformHierarchy::GetLocal(NodeId node) const
+{
+	Validate(node, "node");
+	return _locals[_nodes[node].Index];
+}
+
+Float4x3A TransformHierarchy::GetWorld(NodeId node) const
+{
+	Validate(node, "node");
+	return _worlds[_nodes[node].Index];
+}
+
+size_t TransformHierarchy::GetIndex(NodeId node) const
+{
+	Validate(node, "node");
+	return (size_t)_nodes[node].Index;
+}
+
+bool TransformHierarchy::Contains(NodeId node) const
+{
+	return node >= 0 && node < (NodeId)_nodes.size() && _nodes[node].Index >= 0;
+}
+
+size_t TransformHierarchy::Update()
+{
+	if (!_layoutCurrent)
+		Rebuild();
+
+	// Every dirty bit lies inside the subtree of the first dirty node at or before it, so walking subtree roots
+	// covers them all and the whole bitset can be cleared afterwards.
+	vector<int> roots;
+	int count = (int)_ids.size();
+	size_t recomputed = 0;
+	int i = 0;
+
+	while (i < count)
+	{
+		size_t word = (size_t)i >> 6;
+		uint64_t bits = _dirty[word] & (~0ull << (i & 63));
+
+		while (!bits && ++word < _dirty.size())
+			bits = _dirty[word];
+
+		if (!bits)
+			break;
+
+		i = (int)(word << 6) + Details::LowestBit(bits);
+		roots.push_back(i);
+		recomputed += _ends[i] - i;
+		i = _ends[i];
+	}
+
+	fill(_dirty.begin(), _dirty.end(), 0);
+
+	if (roots.empty())
+		return 0;
+
+	// Small subtrees become work items as they are. Large ones have their root computed up front, after which
+	// each child's subtree no longer depends on anything still to be computed.
+	vector<pair<int, int>> serial;
+	vector<pair<int, int>> items;
+	vector<int> pending;
+
+	for (auto root : roots)
+	{
+		pending.push_back(root);
+
+		while (!pending.empty())
+		{
+			int node = pending.back();
+			pending.pop_back();
+
+			if (_ends[node] - node <= ParallelSubtreeSize)
+			{
+				AddRange(items, node, _ends[node], ParallelSubtreeSize);
+				continue;
+			}
+
+			AddRange(serial, node, node + 1, INT_MAX);
+
+			size_t first = pending.size();
+			for (int child = node + 1; child < _ends[node]; child = _ends[child])
+				pending.push_back(child);
+			reverse(pending.begin() + first, pending.end());
+		}
+	}
+
+	for (auto& range : serial)
+		Help::Math::MultiplyByParents(_locals.data(), _parents.data(), _worlds.data(), range.first, range.second);
+
+	Details::ParallelFor(items.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t k = begin; k < end; k++)
+			Help::Math::MultiplyByParents(_locals.data(), _parents.data(), _worlds.data(), items[k].first, items[k].second);
+	});
+
+	return recomputed;
+}
+
+void TransformHierarchy::Validate(NodeId node, const char* argName) const
+{
+	if (!Contains(node))
+		throw ArgumentException(argName, "Not a node in this hierarchy");
+}
+
+void TransformHierarchy::Link(NodeId node, NodeId parent)
+{
+	NodeId& first = parent == None ? _firstRoot : _nodes[parent].FirstChild;
+	NodeId& last = parent == None ? _lastRoot : _nodes[parent].LastChild;
+
+	auto& n = _nodes[node];
+	n.Parent = parent;
+	n.PrevSibling = last;
+	n.NextSibling = None;
+
+	if (last == None)
+		first = node;
+	else
+		_nodes[last].NextSibling = node;
+
+	last = node;
+}
+
+void TransformHierarchy::Unlink(NodeId node)
+{
+	auto& n = _nodes[node];
+	NodeId& first = n.Parent == None ? _firstRoot : _nodes[n.Parent].FirstChild;
+	NodeId& last = n.Parent == None ? _lastRoot : _nodes[n.Parent].LastChild;
+
+	if (n.PrevSibling == None) first = n.NextSibling;
+	else _nodes[n.PrevSibling].NextSibling = n.NextSibling;
+
+	if (n.NextSibling == None) last = n.PrevSibling;
+	else _nodes[n.NextSibling].PrevSibling = n.PrevSibling;
+
+	n.Parent = None;
+	n.PrevSibling = None;
+	n.NextSibling = None;
+}
+
+void TransformHierarchy::Rebuild()
+{
+	vector<NodeId> ids;
+	vector<int> parents;
+	vector<int> ends;
+	vector<Float4x3A> locals;
+	vector<Float4x3A> worlds;
+	vector<uint64_t> dirty((_count + 63) / 64, 0);
+
+	ids.reserve(_count);
+	parents.reserve(_count);
+	locals.reserve(_count);
+	worlds.reserve(_count);
+
+	for (NodeId root = _firstRoot; root != None; root = _nodes[root].NextSibling)
+	{
+		NodeId id = root;
+
+		for (;;)
+		{
+			// Parents are visited first, so their Index already refers to the new layout
+			int newIndex = (int)ids.size();
+			int oldIndex = _nodes[id].Index;
+			NodeId parent = _nodes[id].Parent;
+
+			ids.push_back(id);
+			parents.push_back(parent == None ? -1 : _nodes[parent].Index);
+			locals.push_back(_locals[oldIndex]);
+			worlds.push_back(_worlds[oldIndex]);
+
+			if (_dirty[oldIndex >> 6] & (1ull << (oldIndex & 63)))
+				dirty[newIndex >> 6] |= 1ull << (newIndex & 63);
+
+			_nodes[id].Index = newIndex;
+
+			if (_nodes[id].FirstChild != None)
+			{
+				id = _nodes[id].FirstChild;
+				continue;
+			}
+
+			while (id != root && _nodes[id].NextSibling == None)
+				id = _nodes[id].Parent;
+
+			if (id == root)
+				break;
+
+			id = _nodes[id].NextSibling;
+		}
+	}
+
+	ends.resize(ids.size());
+	for (int i = 0; i < (int)ids.size(); i++)
+		ends[i] = i + 1;
+
+	for (int i = (int)ids.size() - 1; i >= 0; i--)
+	{
+		if (parents[i] >= 0 && ends[parents[i]] < ends[i])
+			ends[parents[i]] = ends[i];
+	}
+
+	_ids.swap(ids);
+	_parents.swap(parents);
+	_ends.swap(ends);
+	_locals.swap(locals);
+	_worlds.swap(worlds);
+	_dirty.swap(dirty);
+	_layoutCurrent = true;
+}
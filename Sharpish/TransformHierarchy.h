@@ -0,0 +1,90 @@
+#pragma once
+
+namespace CS
+{
+	// A scene graph of local transforms that keeps world transforms up to date incrementally.
+	//
+	// Nodes are stored depth-first in flat arrays, each with the index of its parent, so every subtree occupies a
+	// contiguous range and parents precede their children. Changing a local transform only sets that node's
+	// dirty bit; Update() recomputes the world transforms of dirty nodes and their descendants and nothing else,
+	// splitting large subtrees across worker threads.
+	//
+	// World transforms follow the row-vector convention: world = local * parent world.
+	class TransformHierarchy
+	{
+	public:
+		typedef int NodeId;
+		static const NodeId None = -1;
+
+		TransformHierarchy();
+
+		// Adds a node as the last child of parent, or as a new root if parent is None. Ids stay valid until the
+		// node is removed and may be reused afterwards. Adding children in depth-first order is cheapest.
+		NodeId AddNode(NodeId parent, const Float4x3A& local);
+		NodeId AddNode(NodeId parent, const RFrame& local);
+
+		// Removes node and all of its descendants.
+		void RemoveNode(NodeId node);
+
+		// Moves node (with its descendants) to the end of parent's children, or makes it a root if parent is
+		// None. Throws ArgumentException if parent is node or one of its descendants.
+		void SetParent(NodeId node, NodeId parent);
+		NodeId GetParent(NodeId node) const;
+
+		void SetLocal(NodeId node, const Float4x3A& local);
+		void SetLocal(NodeId node, const RFrame& local);
+		Float4x3A GetLocal(NodeId node) const;
+
+		// The world transform as of the last Update.
+		Float4x3A GetWorld(NodeId node) const;
+
+		// Recomputes the world transforms of dirty nodes and their descendants. Returns the number of nodes
+		// recomputed.
+		size_t Update();
+
+		bool Contains(NodeId node) const;
+
+		PROPERTY_READONLY(size_t, Count);
+		size_t GetCount() const { return _count; }
+
+		// World transforms for every slot in storage order, valid after Update until the next structural change.
+		// GetIndex maps a node to its slot. Use these to upload a whole hierarchy without per-node lookups.
+		PROPERTY_READONLY(const Float4x3A*, WorldTransforms);
+		const Float4x3A* GetWorldTransforms() const { return _worlds.data(); }
+		size_t GetIndex(NodeId node) const;
+
+	private:
+		struct Node
+		{
+			NodeId Parent;
+			NodeId FirstChild;
+			NodeId LastChild;
+			NodeId PrevSibling;
+			NodeId NextSibling;
+			int Index;
+		};
+
+		// Per node id
+		std::vector<Node> _nodes;
+		std::vector<NodeId> _freeIds;
+		NodeId _firstRoot;
+		NodeId _lastRoot;
+
+		// Per slot, depth-first once the layout is current
+		std::vector<NodeId> _ids;
+		std::vector<int> _parents;
+		std::vector<int> _ends;
+		std::vector<Float4x3A> _locals;
+		std::vector<Float4x3A> _worlds;
+		std::vector<uint64_t> _dirty;
+
+		size_t _count;
+		bool _layoutCurrent;
+
+		void Validate(NodeId node, const char* argName) const;
+		void Link(NodeId node, NodeId parent);
+		void Unlink(NodeId node);
+		void MarkDirty(int index) { _dirty[index >> 6] |= 1ull << (index & 63); }
+		void Rebuild();
+	};
+}
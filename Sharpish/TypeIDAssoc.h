@@ -37,6 +37,23 @@ IS_GENERIC_VALUETYPE(2, std::vector, "4F2285D6-EB3E-4045-A5AE-D67371E0E9D4");
 IS_VALUETYPE(D3DCOLORVALUE, "D6C53DE3-EA86-4187-84A1-3C2A509E9F9A");
 IS_VALUETYPE(UUID, "5AD11C16-6A46-4B57-B2AA-1793E2F0DF1E");
 
+namespace std
+{
+	template<>
+	struct hash<UUID>
+	{
+		size_t operator()(const UUID& id) const
+		{
+			auto arr = (const size_t*)&id;
+
+			if (sizeof(size_t) == 8)
+				return arr[0] ^ arr[1];
+			else
+				return arr[0] ^ arr[1] ^ arr[2] ^ arr[3];
+		}
+	};
+}
+
 IS_INTERFACE(IUnknown);
 IS_INTERFACE(Ext::IWeakReference);
 IS_INTERFACE(Ext::IWeakReferenceSource);
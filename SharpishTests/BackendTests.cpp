@@ -0,0 +1,141 @@
+#include "Test.h"
+
+// The same checks run against every backend MathBackend.h can select (build with SHARPISH_MATH_SCALAR,
+// SHARPISH_MATH_SSE2, SHARPISH_MATH_SSE4 or SHARPISH_MATH_AVX2 defined). Each backend must match a double
+// precision reference within the tolerances below, so any two backends agree to within twice them. They are
+// not bit-identical: the AVX2 backend fuses multiplies and adds that the others round separately.
+
+using namespace CS;
+using namespace SharpishTests;
+
+namespace
+{
+	// Relative to the magnitude of the result, or absolute below 1
+	const double Tolerance = 4e-6;
+
+	double Bound(double expected) { return Tolerance * (std::fabs(expected) > 1 ? std::fabs(expected) : 1); }
+
+	struct D3
+	{
+		double X, Y, Z;
+		D3(const Float3& v) : X(v.X), Y(v.Y), Z(v.Z) { }
+		D3(double x, double y, double z) : X(x), Y(y), Z(z) { }
+		double Dot(const D3& b) const { return X * b.X + Y * b.Y + Z * b.Z; }
+		D3 Cross(const D3& b) const { return D3(Y * b.Z - Z * b.Y, Z * b.X - X * b.Z, X * b.Y - Y * b.X); }
+		// Rounded to floats for CheckNear, far inside the tolerance
+		operator XMVECTOR() const { return XMVectorSet((float)X, (float)Y, (float)Z, 0); }
+	};
+
+	void ToDoubles(const Float4x4A& m, double out[16])
+	{
+		Float4x4 u = m;
+		for (int i = 0; i < 16; i++)
+			out[i] = ((const float*)&u)[i];
+	}
+
+	Float4x4A RandomAffine(Random& random)
+	{
+		auto rotation = QuaternionA::FromPitchYawRoll(random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f));
+		return XMMatrixAffineTransformation(Float3A(random.NextFloat3(0.5f, 2)), XMVectorZero(), rotation, Float3A(random.NextFloat3(-10, 10)));
+	}
+}
+
+TEST(Backend_VectorArithmetic)
+{
+	Random random(3);
+	for (int i = 0; i < 1000; i++)
+	{
+		Float3 a = random.NextFloat3(-10, 10), b = random.NextFloat3(-10, 10);
+		D3 da(a), db(b);
+		Float3A aa = a, ab = b;
+
+		CheckNear(aa + ab, D3(da.X + db.X, da.Y + db.Y, da.Z + db.Z), Tolerance);
+		CheckNear(aa - ab, D3(da.X - db.X, da.Y - db.Y, da.Z - db.Z), Tolerance);
+		CheckNear(aa * ab, D3(da.X * db.X, da.Y * db.Y, da.Z * db.Z), Tolerance);
+		CheckNear(aa * 1.5f, D3(da.X * 1.5, da.Y * 1.5, da.Z * 1.5), Tolerance);
+		CheckNear(aa.Cross(ab), da.Cross(db), Tolerance, 100);
+		CHECK_NEAR(aa.Dot(ab), da.Dot(db), Bound(300));
+		CHECK_NEAR(aa.GetLength(), std::sqrt(da.Dot(da)), Bound(std::sqrt(da.Dot(da))));
+
+		double length = std::sqrt(da.Dot(da));
+		CheckNear(aa.Normalize(), D3(da.X / length, da.Y / length, da.Z / length), Tolerance);
+		CheckNear(Float3A::Lerp(aa, ab, 0.25f), D3(da.X + (db.X - da.X) * 0.25, da.Y + (db.Y - da.Y) * 0.25, da.Z + (db.Z - da.Z) * 0.25), Tolerance);
+	}
+}
+
+TEST(Backend_QuaternionRotation)
+{
+	Random random(5);
+	for (int i = 0; i < 1000; i++)
+	{
+		D3 axis = D3(random.NextFloat3(-1, 1));
+		double norm = std::sqrt(axis.Dot(axis));
+		if (norm < 0.1)
+			continue;
+		axis = D3(axis.X / norm, axis.Y / norm, axis.Z / norm);
+		double angle = random.Next(-3.0f, 3.0f);
+
+		auto q = QuaternionA::FromNormalAxisAngle(Float3A((float)axis.X, (float)axis.Y, (float)axis.Z), (float)angle);
+		Float3 v = random.NextFloat3(-10, 10);
+
+		// Rodrigues' rotation formula
+		D3 dv(v), kxv = axis.Cross(dv);
+		double c = std::cos(angle), s = std::sin(angle), kdv = axis.Dot(dv) * (1 - c);
+		D3 expected(dv.X * c + kxv.X * s + axis.X * kdv, dv.Y * c + kxv.Y * s + axis.Y * kdv, dv.Z * c + kxv.Z * s + axis.Z * kdv);
+
+		CheckNear(Float3A(v).Rotate(q), expected, Tolerance);
+		CHECK_NEAR((q * q.GetInverse()).GetW(), 1, Tolerance);
+		CHECK_NEAR(q.GetLength(), 1, Tolerance);
+	}
+}
+
+TEST(Backend_MatrixProductsAndInverse)
+{
+	Random random(7);
+	for (int i = 0; i < 500; i++)
+	{
+		Float4x4A a = RandomAffine(random), b = RandomAffine(random);
+		double da[16], db[16], product[16];
+		ToDoubles(a, da);
+		ToDoubles(b, db);
+		ToDoubles(a * b, product);
+
+		for (int r = 0; r < 4; r++)
+			for (int c = 0; c < 4; c++)
+			{
+				double expected = 0;
+				for (int k = 0; k < 4; k++)
+					expected += da[r * 4 + k] * db[k * 4 + c];
+				CHECK_NEAR(product[r * 4 + c], expected, Bound(expected) * 4);
+			}
+
+		double identity[16];
+		ToDoubles(a * a.GetInverse(), identity);
+		for (int k = 0; k < 16; k++)
+			CHECK_NEAR(identity[k], (k % 5) ? 0.0 : 1.0, 2e-5);
+
+		Float4 p(random.NextFloat3(-10, 10), 1);
+		Float4A transformed = Float4A(p).Transform(a);
+		double expected[4] = { 0, 0, 0, 0 }, dp[4] = { p.X, p.Y, p.Z, p.W };
+		for (int c = 0; c < 4; c++)
+			for (int k = 0; k < 4; k++)
+				expected[c] += dp[k] * da[k * 4 + c];
+		CHECK_NEAR(transformed.GetX(), expected[0], Bound(expected[0]) * 4);
+		CHECK_NEAR(transformed.GetY(), expected[1], Bound(expected[1]) * 4);
+		CHECK_NEAR(transformed.GetZ(), expected[2], Bound(expected[2]) * 4);
+		CHECK_NEAR(transformed.GetW(), expected[3], Bound(expected[3]) * 4);
+	}
+}
+
+TEST(Backend_Comparisons)
+{
+	Float3A a(1, 2, 3), b(1, 5, -3);
+	CHECK(a == Float3A(1, 2, 3));
+	CHECK(a != b);
+	CHECK(Float3A(a.GetX(), a.GetY(), a.GetZ()) == a);
+
+	auto less = a.GetComponentWise() < b;
+	CHECK(!less.GetX());
+	CHECK(less.GetY());
+	CHECK(!less.GetZ());
+}
@@ -0,0 +1,108 @@
+#include "Test.h"
+
+// The Float3 and Float3A array kernels in Help::Math against the single-vector DirectXMath functions, at every
+// SIMD level, for counts that fill registers exactly and that leave a remainder, and in place.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	const size_t Counts[] = { 0, 1, 3, 8, 17, 67, 1000 };
+	const double Tolerance = 1e-5;
+
+	// The kernels clear W of Float3A results, which Float3 has no room for
+	template<typename T> void CheckW(const T&) { }
+	void CheckW(const Float3A& v) { CHECK(Float4A(v).GetW() == 0); }
+
+	template<typename T>
+	std::vector<T> Vectors(size_t count, uint32_t seed)
+	{
+		Random random(seed);
+		std::vector<T> vectors(count);
+		for (auto& v : vectors)
+			v = T(Float3A(random.NextFloat3(-20, 20)));
+		return vectors;
+	}
+
+	template<typename T>
+	void CheckKernels()
+	{
+		Float3A v(0.3f, -2, 5);
+		ForEachSimdLevel([&](SimdLevel)
+		{
+			for (size_t count : Counts)
+			{
+				auto a = Vectors<T>(count, 71);
+				auto b = Vectors<T>(count, 72);
+				std::vector<T> out(count);
+				std::vector<float> scalars(count);
+
+				Help::Math::Normalize(a.data(), out.data(), count);
+				for (size_t i = 0; i < count; i++)
+				{
+					CheckNear(Float3(out[i]), XMVector3Normalize(Float3A(a[i])), Tolerance);
+					CheckW(out[i]);
+				}
+
+				Help::Math::Length(a.data(), scalars.data(), count);
+				for (size_t i = 0; i < count; i++)
+					CHECK_NEAR(scalars[i], XMVectorGetX(XMVector3Length(Float3A(a[i]))), Tolerance * scalars[i]);
+
+				Help::Math::Dot(a.data(), v, scalars.data(), count);
+				for (size_t i = 0; i < count; i++)
+					CHECK_NEAR(scalars[i], XMVectorGetX(XMVector3Dot(Float3A(a[i]), v)), 1e-4);
+
+				Help::Math::Cross(a.data(), b.data(), out.data(), count);
+				for (size_t i = 0; i < count; i++)
+					CheckNear(Float3(out[i]), XMVector3Cross(Float3A(a[i]), Float3A(b[i])), Tolerance);
+
+				Help::Math::Lerp(a.data(), b.data(), 0.25f, out.data(), count);
+				for (size_t i = 0; i < count; i++)
+					CheckNear(Float3(out[i]), XMVectorLerp(Float3A(a[i]), Float3A(b[i]), 0.25f), Tolerance);
+
+				Help::Math::Min(a.data(), b.data(), out.data(), count);
+				for (size_t i = 0; i < count; i++)
+					CheckNear(Float3(out[i]), XMVectorMin(Float3A(a[i]), Float3A(b[i])), Tolerance);
+
+				Help::Math::Max(a.data(), b.data(), out.data(), count);
+				for (size_t i = 0; i < count; i++)
+					CheckNear(Float3(out[i]), XMVectorMax(Float3A(a[i]), Float3A(b[i])), Tolerance);
+
+				Help::Math::ScaleAdd(a.data(), -1.5f, b.data(), out.data(), count);
+				for (size_t i = 0; i < count; i++)
+					CheckNear(Float3(out[i]), XMVectorMultiplyAdd(Float3A(a[i]), XMVectorReplicate(-1.5f), Float3A(b[i])), Tolerance);
+
+				// In place
+				auto copy = a;
+				Help::Math::Normalize(a.data(), a.data(), count);
+				for (size_t i = 0; i < count; i++)
+					CheckNear(Float3(a[i]), XMVector3Normalize(Float3A(copy[i])), Tolerance);
+			}
+		});
+	}
+}
+
+TEST(Batch_Float3KernelsMatchDirectXMath)
+{
+	CheckKernels<Float3>();
+}
+
+TEST(Batch_Float3AKernelsMatchDirectXMath)
+{
+	CheckKernels<Float3A>();
+}
+
+TEST(Batch_NormalizeZero)
+{
+	std::vector<Float3A> zeros(19, Float3A(0, 0, 0));
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		std::vector<Float3A> out(zeros.size(), Float3A(1, 1, 1));
+		Help::Math::Normalize(zeros.data(), out.data(), zeros.size());
+		for (auto& v : out)
+			CHECK(v.GetX() == 0 && v.GetY() == 0 && v.GetZ() == 0);
+	});
+}
@@ -0,0 +1,189 @@
+#include "Test.h"
+#include <algorithm>
+#include <cfloat>
+
+// BoundingBoxA::Transform against the box around the eight transformed corners in double precision, and the
+// batch transforms against the single-box one, at every SIMD level.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	// A partial register, whole registers, and more than one thread's share
+	const size_t Counts[] = { 0, 1, 7, 16, 33, 10000 };
+
+	// Scaled, some mirrored, rotated, sheared and translated
+	Float4x3A RandomMatrix(Random& random, size_t i)
+	{
+		XMMATRIX shear = XMMatrixIdentity();
+		shear.r[0] = XMVectorSet(1, random.Next(-0.5f, 0.5f), random.Next(-0.5f, 0.5f), 0);
+		auto scale = XMVectorSet(random.Next(0.2f, 5.0f) * (i % 5 == 4 ? -1 : 1), random.Next(0.2f, 5.0f), random.Next(0.2f, 5.0f), 0);
+		auto rotation = XMQuaternionRotationRollPitchYaw(random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f));
+		auto translation = XMVectorSet(random.Next(-100.0f, 100.0f), random.Next(-100.0f, 100.0f), random.Next(-100.0f, 100.0f), 0);
+		return XMMatrixMultiply(shear, XMMatrixAffineTransformation(scale, XMVectorZero(), rotation, translation));
+	}
+
+	// Every 11th is empty and every 13th flat
+	BoundingBoxA MixedBox(Random& random, size_t i)
+	{
+		if (i % 11 == 10)
+			return BoundingBoxA();
+		auto box = RandomBox(random, 50, 20);
+		if (i % 13 == 12)
+		{
+			Float3 lo = box.Minima, hi = box.Maxima;
+			box = BoundingBoxA(Float3A(lo), Float3A(hi.X, hi.Y, lo.Z));
+		}
+		return box;
+	}
+
+	// The box around the transformed corners, and the largest magnitude involved, for scaling tolerances
+	void CornerBox(const BoundingBoxA& box, const Float4x3A& mat, double lo[3], double hi[3], double& magnitude)
+	{
+		Float3 bmin = box.Minima, bmax = box.Maxima;
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m, mat);
+		magnitude = 1;
+		for (int k = 0; k < 3; k++)
+		{
+			lo[k] = DBL_MAX;
+			hi[k] = -DBL_MAX;
+		}
+
+		for (int c = 0; c < 8; c++)
+		{
+			double p[3] = { c & 1 ? bmax.X : bmin.X, c & 2 ? bmax.Y : bmin.Y, c & 4 ? bmax.Z : bmin.Z };
+			for (int k = 0; k < 3; k++)
+			{
+				double v = p[0] * m.m[0][k] + p[1] * m.m[1][k] + p[2] * m.m[2][k] + m.m[3][k];
+				lo[k] = std::min(lo[k], v);
+				hi[k] = std::max(hi[k], v);
+				magnitude = std::max(magnitude, std::fabs(v));
+			}
+		}
+	}
+
+	bool IsDefault(const Float3& minima, const Float3& maxima)
+	{
+		return minima.X == FLT_MAX && minima.Y == FLT_MAX && minima.Z == FLT_MAX && maxima.X == -FLT_MAX && maxima.Y == -FLT_MAX && maxima.Z == -FLT_MAX;
+	}
+}
+
+TEST(BoundingBoxTransform_IsTheBoxAroundTheCorners)
+{
+	Random random(241);
+	for (size_t i = 0; i < 2000; i++)
+	{
+		auto box = MixedBox(random, i);
+		auto mat = RandomMatrix(random, i);
+		auto transformed = box.Transform(mat);
+
+		if (!box.GetExists())
+		{
+			CHECK(transformed == BoundingBoxA());
+			continue;
+		}
+
+		double lo[3], hi[3], magnitude;
+		CornerBox(box, mat, lo, hi, magnitude);
+		Float3 tmin = transformed.Minima, tmax = transformed.Maxima;
+		const float actualLo[3] = { tmin.X, tmin.Y, tmin.Z }, actualHi[3] = { tmax.X, tmax.Y, tmax.Z };
+		for (int k = 0; k < 3; k++)
+		{
+			CHECK_NEAR(actualLo[k], lo[k], 1e-5 * magnitude);
+			CHECK_NEAR(actualHi[k], hi[k], 1e-5 * magnitude);
+		}
+
+		// The unaligned box transforms the same way
+		BoundingBox unaligned(box);
+		CHECK(unaligned.Transform(mat) == transformed);
+	}
+
+	// Boxes out to the limits of float don't overflow through their size
+	BoundingBoxA huge(Float3A(-FLT_MAX, -FLT_MAX, -FLT_MAX), Float3A(FLT_MAX, FLT_MAX, FLT_MAX));
+	CHECK(huge.Transform(Float4x3A(XMMatrixIdentity())) == huge);
+	BoundingBoxA wide(Float3A(-FLT_MAX, 0, 0), Float3A(FLT_MAX, 1, 1));
+	Float3 moved = wide.Transform(Float4x3A(XMMatrixTranslation(0, 5, 0))).Maxima;
+	CHECK(moved.X == FLT_MAX && moved.Y == 6 && moved.Z == 1);
+}
+
+TEST(BoundingBoxTransform_BatchesMatchSingleBoxes)
+{
+	Random random(242);
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<BoundingBoxA> boxes(count);
+			std::vector<Float4x3A> matrices(count);
+			std::vector<Float3> minima(count), maxima(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				boxes[i] = MixedBox(random, i);
+				matrices[i] = RandomMatrix(random, i);
+				minima[i] = boxes[i].Minima;
+				maxima[i] = boxes[i].Maxima;
+			}
+			auto shared = RandomMatrix(random, 0);
+			Float3Stream minStream(minima.data(), count), maxStream(maxima.data(), count);
+
+			for (bool parallel : { false, true })
+			{
+				for (bool perBox : { false, true })
+				{
+					// Sized wrong, so they're reallocated
+					Float3Stream outMinima(count + 1), outMaxima;
+					if (perBox)
+						BoundingBoxA::Transform(minStream, maxStream, matrices.data(), outMinima, outMaxima, parallel);
+					else
+						BoundingBoxA::Transform(minStream, maxStream, shared, outMinima, outMaxima, parallel);
+					CHECK(outMinima.size() == count && outMaxima.size() == count);
+
+					std::vector<BoundingBoxA> outBoxes(count);
+					if (perBox)
+						BoundingBoxA::Transform(boxes.data(), count, matrices.data(), outBoxes.data(), parallel);
+					else
+						BoundingBoxA::Transform(boxes.data(), count, shared, outBoxes.data(), parallel);
+
+					for (size_t i = 0; i < count; i++)
+					{
+						auto expected = boxes[i].Transform(perBox ? matrices[i] : shared);
+						CHECK(outBoxes[i] == expected);
+
+						// The SoA kernel may fuse multiplies the single-box path doesn't
+						Float3 lo = outMinima.Get(i), hi = outMaxima.Get(i);
+						if (boxes[i].GetExists())
+							CheckNear(BoundingBoxA(Float3A(lo), Float3A(hi)), expected, 1e-5);
+						else
+							CHECK(IsDefault(lo, hi));
+					}
+				}
+			}
+
+			// In place
+			std::vector<BoundingBoxA> inPlace(boxes);
+			BoundingBoxA::Transform(inPlace.data(), count, matrices.data(), inPlace.data());
+			Float3Stream minCopy(minima.data(), count), maxCopy(maxima.data(), count), outMinima, outMaxima;
+			BoundingBoxA::Transform(minStream, maxStream, matrices.data(), outMinima, outMaxima);
+			BoundingBoxA::Transform(minCopy, maxCopy, matrices.data(), minCopy, maxCopy);
+			for (size_t i = 0; i < count; i++)
+			{
+				CHECK(inPlace[i] == boxes[i].Transform(matrices[i]));
+				Float3 a = minCopy.Get(i), b = outMinima.Get(i), c = maxCopy.Get(i), d = outMaxima.Get(i);
+				CHECK(a.X == b.X && a.Y == b.Y && a.Z == b.Z && c.X == d.X && c.Y == d.Y && c.Z == d.Z);
+			}
+		}
+	});
+
+	Float3Stream one(1), two(2), out;
+	Float4x3A identity = XMMatrixIdentity();
+	BoundingBoxA box;
+	CHECK_THROWS(BoundingBoxA::Transform(one, two, identity, out, out), ArgumentException);
+	CHECK_THROWS(BoundingBoxA::Transform(one, one, (const Float4x3A*)nullptr, out, out), ArgumentNullException);
+	CHECK_THROWS(BoundingBoxA::Transform(&box, 1, (const Float4x3A*)nullptr, &box), ArgumentNullException);
+	CHECK_THROWS(BoundingBoxA::Transform(nullptr, 1, identity, &box), ArgumentNullException);
+	CHECK_THROWS(BoundingBoxA::Transform(&box, 1, identity, nullptr), ArgumentNullException);
+}
@@ -0,0 +1,296 @@
+#include "Test.h"
+#include <algorithm>
+#include <cfloat>
+
+// Bvh queries against brute force over the same boxes, for serial and parallel builds and several leaf sizes.
+// The brute force uses the same float slab and distance tests as the leaves, so results match exactly.
+
+using namespace CS;
+using namespace SharpishTests;
+
+namespace
+{
+	const int LeafSizes[] = { 1, Bvh::DefaultLeafSize, Bvh::MaxLeafSize };
+
+	// Boxes of mixed sizes, some of them flat, with every 50th empty
+	std::vector<BoundingBoxA> RandomBoxes(size_t count, uint32_t seed)
+	{
+		Random random(seed);
+		std::vector<BoundingBoxA> boxes(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			boxes[i] = RandomBox(random, 100, i % 10 ? 4.0f : 30.0f);
+			if (i % 13 == 0)
+			{
+				Float3 lo = boxes[i].Minima, hi = boxes[i].Maxima;
+				boxes[i] = BoundingBoxA(Float3A(lo), Float3A(hi.X, lo.Y, hi.Z));
+			}
+			if (i % 50 == 49)
+				boxes[i] = BoundingBoxA();
+		}
+		return boxes;
+	}
+
+	bool IsEmpty(const BoundingBoxA& box)
+	{
+		Float3 lo = box.Minima, hi = box.Maxima;
+		return lo.X > hi.X || lo.Y > hi.Y || lo.Z > hi.Z;
+	}
+
+	// The leaves' slab test
+	bool RayHit(const Float3& origin, const Float3& direction, const BoundingBoxA& box, float maxDistance, float& enter)
+	{
+		if (IsEmpty(box))
+			return false;
+
+		Float3 lo = box.Minima, hi = box.Maxima;
+		const float o[3] = { origin.X, origin.Y, origin.Z }, d[3] = { direction.X, direction.Y, direction.Z };
+		const float minima[3] = { lo.X, lo.Y, lo.Z }, maxima[3] = { hi.X, hi.Y, hi.Z };
+		float tNear = 0, tFar = maxDistance;
+		for (int k = 0; k < 3; k++)
+		{
+			float inverse = std::fabs(d[k]) < FLT_MIN ? (std::signbit(d[k]) ? -FLT_MAX : FLT_MAX) : 1 / d[k];
+			float t0 = (minima[k] - o[k]) * inverse, t1 = (maxima[k] - o[k]) * inverse;
+			tNear = std::max(std::min(t0, t1), tNear);
+			tFar = std::min(std::max(t0, t1), tFar);
+		}
+		enter = tNear;
+		return tNear <= tFar;
+	}
+
+	bool Overlaps(const BoundingBoxA& box, const BoundingBoxA& query)
+	{
+		Float3 lo = box.Minima, hi = box.Maxima, qlo = query.Minima, qhi = query.Maxima;
+		return !IsEmpty(box) && lo.X <= qhi.X && hi.X >= qlo.X && lo.Y <= qhi.Y && hi.Y >= qlo.Y && lo.Z <= qhi.Z && hi.Z >= qlo.Z;
+	}
+
+	bool Overlaps(const BoundingBoxA& box, const Float3& center, float radius)
+	{
+		if (IsEmpty(box))
+			return false;
+		Float3 lo = box.Minima, hi = box.Maxima;
+		const float c[3] = { center.X, center.Y, center.Z }, minima[3] = { lo.X, lo.Y, lo.Z }, maxima[3] = { hi.X, hi.Y, hi.Z };
+		float distanceSq = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			float d = std::max(std::max(minima[k] - c[k], c[k] - maxima[k]), 0.0f);
+			distanceSq += d * d;
+		}
+		return distanceSq <= radius * radius;
+	}
+
+	std::vector<uint32_t> Sorted(std::vector<uint32_t> indices)
+	{
+		std::sort(indices.begin(), indices.end());
+		return indices;
+	}
+
+	struct Ray
+	{
+		Float3 Origin;
+		Float3 Direction;
+		float MaxDistance;
+	};
+
+	// Rays from outside and inside the scene, some along an axis, some limited to a segment
+	std::vector<Ray> RandomRays(size_t count, uint32_t seed)
+	{
+		Random random(seed);
+		std::vector<Ray> rays(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			rays[i].Origin = random.NextFloat3(i % 2 ? -100.0f : -200.0f, i % 2 ? 100.0f : 200.0f);
+			Float3 target = random.NextFloat3(-50, 50);
+			rays[i].Direction = Float3(target.X - rays[i].Origin.X, target.Y - rays[i].Origin.Y, target.Z - rays[i].Origin.Z);
+			if (i % 7 == 0)
+				rays[i].Direction = Float3(0, 0, i % 2 ? 1.0f : -1.0f);
+			rays[i].MaxDistance = i % 3 ? FLT_MAX : random.Next(0.0f, 1.0f);
+		}
+		return rays;
+	}
+}
+
+TEST(Bvh_QueriesMatchBruteForce)
+{
+	for (size_t count : { (size_t)1, (size_t)5, (size_t)3000, (size_t)20000 })
+	{
+		auto boxes = RandomBoxes(count, 181);
+		auto rays = RandomRays(200, 182);
+
+		for (int leafSize : LeafSizes)
+		{
+			for (bool parallel : { false, true })
+			{
+				Bvh bvh(boxes.data(), count, leafSize, parallel);
+				CHECK(bvh.size() == count && bvh.GetNodeCount() > 0);
+
+				// The bounds cover every box
+				auto bounds = bvh.GetBounds();
+				for (auto& box : boxes)
+					if (!IsEmpty(box))
+						CHECK(Overlaps(box, bounds) && bounds.Combine(box) == bounds);
+
+				for (auto& ray : rays)
+				{
+					std::vector<uint32_t> all, expectedAll;
+					bvh.RaycastAll(Float3A(ray.Origin), Float3A(ray.Direction), ray.MaxDistance, all);
+
+					float nearest = FLT_MAX, enter;
+					for (uint32_t i = 0; i < count; i++)
+					{
+						if (!RayHit(ray.Origin, ray.Direction, boxes[i], ray.MaxDistance, enter))
+							continue;
+						expectedAll.push_back(i);
+						nearest = std::min(nearest, enter);
+					}
+					CHECK(Sorted(all) == expectedAll);
+
+					uint32_t index;
+					float distance;
+					bool hit = bvh.RaycastFirst(Float3A(ray.Origin), Float3A(ray.Direction), ray.MaxDistance, index, distance);
+					CHECK(hit == !expectedAll.empty());
+					if (hit)
+					{
+						// Ties may go to either box
+						CHECK(distance == nearest);
+						CHECK(RayHit(ray.Origin, ray.Direction, boxes[index], ray.MaxDistance, enter) && enter == nearest);
+					}
+				}
+
+				Random random(183);
+				for (int q = 0; q < 100; q++)
+				{
+					Float3 center = random.NextFloat3(-110, 110), extent = random.NextFloat3(0, 20);
+					BoundingBoxA query(Float3A(center.X - extent.X, center.Y - extent.Y, center.Z - extent.Z), Float3A(center.X + extent.X, center.Y + extent.Y, center.Z + extent.Z));
+					float radius = random.Next(0.0f, 20.0f);
+
+					std::vector<uint32_t> inBox, inSphere, expectedBox, expectedSphere;
+					CHECK(bvh.Overlap(query, inBox) == inBox.size());
+					CHECK(bvh.Overlap(BoundingSphereA(center, radius), inSphere) == inSphere.size());
+					for (uint32_t i = 0; i < count; i++)
+					{
+						if (Overlaps(boxes[i], query))
+							expectedBox.push_back(i);
+						if (Overlaps(boxes[i], center, radius))
+							expectedSphere.push_back(i);
+					}
+					CHECK(Sorted(inBox) == expectedBox);
+					CHECK(Sorted(inSphere) == expectedSphere);
+				}
+			}
+		}
+	}
+}
+
+TEST(Bvh_CullMatchesFrustumCuller)
+{
+	auto boxes = RandomBoxes(20000, 184);
+	Bvh bvh(boxes.data(), boxes.size());
+
+	Random random(185);
+	for (int q = 0; q < 20; q++)
+	{
+		Float3 eye = random.NextFloat3(-150, 150), target = random.NextFloat3(-30, 30);
+		auto viewProjection = Float4x4A::LookAt(Float3A(eye), Float3A(target), Float3A(0, 1, 0)) * Float4x4A::PerspectiveFov(random.Next(0.3f, 1.5f), 1.5f, 1, random.Next(50.0f, 400.0f));
+		FrustumCuller culler(viewProjection);
+
+		std::vector<uint32_t> visible, expected;
+		CHECK(bvh.Cull(viewProjection, visible) == visible.size());
+		for (uint32_t i = 0; i < boxes.size(); i++)
+			if (!IsEmpty(boxes[i]) && culler.IsVisible(boxes[i]))
+				expected.push_back(i);
+		CHECK(Sorted(visible) == expected);
+	}
+}
+
+TEST(Bvh_BatchRaycastMatchesSingleRays)
+{
+	auto boxes = RandomBoxes(5000, 186);
+	Bvh bvh(boxes.data(), boxes.size());
+	auto rays = RandomRays(1000, 187);
+
+	std::vector<Float3> origins, directions;
+	for (auto& ray : rays)
+	{
+		origins.push_back(ray.Origin);
+		directions.push_back(ray.Direction);
+	}
+	Float3Stream originStream(origins.data(), origins.size()), directionStream(directions.data(), directions.size());
+
+	for (bool parallel : { false, true })
+	{
+		std::vector<int32_t> indices(rays.size());
+		std::vector<float> distances(rays.size());
+		bvh.RaycastFirst(originStream, directionStream, 500, indices.data(), distances.data(), parallel);
+
+		for (size_t i = 0; i < rays.size(); i++)
+		{
+			uint32_t index;
+			float distance;
+			if (bvh.RaycastFirst(Float3A(origins[i]), Float3A(directions[i]), 500, index, distance))
+				CHECK(indices[i] == (int32_t)index && distances[i] == distance);
+			else
+				CHECK(indices[i] == -1 && distances[i] == 500);
+		}
+	}
+
+	std::vector<int32_t> indices(1);
+	CHECK_THROWS(bvh.RaycastFirst(originStream, Float3Stream(), 500, indices.data(), nullptr), ArgumentException);
+}
+
+TEST(Bvh_RaycastRefinedByHitTest)
+{
+	// Odd boxes are hollow and even ones are hit half a unit past where the ray enters them
+	auto boxes = RandomBoxes(5000, 188);
+	Bvh bvh(boxes.data(), boxes.size());
+	auto hitTest = [](uint32_t index, float& distance)
+	{
+		if (index % 2)
+			return false;
+		distance += 0.5f;
+		return true;
+	};
+
+	for (auto& ray : RandomRays(300, 189))
+	{
+		float maxDistance = std::min(ray.MaxDistance, 100.0f), nearest = FLT_MAX, enter;
+		for (uint32_t i = 0; i < boxes.size(); i += 2)
+			if (RayHit(ray.Origin, ray.Direction, boxes[i], maxDistance, enter) && enter + 0.5f <= maxDistance)
+				nearest = std::min(nearest, enter + 0.5f);
+
+		uint32_t index;
+		float distance;
+		bool hit = bvh.RaycastFirst(Float3A(ray.Origin), Float3A(ray.Direction), maxDistance, index, distance, hitTest);
+		CHECK(hit == (nearest != FLT_MAX));
+		if (hit)
+			CHECK(index % 2 == 0 && distance == nearest);
+	}
+}
+
+TEST(Bvh_DegenerateInputs)
+{
+	// No boxes
+	Bvh none(nullptr, 0);
+	std::vector<uint32_t> found;
+	uint32_t index;
+	float distance;
+	CHECK(none.empty() && none.GetNodeCount() == 0);
+	CHECK(!none.RaycastFirst(Float3A(0, 0, 0), Float3A(1, 0, 0), FLT_MAX, index, distance));
+	CHECK(none.Overlap(BoundingSphereA(Float3(0, 0, 0), 1e6f), found) == 0);
+
+	// Identical boxes, which no plane can split
+	std::vector<BoundingBoxA> same(1000, BoundingBoxA(Float3A(1, 2, 3), Float3A(2, 3, 4)));
+	for (bool parallel : { false, true })
+	{
+		Bvh bvh(same.data(), same.size(), Bvh::DefaultLeafSize, parallel);
+		found.clear();
+		CHECK(bvh.Overlap(BoundingSphereA(Float3(1.5f, 2.5f, 3.5f), 0), found) == same.size());
+		CHECK(Sorted(found).back() == same.size() - 1);
+		found.clear();
+		CHECK(bvh.RaycastAll(Float3A(0, 0, 0), Float3A(1, 2, 3), FLT_MAX, found) == same.size());
+	}
+
+	CHECK_THROWS(Bvh(same.data(), same.size(), 0), ArgumentException);
+	CHECK_THROWS(Bvh(same.data(), same.size(), Bvh::MaxLeafSize + 1), ArgumentException);
+	CHECK_THROWS(Bvh(nullptr, 3), ArgumentNullException);
+}
@@ -0,0 +1,220 @@
+#include "Test.h"
+
+// Help::Math::DecomposeMany: exact recovery of scale, rotation and translation, recomposition of sheared and
+// mirrored matrices, and singular matrices, at every SIMD level.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	// A partial register, and more than one thread's share
+	const size_t Counts[] = { 0, 1, 7, 16, 61, 2500 };
+
+	struct Srt
+	{
+		XMFLOAT3 Scale;
+		XMFLOAT4 Rotation;
+		XMFLOAT3 Translation;
+
+		XMMATRIX Matrix() const
+		{
+			return XMMatrixAffineTransformation(XMLoadFloat3(&Scale), XMVectorZero(), XMLoadFloat4(&Rotation), XMLoadFloat3(&Translation));
+		}
+	};
+
+	// Every fifth has a negative X scale
+	std::vector<Srt> RandomSrts(size_t count, Random& random)
+	{
+		std::vector<Srt> srts(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			srts[i].Scale = XMFLOAT3(random.Next(0.2f, 5.0f) * (i % 5 == 4 ? -1 : 1), random.Next(0.2f, 5.0f), random.Next(0.2f, 5.0f));
+			XMStoreFloat4(&srts[i].Rotation, XMQuaternionRotationRollPitchYaw(random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f)));
+			srts[i].Translation = XMFLOAT3(random.Next(-100.0f, 100.0f), random.Next(-100.0f, 100.0f), random.Next(-100.0f, 100.0f));
+		}
+		return srts;
+	}
+
+	// The angle between two unit rotations, from the shorter of the chords to b and -b, which stays accurate near
+	// zero where acos of the dot product doesn't
+	double RotationAngle(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMFLOAT4 p, q;
+		XMStoreFloat4(&p, a);
+		XMStoreFloat4(&q, b);
+		double minus = 0, plus = 0;
+		for (int k = 0; k < 4; k++)
+		{
+			double x = (&p.x)[k], y = (&q.x)[k];
+			minus += (x - y) * (x - y);
+			plus += (x + y) * (x + y);
+		}
+		return 4 * std::asin(std::fmin(1.0, std::sqrt(std::fmin(minus, plus)) / 2));
+	}
+
+	void CheckUpper3x3Near(const XMMATRIX& actual, const XMMATRIX& expected, double tolerance)
+	{
+		XMFLOAT4X4 a, e;
+		XMStoreFloat4x4(&a, actual);
+		XMStoreFloat4x4(&e, expected);
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 3; c++)
+				CHECK_NEAR(a.m[r][c], e.m[r][c], tolerance);
+	}
+}
+
+TEST(Decompose_RecoversScaleRotationTranslation)
+{
+	Random random(151);
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			auto srts = RandomSrts(count, random);
+			std::vector<Float4x4A> m(count);
+			std::vector<Float4x3A> m3(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				m[i] = srts[i].Matrix();
+				m3[i] = srts[i].Matrix();
+			}
+
+			std::vector<Float3> position(count), scale(count), position3(count), scale3(count);
+			std::vector<Quaternion> orientation(count), orientation3(count);
+			std::vector<Float4x3A> residual(count);
+			std::unique_ptr<bool[]> decomposed(new bool[count]);
+
+			CHECK(Help::Math::DecomposeMany(m.data(), position.data(), orientation.data(), scale.data(), residual.data(), count, decomposed.get()) == count);
+			CHECK(Help::Math::DecomposeMany(m3.data(), position3.data(), orientation3.data(), scale3.data(), nullptr, count) == count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				auto& srt = srts[i];
+				CHECK(decomposed[i]);
+
+				CHECK_NEAR(position[i].X, srt.Translation.x, 0);
+				CHECK_NEAR(position[i].Y, srt.Translation.y, 0);
+				CHECK_NEAR(position[i].Z, srt.Translation.z, 0);
+
+				CHECK_NEAR(scale[i].X, srt.Scale.x, 2e-5 * std::fabs(srt.Scale.x));
+				CHECK_NEAR(scale[i].Y, srt.Scale.y, 2e-5 * srt.Scale.y);
+				CHECK_NEAR(scale[i].Z, srt.Scale.z, 2e-5 * srt.Scale.z);
+
+				// The orientation of a mirrored matrix is the rotation after the X axis is negated back
+				CHECK_NEAR(RotationAngle(QuaternionA(orientation[i]), XMLoadFloat4(&srt.Rotation)), 0, 1e-5);
+				CHECK_NEAR(XMVectorGetX(XMVector4Length(QuaternionA(orientation[i]))), 1, 1e-6);
+				CHECK(Help::Math::IsApproximatelyIdentity(residual[i]));
+
+				// The two layouts run the same kernel
+				CHECK(position3[i].X == position[i].X && scale3[i].Y == scale[i].Y && orientation3[i].W == orientation[i].W);
+			}
+		}
+	});
+}
+
+TEST(Decompose_AgreesWithSRTDecomposition)
+{
+	Random random(152);
+	auto srts = RandomSrts(200, random);
+	std::vector<Float4x4A> m(srts.size());
+	for (size_t i = 0; i < srts.size(); i++)
+		m[i] = srts[i].Matrix();
+
+	std::vector<Float3> position(m.size()), scale(m.size());
+	std::vector<Quaternion> orientation(m.size());
+	Help::Math::DecomposeMany(m.data(), position.data(), orientation.data(), scale.data(), nullptr, m.size());
+
+	for (size_t i = 0; i < m.size(); i++)
+	{
+		Float3 p, s;
+		Quaternion q;
+		CHECK(Help::Math::SRTDecomposition(m[i], nullptr, &p, &q, &s));
+		CHECK(p.X == position[i].X && p.Y == position[i].Y && p.Z == position[i].Z);
+		CHECK_NEAR(scale[i].X, s.X, 1e-4 * std::fabs(s.X));
+		CHECK_NEAR(scale[i].Y, s.Y, 1e-4 * s.Y);
+		CHECK_NEAR(scale[i].Z, s.Z, 1e-4 * s.Z);
+		// SRTDecomposition averages angles from acos, which is good to about 1e-3 radians
+		CHECK_NEAR(RotationAngle(QuaternionA(orientation[i]), QuaternionA(q)), 0, 2e-3);
+	}
+}
+
+TEST(Decompose_ShearedMatricesRecompose)
+{
+	Random random(153);
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		auto srts = RandomSrts(333, random);
+		std::vector<Float4x3A> m(srts.size());
+		for (size_t i = 0; i < srts.size(); i++)
+		{
+			XMMATRIX shear = XMMatrixIdentity();
+			shear.r[0] = XMVectorSet(1, random.Next(-0.5f, 0.5f), random.Next(-0.5f, 0.5f), 0);
+			shear.r[1] = XMVectorSet(0, 1, random.Next(-0.5f, 0.5f), 0);
+			m[i] = XMMatrixMultiply(shear, srts[i].Matrix());
+		}
+
+		std::vector<Float3> scale(m.size());
+		std::vector<Quaternion> orientation(m.size());
+		std::vector<Float4x3A> residual(m.size());
+		CHECK(Help::Math::DecomposeMany(m.data(), nullptr, orientation.data(), scale.data(), residual.data(), m.size()) == m.size());
+
+		for (size_t i = 0; i < m.size(); i++)
+		{
+			// M = residual * scale * rotation, with a proper rotation
+			QuaternionA q = orientation[i];
+			CHECK_NEAR(XMVectorGetX(XMVector4Length(q)), 1, 1e-6);
+			XMMATRIX recomposed = XMMatrixMultiply(XMMatrixMultiply(residual[i], XMMatrixScaling(scale[i].X, scale[i].Y, scale[i].Z)), XMMatrixRotationQuaternion(q));
+
+			XMFLOAT4X4 e;
+			XMStoreFloat4x4(&e, m[i]);
+			double size = 0;
+			for (int r = 0; r < 3; r++)
+				for (int c = 0; c < 3; c++)
+					size = std::fmax(size, std::fabs(e.m[r][c]));
+			CheckUpper3x3Near(recomposed, m[i], 5e-5 * size);
+			CHECK(!Help::Math::IsApproximatelyIdentity(residual[i], 1e-3f));
+		}
+	});
+}
+
+TEST(Decompose_SingularMatrices)
+{
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		// A register and a tail, with singular matrices in both
+		const size_t count = 21;
+		std::vector<Float4x4A> m(count, Float4x4A(XMMatrixTranslation(1, 2, 3)));
+		m[3] = XMMatrixScaling(1, 0, 1);
+		m[19] = XMMatrixScaling(1e-3f, 1e-3f, 1e-3f);
+		m[20].SetRow(2, m[20].GetRow(0));
+
+		std::vector<Float3> position(count), scale(count);
+		std::vector<Quaternion> orientation(count);
+		std::vector<Float4x3A> residual(count);
+		std::unique_ptr<bool[]> decomposed(new bool[count]);
+		CHECK(Help::Math::DecomposeMany(m.data(), position.data(), orientation.data(), scale.data(), residual.data(), count, decomposed.get()) == count - 3);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			bool singular = i == 3 || i == 19 || i == 20;
+			CHECK(decomposed[i] == !singular);
+			CHECK_NEAR(RotationAngle(QuaternionA(orientation[i]), XMQuaternionIdentity()), 0, 1e-6);
+			if (singular)
+			{
+				CHECK(scale[i].X == 0 && scale[i].Y == 0 && scale[i].Z == 0);
+				CheckUpper3x3Near(residual[i], XMMatrixScaling(0, 0, 0), 0);
+			}
+			else
+			{
+				CHECK(position[i].X == 1 && position[i].Y == 2 && position[i].Z == 3);
+				CHECK(Help::Math::IsApproximatelyIdentity(residual[i]));
+			}
+		}
+
+		// Every output may be null
+		CHECK(Help::Math::DecomposeMany(m.data(), nullptr, nullptr, nullptr, nullptr, count) == count - 3);
+	});
+}
@@ -0,0 +1,73 @@
+#include "Test.h"
+#include "MathLanes.h"
+
+// Runtime dispatch: the level reached follows the CPU, and the wide copies of the kernels agree with the baseline.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+#if defined(SHARPISH_TARGET_REGIONS)
+// Built with target regions, every level is compiled in whatever the flags, so only the CPU limits it
+TEST(Dispatch_SupportedLevelFollowsCpu)
+{
+	__builtin_cpu_init();
+	auto expected = SimdLevel::Baseline;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c"))
+		expected = __builtin_cpu_supports("avx512f") ? SimdLevel::AVX512 : SimdLevel::AVX2;
+
+	CHECK(Help::Math::GetSupportedSimdLevel() == expected);
+}
+#endif
+
+TEST(Dispatch_WideKernelsMatchBaseline)
+{
+	const size_t count = 1000;
+	Random random(11);
+
+	std::vector<Float3> points(count);
+	std::vector<float> angles(count);
+	std::vector<BoundingSphereA> spheres(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		points[i] = random.NextFloat3(-50, 50);
+		angles[i] = random.Next(-10.0f, 10.0f);
+		spheres[i] = BoundingSphereA(Float3A(random.NextFloat3(-60, 60)), random.Next(0.1f, 5.0f));
+	}
+
+	auto m = Float4x3A::LookAt(Float3A(1, 2, -3), Float3A(0, 0, 0), Float3A(0, 1, 0));
+	auto viewProjection = Float4x4A::LookAt(Float3A(0, 0, -80), Float3A(0, 0, 0), Float3A(0, 1, 0)) * Float4x4A::PerspectiveFov(0.8f, 1.5f, 1, 100);
+	FrustumCuller culler(viewProjection);
+	Float3Stream stream(points.data(), count);
+
+	Float3Stream baseTransformed;
+	std::vector<float> baseSin(count);
+	std::vector<uint32_t> baseVisible((count + 31) / 32);
+
+	ForEachSimdLevel([&](SimdLevel level)
+	{
+		auto transformed = stream.Transform(m);
+		std::vector<float> sines(count);
+		Help::Math::Sin(angles.data(), sines.data(), count);
+		std::vector<uint32_t> visible((count + 31) / 32);
+		culler.Cull(spheres.data(), count, visible.data(), false);
+
+		if (level == SimdLevel::Baseline)
+		{
+			baseTransformed = transformed;
+			baseSin = sines;
+			baseVisible = visible;
+			return;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			CHECK_NEAR(transformed.GetX()[i], baseTransformed.GetX()[i], 1e-4);
+			CHECK_NEAR(transformed.GetY()[i], baseTransformed.GetY()[i], 1e-4);
+			CHECK_NEAR(transformed.GetZ()[i], baseTransformed.GetZ()[i], 1e-4);
+			CHECK_NEAR(sines[i], baseSin[i], 1e-6);
+		}
+		CHECK(visible == baseVisible);
+	});
+}
@@ -0,0 +1,211 @@
+#include "Test.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+// DynamicAabbTree through a simulation of inserts, moves and removals: fat boxes as documented, and queries and
+// pairs against brute force over the fat boxes, serial and parallel.
+
+using namespace CS;
+using namespace SharpishTests;
+
+namespace
+{
+	typedef DynamicAabbTree::ProxyId ProxyId;
+	typedef std::vector<std::pair<ProxyId, ProxyId>> Pairs;
+
+	BoundingBoxA Offset(const BoundingBoxA& box, const Float3& d)
+	{
+		return BoundingBoxA(box.Minima + Float3A(d), box.Maxima + Float3A(d));
+	}
+
+	bool Touches(const BoundingBoxA& a, const BoundingBoxA& b)
+	{
+		Float3 alo = a.Minima, ahi = a.Maxima, blo = b.Minima, bhi = b.Maxima;
+		return alo.X <= bhi.X && ahi.X >= blo.X && alo.Y <= bhi.Y && ahi.Y >= blo.Y && alo.Z <= bhi.Z && ahi.Z >= blo.Z;
+	}
+
+	bool Encloses(const BoundingBoxA& outer, const BoundingBoxA& inner)
+	{
+		Float3 olo = outer.Minima, ohi = outer.Maxima, ilo = inner.Minima, ihi = inner.Maxima;
+		return olo.X <= ilo.X && olo.Y <= ilo.Y && olo.Z <= ilo.Z && ohi.X >= ihi.X && ohi.Y >= ihi.Y && ohi.Z >= ihi.Z;
+	}
+
+	BoundingBoxA Fattened(const BoundingBoxA& box, float margin)
+	{
+		return BoundingBoxA(box.Minima - Float3A(margin, margin, margin), box.Maxima + Float3A(margin, margin, margin));
+	}
+
+	Pairs Sorted(Pairs pairs)
+	{
+		std::sort(pairs.begin(), pairs.end());
+		return pairs;
+	}
+
+	// The proxies in the tree and their current (not fat) boxes
+	typedef std::map<ProxyId, BoundingBoxA> Model;
+
+	void CheckAgainstBruteForce(const DynamicAabbTree& tree, const Model& model, Random& random)
+	{
+		CHECK(tree.GetCount() == model.size());
+		// Rotations keep the tree within a small factor of the best height
+		CHECK(tree.GetHeight() <= 2 * (int)std::ceil(std::log2((double)model.size() + 1)) + 1);
+
+		for (auto& entry : model)
+		{
+			CHECK(tree.Contains(entry.first));
+			CHECK(Encloses(tree.GetFatBox(entry.first), entry.second));
+		}
+
+		for (int q = 0; q < 20; q++)
+		{
+			auto query = RandomBox(random, 60, 15);
+			std::vector<ProxyId> found, expected;
+			CHECK(tree.Overlap(query, found) == found.size());
+			for (auto& entry : model)
+				if (Touches(tree.GetFatBox(entry.first), query))
+					expected.push_back(entry.first);
+			std::sort(found.begin(), found.end());
+			CHECK(found == expected);
+		}
+
+		Pairs expected;
+		for (auto a = model.begin(); a != model.end(); ++a)
+			for (auto b = std::next(a); b != model.end(); ++b)
+				if (Touches(tree.GetFatBox(a->first), tree.GetFatBox(b->first)))
+					expected.emplace_back(a->first, b->first);
+
+		for (bool parallel : { false, true })
+		{
+			Pairs pairs;
+			CHECK(tree.FindPairs(pairs, parallel) == pairs.size());
+			for (size_t i = 0; i < pairs.size(); i++)
+			{
+				CHECK(pairs[i].first < pairs[i].second);
+				CHECK(i == 0 || pairs[i - 1].first <= pairs[i].first);
+			}
+			CHECK(Sorted(pairs) == expected);
+
+			// The pairs involving a few proxies
+			std::vector<ProxyId> some;
+			for (auto& entry : model)
+				if (random.Next(10u) == 0)
+					some.push_back(entry.first);
+			Pairs subset, expectedSubset;
+			CHECK(tree.FindPairs(some.data(), some.size(), subset, parallel) == subset.size());
+			for (auto& pair : expected)
+				if (std::count(some.begin(), some.end(), pair.first) || std::count(some.begin(), some.end(), pair.second))
+					expectedSubset.push_back(pair);
+			for (auto& pair : subset)
+				CHECK(pair.first < pair.second);
+			CHECK(Sorted(subset) == expectedSubset);
+		}
+	}
+}
+
+TEST(DynamicAabbTree_SimulationMatchesBruteForce)
+{
+	const float margin = 0.2f;
+	DynamicAabbTree tree(margin);
+	Model model;
+	Random random(191);
+
+	for (int i = 0; i < 1500; i++)
+	{
+		auto box = RandomBox(random, 50, 4);
+		ProxyId id = tree.Insert(box);
+		CHECK(!model.count(id));
+		model[id] = box;
+		CHECK(tree.GetFatBox(id) == Fattened(box, margin));
+	}
+	CheckAgainstBruteForce(tree, model, random);
+
+	for (int step = 0; step < 8; step++)
+	{
+		// Most proxies drift less than the margin, a few jump
+		std::vector<ProxyId> ids;
+		std::vector<BoundingBoxA> boxes;
+		for (auto& entry : model)
+		{
+			if (random.Next(3u))
+				continue;
+			ids.push_back(entry.first);
+			boxes.push_back(random.Next(20u) ? Offset(entry.second, random.NextFloat3(-0.1f, 0.1f)) : RandomBox(random, 50, 4));
+		}
+
+		std::vector<ProxyId> expectedReinserted;
+		for (size_t i = 0; i < ids.size(); i++)
+			if (!Encloses(tree.GetFatBox(ids[i]), boxes[i]))
+				expectedReinserted.push_back(ids[i]);
+
+		std::vector<ProxyId> reinserted;
+		CHECK(tree.MoveMany(ids.data(), boxes.data(), ids.size(), &reinserted, step % 2 == 0) == expectedReinserted.size());
+		CHECK(reinserted == expectedReinserted);
+		for (size_t i = 0; i < ids.size(); i++)
+			model[ids[i]] = boxes[i];
+		for (ProxyId id : reinserted)
+			CHECK(tree.GetFatBox(id) == Fattened(model[id], margin));
+
+		// Remove some and insert others, which may reuse their ids
+		for (int r = 0; r < 100; r++)
+		{
+			auto it = model.begin();
+			std::advance(it, random.Next((uint32_t)model.size()));
+			tree.Remove(it->first);
+			CHECK(!tree.Contains(it->first));
+			model.erase(it);
+		}
+		for (int a = 0; a < 100; a++)
+		{
+			auto box = RandomBox(random, 50, 4);
+			model[tree.Insert(box)] = box;
+		}
+
+		CheckAgainstBruteForce(tree, model, random);
+	}
+
+	// Down to nothing
+	while (!model.empty())
+	{
+		tree.Remove(model.begin()->first);
+		model.erase(model.begin());
+	}
+	CHECK(tree.GetCount() == 0 && tree.GetHeight() == 0);
+	Pairs pairs;
+	CHECK(tree.FindPairs(pairs) == 0);
+}
+
+TEST(DynamicAabbTree_MoveKeepsOrGrowsTheFatBox)
+{
+	const float margin = 0.5f;
+	DynamicAabbTree tree(margin);
+	BoundingBoxA box(Float3A(0, 0, 0), Float3A(1, 1, 1));
+	ProxyId id = tree.Insert(box);
+	ProxyId other = tree.Insert(BoundingBoxA(Float3A(5, 5, 5), Float3A(6, 6, 6)));
+
+	// Inside the fat box, nothing changes
+	CHECK(!tree.Move(id, Offset(box, Float3(0.4f, -0.4f, 0))));
+	CHECK(tree.GetFatBox(id) == Fattened(box, margin));
+
+	// Leaving it reinserts with a fresh fat box, stretched along the displacement
+	auto moved = Offset(box, Float3(2, 0, 0));
+	Float3 displacement(3, 0, -1);
+	CHECK(tree.Move(id, moved, Float3A(displacement)));
+	auto fat = Fattened(moved, margin);
+	CHECK(tree.GetFatBox(id) == fat.Combine(Offset(fat, displacement)));
+
+	// A move along the displacement stays inside
+	CHECK(!tree.Move(id, Offset(moved, displacement)));
+
+	std::vector<ProxyId> found;
+	tree.Overlap(BoundingBoxA(Float3A(5.9f, 5.9f, 5.9f), Float3A(7, 7, 7)), found);
+	CHECK(found.size() == 1 && found[0] == other);
+
+	CHECK_THROWS(tree.Insert(BoundingBoxA()), ArgumentException);
+	CHECK_THROWS(tree.Move(id, BoundingBoxA()), ArgumentException);
+	CHECK_THROWS(tree.Move(12345, box), ArgumentException);
+	tree.Remove(other);
+	CHECK_THROWS(tree.Remove(other), ArgumentException);
+	CHECK_THROWS(tree.GetFatBox(other), ArgumentException);
+	CHECK_THROWS(DynamicAabbTree(-1), ArgumentException);
+}
@@ -0,0 +1,204 @@
+#include "Test.h"
+#include <cstring>
+
+// The normal and quaternion encodings: decode errors within the bounds in MathEncoding.h, and codes that are the
+// same from the single-value constructors and from the batch kernels at every SIMD level, for random inputs and
+// for inputs right at the quantization steps.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	const double Degrees = 180 / 3.14159265358979323846;
+
+	// Angles in double precision, from atan2 of the cross and dot products, which stays accurate near zero
+	double AngleBetween(const Float3& a, const Float3& b)
+	{
+		double cx = (double)a.Y * b.Z - (double)a.Z * b.Y;
+		double cy = (double)a.Z * b.X - (double)a.X * b.Z;
+		double cz = (double)a.X * b.Y - (double)a.Y * b.X;
+		double dot = (double)a.X * b.X + (double)a.Y * b.Y + (double)a.Z * b.Z;
+		return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot) * Degrees;
+	}
+
+	// The angle of the rotation from a to b
+	double RotationAngle(const Quaternion& a, const Quaternion& b)
+	{
+		double dot = (double)a.X * b.X + (double)a.Y * b.Y + (double)a.Z * b.Z + (double)a.W * b.W;
+		double la = std::sqrt((double)a.X * a.X + (double)a.Y * a.Y + (double)a.Z * a.Z + (double)a.W * a.W);
+		double lb = std::sqrt((double)b.X * b.X + (double)b.Y * b.Y + (double)b.Z * b.Z + (double)b.W * b.W);
+		double c = std::fmin(1.0, std::fabs(dot) / (la * lb));
+		// 2 asin of the half-chord is accurate where 2 acos(c) loses everything
+		return 4 * std::asin(std::sqrt((1 - c) / 2)) * Degrees;
+	}
+
+	// x moved by ulps floats up or down
+	float Nudge(float x, int ulps)
+	{
+		for (; ulps > 0; ulps--)
+			x = std::nextafter(x, INFINITY);
+		for (; ulps < 0; ulps++)
+			x = std::nextafter(x, -INFINITY);
+		return x;
+	}
+
+	// Directions a few floats either side of the quantization steps: u on the grid lines, where the grid point
+	// below changes, and halfway between them, where two grid points decode equally close. A multiply and add
+	// fused at one SIMD level and not another would give them different codes. v also sits on a step, and both
+	// are in the upper half, where the octahedron isn't folded.
+	template<int Bits>
+	std::vector<Float3> HalfStepDirections()
+	{
+		const float maxCode = (float)((1u << OctahedralNormal<Bits>::ComponentBits) - 2);
+		auto toSquare = [&](float code) { return code * (2 / maxCode) - 1; };
+
+		std::vector<Float3> directions;
+		for (int k = 0; k < 64; k++)
+		{
+			float u = toSquare(std::floor(k * maxCode / 64) + (k & 1) * 0.5f);
+			float room = 1 - std::fabs(u);
+			float v = toSquare(std::floor((1 + room * ((k % 7) / 7.0f - 0.5f)) * maxCode / 2) + (k & 2) * 0.25f);
+			for (int ulps = -3; ulps <= 3; ulps++)
+				directions.push_back(Float3(Nudge(u, ulps), v, 1 - std::fabs(u) - std::fabs(v)));
+		}
+		return directions;
+	}
+
+	// Rotations whose x lies a few floats either side of where its code rounds up, with y and z on steps too and
+	// w the largest, so x, y and z are the three kept
+	template<int Bits>
+	std::vector<Quaternion> HalfStepRotations()
+	{
+		const float maxCode = (float)((1u << CompactQuaternion<Bits>::ComponentBits) - 2), scale = maxCode * 0.5f * 1.41421356f;
+		auto toComponent = [&](float code) { return (code - maxCode * 0.5f) / scale; };
+
+		std::vector<Quaternion> rotations;
+		for (int k = 0; k < 64; k++)
+		{
+			float a = toComponent(std::floor(maxCode * (0.15f + 0.7f * k / 64)) + 0.5f);
+			float b = toComponent(std::floor(maxCode * (0.3f + 0.4f * (k * 17 % 64) / 64)) + 0.5f);
+			float c = toComponent(std::floor(maxCode * (0.45f + 0.1f * (k % 8) / 8)) + 0.5f);
+			float w = std::sqrt(1 - a * a - b * b - c * c);
+			for (int ulps = -3; ulps <= 3; ulps++)
+				rotations.push_back(QuaternionA(XMVectorSet(Nudge(a, ulps), b, c, w)));
+		}
+		return rotations;
+	}
+
+	template<int Bits>
+	void CheckNormals(double bound)
+	{
+		typedef OctahedralNormal<Bits> Code;
+		Random random(131);
+		std::vector<Float3> directions(20011);
+		for (auto& d : directions)
+		{
+			do d = random.NextFloat3(-1, 1);
+			while (d.X * d.X + d.Y * d.Y + d.Z * d.Z < 1e-4f);
+		}
+		// The axes and the octahedron's folds
+		directions[0] = Float3(0, 0, -1);
+		directions[1] = Float3(1, 0, 0);
+		directions[2] = Float3(0.5f, -0.5f, 0);
+		directions[3] = Float3(1e-7f, 1, -1e-7f);
+		auto steps = HalfStepDirections<Bits>();
+		directions.insert(directions.end(), steps.begin(), steps.end());
+
+		std::vector<Code> single(directions.size());
+		for (size_t i = 0; i < directions.size(); i++)
+			single[i] = Code(Float3A(directions[i]));
+
+		ForEachSimdLevel([&](SimdLevel)
+		{
+			std::vector<Code> codes(directions.size());
+			std::vector<Float3> decoded(directions.size());
+			Code::Encode(directions.data(), codes.data(), directions.size());
+			Code::Decode(codes.data(), decoded.data(), codes.size());
+			CHECK(!memcmp(codes.data(), single.data(), codes.size() * sizeof(Code)));
+
+			double worst = 0, worstLength = 0;
+			for (size_t i = 0; i < directions.size(); i++)
+			{
+				worst = std::fmax(worst, AngleBetween(directions[i], decoded[i]));
+				const Float3& d = decoded[i];
+				worstLength = std::fmax(worstLength, std::fabs(std::sqrt((double)d.X * d.X + (double)d.Y * d.Y + (double)d.Z * d.Z) - 1));
+			}
+			CHECK_NEAR(worst, 0, bound);
+			CHECK_NEAR(worstLength, 0, 4e-7);
+		});
+
+		Float3 zero = Float3A(Code(Float3A(0, 0, 0)));
+		CHECK(zero.X == 0 && zero.Y == 0 && zero.Z == 1);
+	}
+
+	template<int Bits>
+	void CheckQuaternions(double bound)
+	{
+		typedef CompactQuaternion<Bits> Code;
+		Random random(132);
+		std::vector<Quaternion> rotations(20011);
+		for (auto& q : rotations)
+			q = QuaternionA(XMVectorSet(random.Next(-1.0f, 1.0f), random.Next(-1.0f, 1.0f), random.Next(-1.0f, 1.0f), random.Next(-1.0f, 1.0f)));
+		// Near the worst case, all four components close to 1/2, and unnormalized input
+		rotations[0] = QuaternionA(XMVectorSet(0.5f, -0.5f, 0.5f, 0.5f));
+		rotations[1] = QuaternionA(XMVectorSet(0.49f, 0.51f, -0.5f, 0.5f));
+		rotations[2] = QuaternionA(XMVectorSet(0, 0, 0, -3));
+		auto steps = HalfStepRotations<Bits>();
+		rotations.insert(rotations.end(), steps.begin(), steps.end());
+
+		std::vector<Code> single(rotations.size());
+		for (size_t i = 0; i < rotations.size(); i++)
+			single[i] = Code(QuaternionA(rotations[i]));
+
+		ForEachSimdLevel([&](SimdLevel)
+		{
+			std::vector<Code> codes(rotations.size());
+			std::vector<Quaternion> decoded(rotations.size());
+			Code::Encode(rotations.data(), codes.data(), rotations.size());
+			Code::Decode(codes.data(), decoded.data(), codes.size());
+			CHECK(!memcmp(codes.data(), single.data(), codes.size() * sizeof(Code)));
+
+			double worst = 0, worstLength = 0;
+			for (size_t i = 0; i < rotations.size(); i++)
+			{
+				worst = std::fmax(worst, RotationAngle(rotations[i], decoded[i]));
+				const Quaternion& q = decoded[i];
+				worstLength = std::fmax(worstLength, std::fabs(std::sqrt((double)q.X * q.X + (double)q.Y * q.Y + (double)q.Z * q.Z + (double)q.W * q.W) - 1));
+			}
+			CHECK_NEAR(worst, 0, bound);
+			CHECK_NEAR(worstLength, 0, 4e-7);
+		});
+
+		Quaternion identity = QuaternionA(Code(QuaternionA(XMVectorZero())));
+		CHECK(identity.X == 0 && identity.Y == 0 && identity.Z == 0 && identity.W == 1);
+	}
+}
+
+TEST(Encoding_OctahedralNormalErrorBounds)
+{
+	CheckNormals<16>(0.64);
+	CheckNormals<24>(0.040);
+	CheckNormals<32>(0.0025);
+}
+
+TEST(Encoding_CompactQuaternionErrorBounds)
+{
+	CheckQuaternions<32>(0.28);
+	CheckQuaternions<48>(0.0086);
+	CheckQuaternions<64>(0.00031);
+}
+
+TEST(Encoding_LengthAndSignDoNotChangeCodes)
+{
+	// Directions are normalized before encoding, and q and -q are the same rotation
+	OctahedralNormal16 z(Float3A(0, 0, 1));
+	OctahedralNormal16 longer(Float3A(0, 0, 5));
+	CHECK(!memcmp(z.Bytes, longer.Bytes, sizeof(z.Bytes)));
+
+	CompactQuaternion32 identity(QuaternionA::Identity);
+	CompactQuaternion32 negated(QuaternionA(XMVectorSet(0, 0, 0, -1)));
+	CHECK(!memcmp(identity.Bytes, negated.Bytes, sizeof(identity.Bytes)));
+}
@@ -0,0 +1,50 @@
+#include "Test.h"
+
+// Fused expressions give exactly the multiply-adds they document, and agree with the plain operators up to the
+// single rounding each fused multiply-add saves.
+
+using namespace CS;
+using namespace SharpishTests;
+
+TEST(Expression_FusesMultiplyAdds)
+{
+	Float3A a(1.1f, -2.3f, 3.7f), b(0.3f, 5.5f, -1.25f), c(-4.2f, 0.7f, 2.9f);
+	float dt = 0.016f;
+
+	Float3A fused = Fuse(a) * dt + b;
+	CHECK(fused == Float3A(XMVectorMultiplyAdd(a, XMVectorReplicate(dt), b)));
+
+	Float3A leading = b + Fuse(a) * c;
+	CHECK(leading == Float3A(XMVectorMultiplyAdd(a, c, b)));
+
+	Float3A difference = c - Fuse(a) * b;
+	CHECK(difference == Float3A(XMVectorNegativeMultiplySubtract(a, b, c)));
+
+	// Verlet: (2x - xPrev) + a * dt^2, with the last sum fused
+	Float3A verlet = Fuse(a) * 2.0f - b + Fuse(c) * (dt * dt);
+	CHECK(verlet == Float3A(XMVectorMultiplyAdd(c, XMVectorReplicate(dt * dt), XMVectorMultiplyAdd(a, XMVectorReplicate(2.0f), XMVectorNegate(b)))));
+}
+
+TEST(Expression_MatchesPlainOperators)
+{
+	Random random(111);
+	for (int i = 0; i < 200; i++)
+	{
+		Float4A a(random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f));
+		Float4A b(random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f));
+		Float4A c(random.Next(0.5f, 10.0f), random.Next(0.5f, 10.0f), random.Next(0.5f, 10.0f), random.Next(0.5f, 10.0f));
+		float s = random.Next(-3.0f, 3.0f);
+
+		Float4A fused = (Fuse(a) * s + b) / c - Fuse(b) * a + -Fuse(c);
+		Float4A plain = (a * s + b) / c - b * a + -c;
+		CHECK_NEAR(fused.GetX(), plain.GetX(), 1e-4);
+		CHECK_NEAR(fused.GetY(), plain.GetY(), 1e-4);
+		CHECK_NEAR(fused.GetZ(), plain.GetZ(), 1e-4);
+		CHECK_NEAR(fused.GetW(), plain.GetW(), 1e-4);
+	}
+
+	// Unaligned vectors and assignment back into the operand
+	Float2 x(1, 2), v(3, -4);
+	x = Fuse(v) * 0.5f + x;
+	CHECK(x.X == 2.5f && x.Y == 0);
+}
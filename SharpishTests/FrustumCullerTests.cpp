@@ -0,0 +1,403 @@
+#include "Test.h"
+#include <algorithm>
+
+// FrustumCuller: the planes it extracts, and the batch Cull methods against the plane tests done one volume at a
+// time in double precision, at every SIMD level, serial and split across threads. Volumes within rounding of a
+// plane can go either way and aren't compared.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	// Partial words and registers, and more than one thread's share
+	const size_t Counts[] = { 0, 1, 31, 32, 33, 20011 };
+	const double Margin = 1e-3;
+
+	// Looking down +Z from (0, 0, -80), with the near plane at z = -79 and the far plane at z = 20
+	Float4x4A ViewProjection()
+	{
+		return Float4x4A::LookAt(Float3A(0, 0, -80), Float3A(0, 0, 0), Float3A(0, 1, 0)) * Float4x4A::PerspectiveFov(0.8f, 1.5f, 1, 100);
+	}
+
+	struct Planes
+	{
+		double P[FrustumCuller::PlaneCount][4];
+
+		explicit Planes(const FrustumCuller& culler)
+		{
+			for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+			{
+				Float4 plane = culler.GetPlane(p);
+				P[p][0] = plane.X; P[p][1] = plane.Y; P[p][2] = plane.Z; P[p][3] = plane.W;
+			}
+		}
+
+		double Distance(int p, const Float3& v) const { return P[p][0] * v.X + P[p][1] * v.Y + P[p][2] * v.Z + P[p][3]; }
+	};
+
+	// 1 if visible, 0 if culled, -1 if within Margin of changing
+	int SphereReference(const Planes& planes, const Float3& center, float radius)
+	{
+		int result = 1;
+		for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+		{
+			double d = planes.Distance(p, center) + radius;
+			if (d < -Margin)
+				return 0;
+			if (d < Margin)
+				result = -1;
+		}
+		return result;
+	}
+
+	int BoxReference(const Planes& planes, const Float3& minima, const Float3& maxima)
+	{
+		int result = 1;
+		for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+		{
+			Float3 corner(planes.P[p][0] > 0 ? maxima.X : minima.X, planes.P[p][1] > 0 ? maxima.Y : minima.Y, planes.P[p][2] > 0 ? maxima.Z : minima.Z);
+			double d = planes.Distance(p, corner);
+			if (d < -Margin)
+				return 0;
+			if (d < Margin)
+				result = -1;
+		}
+		return result;
+	}
+
+	inline bool Bit(const std::vector<uint32_t>& mask, size_t i) { return (mask[i / 32] >> (i % 32)) & 1; }
+
+	// Fills the mask and one word past it with set bits, so CheckMask can see that Cull wrote exactly its words
+	std::vector<uint32_t> NewMask(size_t count) { return std::vector<uint32_t>((count + 31) / 32 + 1, ~0u); }
+
+	void CheckMask(const std::vector<uint32_t>& mask, size_t count, const std::vector<int>& expected)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (expected[i] >= 0)
+				CHECK(Bit(mask, i) == (expected[i] == 1));
+		}
+
+		if (count % 32)
+			CHECK((mask[count / 32] >> (count % 32)) == 0);
+		CHECK(mask.back() == ~0u);
+	}
+}
+
+TEST(FrustumCuller_PlanesFaceInward)
+{
+	FrustumCuller culler(ViewProjection());
+	for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+		CHECK_NEAR(XMVectorGetX(XMVector3Length(culler.GetPlane(p))), 1, 1e-6);
+
+	// Distances along the view axis are in world units
+	Planes planes(culler);
+	CHECK_NEAR(planes.Distance(FrustumCuller::Near, Float3(0, 0, -78)), 1, 1e-4);
+	CHECK_NEAR(planes.Distance(FrustumCuller::Far, Float3(0, 0, 0)), 20, 1e-3);
+	for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+		CHECK(planes.Distance(p, Float3(0, 0, 0)) > 0);
+
+	CHECK(culler.IsVisible(BoundingSphere(Float3(0, 0, 0), 1)));
+	CHECK(!culler.IsVisible(BoundingSphere(Float3(0, 0, -85), 1)));
+	CHECK(culler.IsVisible(BoundingSphere(Float3(0, 0, -85), 7)));
+	CHECK(!culler.IsVisible(BoundingBoxA(Float3A(0, 0, 25), Float3A(1, 1, 26))));
+	CHECK(culler.IsVisible(BoundingBoxA(Float3A(0, 0, 15), Float3A(1, 1, 26))));
+
+	// A default culler has no planes and culls nothing
+	FrustumCuller none;
+	CHECK(none.IsVisible(BoundingSphere(Float3(1e6f, 0, 0), 0)));
+}
+
+TEST(FrustumCuller_CullSpheresMatchesReference)
+{
+	FrustumCuller culler(ViewProjection());
+	Planes planes(culler);
+	Random random(161);
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<BoundingSphere> spheres(count);
+			std::vector<BoundingSphereA> spheresA(count);
+			std::vector<Float4> packed(count);
+			std::vector<int> expected(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				Float3 center = random.NextFloat3(-120, 120);
+				float radius = random.Next(0.0f, 8.0f);
+				spheres[i] = BoundingSphere(center, radius);
+				spheresA[i] = BoundingSphereA(center, radius);
+				packed[i] = Float4(center.X, center.Y, center.Z, radius);
+				expected[i] = SphereReference(planes, center, radius);
+				if (expected[i] >= 0)
+					CHECK(culler.IsVisible(spheres[i]) == (expected[i] == 1) && culler.IsVisible(spheresA[i]) == (expected[i] == 1));
+			}
+			Float4Stream stream(packed.data(), count);
+
+			for (bool parallel : { false, true })
+			{
+				auto a = NewMask(count), b = NewMask(count), c = NewMask(count);
+				culler.Cull(spheres.data(), count, a.data(), parallel);
+				culler.Cull(spheresA.data(), count, b.data(), parallel);
+				culler.Cull(stream, c.data(), parallel);
+				CheckMask(a, count, expected);
+				CheckMask(b, count, expected);
+				CheckMask(c, count, expected);
+			}
+		}
+	});
+}
+
+TEST(FrustumCuller_CullBoxesMatchesReference)
+{
+	FrustumCuller culler(ViewProjection());
+	Planes planes(culler);
+	Random random(162);
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<BoundingBoxA> boxes(count);
+			std::vector<Float3> minima(count), maxima(count);
+			std::vector<int> expected(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				boxes[i] = RandomBox(random, 120, 10);
+				minima[i] = boxes[i].Minima;
+				maxima[i] = boxes[i].Maxima;
+				expected[i] = BoxReference(planes, minima[i], maxima[i]);
+				if (expected[i] >= 0)
+					CHECK(culler.IsVisible(boxes[i]) == (expected[i] == 1));
+			}
+			Float3Stream minStream(minima.data(), count), maxStream(maxima.data(), count);
+
+			for (bool parallel : { false, true })
+			{
+				auto a = NewMask(count), b = NewMask(count);
+				culler.Cull(boxes.data(), count, a.data(), parallel);
+				culler.Cull(minStream, maxStream, b.data(), parallel);
+				CheckMask(a, count, expected);
+				CheckMask(b, count, expected);
+			}
+		}
+	});
+}
+
+TEST(FrustumCuller_CompactListsSetBits)
+{
+	Random random(163);
+	for (size_t count : Counts)
+	{
+		std::vector<uint32_t> mask((count + 31) / 32);
+		for (auto& word : mask)
+			word = random.Next(0xFFFFFFFFu) & random.Next(0xFFFFFFFFu);
+		// Bits past count are ignored
+		if (count % 32)
+			mask.back() |= ~0u << (count % 32);
+
+		std::vector<uint32_t> indices(count);
+		size_t n = FrustumCuller::Compact(mask.data(), count, indices.data());
+
+		std::vector<uint32_t> expected;
+		for (size_t i = 0; i < count; i++)
+			if (Bit(mask, i))
+				expected.push_back((uint32_t)i);
+
+		CHECK(n == expected.size());
+		CHECK(std::equal(expected.begin(), expected.end(), indices.begin()));
+	}
+}
+
+namespace
+{
+	enum class Swept { Line, Ray, Segment };
+
+	// Whether any point a + t d, with t in the kind's range, is inside every plane moved out by r. b is the second
+	// endpoint of segments and the direction of lines and rays.
+	bool SweptVisible(const Planes& planes, Swept kind, const Float3& a, const Float3& b, double r)
+	{
+		double da[3] = { a.X, a.Y, a.Z }, db[3] = { b.X, b.Y, b.Z };
+		if (kind == Swept::Segment)
+			for (int k = 0; k < 3; k++)
+				db[k] -= da[k];
+
+		double tMin = kind == Swept::Line ? -1e300 : 0, tMax = kind == Swept::Segment ? 1 : 1e300;
+		for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+		{
+			double s = planes.P[p][0] * da[0] + planes.P[p][1] * da[1] + planes.P[p][2] * da[2] + planes.P[p][3] + r;
+			double v = planes.P[p][0] * db[0] + planes.P[p][1] * db[1] + planes.P[p][2] * db[2];
+			if (v > 0)
+				tMin = std::fmax(tMin, -s / v);
+			else if (v < 0)
+				tMax = std::fmin(tMax, -s / v);
+			else if (s < 0)
+				return false;
+		}
+		return tMin <= tMax;
+	}
+
+	int SweptReference(const Planes& planes, Swept kind, const Float3& a, const Float3& b, double r)
+	{
+		if (SweptVisible(planes, kind, a, b, r - Margin))
+			return 1;
+		return SweptVisible(planes, kind, a, b, r + Margin) ? -1 : 0;
+	}
+
+	int ConeReference(const Planes& planes, const Float3& origin, const Float3& direction, double slope)
+	{
+		int result = 1;
+		double lengthSq = (double)direction.X * direction.X + (double)direction.Y * direction.Y + (double)direction.Z * direction.Z;
+		for (int p = 0; p < FrustumCuller::PlaneCount; p++)
+		{
+			double apex = planes.Distance(p, origin);
+			double along = planes.P[p][0] * direction.X + planes.P[p][1] * direction.Y + planes.P[p][2] * direction.Z;
+			double base = apex + along + slope * std::sqrt(std::fmax(0.0, lengthSq - along * along));
+			double d = std::fmax(apex, base);
+			if (d < -Margin)
+				return 0;
+			if (d < Margin)
+				result = -1;
+		}
+		return result;
+	}
+
+	Float3 Stretch(const Float3& v, float scale) { return Float3(v.X * scale, v.Y * scale, v.Z * scale); }
+}
+
+TEST(FrustumCuller_CullSweptMatchesReference)
+{
+	FrustumCuller culler(ViewProjection());
+	Planes planes(culler);
+	Random random(164);
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<Float3> a(count), b(count), direction(count);
+			std::vector<float> radii(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				a[i] = random.NextFloat3(-150, 150);
+				b[i] = random.NextFloat3(-150, 150);
+				direction[i] = Stretch(random.NextFloat3(-1, 1), random.Next(0.1f, 10.0f));
+				radii[i] = random.Next(0.0f, 5.0f);
+			}
+			Float3Stream as(a.data(), count), bs(b.data(), count), directions(direction.data(), count);
+
+			std::vector<int> segments(count), cylinders(count), lines(count), thickLines(count), rays(count), thickRays(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				segments[i] = SweptReference(planes, Swept::Segment, a[i], b[i], 0);
+				cylinders[i] = SweptReference(planes, Swept::Segment, a[i], b[i], radii[i]);
+				lines[i] = SweptReference(planes, Swept::Line, a[i], direction[i], 0);
+				thickLines[i] = SweptReference(planes, Swept::Line, a[i], direction[i], radii[i]);
+				rays[i] = SweptReference(planes, Swept::Ray, a[i], direction[i], 0);
+				thickRays[i] = SweptReference(planes, Swept::Ray, a[i], direction[i], radii[i]);
+			}
+
+			for (bool parallel : { false, true })
+			{
+				auto mask = NewMask(count);
+				culler.CullLineSegs(as, bs, mask.data(), parallel);
+				CheckMask(mask, count, segments);
+
+				mask = NewMask(count);
+				culler.CullCylinders(as, bs, radii.data(), mask.data(), parallel);
+				CheckMask(mask, count, cylinders);
+
+				mask = NewMask(count);
+				culler.CullCylinders(as, bs, nullptr, mask.data(), parallel);
+				CheckMask(mask, count, segments);
+
+				mask = NewMask(count);
+				culler.CullThickLines(as, directions, nullptr, mask.data(), parallel);
+				CheckMask(mask, count, lines);
+
+				mask = NewMask(count);
+				culler.CullThickLines(as, directions, radii.data(), mask.data(), parallel);
+				CheckMask(mask, count, thickLines);
+
+				mask = NewMask(count);
+				culler.CullThickRays(as, directions, nullptr, mask.data(), parallel);
+				CheckMask(mask, count, rays);
+
+				mask = NewMask(count);
+				culler.CullThickRays(as, directions, radii.data(), mask.data(), parallel);
+				CheckMask(mask, count, thickRays);
+			}
+		}
+	});
+}
+
+TEST(FrustumCuller_CullConesMatchesReference)
+{
+	FrustumCuller culler(ViewProjection());
+	Planes planes(culler);
+	Random random(165);
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<Float3> origin(count), direction(count);
+			std::vector<float> slopes(count);
+			std::vector<int> expected(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				origin[i] = random.NextFloat3(-120, 120);
+				direction[i] = random.NextFloat3(-40, 40);
+				slopes[i] = random.Next(0.0f, 1.0f);
+				expected[i] = ConeReference(planes, origin[i], direction[i], slopes[i]);
+			}
+			Float3Stream origins(origin.data(), count), directions(direction.data(), count);
+
+			for (bool parallel : { false, true })
+			{
+				auto mask = NewMask(count);
+				culler.CullCones(origins, directions, slopes.data(), mask.data(), parallel);
+				CheckMask(mask, count, expected);
+			}
+		}
+	});
+
+	std::vector<uint32_t> mask(1);
+	CHECK_THROWS(culler.CullCones(Float3Stream(), Float3Stream(), nullptr, mask.data()), ArgumentNullException);
+}
+
+TEST(FrustumCuller_SweptCullingIsExact)
+{
+	// At z = 0 the frustum reaches x = 50.7 and y = 33.8. This segment passes outside the corner between the right
+	// and top planes, with each endpoint inside one of them, so a test of endpoints plane by plane keeps it.
+	FrustumCuller culler(ViewProjection());
+	Float3 a(70, 20, 0), b(40, 50, 0), through(-200, 0, 0), across(200, 0, 0);
+	Float3Stream as(&a, 1), bs(&b, 1), throughs(&through, 1), acrosses(&across, 1);
+	uint32_t mask;
+
+	culler.CullLineSegs(as, bs, &mask);
+	CHECK(mask == 0);
+
+	// Moved out far enough to cover the corner
+	float radius = 5;
+	culler.CullCylinders(as, bs, &radius, &mask);
+	CHECK(mask == 1);
+
+	// Neither endpoint is inside the frustum, but the segment crosses it
+	culler.CullLineSegs(throughs, acrosses, &mask);
+	CHECK(mask == 1);
+
+	// Rays only go forward
+	Float3 left(-1, 0, 0), right(1, 0, 0);
+	Float3Stream lefts(&left, 1), rights(&right, 1);
+	culler.CullThickRays(acrosses, rights, nullptr, &mask);
+	CHECK(mask == 0);
+	culler.CullThickRays(acrosses, lefts, nullptr, &mask);
+	CHECK(mask == 1);
+	culler.CullThickLines(acrosses, rights, nullptr, &mask);
+	CHECK(mask == 1);
+}
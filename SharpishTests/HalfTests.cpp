@@ -0,0 +1,163 @@
+#include "Test.h"
+#include <cstring>
+
+// The batch half conversions against a bit-exact reference, at every SIMD level: every half value decodes exactly,
+// and encoding rounds to nearest even, including ties, subnormals and overflow.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	uint32_t Bits(float f)
+	{
+		uint32_t x;
+		memcpy(&x, &f, sizeof(x));
+		return x;
+	}
+
+	double Decode(uint16_t h)
+	{
+		int exponent = (h >> 10) & 0x1f;
+		int mantissa = h & 0x3ff;
+		double sign = (h & 0x8000) ? -1 : 1;
+		if (exponent == 0x1f)
+			return mantissa ? NAN : sign * INFINITY;
+		if (exponent == 0)
+			return sign * std::ldexp(mantissa, -24);
+		return sign * std::ldexp(mantissa | 0x400, exponent - 25);
+	}
+
+	// Round to nearest even. NaNs come back as a quiet NaN; only their NaN-ness is compared.
+	uint16_t Encode(float f)
+	{
+		uint32_t x = Bits(f);
+		uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+		uint32_t magnitude = x & 0x7fffffff;
+
+		if (magnitude > 0x7f800000)
+			return sign | 0x7e00;
+		// 65520 and up, halfway past the largest half, round to infinity
+		if (magnitude >= 0x477ff000)
+			return sign | 0x7c00;
+		// Below the smallest normal half the result counts units of 2^-24, which scaling by 2^24 gives exactly
+		if (magnitude < 0x38800000)
+			return sign | (uint16_t)std::nearbyint(std::fabs(f) * 16777216.0f);
+
+		uint32_t rebiased = magnitude - 0x38000000;
+		return sign | (uint16_t)((rebiased + 0xfff + ((rebiased >> 13) & 1)) >> 13);
+	}
+
+	bool SameHalf(uint16_t actual, uint16_t expected)
+	{
+		bool actualNan = (actual & 0x7c00) == 0x7c00 && (actual & 0x3ff);
+		bool expectedNan = (expected & 0x7c00) == 0x7c00 && (expected & 0x3ff);
+		return actualNan || expectedNan ? actualNan == expectedNan : actual == expected;
+	}
+
+	bool SameFloat(float actual, double expected)
+	{
+		return std::isnan(expected) ? std::isnan(actual) : (double)actual == expected && std::signbit(actual) == std::signbit(expected);
+	}
+}
+
+TEST(Half_EveryValueDecodesExactly)
+{
+	std::vector<Half4> halves(16384);
+	for (size_t i = 0; i < halves.size(); i++)
+	{
+		halves[i].XBits = (uint16_t)(i * 4);
+		halves[i].YBits = (uint16_t)(i * 4 + 1);
+		halves[i].ZBits = (uint16_t)(i * 4 + 2);
+		halves[i].WBits = (uint16_t)(i * 4 + 3);
+	}
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		std::vector<Float4> floats(halves.size());
+		std::vector<Float4A> aligned(halves.size());
+		Half4::ToFloat(halves.data(), floats.data(), halves.size());
+		Half4::ToFloat(halves.data(), aligned.data(), halves.size());
+
+		size_t wrong = 0;
+		for (size_t i = 0; i < halves.size(); i++)
+		{
+			const float* f = &floats[i].X;
+			for (int k = 0; k < 4; k++)
+				wrong += !SameFloat(f[k], Decode((uint16_t)(i * 4 + k)));
+			wrong += !SameFloat(aligned[i].GetY(), Decode((uint16_t)(i * 4 + 1)));
+		}
+		CHECK(wrong == 0);
+	});
+}
+
+TEST(Half_EncodingRoundsToNearestEven)
+{
+	// Random magnitudes over the whole half range and past it, then the edge cases
+	Random random(121);
+	std::vector<float> values;
+	for (int i = 0; i < 20000; i++)
+	{
+		float magnitude = std::ldexp(random.Next(1.0f, 2.0f), (int)random.Next(48) - 28);
+		values.push_back(random.Next(2) ? magnitude : -magnitude);
+	}
+
+	const float edges[] = { 0.0f, -0.0f, 1.0f, 65504.0f, 65519.99f, 65520.0f, 1e6f, INFINITY, -INFINITY, NAN,
+		std::ldexp(1.0f, -14), std::ldexp(1.0f, -24), std::ldexp(1.0f, -25), std::ldexp(3.0f, -26), std::ldexp(1.0f, -26),
+		1.0f + std::ldexp(1.0f, -11), 1.0f + std::ldexp(3.0f, -11), 2049.0f, 2051.0f, 1e-10f };
+	values.insert(values.end(), edges, edges + sizeof(edges) / sizeof(edges[0]));
+	while (values.size() % 12)
+		values.push_back(0.5f);
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		size_t wrong = 0;
+
+		std::vector<Half2> h2(values.size() / 2);
+		Half2::FromFloat((const Float2*)values.data(), h2.data(), h2.size());
+		for (size_t i = 0; i < h2.size(); i++)
+			wrong += !SameHalf(h2[i].XBits, Encode(values[i * 2])) + !SameHalf(h2[i].YBits, Encode(values[i * 2 + 1]));
+
+		std::vector<Half3> h3(values.size() / 3);
+		Half3::FromFloat((const Float3*)values.data(), h3.data(), h3.size());
+		for (size_t i = 0; i < h3.size(); i++)
+			wrong += !SameHalf(h3[i].ZBits, Encode(values[i * 3 + 2]));
+
+		std::vector<Half4> h4(values.size() / 4);
+		std::vector<Float4A> aligned(h4.size());
+		memcpy(aligned.data(), values.data(), values.size() * sizeof(float));
+		Half4::FromFloat(aligned.data(), h4.data(), h4.size());
+		for (size_t i = 0; i < h4.size(); i++)
+			wrong += !SameHalf(h4[i].XBits, Encode(values[i * 4])) + !SameHalf(h4[i].WBits, Encode(values[i * 4 + 3]));
+
+		CHECK(wrong == 0);
+	});
+
+	// The single-value constructors round the same way
+	Half3 h(65520.0f, 1.0f + std::ldexp(1.0f, -11), -std::ldexp(3.0f, -26));
+	CHECK(h.XBits == 0x7c00 && h.YBits == 0x3c00 && h.ZBits == 0x8001);
+}
+
+TEST(Half_RoundTripsThroughFloat)
+{
+	Random random(122);
+	std::vector<Float3> values(999), back(999);
+	for (auto& v : values)
+		v = random.NextFloat3(-1000, 1000);
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		std::vector<Half3> halves(values.size());
+		Half3::FromFloat(values.data(), halves.data(), values.size());
+		Half3::ToFloat(halves.data(), back.data(), values.size());
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			// Half keeps 11 significant bits
+			CHECK_NEAR(back[i].X, values[i].X, std::fabs(values[i].X) / 2048);
+			CHECK_NEAR(back[i].Z, values[i].Z, std::fabs(values[i].Z) / 2048);
+			CHECK(Float3(Float3A(halves[i])).Y == back[i].Y);
+		}
+	});
+}
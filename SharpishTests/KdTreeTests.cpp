@@ -0,0 +1,200 @@
+#include "Test.h"
+#include <algorithm>
+#include <cfloat>
+
+// KdTree queries against brute force over the same points, for serial and parallel builds of several sizes. The
+// brute force computes distances the same way and breaks ties by index, so results match exactly.
+
+using namespace CS;
+using namespace SharpishTests;
+
+namespace
+{
+	// Empty, a single leaf, one split, and enough points for the parallel build's level-by-level splits
+	const size_t Counts[] = { 0, 1, KdTree::LeafSize, KdTree::LeafSize + 1, 1000, 50000 };
+
+	// Every tenth point repeats an earlier one, so there are ties, and every 13th shares its X with the first
+	std::vector<Float3> RandomPoints(size_t count, uint32_t seed)
+	{
+		Random random(seed);
+		std::vector<Float3> points(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			points[i] = random.NextFloat3(-50, 50);
+			if (i % 10 == 9)
+				points[i] = points[random.Next((uint32_t)i)];
+			if (i % 13 == 12)
+				points[i].X = points[0].X;
+		}
+		return points;
+	}
+
+	float DistanceSq(const Float3& p, const Float3& q)
+	{
+		float dx = p.X - q.X, dy = p.Y - q.Y, dz = p.Z - q.Z;
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	std::vector<std::pair<float, uint32_t>> BruteNearest(const std::vector<Float3>& points, const Float3& q, size_t k, float maxDistance)
+	{
+		std::vector<std::pair<float, uint32_t>> all;
+		for (uint32_t i = 0; i < points.size(); i++)
+		{
+			float distanceSq = DistanceSq(points[i], q);
+			if (distanceSq <= maxDistance * maxDistance)
+				all.emplace_back(distanceSq, i);
+		}
+		std::sort(all.begin(), all.end());
+		all.resize(std::min(all.size(), k));
+		return all;
+	}
+
+	std::vector<uint32_t> BruteInRadius(const std::vector<Float3>& points, const Float3& c, float radius)
+	{
+		std::vector<uint32_t> found;
+		for (uint32_t i = 0; i < points.size(); i++)
+			if (DistanceSq(points[i], c) <= radius * radius)
+				found.push_back(i);
+		return found;
+	}
+
+	// Queries near the points, on them, and well outside the cloud
+	std::vector<Float3> Queries(const std::vector<Float3>& points, size_t count, uint32_t seed)
+	{
+		Random random(seed);
+		std::vector<Float3> queries(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			queries[i] = random.NextFloat3(-60, 60);
+			if (i % 4 == 0 && !points.empty())
+				queries[i] = points[random.Next((uint32_t)points.size())];
+			if (i % 9 == 0)
+				queries[i].Y += 500;
+		}
+		return queries;
+	}
+}
+
+TEST(KdTree_FindNearestMatchesBruteForce)
+{
+	for (size_t count : Counts)
+	{
+		auto points = RandomPoints(count, 221);
+		auto queries = Queries(points, 100, 222);
+
+		for (bool parallel : { false, true })
+		{
+			KdTree tree(points.data(), count, parallel);
+			CHECK(tree.size() == count && tree.empty() == (count == 0));
+
+			for (size_t q = 0; q < queries.size(); q++)
+			{
+				size_t k = q % 3 == 0 ? 1 : q % 3 == 1 ? 5 : 40;
+				float maxDistance = q % 2 ? FLT_MAX : 8.0f;
+				auto expected = BruteNearest(points, queries[q], k, maxDistance);
+
+				// Appended after what's already there
+				std::vector<uint32_t> indices(1, 12345);
+				std::vector<float> distances(1, -1.0f);
+				CHECK(tree.FindNearest(Float3A(queries[q]), k, indices, &distances, maxDistance) == expected.size());
+				CHECK(indices.size() == expected.size() + 1 && distances.size() == expected.size() + 1);
+				CHECK(indices[0] == 12345 && distances[0] == -1.0f);
+
+				for (size_t j = 0; j < expected.size(); j++)
+				{
+					CHECK(indices[j + 1] == expected[j].second);
+					CHECK(distances[j + 1] == sqrtf(expected[j].first));
+				}
+			}
+		}
+	}
+
+	KdTree empty;
+	std::vector<uint32_t> indices;
+	CHECK(empty.FindNearest(Float3A(0, 0, 0), 3, indices) == 0 && indices.empty());
+	auto points = RandomPoints(100, 223);
+	KdTree tree(points.data(), points.size());
+	CHECK(tree.FindNearest(Float3A(0, 0, 0), 0, indices) == 0);
+	CHECK(tree.FindNearest(Float3A(0, 0, 0), 3, indices, nullptr, -1) == 0);
+	CHECK(tree.FindNearest(Float3A(0, 0, 0), 1000, indices) == 100);
+	CHECK_THROWS(KdTree((const Float3*)nullptr, 5), ArgumentNullException);
+}
+
+TEST(KdTree_FindInRadiusMatchesBruteForce)
+{
+	for (size_t count : Counts)
+	{
+		auto points = RandomPoints(count, 224);
+		auto queries = Queries(points, 100, 225);
+
+		for (bool parallel : { false, true })
+		{
+			KdTree tree(points.data(), count, parallel);
+			for (size_t q = 0; q < queries.size(); q++)
+			{
+				// Zero finds exact duplicates only
+				float radius = q % 5 == 0 ? 0 : q % 5 == 1 ? 30.0f : 3.0f;
+				std::vector<uint32_t> found;
+				CHECK(tree.FindInRadius(Float3A(queries[q]), radius, found) == found.size());
+				std::sort(found.begin(), found.end());
+				CHECK(found == BruteInRadius(points, queries[q], radius));
+			}
+		}
+	}
+}
+
+TEST(KdTree_BatchQueriesMatchSingleQueries)
+{
+	auto points = RandomPoints(30000, 226);
+	auto queries = Queries(points, 5000, 227);
+	Float3Stream stream(queries.data(), queries.size());
+	KdTree tree(points.data(), points.size());
+
+	const size_t k = 6;
+	const float maxDistance = 2.5f;
+	for (bool parallel : { false, true })
+	{
+		std::vector<int32_t> indices(queries.size() * k);
+		std::vector<float> distances(queries.size() * k);
+		tree.FindNearest(stream, k, indices.data(), distances.data(), maxDistance, parallel);
+
+		std::vector<int32_t> indicesOnly(queries.size() * k);
+		tree.FindNearest(stream, k, indicesOnly.data(), nullptr, maxDistance, parallel);
+		CHECK(indicesOnly == indices);
+
+		std::vector<uint32_t> inRadius, offsets;
+		tree.FindInRadius(stream, maxDistance, inRadius, offsets, parallel);
+		CHECK(offsets.size() == queries.size() + 1 && offsets[0] == 0 && offsets.back() == inRadius.size());
+
+		for (size_t i = 0; i < queries.size(); i++)
+		{
+			std::vector<uint32_t> single;
+			std::vector<float> singleDistances;
+			size_t found = tree.FindNearest(Float3A(queries[i]), k, single, &singleDistances, maxDistance);
+
+			// Rows are padded with -1 and maxDistance
+			for (size_t j = 0; j < k; j++)
+			{
+				CHECK(indices[i * k + j] == (j < found ? (int32_t)single[j] : -1));
+				CHECK(distances[i * k + j] == (j < found ? singleDistances[j] : maxDistance));
+			}
+
+			single.clear();
+			tree.FindInRadius(Float3A(queries[i]), maxDistance, single);
+			std::vector<uint32_t> row(inRadius.begin() + offsets[i], inRadius.begin() + offsets[i + 1]);
+			std::sort(single.begin(), single.end());
+			std::sort(row.begin(), row.end());
+			CHECK(row == single);
+		}
+	}
+
+	// No queries, and no points
+	std::vector<uint32_t> inRadius(3), offsets;
+	tree.FindInRadius(Float3Stream(), 1, inRadius, offsets);
+	CHECK(inRadius.empty() && offsets.size() == 1 && offsets[0] == 0);
+	KdTree empty;
+	std::vector<int32_t> indices(queries.size());
+	empty.FindNearest(stream, 1, indices.data(), nullptr);
+	CHECK(std::count(indices.begin(), indices.end(), -1) == (ptrdiff_t)queries.size());
+	CHECK_THROWS(tree.FindNearest(stream, 1, nullptr, nullptr), ArgumentNullException);
+}
@@ -0,0 +1,308 @@
+#include "Test.h"
+#include <algorithm>
+#include <cfloat>
+#include <map>
+
+// LooseOctree queries against brute force over the same spheres while objects are inserted, moved and removed.
+// The brute force uses the same float tests as the octree's objects, so results match exactly.
+
+using namespace CS;
+using namespace SharpishTests;
+
+namespace
+{
+	typedef LooseOctree::ObjectId ObjectId;
+	typedef std::map<ObjectId, BoundingSphere> Model;
+
+	// Mostly small props, some large ones, a few points, and every 40th centered outside the world
+	BoundingSphere RandomSphere(Random& random, uint32_t i)
+	{
+		Float3 center = random.NextFloat3(-100, 100);
+		float radius = i % 10 == 0 ? random.Next(10.0f, 40.0f) : random.Next(0.05f, 2.0f);
+		if (i % 17 == 0)
+			radius = 0;
+		if (i % 40 == 39)
+			center.X += 150;
+		return BoundingSphere(center, radius);
+	}
+
+	bool Same(const BoundingSphere& a, const BoundingSphere& b)
+	{
+		Float3 ca = a.GetCenter(), cb = b.GetCenter();
+		return ca.X == cb.X && ca.Y == cb.Y && ca.Z == cb.Z && a.GetRadius() == b.GetRadius();
+	}
+
+	bool SphereOverlaps(const BoundingSphere& s, const Float3& c, float radius)
+	{
+		Float3 p = s.GetCenter();
+		float dx = p.X - c.X, dy = p.Y - c.Y, dz = p.Z - c.Z, reach = s.GetRadius() + radius;
+		return dx * dx + dy * dy + dz * dz <= reach * reach;
+	}
+
+	bool BoxOverlaps(const BoundingSphere& s, const Float3& minima, const Float3& maxima)
+	{
+		Float3 p = s.GetCenter();
+		const float c[3] = { p.X, p.Y, p.Z };
+		const float center[3] = { (minima.X + maxima.X) / 2, (minima.Y + maxima.Y) / 2, (minima.Z + maxima.Z) / 2 };
+		const float extent[3] = { (maxima.X - minima.X) / 2, (maxima.Y - minima.Y) / 2, (maxima.Z - minima.Z) / 2 };
+		float distanceSq = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			float d = std::max(std::fabs(c[k] - center[k]) - extent[k], 0.0f);
+			distanceSq += d * d;
+		}
+		return distanceSq <= s.GetRadius() * s.GetRadius();
+	}
+
+	// The octree's ray-sphere test
+	bool RayHit(const Float3& origin, const Float3& direction, const BoundingSphere& s, float maxDistance, float& enter)
+	{
+		Float3 p = s.GetCenter();
+		float r = s.GetRadius();
+		float m[3] = { origin.X - p.X, origin.Y - p.Y, origin.Z - p.Z };
+		float b = m[0] * direction.X + m[1] * direction.Y + m[2] * direction.Z;
+		float c = m[0] * m[0] + m[1] * m[1] + m[2] * m[2] - r * r;
+		float a = direction.X * direction.X + direction.Y * direction.Y + direction.Z * direction.Z;
+
+		if (c <= 0)
+		{
+			enter = 0;
+			return true;
+		}
+
+		float discriminant = b * b - a * c;
+		if (b >= 0 || discriminant < 0 || a == 0)
+			return false;
+
+		enter = (-b - std::sqrt(discriminant)) / a;
+		return enter <= maxDistance;
+	}
+
+	std::vector<ObjectId> Sorted(std::vector<ObjectId> objects)
+	{
+		std::sort(objects.begin(), objects.end());
+		return objects;
+	}
+
+	void CheckAgainstBruteForce(const LooseOctree& octree, const Model& model, Random& random)
+	{
+		CHECK(octree.GetCount() == model.size());
+		for (auto& entry : model)
+		{
+			CHECK(octree.Contains(entry.first));
+			CHECK(Same(octree.GetSphere(entry.first), entry.second));
+		}
+
+		for (int q = 0; q < 20; q++)
+		{
+			Float3 center = random.NextFloat3(-130, 130);
+			float radius = random.Next(0.0f, 25.0f);
+			std::vector<ObjectId> found, expected;
+			CHECK(octree.Overlap(BoundingSphereA(center, radius), found) == found.size());
+			for (auto& entry : model)
+				if (SphereOverlaps(entry.second, center, radius))
+					expected.push_back(entry.first);
+			CHECK(Sorted(found) == expected);
+
+			Float3 size = random.NextFloat3(0, 40);
+			Float3 maxima(center.X + size.X, center.Y + size.Y, center.Z + size.Z);
+			found.clear();
+			expected.clear();
+			CHECK(octree.Overlap(BoundingBoxA(Float3A(center), Float3A(maxima)), found) == found.size());
+			for (auto& entry : model)
+				if (BoxOverlaps(entry.second, center, maxima))
+					expected.push_back(entry.first);
+			CHECK(Sorted(found) == expected);
+		}
+
+		for (int q = 0; q < 20; q++)
+		{
+			Float3 origin = random.NextFloat3(-150, 150), direction = random.NextFloat3(-1, 1);
+			// Some rays run along an axis, and some are segments
+			if (q % 4 == 0)
+				direction.Y = direction.Z = 0;
+			float maxDistance = q % 3 == 0 ? random.Next(10.0f, 200.0f) : FLT_MAX;
+
+			std::vector<ObjectId> found, expected;
+			ObjectId closest = LooseOctree::None;
+			float closestEnter = FLT_MAX;
+			for (auto& entry : model)
+			{
+				float enter;
+				if (RayHit(origin, direction, entry.second, maxDistance, enter))
+				{
+					expected.push_back(entry.first);
+					if (enter < closestEnter)
+					{
+						closestEnter = enter;
+						closest = entry.first;
+					}
+				}
+			}
+
+			CHECK(octree.RaycastAll(Float3A(origin), Float3A(direction), maxDistance, found) == found.size());
+			CHECK(Sorted(found) == expected);
+
+			ObjectId first;
+			float distance;
+			bool hit = octree.RaycastFirst(Float3A(origin), Float3A(direction), maxDistance, first, distance);
+			CHECK(hit == (closest != LooseOctree::None));
+			if (hit)
+			{
+				// Ties may go to either object
+				float enter;
+				CHECK(distance == closestEnter);
+				CHECK(RayHit(origin, direction, model.at(first), maxDistance, enter) && enter == distance);
+			}
+		}
+
+		for (int q = 0; q < 10; q++)
+		{
+			Float3 eye = random.NextFloat3(-150, 150), target = random.NextFloat3(-30, 30);
+			auto viewProjection = Float4x4A::LookAt(Float3A(eye), Float3A(target), Float3A(0, 1, 0)) * Float4x4A::PerspectiveFov(random.Next(0.3f, 1.5f), 1.5f, 1, random.Next(50.0f, 400.0f));
+			FrustumCuller culler(viewProjection);
+
+			std::vector<ObjectId> visible, expected;
+			CHECK(octree.Cull(culler, visible) == visible.size());
+			for (auto& entry : model)
+				if (culler.IsVisible(entry.second))
+					expected.push_back(entry.first);
+			CHECK(Sorted(visible) == expected);
+		}
+	}
+}
+
+TEST(LooseOctree_SimulationMatchesBruteForce)
+{
+	LooseOctree octree(BoundingBoxA(Float3A(-100, -100, -100), Float3A(100, 100, 100)));
+	Model model;
+	Random random(211);
+	uint32_t next = 0;
+
+	for (int i = 0; i < 3000; i++)
+	{
+		auto sphere = RandomSphere(random, next++);
+		ObjectId id = octree.Insert(sphere);
+		CHECK(!model.count(id));
+		model[id] = sphere;
+	}
+	CheckAgainstBruteForce(octree, model, random);
+
+	for (int step = 0; step < 6; step++)
+	{
+		// Most objects drift, a few jump, some grow or shrink
+		for (auto& entry : model)
+		{
+			if (random.Next(3u))
+				continue;
+			BoundingSphere sphere = entry.second;
+			Float3 c = sphere.GetCenter(), d = random.NextFloat3(-0.5f, 0.5f);
+			if (random.Next(20u) == 0)
+				sphere = RandomSphere(random, next++);
+			else if (random.Next(10u) == 0)
+				sphere = BoundingSphere(c, sphere.GetRadius() * random.Next(0.2f, 5.0f));
+			else
+				sphere = BoundingSphere(Float3(c.X + d.X, c.Y + d.Y, c.Z + d.Z), sphere.GetRadius());
+			octree.Move(entry.first, sphere);
+			entry.second = sphere;
+		}
+
+		// Remove some and insert others, which may reuse their ids
+		for (int r = 0; r < 200; r++)
+		{
+			auto it = model.begin();
+			std::advance(it, random.Next((uint32_t)model.size()));
+			octree.Remove(it->first);
+			CHECK(!octree.Contains(it->first));
+			model.erase(it);
+		}
+		for (int a = 0; a < 200; a++)
+		{
+			auto sphere = RandomSphere(random, next++);
+			model[octree.Insert(sphere)] = sphere;
+		}
+
+		CheckAgainstBruteForce(octree, model, random);
+	}
+
+	// Emptied nodes are pruned back to the root
+	while (!model.empty())
+	{
+		octree.Remove(model.begin()->first);
+		model.erase(model.begin());
+	}
+	CHECK(octree.GetCount() == 0 && octree.GetNodeCount() == 1);
+	std::vector<ObjectId> found;
+	CHECK(octree.Overlap(BoundingSphereA(Float3(0, 0, 0), 1000), found) == 0);
+}
+
+TEST(LooseOctree_InsertManyMatchesInsert)
+{
+	const size_t count = 20000;
+	Random random(212);
+	std::vector<BoundingSphere> spheres(count);
+	for (uint32_t i = 0; i < count; i++)
+		spheres[i] = RandomSphere(random, i);
+
+	LooseOctree single(BoundingBoxA(Float3A(-100, -100, -100), Float3A(100, 100, 100)), 10);
+	for (auto& sphere : spheres)
+		single.Insert(sphere);
+
+	for (bool parallel : { false, true })
+	{
+		LooseOctree octree(BoundingBoxA(Float3A(-100, -100, -100), Float3A(100, 100, 100)), 10);
+		// Ids freed before the batch are reused by it
+		ObjectId removed = octree.Insert(spheres[0]);
+		octree.Remove(removed);
+
+		std::vector<ObjectId> ids(count);
+		octree.InsertMany(spheres.data(), count, ids.data(), parallel);
+		CHECK(octree.GetCount() == count && octree.GetNodeCount() == single.GetNodeCount());
+		CHECK(std::count(ids.begin(), ids.end(), removed) == 1);
+
+		std::vector<ObjectId> sortedIds = Sorted(ids);
+		CHECK(std::adjacent_find(sortedIds.begin(), sortedIds.end()) == sortedIds.end());
+		for (size_t i = 0; i < count; i++)
+			CHECK(Same(octree.GetSphere(ids[i]), spheres[i]));
+
+		Model model;
+		for (size_t i = 0; i < count; i++)
+			model[ids[i]] = spheres[i];
+		Random queries(213);
+		CheckAgainstBruteForce(octree, model, queries);
+	}
+
+	LooseOctree octree(BoundingBoxA(Float3A(-1, -1, -1), Float3A(1, 1, 1)));
+	octree.InsertMany(nullptr, 0);
+	CHECK_THROWS(octree.InsertMany(nullptr, 1), ArgumentNullException);
+}
+
+TEST(LooseOctree_MoveRelocatesOnlyAcrossCells)
+{
+	// A 64-wide world at depth 3 has 8-wide cells at the deepest level
+	LooseOctree octree(BoundingBoxA(Float3A(0, 0, 0), Float3A(64, 64, 64)), 3);
+	ObjectId id = octree.Insert(BoundingSphere(Float3(1, 1, 1), 0.5f));
+	CHECK(octree.GetNodeCount() == 4);
+
+	// Within the cell, and then across into its neighbour
+	CHECK(!octree.Move(id, BoundingSphere(Float3(7, 2, 3), 0.5f)));
+	CHECK(octree.Move(id, BoundingSphere(Float3(9, 2, 3), 0.5f)));
+	CHECK(octree.GetNodeCount() == 4);
+
+	// Growing past the cell size moves it up a level, and leaving the world moves it into the root
+	CHECK(octree.Move(id, BoundingSphere(Float3(9, 2, 3), 5)));
+	CHECK(octree.GetNodeCount() == 3);
+	CHECK(octree.Move(id, BoundingSphere(Float3(-5, 2, 3), 5)));
+	CHECK(octree.GetNodeCount() == 1);
+	CHECK(!octree.Move(id, BoundingSphere(Float3(100, 2, 3), 0.5f)));
+
+	std::vector<ObjectId> found;
+	CHECK(octree.Overlap(BoundingSphereA(Float3(100, 2, 3.4f), 0), found) == 1 && found[0] == id);
+
+	octree.Remove(id);
+	CHECK_THROWS(octree.Remove(id), ArgumentException);
+	CHECK_THROWS(octree.Move(id, BoundingSphere()), ArgumentException);
+	CHECK_THROWS(octree.GetSphere(-1), ArgumentException);
+	CHECK_THROWS(LooseOctree(BoundingBoxA(), 3), ArgumentException);
+	CHECK_THROWS(LooseOctree(BoundingBoxA(Float3A(0, 0, 0), Float3A(1, 1, 1)), LooseOctree::MaxDepth + 1), ArgumentException);
+}
@@ -0,0 +1,154 @@
+#include "Test.h"
+#include <cstring>
+
+using namespace SharpishTests;
+
+namespace
+{
+	struct Registration
+	{
+		const char* Name;
+		TestFunction Run;
+		bool IsBenchmark;
+	};
+
+	std::vector<Registration>& Registry()
+	{
+		static std::vector<Registration> registry;
+		return registry;
+	}
+
+	int _failures = 0;
+}
+
+Registrar::Registrar(const char* name, TestFunction run, bool isBenchmark)
+{
+	Registry().push_back({ name, run, isBenchmark });
+}
+
+void SharpishTests::Fail(const char* file, int line, const std::string& what)
+{
+	if (_failures++ < 200)
+		printf("  %s(%d): CHECK failed: %s\n", file, line, what.c_str());
+}
+
+std::string SharpishTests::Describe(double actual, double expected, double tolerance)
+{
+	char text[128];
+	snprintf(text, sizeof(text), "got %.9g, expected %.9g within %.3g", actual, expected, tolerance);
+	return text;
+}
+
+namespace
+{
+	void CheckNear(const float* actual, const float* expected, int count, double tolerance, double scale)
+	{
+		for (int i = 0; i < count; i++)
+			scale = std::fmax(scale, std::fabs(expected[i]));
+		for (int i = 0; i < count; i++)
+			CHECK_NEAR(actual[i], expected[i], tolerance * std::fmax(1.0, scale));
+	}
+}
+
+void SharpishTests::CheckNear(DirectX::FXMVECTOR actual, DirectX::FXMVECTOR expected, double tolerance, double scale, int components)
+{
+	DirectX::XMFLOAT4 a, e;
+	DirectX::XMStoreFloat4(&a, actual);
+	DirectX::XMStoreFloat4(&e, expected);
+	::CheckNear(&a.x, &e.x, components, tolerance, scale);
+}
+
+void SharpishTests::CheckNear(const DirectX::XMMATRIX& actual, const DirectX::XMMATRIX& expected, double tolerance)
+{
+	DirectX::XMFLOAT4X4 a, e;
+	DirectX::XMStoreFloat4x4(&a, actual);
+	DirectX::XMStoreFloat4x4(&e, expected);
+	::CheckNear(&a.m[0][0], &e.m[0][0], 16, tolerance, 0);
+}
+
+void SharpishTests::CheckNear(const CS::BoundingBoxA& actual, const CS::BoundingBoxA& expected, double tolerance)
+{
+	CS::Float3 alo = actual.Minima, ahi = actual.Maxima, elo = expected.Minima, ehi = expected.Maxima;
+	const float a[6] = { alo.X, alo.Y, alo.Z, ahi.X, ahi.Y, ahi.Z }, e[6] = { elo.X, elo.Y, elo.Z, ehi.X, ehi.Y, ehi.Z };
+	::CheckNear(a, e, 6, tolerance, 0);
+}
+
+double SharpishTests::Measure(const std::function<void()>& body)
+{
+	typedef std::chrono::steady_clock Clock;
+	body();
+
+	size_t calls = 0;
+	auto start = Clock::now();
+	auto elapsed = Clock::duration::zero();
+	for (size_t batch = 1; elapsed < std::chrono::milliseconds(200); batch *= 2)
+	{
+		for (size_t i = 0; i < batch; i++)
+			body();
+		calls += batch;
+		elapsed = Clock::now() - start;
+	}
+	return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
+
+void SharpishTests::Report(const char* what, double value, const char* unit)
+{
+	printf("  %-56s %12.3f %s\n", what, value, unit);
+}
+
+const char* SharpishTests::SimdLevelName(CS::Help::Math::SimdLevel level)
+{
+	switch (level)
+	{
+	case CS::Help::Math::SimdLevel::AVX2: return "AVX2";
+	case CS::Help::Math::SimdLevel::AVX512: return "AVX-512";
+	default: return "Baseline";
+	}
+}
+
+// usage: SharpishTests [--bench] [name prefix...]
+int main(int argc, char** argv)
+{
+	bool benchmarks = false;
+	std::vector<const char*> prefixes;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--bench"))
+			benchmarks = true;
+		else
+			prefixes.push_back(argv[i]);
+	}
+
+	int run = 0, failed = 0;
+	for (auto& test : Registry())
+	{
+		if (test.IsBenchmark != benchmarks)
+			continue;
+
+		bool selected = prefixes.empty();
+		for (auto prefix : prefixes)
+			selected |= !strncmp(test.Name, prefix, strlen(prefix));
+		if (!selected)
+			continue;
+
+		printf("%s\n", test.Name);
+		fflush(stdout);
+
+		int before = _failures;
+		try
+		{
+			test.Run();
+		}
+		catch (const std::exception& e)
+		{
+			Fail(__FILE__, __LINE__, std::string("unexpected exception: ") + e.what());
+		}
+
+		run++;
+		if (_failures != before)
+			failed++;
+	}
+
+	printf("%d run, %d failed\n", run, failed);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+#include "Test.h"
+
+// The batch matrix kernels in Help::Math against DirectXMath, at every SIMD level.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	const size_t Counts[] = { 0, 1, 7, 16, 61 };
+
+	// Affine transforms with scales well away from zero, so the inverses are well conditioned
+	XMMATRIX RandomAffine(Random& random)
+	{
+		auto scale = XMVectorSet(random.Next(0.5f, 2.0f), random.Next(0.5f, 2.0f), random.Next(0.5f, 2.0f), 0);
+		auto rotation = XMQuaternionRotationRollPitchYaw(random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f));
+		auto translation = XMVectorSet(random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f), 0);
+		return XMMatrixAffineTransformation(scale, XMVectorZero(), rotation, translation);
+	}
+
+	// A general 4x4 matrix: an affine transform with a perspective column
+	XMMATRIX RandomGeneral(Random& random)
+	{
+		auto m = RandomAffine(random);
+		m.r[0] = XMVectorSetW(m.r[0], random.Next(-0.2f, 0.2f));
+		m.r[1] = XMVectorSetW(m.r[1], random.Next(-0.2f, 0.2f));
+		m.r[2] = XMVectorSetW(m.r[2], random.Next(-0.2f, 0.2f));
+		m.r[3] = XMVectorSetW(m.r[3], random.Next(0.5f, 2.0f));
+		return m;
+	}
+}
+
+TEST(MatrixBatch_MultiplyMatchesDirectXMath)
+{
+	Random random(91);
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<Float4x4A> a(count), b(count), out(count);
+			std::vector<Float4x3A> a3(count), b3(count), out3(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				a[i] = RandomGeneral(random);
+				b[i] = RandomGeneral(random);
+				a3[i] = RandomAffine(random);
+				b3[i] = RandomAffine(random);
+			}
+			Float4x4A m = RandomGeneral(random);
+			Float4x3A m3 = RandomAffine(random);
+
+			Help::Math::MultiplyMany(a.data(), b.data(), out.data(), count);
+			for (size_t i = 0; i < count; i++)
+				CheckNear(out[i], XMMatrixMultiply(a[i], b[i]), 1e-6);
+
+			Help::Math::MultiplyMany(a3.data(), b3.data(), out3.data(), count);
+			for (size_t i = 0; i < count; i++)
+				CheckNear(out3[i], XMMatrixMultiply(a3[i], b3[i]), 1e-6);
+
+			Help::Math::MultiplyByOne(a.data(), m, out.data(), count);
+			for (size_t i = 0; i < count; i++)
+				CheckNear(out[i], XMMatrixMultiply(a[i], m), 1e-6);
+
+			// In place
+			auto copy = a3;
+			Help::Math::MultiplyByOne(a3.data(), m3, a3.data(), count);
+			for (size_t i = 0; i < count; i++)
+				CheckNear(a3[i], XMMatrixMultiply(copy[i], m3), 1e-6);
+		}
+	});
+}
+
+TEST(MatrixBatch_MultiplyByParentsResolvesHierarchy)
+{
+	Random random(92);
+	const size_t count = 50;
+	std::vector<Float4x3A> local(count), world(count);
+	std::vector<int> parents(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		local[i] = RandomAffine(random);
+		parents[i] = i == 0 || i % 9 == 0 ? -1 : (int)random.Next((uint32_t)i);
+	}
+
+	Help::Math::MultiplyByParents(local.data(), parents.data(), world.data(), 0, count);
+	for (size_t i = 0; i < count; i++)
+	{
+		XMMATRIX expected = local[i];
+		for (int p = parents[i]; p >= 0; p = parents[p])
+			expected = XMMatrixMultiply(expected, local[p]);
+		CheckNear(world[i], expected, 1e-5);
+	}
+}
+
+TEST(MatrixBatch_InverseAndDeterminantMatchDirectXMath)
+{
+	Random random(93);
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<Float4x4A> m(count), inverse(count);
+			std::vector<Float4x3A> affine(count), affineInverse(count);
+			std::vector<float> determinants(count), inverseDeterminants(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				m[i] = RandomGeneral(random);
+				affine[i] = RandomAffine(random);
+			}
+
+			Help::Math::InverseMany(m.data(), inverse.data(), count, inverseDeterminants.data());
+			Help::Math::DeterminantMany(m.data(), determinants.data(), count);
+			Help::Math::InverseAffine(affine.data(), affineInverse.data(), count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				XMVECTOR determinant;
+				XMMATRIX expected = XMMatrixInverse(&determinant, m[i]);
+				CheckNear(inverse[i], expected, 1e-5);
+				double d = XMVectorGetX(determinant);
+				CHECK_NEAR(determinants[i], d, 1e-5 * std::fmax(1.0, std::fabs(d)));
+				CHECK_NEAR(inverseDeterminants[i], d, 1e-5 * std::fmax(1.0, std::fabs(d)));
+
+				CheckNear(XMMatrixMultiply(affine[i], affineInverse[i]), XMMatrixIdentity(), 1e-5);
+			}
+		}
+	});
+}
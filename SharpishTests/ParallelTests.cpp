@@ -0,0 +1,80 @@
+#include "Test.h"
+#include "MathParallel.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+using namespace CS;
+using namespace SharpishTests;
+
+TEST(Parallel_CoversEveryElementOnce)
+{
+	const size_t count = 100003;
+	std::vector<std::atomic<int>> hits(count);
+	for (auto& h : hits)
+		h = 0;
+
+	Details::ParallelFor(count, 64, [&](size_t begin, size_t end)
+	{
+		CHECK(begin % 64 == 0);
+		for (size_t i = begin; i < end; i++)
+			hits[i]++;
+	});
+
+	size_t wrong = 0;
+	for (auto& h : hits)
+		wrong += h != 1;
+	CHECK(wrong == 0);
+}
+
+TEST(Parallel_RethrowsOnCaller)
+{
+	CHECK_THROWS(Details::ParallelFor(10000, 16, [](size_t, size_t end) { if (end > 5000) throw std::runtime_error("chunk"); }),
+		std::runtime_error);
+}
+
+// A chunk of the first call waits for the second call to start, which a pool that ran one call at a time would
+// never allow
+TEST(Parallel_ConcurrentCallersOverlap)
+{
+	if (Details::ParallelThreadCount() < 2)
+		return;
+
+	std::atomic<bool> secondStarted(false), timedOut(false);
+	auto waitForSecond = [&]
+	{
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (!secondStarted)
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+			{
+				timedOut = true;
+				return;
+			}
+			std::this_thread::yield();
+		}
+	};
+
+	std::atomic<size_t> firstSum(0), secondSum(0);
+	std::thread first([&]
+	{
+		Details::ParallelFor(1024, 1, [&](size_t begin, size_t end)
+		{
+			if (begin == 0)
+				waitForSecond();
+			firstSum += end - begin;
+		});
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	Details::ParallelFor(1024, 1, [&](size_t begin, size_t end)
+	{
+		secondStarted = true;
+		secondSum += end - begin;
+	});
+
+	first.join();
+	CHECK(!timedOut);
+	CHECK(firstSum == 1024);
+	CHECK(secondSum == 1024);
+}
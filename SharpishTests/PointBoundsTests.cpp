@@ -0,0 +1,223 @@
+#include "Test.h"
+#include <algorithm>
+#include <cfloat>
+
+// BoundingBoxA::OfPoints against a scalar reduction at every SIMD level, and BoundingSphereA::OfPoints for
+// containment of every point and for point sets whose smallest sphere is known.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	// Partial and whole registers, and more than one piece of work
+	const size_t Counts[] = { 1, 3, 7, 16, 33, 16384, 100003 };
+
+	const double Pi = 3.14159265358979323846;
+
+	// Unit directions, uniform over the sphere
+	Float3 RandomDirection(Random& random)
+	{
+		for (;;)
+		{
+			Float3 v = random.NextFloat3(-1, 1);
+			double lengthSq = (double)v.X * v.X + (double)v.Y * v.Y + (double)v.Z * v.Z;
+			if (lengthSq > 1e-4 && lengthSq <= 1)
+			{
+				double s = 1 / std::sqrt(lengthSq);
+				return Float3((float)(v.X * s), (float)(v.Y * s), (float)(v.Z * s));
+			}
+		}
+	}
+
+	Float3 Along(const Float3& center, const Float3& direction, float distance)
+	{
+		return Float3(center.X + direction.X * distance, center.Y + direction.Y * distance, center.Z + direction.Z * distance);
+	}
+
+	double Distance(const Float3& a, const Float3& b)
+	{
+		double dx = (double)a.X - b.X, dy = (double)a.Y - b.Y, dz = (double)a.Z - b.Z;
+		return std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+
+	// Every point in the float sphere, measured exactly
+	void CheckHolds(const BoundingSphereA& sphere, const std::vector<Float3>& points)
+	{
+		Float3 center = sphere.GetCenter();
+		double radius = sphere.GetRadius(), furthest = 0;
+		for (auto& p : points)
+			furthest = std::max(furthest, Distance(p, center));
+		CHECK(furthest <= radius);
+	}
+
+	// Within rounding of the known smallest sphere
+	void CheckSmallest(const BoundingSphereA& sphere, const Float3& center, double radius)
+	{
+		double scale = std::max({ radius, (double)std::fabs(center.X), (double)std::fabs(center.Y), (double)std::fabs(center.Z) });
+		CHECK_NEAR(sphere.GetRadius(), radius, 1e-5 * scale);
+		CHECK(Distance(sphere.GetCenter(), center) <= 1e-4 * scale);
+	}
+
+	std::vector<Float3A> Aligned(const std::vector<Float3>& points)
+	{
+		return std::vector<Float3A>(points.begin(), points.end());
+	}
+}
+
+TEST(PointBounds_BoxMatchesScalarReduction)
+{
+	Random random(251);
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<Float3> points(count);
+			for (auto& p : points)
+				p = random.NextFloat3(-1000, 1000);
+			// The extremes anywhere, including the last, partial register
+			points[count - 1].Y = 5000;
+			points[count / 2].Z = -5000;
+			auto aligned = Aligned(points);
+			Float3Stream stream(points.data(), count);
+
+			float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (auto& p : points)
+			{
+				const float c[3] = { p.X, p.Y, p.Z };
+				for (int k = 0; k < 3; k++)
+				{
+					lo[k] = std::min(lo[k], c[k]);
+					hi[k] = std::max(hi[k], c[k]);
+				}
+			}
+			BoundingBoxA expected(Float3A(lo[0], lo[1], lo[2]), Float3A(hi[0], hi[1], hi[2]));
+
+			for (bool parallel : { false, true })
+			{
+				CHECK(BoundingBoxA::OfPoints(points.data(), count, parallel) == expected);
+				CHECK(BoundingBoxA::OfPoints(aligned.data(), count, parallel) == expected);
+				CHECK(BoundingBoxA::OfPoints(stream, parallel) == expected);
+			}
+
+			// The point constructors reduce the same way
+			CHECK(BoundingBoxA(aligned.data(), (int)count) == expected);
+			CHECK(BoundingBoxA(BoundingBox(aligned.data(), (int)count)) == expected);
+		}
+	});
+
+	CHECK(BoundingBoxA::OfPoints((const Float3*)nullptr, 0) == BoundingBoxA());
+	CHECK(BoundingBoxA::OfPoints(Float3Stream()) == BoundingBoxA());
+	CHECK_THROWS(BoundingBoxA::OfPoints((const Float3*)nullptr, 3), ArgumentNullException);
+}
+
+TEST(PointBounds_SphereHoldsEveryPoint)
+{
+	Random random(252);
+	for (size_t count : Counts)
+	{
+		// A skewed cloud: a dense lump and a sparse tail, away from the origin
+		std::vector<Float3> points(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			points[i] = random.NextFloat3(-10, 10);
+			if (i % 50 == 0)
+				points[i] = Along(points[i], RandomDirection(random), random.Next(0.0f, 200.0f));
+			points[i].X += 1000;
+		}
+		auto aligned = Aligned(points);
+
+		auto serial = BoundingSphereA::OfPoints(points.data(), count, false);
+		auto parallel = BoundingSphereA::OfPoints(points.data(), count, true);
+		CheckHolds(serial, points);
+		CheckHolds(parallel, points);
+
+		// The layouts only differ in stride, and the threads at most in a Ritter fallback
+		auto fromAligned = BoundingSphereA::OfPoints(aligned.data(), count, false);
+		CHECK(fromAligned.GetRadius() == serial.GetRadius());
+		CHECK(Distance(fromAligned.GetCenter(), serial.GetCenter()) == 0);
+		CHECK_NEAR(parallel.GetRadius(), serial.GetRadius(), 1e-5 * serial.GetRadius());
+
+		BoundingSphere unaligned = BoundingSphere::OfPoints(points.data(), count);
+		CHECK_NEAR(unaligned.GetRadius(), parallel.GetRadius(), 1e-5 * serial.GetRadius());
+
+		// No looser than the sphere around the box
+		auto ofBox = BoundingSphereA::OfBox(BoundingBoxA::OfPoints(points.data(), count));
+		CHECK(serial.GetRadius() <= ofBox.GetRadius() * (1 + 1e-6));
+	}
+}
+
+TEST(PointBounds_SphereIsTheSmallest)
+{
+	Random random(253);
+	const Float3 center(30, -20, 500);
+	const float radius = 40;
+
+	for (size_t count : { (size_t)100, (size_t)100000 })
+	{
+		// A diameter along X, with every other point well inside
+		std::vector<Float3> points;
+		points.push_back(Float3(center.X - radius, center.Y, center.Z));
+		for (size_t i = 0; i < count; i++)
+			points.push_back(Along(center, RandomDirection(random), random.Next(0.0f, 0.9f * radius)));
+		points.push_back(Float3(center.X + radius, center.Y, center.Z));
+		for (bool parallel : { false, true })
+		{
+			auto sphere = BoundingSphereA::OfPoints(points.data(), points.size(), parallel);
+			CheckHolds(sphere, points);
+			CheckSmallest(sphere, center, radius);
+		}
+
+		// Points all over the surface, which a Ritter sphere alone bounds a few percent loosely
+		points.clear();
+		for (size_t i = 0; i < count; i++)
+			points.push_back(Along(center, RandomDirection(random), radius));
+		for (bool parallel : { false, true })
+		{
+			auto sphere = BoundingSphereA::OfPoints(points.data(), points.size(), parallel);
+			CheckHolds(sphere, points);
+			CHECK(sphere.GetRadius() <= radius * (1 + 1e-5));
+			CHECK(sphere.GetRadius() >= radius * (1 - 1e-2));
+		}
+	}
+
+	// An equilateral triangle's circumcircle, which no pair of its points spans
+	std::vector<Float3> triangle;
+	for (int k = 0; k < 3; k++)
+		triangle.push_back(Float3(center.X + radius * (float)std::cos(2 * Pi * k / 3), center.Y + radius * (float)std::sin(2 * Pi * k / 3), center.Z));
+	for (int i = 0; i < 50; i++)
+		triangle.push_back(Along(center, RandomDirection(random), random.Next(0.0f, 0.45f * radius)));
+	auto circumcircle = BoundingSphereA::OfPoints(triangle.data(), triangle.size());
+	CheckHolds(circumcircle, triangle);
+	CheckSmallest(circumcircle, center, radius);
+
+	// A regular tetrahedron's circumsphere, which needs all four
+	const float s = radius / std::sqrt(3.0f);
+	std::vector<Float3> tetrahedron =
+	{
+		Float3(center.X + s, center.Y + s, center.Z + s), Float3(center.X + s, center.Y - s, center.Z - s),
+		Float3(center.X - s, center.Y + s, center.Z - s), Float3(center.X - s, center.Y - s, center.Z + s),
+	};
+	auto circumsphere = BoundingSphereA::OfPoints(tetrahedron.data(), tetrahedron.size());
+	CheckHolds(circumsphere, tetrahedron);
+	CheckSmallest(circumsphere, center, radius);
+
+	// Degenerate sets
+	std::vector<Float3> same(1000, center);
+	auto point = BoundingSphereA::OfPoints(same.data(), same.size());
+	CheckHolds(point, same);
+	CHECK(point.GetRadius() <= 1e-4f && Distance(point.GetCenter(), center) == 0);
+
+	std::vector<Float3> line;
+	for (int i = 0; i <= 100; i++)
+		line.push_back(Float3(center.X, center.Y - radius + 2 * radius * i / 100, center.Z));
+	auto segment = BoundingSphereA::OfPoints(line.data(), line.size());
+	CheckHolds(segment, line);
+	CheckSmallest(segment, center, radius);
+
+	auto none = BoundingSphereA::OfPoints((const Float3*)nullptr, 0);
+	CHECK(none.GetRadius() == 0);
+	CHECK_THROWS(BoundingSphereA::OfPoints((const Float3*)nullptr, 2), ArgumentNullException);
+}
@@ -0,0 +1,156 @@
+#include "Test.h"
+#include <string>
+
+// The precision tiers of the batch Normalize and Length against double precision, at every SIMD level, within the
+// bounds that MathPrecision.h documents, and the benchmark that measures its table.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	const double Ulp = 1.0 / (1 << 23);
+	// The rounding of the dot product and of the multiply by the reciprocal, on top of the reciprocal square root
+	const double Slack = 2 * Ulp;
+
+	// Vectors in every direction, with lengths spread over the range whose squares are normal floats
+	std::vector<Float3A> Vectors(size_t count, uint32_t seed)
+	{
+		Random random(seed);
+		std::vector<Float3A> vectors(count);
+		for (auto& v : vectors)
+		{
+			Float3 d = random.NextFloat3(-1, 1);
+			float scale = powf(10, random.Next(-15.0f, 15.0f));
+			v = Float3A(d.X * scale, d.Y * scale, d.Z * scale);
+		}
+		return vectors;
+	}
+
+	double LengthOf(const Float3A& v)
+	{
+		double x = v.GetX(), y = v.GetY(), z = v.GetZ();
+		return std::sqrt(x * x + y * y + z * z);
+	}
+
+	// The largest error of any component of the unit vectors, and the largest relative error of the lengths
+	template<Precision P>
+	void Errors(const std::vector<Float3A>& vectors, double& outNormalize, double& outLength)
+	{
+		std::vector<Float3A> normalized(vectors.size());
+		std::vector<float> lengths(vectors.size());
+		Help::Math::Normalize<P>(vectors.data(), normalized.data(), vectors.size());
+		Help::Math::Length<P>(vectors.data(), lengths.data(), vectors.size());
+
+		outNormalize = outLength = 0;
+		for (size_t i = 0; i < vectors.size(); i++)
+		{
+			const Float3A& v = vectors[i];
+			double length = LengthOf(v);
+			outNormalize = std::fmax(outNormalize, std::fabs(normalized[i].GetX() - v.GetX() / length));
+			outNormalize = std::fmax(outNormalize, std::fabs(normalized[i].GetY() - v.GetY() / length));
+			outNormalize = std::fmax(outNormalize, std::fabs(normalized[i].GetZ() - v.GetZ() / length));
+			outLength = std::fmax(outLength, std::fabs(lengths[i] - length) / length);
+		}
+	}
+
+	// The documented reciprocal square root error of tier P at a level
+	double Bound(Precision p, SimdLevel level)
+	{
+		bool wide = level == SimdLevel::AVX512;
+		switch (p)
+		{
+		case Precision::Exact: return Ulp;
+		case Precision::Refined: return wide ? 1.2e-7 : 2.4e-7;
+		default: return wide ? 6.0e-5 : 3.3e-4;
+		}
+	}
+
+	// A whole number of registers at every level meets that level's bound. The elements left over by a ragged
+	// count take the SSE path, so the looser SSE bound covers those.
+	template<Precision P>
+	void CheckTier(const std::vector<Float3A>& whole, const std::vector<Float3A>& ragged)
+	{
+		ForEachSimdLevel([&](SimdLevel level)
+		{
+			double normalizeError, lengthError;
+			Errors<P>(whole, normalizeError, lengthError);
+			CHECK_NEAR(normalizeError, 0, Bound(P, level) + Slack);
+			CHECK_NEAR(lengthError, 0, Bound(P, level) + Slack);
+
+			Errors<P>(ragged, normalizeError, lengthError);
+			CHECK_NEAR(normalizeError, 0, Bound(P, SimdLevel::Baseline) + Slack);
+			CHECK_NEAR(lengthError, 0, Bound(P, SimdLevel::Baseline) + Slack);
+		});
+	}
+}
+
+TEST(Precision_TiersWithinDocumentedBounds)
+{
+	auto whole = Vectors(4096, 51);
+	auto ragged = Vectors(4003, 53);
+	CheckTier<Precision::Exact>(whole, ragged);
+	CheckTier<Precision::Refined>(whole, ragged);
+	CheckTier<Precision::Estimate>(whole, ragged);
+}
+
+TEST(Precision_ZeroVectors)
+{
+	std::vector<Float3A> zeros(37, Float3A(0, 0, 0));
+	std::vector<Float3A> normalized(zeros.size(), Float3A(1, 1, 1));
+	std::vector<float> lengths(zeros.size(), 1);
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		Help::Math::Normalize<Precision::Refined>(zeros.data(), normalized.data(), zeros.size());
+		Help::Math::Length<Precision::Estimate>(zeros.data(), lengths.data(), zeros.size());
+		for (size_t i = 0; i < zeros.size(); i++)
+		{
+			CHECK(normalized[i].GetX() == 0 && normalized[i].GetY() == 0 && normalized[i].GetZ() == 0);
+			CHECK(lengths[i] == 0);
+		}
+
+		Help::Math::Normalize<Precision::Estimate>(zeros.data(), normalized.data(), zeros.size());
+		for (auto& n : normalized)
+			CHECK(n.GetX() == 0 && n.GetY() == 0 && n.GetZ() == 0);
+	});
+}
+
+TEST(Precision_VectorMembersMatchDirectXMath)
+{
+	Float3A v(3, -4, 12);
+	CHECK(v.Normalize<Precision::Exact>() == v.Normalize());
+	CHECK_NEAR(v.Normalize<Precision::Refined>().GetY(), -4.0 / 13, 2.4e-7 + Slack);
+	CHECK_NEAR(v.GetLength<Precision::Estimate>(), 13, 13 * (3.3e-4 + Slack));
+}
+
+// The table in MathPrecision.h: the largest errors of each tier and the throughput of normalizing 3D vectors, at
+// each SIMD level, with the data in cache
+BENCHMARK(Precision_NormalizeTiers)
+{
+	auto vectors = Vectors(4096, 52);
+	std::vector<Float3A> out(vectors.size());
+
+	ForEachSimdLevel([&](SimdLevel level)
+	{
+		std::string name = SimdLevelName(level);
+		double exact = Measure([&] { Help::Math::Normalize<Precision::Exact>(vectors.data(), out.data(), out.size()); });
+		double refined = Measure([&] { Help::Math::Normalize<Precision::Refined>(vectors.data(), out.data(), out.size()); });
+		double estimate = Measure([&] { Help::Math::Normalize<Precision::Estimate>(vectors.data(), out.data(), out.size()); });
+
+		double normalizeError, lengthError;
+		Errors<Precision::Exact>(vectors, normalizeError, lengthError);
+		Report((name + " Exact, largest error").c_str(), normalizeError / Ulp, "ULP");
+		Report((name + " Exact, normalize").c_str(), exact / vectors.size(), "ns/vector");
+
+		Errors<Precision::Refined>(vectors, normalizeError, lengthError);
+		Report((name + " Refined, largest error").c_str(), normalizeError / Ulp, "ULP");
+		Report((name + " Refined, throughput over Exact").c_str(), exact / refined, "x");
+
+		Errors<Precision::Estimate>(vectors, normalizeError, lengthError);
+		Report((name + " Estimate, largest error").c_str(), normalizeError / Ulp, "ULP");
+		Report((name + " Estimate, throughput over Exact").c_str(), exact / estimate, "x");
+	});
+}
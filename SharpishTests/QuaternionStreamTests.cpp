@@ -0,0 +1,96 @@
+#include "Test.h"
+
+// QuaternionStream against the QuaternionA operations it mirrors, at every SIMD level.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	const size_t Lengths[] = { 0, 1, 15, 16, 17, 333 };
+	const double Tolerance = 2e-6;
+
+	std::vector<QuaternionA> Rotations(size_t count, uint32_t seed)
+	{
+		Random random(seed);
+		std::vector<QuaternionA> rotations(count);
+		for (auto& q : rotations)
+			q = QuaternionA::FromPitchYawRoll(random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f));
+		return rotations;
+	}
+}
+
+TEST(QuaternionStream_MatchesQuaternionA)
+{
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t length : Lengths)
+		{
+			auto a = Rotations(length, 81);
+			auto b = Rotations(length, 82);
+
+			// Unnormalized inputs for Normalize and Inverse
+			std::vector<QuaternionA> scaled(length);
+			for (size_t i = 0; i < length; i++)
+				scaled[i] = QuaternionA(XMVectorScale(a[i], 0.5f + (float)(i % 7)));
+
+			QuaternionStream qa(a.data(), length), qb(b.data(), length), qs(scaled.data(), length);
+			auto normalized = qs.Normalize();
+			auto inverse = qs.Inverse();
+			auto product = qa.Multiply(qb);
+			auto slerp = QuaternionStream::Slerp(qa, qb, 0.3f);
+			auto nlerp = QuaternionStream::Nlerp(qa, qb, 0.3f);
+
+			for (size_t i = 0; i < length; i++)
+			{
+				CheckNear(normalized.Get(i), XMQuaternionNormalize(scaled[i]), Tolerance, 0, 4);
+				CheckNear(inverse.Get(i), XMQuaternionInverse(scaled[i]), Tolerance, 0, 4);
+				CheckNear(product.Get(i), a[i] * b[i], Tolerance, 0, 4);
+
+				// Both take the shorter arc
+				XMVECTOR to = XMVectorGetX(XMQuaternionDot(a[i], b[i])) < 0 ? XMVectorNegate(b[i]) : (XMVECTOR)b[i];
+				CheckNear(slerp.Get(i), XMQuaternionSlerp(a[i], to, 0.3f), Tolerance, 0, 4);
+				CheckNear(nlerp.Get(i), XMQuaternionNormalize(XMVectorLerp(a[i], to, 0.3f)), Tolerance, 0, 4);
+			}
+		}
+	});
+}
+
+TEST(QuaternionStream_RotateVectors)
+{
+	Random random(83);
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t length : Lengths)
+		{
+			auto q = Rotations(length, 84);
+			std::vector<Float3> v(length);
+			for (auto& p : v)
+				p = random.NextFloat3(-5, 5);
+
+			QuaternionStream stream(q.data(), length);
+			Float3Stream vectors(v.data(), length);
+			auto rotated = stream.RotateVectors(vectors);
+			CHECK(rotated.size() == length);
+
+			for (size_t i = 0; i < length; i++)
+			{
+				Float3 e = Float3A(XMVector3Rotate(Float3A(v[i]), q[i]));
+				Float3 r = rotated.Get(i);
+				CHECK_NEAR(r.X, e.X, 1e-5);
+				CHECK_NEAR(r.Y, e.Y, 1e-5);
+				CHECK_NEAR(r.Z, e.Z, 1e-5);
+			}
+		}
+	});
+}
+
+TEST(QuaternionStream_RejectsMismatchedSizes)
+{
+	auto q = Rotations(5, 85);
+	QuaternionStream a(q.data(), 5), b(q.data(), 4);
+	CHECK_THROWS(a.Multiply(b), ArgumentException);
+	CHECK_THROWS(QuaternionStream::Slerp(a, b, 0.5f), ArgumentException);
+}
@@ -0,0 +1,256 @@
+#include "Test.h"
+#include <cfloat>
+
+// The packet ray tests in Help::Math against slab and quadratic tests done one volume at a time in double
+// precision, at every SIMD level. Volumes within rounding of a grazing hit, or of maxDistance, can go either way
+// and aren't compared.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	// Partial words and registers, and more than one thread's share
+	const size_t Counts[] = { 0, 1, 31, 32, 33, 20011 };
+
+	struct Expected
+	{
+		int Hit;	// 1 for a hit, 0 for a miss, -1 if too close to call
+		double Enter;
+	};
+
+	// Classifies by the smallest of the margins that must all be positive for a hit
+	Expected Classify(double margin, double scale, double enter)
+	{
+		Expected e = { margin >= 1e-4 * scale ? 1 : margin < -1e-4 * scale ? 0 : -1, enter };
+		return e;
+	}
+
+	Expected RayBox(const Float3& origin, const Float3& direction, const Float3& minima, const Float3& maxima, double maxDistance)
+	{
+		double o[3] = { origin.X, origin.Y, origin.Z }, d[3] = { direction.X, direction.Y, direction.Z };
+		double lo[3] = { minima.X, minima.Y, minima.Z }, hi[3] = { maxima.X, maxima.Y, maxima.Z };
+		double tNear = 0, tFar = maxDistance, scale = 1;
+
+		for (int k = 0; k < 3; k++)
+		{
+			if (lo[k] > hi[k])
+				return Classify(-1, 0, 0);
+
+			if (d[k] == 0)
+			{
+				double inside = std::fmin(o[k] - lo[k], hi[k] - o[k]);
+				if (inside < 0)
+					return Classify(inside, 0, 0);
+				continue;
+			}
+
+			double t0 = (lo[k] - o[k]) / d[k], t1 = (hi[k] - o[k]) / d[k];
+			tNear = std::fmax(tNear, std::fmin(t0, t1));
+			tFar = std::fmin(tFar, std::fmax(t0, t1));
+			scale = std::fmax(scale, std::fmax(std::fabs(t0), std::fabs(t1)));
+		}
+		return Classify(tFar - tNear, scale, tNear);
+	}
+
+	Expected RaySphere(const Float3& origin, const Float3& direction, const Float3& center, double radius, double maxDistance)
+	{
+		double m[3] = { (double)origin.X - center.X, (double)origin.Y - center.Y, (double)origin.Z - center.Z };
+		double d[3] = { direction.X, direction.Y, direction.Z };
+		double a = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+		double b = m[0] * d[0] + m[1] * d[1] + m[2] * d[2];
+		double c = m[0] * m[0] + m[1] * m[1] + m[2] * m[2] - radius * radius;
+
+		// A point is inside or not
+		if (a == 0)
+			return Classify(-c, radius * radius, 0);
+
+		// Grazing rays lose the discriminant to cancellation
+		double discriminant = b * b - a * c;
+		if (std::fabs(discriminant) < 1e-4 * (b * b + std::fabs(a * c)))
+			return Classify(0, 1, 0);
+		if (discriminant < 0)
+			return Classify(-1, 0, 0);
+
+		double root = std::sqrt(discriminant);
+		double exit = (root - b) / a, enter = std::fmax(0.0, -(b + root) / a);
+		double scale = std::fmax(1.0, std::fabs(b) / a);
+		return Classify(std::fmin(exit, maxDistance - enter), scale, enter);
+	}
+
+	inline bool Bit(const std::vector<uint32_t>& mask, size_t i) { return (mask[i / 32] >> (i % 32)) & 1; }
+
+	// Set bits, and one word past the mask, so CheckHits can see that exactly the mask's words were written
+	std::vector<uint32_t> NewMask(size_t count) { return std::vector<uint32_t>((count + 31) / 32 + 1, ~0u); }
+
+	void CheckHits(const std::vector<uint32_t>& mask, const std::vector<float>& enter, size_t hits, const std::vector<Expected>& expected)
+	{
+		size_t count = expected.size(), set = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			bool hit = Bit(mask, i);
+			set += hit;
+			CHECK(hit ? enter[i] >= 0 : enter[i] == FLT_MAX);
+
+			if (expected[i].Hit < 0)
+				continue;
+			CHECK(hit == (expected[i].Hit == 1));
+			if (hit)
+				CHECK_NEAR(enter[i], expected[i].Enter, 1e-3 * std::fmax(1.0, expected[i].Enter));
+		}
+
+		CHECK(hits == set);
+		if (count % 32)
+			CHECK((mask[count / 32] >> (count % 32)) == 0);
+		CHECK(mask.back() == ~0u);
+	}
+
+	// Rays from outside the scene, from inside it, along an axis (zero direction components), and a segment
+	struct Ray
+	{
+		Float3 Origin;
+		Float3 Direction;
+		float MaxDistance;
+	};
+
+	std::vector<Ray> Rays()
+	{
+		Ray rays[] =
+		{
+			{ Float3(-150, 3, 7), Float3(1, 0.1f, -0.05f), FLT_MAX },
+			{ Float3(0, 0, 0), Float3(0.3f, -0.8f, 0.5f), FLT_MAX },
+			{ Float3(-150, 12.5f, -20.5f), Float3(2, 0, 0), FLT_MAX },
+			{ Float3(20.5f, -150, 20.5f), Float3(0, 1, 0), 150 },
+			{ Float3(-100, -100, -100), Float3(40, 45, 50), 3 },
+		};
+		return std::vector<Ray>(std::begin(rays), std::end(rays));
+	}
+}
+
+TEST(RayPacket_RayBoxesMatchesReference)
+{
+	Random random(171);
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<BoundingBoxA> boxes(count);
+			std::vector<Float3> minima(count), maxima(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				auto box = RandomBox(random, 100, 40);
+				minima[i] = box.Minima;
+				maxima[i] = box.Maxima;
+				// Every seventh box is empty
+				if (i % 7 == 6)
+					std::swap(minima[i].Y, maxima[i].Y);
+				boxes[i] = BoundingBoxA(Float3A(minima[i]), Float3A(maxima[i]));
+			}
+			Float3Stream minStream(minima.data(), count), maxStream(maxima.data(), count);
+
+			for (auto& ray : Rays())
+			{
+				std::vector<Expected> expected(count);
+				for (size_t i = 0; i < count; i++)
+					expected[i] = RayBox(ray.Origin, ray.Direction, minima[i], maxima[i], ray.MaxDistance);
+
+				auto a = NewMask(count), b = NewMask(count);
+				std::vector<float> enterA(count), enterB(count);
+				size_t hitsA = Help::Math::IntersectRayBoxes(Float3A(ray.Origin), Float3A(ray.Direction), boxes.data(), count, a.data(), enterA.data(), ray.MaxDistance);
+				size_t hitsB = Help::Math::IntersectRayBoxes(Float3A(ray.Origin), Float3A(ray.Direction), minStream, maxStream, b.data(), enterB.data(), ray.MaxDistance);
+				CheckHits(a, enterA, hitsA, expected);
+				CheckHits(b, enterB, hitsB, expected);
+
+				// Distances are optional
+				auto c = NewMask(count);
+				CHECK(Help::Math::IntersectRayBoxes(Float3A(ray.Origin), Float3A(ray.Direction), boxes.data(), count, c.data(), nullptr, ray.MaxDistance) == hitsA);
+				CHECK(c == a);
+			}
+		}
+	});
+}
+
+TEST(RayPacket_RaysBoxMatchesReference)
+{
+	Random random(172);
+	Float3 minima(-20, -10, 5), maxima(30, 10, 25);
+	BoundingBoxA box(Float3A(minima), Float3A(maxima));
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<Float3> origins(count), directions(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				origins[i] = random.NextFloat3(-80, 80);
+				directions[i] = random.NextFloat3(-1, 1);
+				// Some rays run along an axis
+				if (i % 5 == 0)
+					directions[i].X = directions[i].Z = 0;
+			}
+			Float3Stream originStream(origins.data(), count), directionStream(directions.data(), count);
+
+			for (float maxDistance : { FLT_MAX, 60.0f })
+			{
+				std::vector<Expected> expected(count);
+				for (size_t i = 0; i < count; i++)
+					expected[i] = RayBox(origins[i], directions[i], minima, maxima, maxDistance);
+
+				auto mask = NewMask(count);
+				std::vector<float> enter(count);
+				size_t hits = Help::Math::IntersectRaysBox(originStream, directionStream, box, mask.data(), enter.data(), maxDistance);
+				CheckHits(mask, enter, hits, expected);
+			}
+		}
+	});
+
+	std::vector<Float3> one(1);
+	Float3Stream single(one.data(), 1), pair(Float3Stream(2));
+	uint32_t mask;
+	CHECK_THROWS(Help::Math::IntersectRaysBox(single, pair, box, &mask), ArgumentException);
+}
+
+TEST(RayPacket_RaySpheresMatchesReference)
+{
+	Random random(173);
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t count : Counts)
+		{
+			std::vector<BoundingSphereA> spheres(count);
+			std::vector<Float4> packed(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				Float3 center = random.NextFloat3(-100, 100);
+				float radius = random.Next(0.0f, 25.0f);
+				spheres[i] = BoundingSphereA(center, radius);
+				packed[i] = Float4(center.X, center.Y, center.Z, radius);
+			}
+			Float4Stream stream(packed.data(), count);
+
+			auto rays = Rays();
+			// A zero direction hits the spheres its origin is inside
+			rays.push_back({ Float3(5, -5, 10), Float3(0, 0, 0), FLT_MAX });
+
+			for (auto& ray : rays)
+			{
+				std::vector<Expected> expected(count);
+				for (size_t i = 0; i < count; i++)
+				{
+					Float4 s = packed[i];
+					expected[i] = RaySphere(ray.Origin, ray.Direction, Float3(s.X, s.Y, s.Z), s.W, ray.MaxDistance);
+				}
+
+				auto a = NewMask(count), b = NewMask(count);
+				std::vector<float> enterA(count), enterB(count);
+				size_t hitsA = Help::Math::IntersectRaySpheres(Float3A(ray.Origin), Float3A(ray.Direction), spheres.data(), count, a.data(), enterA.data(), ray.MaxDistance);
+				size_t hitsB = Help::Math::IntersectRaySpheres(Float3A(ray.Origin), Float3A(ray.Direction), stream, b.data(), enterB.data(), ray.MaxDistance);
+				CheckHits(a, enterA, hitsA, expected);
+				CheckHits(b, enterB, hitsB, expected);
+			}
+		}
+	});
+}
@@ -0,0 +1,223 @@
+#include "Test.h"
+
+// Linear blend and dual quaternion skinning against the same blends done one vertex at a time with DirectXMath, at
+// every SIMD level, serial and split across threads.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	// Up to two registers, a partial register, and more than one thread's share
+	const size_t Lengths[] = { 0, 1, 15, 16, 17, 5003 };
+	const int BoneCount = 12;
+	const int Influences = 4;
+	const double Tolerance = 2e-5;
+
+	struct Mesh
+	{
+		std::vector<Float3> Positions;
+		std::vector<Float3> Normals;
+		std::vector<int> Bones;
+		std::vector<float> Weights;
+	};
+
+	// Weights add up to 1. Every third vertex has a zero-weight influence, and vertex 0 has one bone only.
+	Mesh RandomMesh(size_t count, Random& random)
+	{
+		Mesh mesh;
+		mesh.Positions.resize(count);
+		mesh.Normals.resize(count);
+		mesh.Bones.resize(count * Influences);
+		mesh.Weights.resize(count * Influences);
+
+		for (size_t v = 0; v < count; v++)
+		{
+			mesh.Positions[v] = random.NextFloat3(-3, 3);
+			mesh.Normals[v] = Float3A(XMVector3Normalize(Float3A(random.NextFloat3(-1, 1))));
+
+			float sum = 0;
+			for (int k = 0; k < Influences; k++)
+			{
+				float w = (v == 0 && k > 0) || (v % 3 == 1 && k == 2) ? 0 : random.Next(0.05f, 1.0f);
+				mesh.Bones[v * Influences + k] = (int)random.Next((uint32_t)BoneCount);
+				mesh.Weights[v * Influences + k] = w;
+				sum += w;
+			}
+			for (int k = 0; k < Influences; k++)
+				mesh.Weights[v * Influences + k] /= sum;
+		}
+		return mesh;
+	}
+
+	// Rotations and translations, and a uniform scale for the linear blend
+	XMMATRIX RandomBone(Random& random, bool scaled)
+	{
+		return XMMatrixAffineTransformation(XMVectorReplicate(scaled ? random.Next(0.8f, 1.25f) : 1.0f), XMVectorZero(),
+			XMQuaternionRotationRollPitchYaw(random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f)),
+			XMVectorSet(random.Next(-2.0f, 2.0f), random.Next(-2.0f, 2.0f), random.Next(-2.0f, 2.0f), 0));
+	}
+
+	// The blended dual quaternion of vertex v, each bone taken from the hemisphere of the sum so far
+	DualQuaternionA BlendDualQuaternions(const Mesh& mesh, size_t v, const std::vector<DualQuaternionA>& palette)
+	{
+		XMVECTOR real = XMVectorZero(), dual = XMVectorZero();
+		for (int k = 0; k < Influences; k++)
+		{
+			float w = mesh.Weights[v * Influences + k];
+			if (w == 0)
+				continue;
+			auto& bone = palette[mesh.Bones[v * Influences + k]];
+			if (XMVectorGetX(XMVector4Dot(bone.Real, real)) < 0)
+				w = -w;
+			real = XMVectorMultiplyAdd(XMVectorReplicate(w), bone.Real, real);
+			dual = XMVectorMultiplyAdd(XMVectorReplicate(w), bone.Dual, dual);
+		}
+
+		auto scale = XMVectorReciprocalSqrt(XMVector4LengthSq(real));
+		DualQuaternionA blended;
+		blended.Real = XMVectorMultiply(real, scale);
+		blended.Dual = XMVectorMultiply(dual, scale);
+		return blended;
+	}
+}
+
+TEST(Skinning_LinearBlendMatchesReference)
+{
+	Random random(141);
+	std::vector<Float4x3A> palette(BoneCount);
+	for (auto& m : palette)
+		m = RandomBone(random, true);
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t length : Lengths)
+		{
+			auto mesh = RandomMesh(length, random);
+			SkinInfluences influences(mesh.Bones.data(), mesh.Weights.data(), length, Influences);
+			Float3Stream positions(mesh.Positions.data(), length), normals(mesh.Normals.data(), length);
+
+			for (bool parallel : { false, true })
+			{
+				Float3Stream outPositions, outNormals, positionsOnly;
+				Skinning::LinearBlend(positions, normals, influences, palette.data(), BoneCount, outPositions, outNormals, parallel);
+				Skinning::LinearBlend(positions, influences, palette.data(), BoneCount, positionsOnly, parallel);
+				CHECK(outPositions.size() == length && outNormals.size() == length && positionsOnly.size() == length);
+
+				for (size_t v = 0; v < length; v++)
+				{
+					XMVECTOR p = XMVectorZero(), n = XMVectorZero();
+					for (int k = 0; k < Influences; k++)
+					{
+						auto w = XMVectorReplicate(mesh.Weights[v * Influences + k]);
+						auto& m = palette[mesh.Bones[v * Influences + k]];
+						p = XMVectorMultiplyAdd(w, XMVector3Transform(Float3A(mesh.Positions[v]), m), p);
+						n = XMVectorMultiplyAdd(w, XMVector3TransformNormal(Float3A(mesh.Normals[v]), m), n);
+					}
+					CheckNear(outPositions.Get(v), p, Tolerance);
+					CheckNear(positionsOnly.Get(v), p, Tolerance);
+					CheckNear(outNormals.Get(v), XMVector3Normalize(n), Tolerance);
+				}
+			}
+		}
+	});
+}
+
+TEST(Skinning_DualQuaternionBlendMatchesReference)
+{
+	Random random(142);
+	std::vector<DualQuaternionA> palette(BoneCount);
+	for (auto& dq : palette)
+		dq = DualQuaternionA(Float4x3A(RandomBone(random, false)));
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t length : Lengths)
+		{
+			auto mesh = RandomMesh(length, random);
+			SkinInfluences influences(mesh.Bones.data(), mesh.Weights.data(), length, Influences);
+			Float3Stream positions(mesh.Positions.data(), length), normals(mesh.Normals.data(), length);
+
+			for (bool parallel : { false, true })
+			{
+				Float3Stream outPositions, outNormals, positionsOnly;
+				Skinning::DualQuaternionBlend(positions, normals, influences, palette.data(), BoneCount, outPositions, outNormals, parallel);
+				Skinning::DualQuaternionBlend(positions, influences, palette.data(), BoneCount, positionsOnly, parallel);
+
+				for (size_t v = 0; v < length; v++)
+				{
+					auto blended = BlendDualQuaternions(mesh, v, palette);
+					CheckNear(outPositions.Get(v), blended.TransformPoint(Float3A(mesh.Positions[v])), Tolerance);
+					CheckNear(positionsOnly.Get(v), blended.TransformPoint(Float3A(mesh.Positions[v])), Tolerance);
+					CheckNear(outNormals.Get(v), blended.TransformNormal(Float3A(mesh.Normals[v])), Tolerance);
+				}
+			}
+		}
+	});
+}
+
+TEST(Skinning_SingleRigidBoneAgreesAcrossMethods)
+{
+	// With one rigid bone per vertex both blends are that bone's transform, and outputs may be the inputs
+	Random random(143);
+	std::vector<Float4x3A> matrices(BoneCount);
+	std::vector<DualQuaternionA> dualQuaternions(BoneCount);
+	for (int b = 0; b < BoneCount; b++)
+	{
+		matrices[b] = RandomBone(random, false);
+		dualQuaternions[b] = DualQuaternionA(matrices[b]);
+	}
+
+	const size_t count = 333;
+	std::vector<Float3> points(count);
+	SkinInfluences influences(count, 1);
+	for (size_t v = 0; v < count; v++)
+	{
+		points[v] = random.NextFloat3(-3, 3);
+		influences.Set(v, 0, (int)(v % BoneCount), 1);
+	}
+	CHECK(influences.GetMaxBone() == BoneCount - 1);
+
+	Float3Stream linear(points.data(), count), dual(points.data(), count);
+	Skinning::LinearBlend(linear, influences, matrices.data(), BoneCount, linear);
+	Skinning::DualQuaternionBlend(dual, influences, dualQuaternions.data(), BoneCount, dual);
+
+	for (size_t v = 0; v < count; v++)
+	{
+		auto expected = XMVector3Transform(Float3A(points[v]), matrices[v % BoneCount]);
+		CheckNear(linear.Get(v), expected, Tolerance);
+		CheckNear(dual.Get(v), expected, Tolerance);
+		CheckNear(dualQuaternions[v % BoneCount].TransformPoint(Float3A(points[v])), expected, Tolerance);
+	}
+}
+
+TEST(Skinning_RejectsMismatchedInputs)
+{
+	std::vector<Float4x3A> palette(2, Float4x3A(XMMatrixIdentity()));
+	std::vector<Float3> points(8);
+	Float3Stream positions(points.data(), points.size()), shorter(points.data(), 7), out;
+
+	SkinInfluences influences(points.size(), 2), pastPalette(points.size(), 2);
+	influences.Set(3, 1, 1, 0.5f);
+	pastPalette.Set(3, 1, 2, 0.5f);
+	CHECK_THROWS(Skinning::LinearBlend(positions, pastPalette, palette.data(), palette.size(), out), ArgumentException);
+	CHECK_THROWS(Skinning::LinearBlend(positions, influences, palette.data(), 1, out), ArgumentException);
+	CHECK_THROWS(Skinning::LinearBlend(shorter, influences, palette.data(), palette.size(), out), ArgumentException);
+	CHECK_THROWS(Skinning::LinearBlend(positions, shorter, influences, palette.data(), palette.size(), out, out), ArgumentException);
+	Skinning::LinearBlend(positions, influences, palette.data(), palette.size(), out);
+	CHECK(out.size() == points.size());
+
+	// Overwriting the only use of the largest bone lowers it, in copies too, and unset influences use bone 0
+	SkinInfluences copy = pastPalette;
+	pastPalette.Set(3, 1, 1, 0.5f);
+	CHECK(copy.GetMaxBone() == 1);
+	Skinning::LinearBlend(positions, copy, palette.data(), palette.size(), out);
+	CHECK(SkinInfluences().GetMaxBone() == -1 && SkinInfluences(4, 2).GetMaxBone() == 0);
+
+	CHECK_THROWS(SkinInfluences(4, 0), ArgumentException);
+	CHECK_THROWS(SkinInfluences(4, SkinInfluences::MaxInfluences + 1), ArgumentException);
+	CHECK_THROWS(influences.Set(8, 0, 0, 1), ArgumentException);
+	CHECK_THROWS(influences.Set(0, 2, 0, 1), ArgumentException);
+}
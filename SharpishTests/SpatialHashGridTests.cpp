@@ -0,0 +1,227 @@
+#include "Test.h"
+#include <algorithm>
+
+// SpatialHashGrid queries and pairs against brute force, serial and parallel.
+
+using namespace CS;
+using namespace SharpishTests;
+
+namespace
+{
+	typedef std::vector<std::pair<uint32_t, uint32_t>> Pairs;
+
+	std::vector<Float3> Positions(size_t count, float extent, uint32_t seed)
+	{
+		Random random(seed);
+		std::vector<Float3> positions(count);
+		for (auto& p : positions)
+			p = random.NextFloat3(-extent, extent);
+		return positions;
+	}
+
+	std::vector<Float3A> Aligned(const std::vector<Float3>& positions)
+	{
+		return std::vector<Float3A>(positions.begin(), positions.end());
+	}
+
+	float DistanceSq(const Float3& a, const Float3& b)
+	{
+		float dx = a.X - b.X, dy = a.Y - b.Y, dz = a.Z - b.Z;
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	Pairs Normalized(Pairs pairs)
+	{
+		for (auto& p : pairs)
+			if (p.first > p.second)
+				std::swap(p.first, p.second);
+		std::sort(pairs.begin(), pairs.end());
+		return pairs;
+	}
+
+	Pairs BrutePairs(const std::vector<Float3>& positions, float radius)
+	{
+		Pairs pairs;
+		for (uint32_t i = 0; i < positions.size(); i++)
+			for (uint32_t j = i + 1; j < positions.size(); j++)
+				if (DistanceSq(positions[i], positions[j]) <= radius * radius)
+					pairs.emplace_back(i, j);
+		return pairs;
+	}
+}
+
+TEST(SpatialHashGrid_QueriesMatchBruteForce)
+{
+	// Enough entries for several pieces of the build's counting sort, packed several to a cell
+	const size_t count = 20000;
+	auto positions = Positions(count, 40, 31);
+	auto aligned = Aligned(positions);
+	std::vector<uint32_t> values(count);
+	for (uint32_t i = 0; i < count; i++)
+		values[i] = i;
+
+	for (bool parallel : { false, true })
+	{
+		SpatialHashGrid<uint32_t> grid(2.0f);
+		grid.Build(aligned.data(), values.data(), count, parallel);
+		CHECK(grid.size() == count);
+
+		Random random(32);
+		for (int q = 0; q < 50; q++)
+		{
+			Float3 center = random.NextFloat3(-45, 45);
+			float radius = random.Next(0.5f, 9.0f);
+
+			std::vector<uint32_t> found;
+			grid.QueryRadius(center, radius, found);
+			std::sort(found.begin(), found.end());
+
+			std::vector<uint32_t> expected;
+			for (uint32_t i = 0; i < count; i++)
+				if (DistanceSq(positions[i], center) <= radius * radius)
+					expected.push_back(i);
+			CHECK(found == expected);
+
+			Float3 minima(center.X - radius, center.Y - radius * 0.5f, center.Z - radius);
+			Float3 maxima(center.X + radius, center.Y + radius, center.Z + radius * 2);
+			found.clear();
+			grid.QueryBox(BoundingBoxA(minima, maxima), found);
+			std::sort(found.begin(), found.end());
+
+			expected.clear();
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const Float3& p = positions[i];
+				if (p.X >= minima.X && p.Y >= minima.Y && p.Z >= minima.Z && p.X <= maxima.X && p.Y <= maxima.Y && p.Z <= maxima.Z)
+					expected.push_back(i);
+			}
+			CHECK(found == expected);
+		}
+	}
+}
+
+TEST(SpatialHashGrid_PairsMatchBruteForce)
+{
+	const size_t count = 3000;
+	auto positions = Positions(count, 30, 33);
+	auto aligned = Aligned(positions);
+	std::vector<uint32_t> values(count);
+	for (uint32_t i = 0; i < count; i++)
+		values[i] = i;
+
+	SpatialHashGrid<uint32_t> grid(1.5f);
+	grid.Build(aligned.data(), values.data(), count);
+
+	// The last radius is far above the cell size, where the cells are walked instead of the neighbor offsets
+	for (float radius : { 0.0f, 1.0f, 1.5f, 4.0f, 200.0f })
+	{
+		auto expected = BrutePairs(positions, radius);
+		for (bool parallel : { false, true })
+		{
+			Pairs found;
+			CHECK(grid.FindPairs(radius, found, parallel) == found.size());
+			CHECK(Normalized(found) == expected);
+		}
+	}
+}
+
+TEST(SpatialHashGrid_BuildIsDeterministic)
+{
+	const size_t count = 50000;
+	auto aligned = Aligned(Positions(count, 20, 34));
+	std::vector<uint32_t> values(count);
+	for (uint32_t i = 0; i < count; i++)
+		values[i] = i;
+
+	SpatialHashGrid<uint32_t> serial(1.0f), parallel(1.0f);
+	serial.Build(aligned.data(), values.data(), count, false);
+	parallel.Build(aligned.data(), values.data(), count, true);
+	CHECK(serial.GetCellCount() == parallel.GetCellCount());
+
+	Pairs serialPairs, parallelPairs;
+	serial.FindPairs(0.3f, serialPairs, false);
+	parallel.FindPairs(0.3f, parallelPairs, true);
+	CHECK(serialPairs == parallelPairs);
+}
+
+TEST(SpatialHashGrid_HugeCoordinates)
+{
+	// Coordinates whose cells are far outside the range of int at this cell size, some close to each other
+	std::vector<Float3> positions = Positions(500, 10, 35);
+	Float3 far[] =
+	{
+		Float3(1e30f, 0, 0), Float3(1e30f, 0, 5e-4f), Float3(-1e30f, 5, 5), Float3(3e38f, 3e38f, -3e38f),
+		Float3(-3e38f, -3e38f, 3e38f), Float3(2e6f, 0, 0), Float3(1e7f, 0, 0), Float3(1e7f, 1e-3f, 0),
+	};
+	positions.insert(positions.end(), std::begin(far), std::end(far));
+	auto aligned = Aligned(positions);
+	std::vector<uint32_t> values(positions.size());
+	for (uint32_t i = 0; i < values.size(); i++)
+		values[i] = i;
+
+	SpatialHashGrid<uint32_t> grid(1e-3f);
+	grid.Build(aligned.data(), values.data(), values.size());
+	CHECK(grid.size() == values.size());
+
+	std::vector<Float3> centers(std::begin(far), std::end(far));
+	centers.push_back(Float3(0, 0, 0));
+	for (auto& center : centers)
+	{
+		for (float radius : { 0.0f, 1e-2f, 1.0f })
+		{
+			std::vector<uint32_t> found, expected;
+			grid.QueryRadius(center, radius, found);
+			std::sort(found.begin(), found.end());
+			for (uint32_t i = 0; i < positions.size(); i++)
+				if (DistanceSq(positions[i], center) <= radius * radius)
+					expected.push_back(i);
+			CHECK(found == expected);
+		}
+	}
+
+	// A box from the middle out to the far points along X
+	std::vector<uint32_t> found;
+	grid.QueryBox(BoundingBoxA(Float3A(0, -1, -1), Float3A(2e30f, 1, 1)), found);
+	std::sort(found.begin(), found.end());
+	std::vector<uint32_t> expected;
+	for (uint32_t i = 0; i < positions.size(); i++)
+	{
+		const Float3& p = positions[i];
+		if (p.X >= 0 && p.Y >= -1 && p.Z >= -1 && p.X <= 2e30f && p.Y <= 1 && p.Z <= 1)
+			expected.push_back(i);
+	}
+	CHECK(found == expected);
+
+	// The smaller radius probes neighbor offsets, including past the clamped ends; the larger walks the cells
+	for (float radius : { 1e-3f, 1e-2f })
+	{
+		for (bool parallel : { false, true })
+		{
+			Pairs pairs;
+			grid.FindPairs(radius, pairs, parallel);
+			CHECK(Normalized(pairs) == BrutePairs(positions, radius));
+		}
+	}
+}
+
+TEST(SpatialHashGrid_RejectsBadArguments)
+{
+	CHECK_THROWS(SpatialHashGrid<int> bad(0.0f), ArgumentException);
+	CHECK_THROWS(SpatialHashGrid<int> bad(INFINITY), ArgumentException);
+
+	Float3A p(0, 0, 0);
+	SpatialHashGrid<int> grid(1.0f);
+	CHECK_THROWS(grid.Build(&p, nullptr, 1), ArgumentNullException);
+	int value = 0;
+	CHECK_THROWS(grid.Build(nullptr, &value, 1), ArgumentNullException);
+	grid.Build(nullptr, nullptr, 0);
+	CHECK(grid.empty());
+
+	// Positions that aren't finite, which leave the grid empty
+	Float3A bad[] = { Float3A(0, 0, 0), Float3A(NAN, 0, 0), Float3A(0, INFINITY, 0) };
+	int badValues[] = { 1, 2, 3 };
+	grid.Build(bad, badValues, 1);
+	CHECK_THROWS(grid.Build(bad, badValues, 2), ArgumentException);
+	CHECK(grid.empty() && grid.GetCellCount() == 0);
+	CHECK_THROWS(grid.Build(bad + 2, badValues, 1), ArgumentException);
+}
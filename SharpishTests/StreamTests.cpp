@@ -0,0 +1,112 @@
+#include "Test.h"
+
+// Float3Stream and Float4Stream: storage and conversions, and the transform kernels against DirectXMath at every
+// SIMD level, for lengths that fill registers exactly and that leave part of one.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	const size_t Lengths[] = { 0, 1, 15, 16, 17, 1001 };
+
+	std::vector<Float3> Points(size_t count, uint32_t seed)
+	{
+		Random random(seed);
+		std::vector<Float3> points(count);
+		for (auto& p : points)
+			p = random.NextFloat3(-10, 10);
+		return points;
+	}
+}
+
+TEST(Stream_StorageAndConversions)
+{
+	for (size_t length : Lengths)
+	{
+		auto points = Points(length, 61);
+		Float3Stream stream(points.data(), length);
+		CHECK(stream.size() == length);
+		CHECK(stream.GetStride() % Float3Stream::LaneAlignment == 0 && stream.GetStride() >= length);
+		CHECK((uintptr_t)stream.GetX() % 64 == 0 && (uintptr_t)stream.GetY() % 64 == 0 && (uintptr_t)stream.GetZ() % 64 == 0);
+
+		std::vector<Float3> back(length);
+		stream.CopyTo(back.data());
+		for (size_t i = 0; i < length; i++)
+		{
+			CHECK(back[i].X == points[i].X && back[i].Y == points[i].Y && back[i].Z == points[i].Z);
+			CHECK(Float3(stream.Get(i)).Y == points[i].Y);
+		}
+
+		auto aligned = stream.ToArrayA();
+		CHECK(aligned.size() == length);
+		if (length)
+		{
+			stream.Set(0, Float3A(1, 2, 3));
+			CHECK(stream.GetX()[0] == 1 && stream.GetY()[0] == 2 && stream.GetZ()[0] == 3);
+		}
+	}
+
+	std::vector<Float4A> vectors = { Float4A(1, 2, 3, 4), Float4A(-5, 6, -7, 8) };
+	Float4Stream stream4(vectors.data(), vectors.size());
+	std::vector<Float4A> back4(vectors.size());
+	stream4.CopyTo(back4.data());
+	CHECK(back4[1] == vectors[1]);
+	CHECK(stream4.GetW()[0] == 4);
+}
+
+TEST(Stream_TransformsMatchDirectXMath)
+{
+	auto affine = Float4x3A(XMMatrixAffineTransformation(XMVectorSet(1.5f, 0.5f, 2, 0), XMVectorZero(), XMQuaternionRotationRollPitchYaw(0.3f, -1.1f, 2.0f), XMVectorSet(4, -2, 7, 0)));
+	auto projection = Float4x4A::LookAt(Float3A(3, 4, -30), Float3A(0, 0, 0), Float3A(0, 1, 0)) * Float4x4A::PerspectiveFov(0.9f, 1.3f, 0.5f, 200);
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t length : Lengths)
+		{
+			auto points = Points(length, 62);
+			Float3Stream stream(points.data(), length);
+
+			auto transformed = stream.Transform(affine);
+			auto normals = stream.TransformNormal(affine);
+			auto coords = stream.TransformCoord(projection);
+			CHECK(transformed.size() == length && normals.size() == length && coords.size() == length);
+
+			for (size_t i = 0; i < length; i++)
+			{
+				Float3A p(points[i]);
+				CheckNear(transformed.Get(i), XMVector3Transform(p, affine), 1e-5, 0, 3);
+				CheckNear(normals.Get(i), XMVector3TransformNormal(p, affine), 1e-5, 0, 3);
+				CheckNear(coords.Get(i), XMVector3TransformCoord(p, projection), 1e-5, 0, 3);
+			}
+
+			// In place
+			stream.Transform(affine, stream);
+			for (size_t i = 0; i < length; i++)
+				CheckNear(stream.Get(i), transformed.Get(i), 1e-5, 0, 3);
+		}
+	});
+}
+
+TEST(Stream_Float4TransformMatchesDirectXMath)
+{
+	auto m = Float4x4A::RotationPitchYawRoll(0.4f, 1.2f, -0.7f) * Float4x4A::Translation(1, -3, 5) * Float4x4A::Scaling(2, 1, 0.5f);
+	Random random(63);
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		for (size_t length : Lengths)
+		{
+			std::vector<Float4A> vectors(length);
+			for (auto& v : vectors)
+				v = Float4A(random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f), random.Next(-2.0f, 2.0f));
+
+			Float4Stream stream(vectors.data(), length);
+			auto transformed = stream.Transform(m);
+			for (size_t i = 0; i < length; i++)
+				CheckNear(transformed.Get(i), XMVector4Transform(vectors[i], m), 1e-5, 0, 4);
+		}
+	});
+}
@@ -0,0 +1,228 @@
+#include "Test.h"
+#include <algorithm>
+#include <set>
+
+// SweepAndPrune pairs against brute force through inserts, moves and removals, and its per-step cost against
+// DynamicAabbTree for the mostly static, coherent scenes it's meant for.
+
+using namespace CS;
+using namespace SharpishTests;
+
+namespace
+{
+	typedef std::pair<int, int> Pair;
+
+	bool Touch(const SweepAndPrune& sap, int a, int b)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			Range p = sap.GetExtent(a, k), q = sap.GetExtent(b, k);
+			if (p.Minimum > q.Maximum || q.Minimum > p.Maximum)
+				return false;
+		}
+		return true;
+	}
+
+	std::vector<Pair> BrutePairs(const SweepAndPrune& sap, const std::vector<int>& live)
+	{
+		std::vector<Pair> pairs;
+		for (size_t i = 0; i < live.size(); i++)
+			for (size_t j = i + 1; j < live.size(); j++)
+				if (Touch(sap, live[i], live[j]))
+					pairs.emplace_back(std::min(live[i], live[j]), std::max(live[i], live[j]));
+		std::sort(pairs.begin(), pairs.end());
+		return pairs;
+	}
+
+	// Applies the changes since the last call to pairs, and checks the result against GetPairs
+	void CheckChanges(SweepAndPrune& sap, std::set<Pair>& pairs)
+	{
+		std::vector<Pair> begun, ended;
+		sap.TakePairChanges(&begun, &ended);
+		for (auto& p : begun)
+			CHECK(pairs.insert(p).second);
+		for (auto& p : ended)
+			CHECK(pairs.erase(p) == 1);
+
+		std::vector<Pair> current;
+		sap.GetPairs(current);
+		CHECK(current == std::vector<Pair>(pairs.begin(), pairs.end()));
+	}
+}
+
+TEST(SweepAndPrune_PairsMatchBruteForce)
+{
+	Random random(41);
+	for (bool parallel : { false, true })
+	{
+		SweepAndPrune sap;
+		std::set<Pair> pairs;
+		std::vector<int> live;
+
+		std::vector<BoundingBoxA> boxes(3000);
+		for (auto& box : boxes)
+			box = RandomBox(random, 50, 4);
+		live.resize(boxes.size());
+		sap.InsertMany(boxes.data(), boxes.size(), live.data(), parallel);
+		CHECK(sap.GetCount() == boxes.size());
+		CheckChanges(sap, pairs);
+
+		std::vector<Pair> current;
+		sap.GetPairs(current);
+		CHECK(current == BrutePairs(sap, live));
+
+		for (int step = 0; step < 20; step++)
+		{
+			for (int i = 0; i < 150; i++)
+			{
+				int proxy = live[random.Next((uint32_t)live.size())];
+				BoundingBoxA box = sap.GetBox(proxy);
+				Float3A shift(random.NextFloat3(-1, 1));
+				sap.Move(proxy, BoundingBoxA(box.Minima + shift, box.Maxima + shift));
+			}
+
+			size_t victim = random.Next((uint32_t)live.size());
+			sap.Remove(live[victim]);
+			live.erase(live.begin() + victim);
+			live.push_back(sap.Insert(RandomBox(random, 50, 4)));
+
+			// A second batch goes through InsertMany's re-sort with proxies already in place
+			if (step == 10)
+			{
+				std::vector<BoundingBoxA> more(500);
+				for (auto& box : more)
+					box = RandomBox(random, 50, 4);
+				std::vector<int> ids(more.size());
+				sap.InsertMany(more.data(), more.size(), ids.data(), parallel);
+				live.insert(live.end(), ids.begin(), ids.end());
+			}
+
+			CheckChanges(sap, pairs);
+			current.clear();
+			sap.GetPairs(current);
+			CHECK(current == BrutePairs(sap, live));
+		}
+	}
+}
+
+// Unit boxes on a grid across zero share their endpoint values, -0 and 0 among them, so InsertMany's radix sort
+// has to put each minimum before the maximum it touches for neighbours to pair, and leave the arrays in the
+// order Move's insertion sort expects
+TEST(SweepAndPrune_InsertManyTiesAcrossZero)
+{
+	std::vector<BoundingBoxA> boxes;
+	for (int x = -3; x < 3; x++)
+		for (int y = -3; y < 3; y++)
+			for (int z = -3; z < 3; z++)
+			{
+				float right = x == -1 ? -0.0f : (float)x + 1;
+				boxes.emplace_back(Float3A((float)x, (float)y, (float)z), Float3A(right, (float)y + 1, (float)z + 1));
+			}
+
+	for (bool parallel : { false, true })
+	{
+		SweepAndPrune sap;
+		std::vector<int> live(boxes.size());
+		sap.InsertMany(boxes.data(), boxes.size(), live.data(), parallel);
+
+		// Each box touches the up to 26 around it: per axis, 6 + 2 * 5 ordered pairs of cells are at most one apart
+		std::vector<Pair> current;
+		sap.GetPairs(current);
+		CHECK(current == BrutePairs(sap, live));
+		CHECK(current.size() == (size_t)(16 * 16 * 16 - 216) / 2);
+
+		Random random(43);
+		for (int i = 0; i < 50; i++)
+		{
+			int proxy = live[random.Next((uint32_t)live.size())];
+			BoundingBoxA box = sap.GetBox(proxy);
+			Float3A shift((float)random.Next(3) - 1, 0, 0);
+			sap.Move(proxy, BoundingBoxA(box.Minima + shift, box.Maxima + shift));
+		}
+		current.clear();
+		sap.GetPairs(current);
+		CHECK(current == BrutePairs(sap, live));
+	}
+}
+
+TEST(SweepAndPrune_TouchingBoxesOverlap)
+{
+	SweepAndPrune sap;
+	int a = sap.Insert(BoundingBoxA(Float3A(0, 0, 0), Float3A(1, 1, 1)));
+	int b = sap.Insert(BoundingBoxA(Float3A(1, 0, 0), Float3A(2, 1, 1)));
+	CHECK(sap.GetPairCount() == 1);
+
+	sap.Move(b, BoundingBoxA(Float3A(1.5f, 0, 0), Float3A(2, 1, 1)));
+	CHECK(sap.GetPairCount() == 0);
+	sap.Remove(a);
+	CHECK(!sap.Contains(a));
+	CHECK_THROWS(sap.Move(a, BoundingBoxA(Float3A(0, 0, 0), Float3A(1, 1, 1))), ArgumentException);
+	CHECK_THROWS(sap.Insert(BoundingBoxA()), ArgumentException);
+}
+
+// Most of the scene is still and a tenth of it drifts a little each step, so the endpoints that move pass few
+// others. Both sides report the pairs that may have begun: SweepAndPrune as its changes, the tree as the pairs of
+// the proxies it had to reinsert.
+BENCHMARK(SweepAndPrune_CoherentMotionVsTree)
+{
+	const size_t count = 20000;
+	Random random(42);
+	std::vector<BoundingBoxA> boxes(count);
+	for (auto& box : boxes)
+		box = RandomBox(random, 150, 2);
+
+	SweepAndPrune sap;
+	std::vector<int> sapIds(count);
+	sap.InsertMany(boxes.data(), count, sapIds.data());
+	sap.TakePairChanges(nullptr, nullptr);
+
+	DynamicAabbTree tree;
+	std::vector<int> treeIds(count);
+	for (size_t i = 0; i < count; i++)
+		treeIds[i] = tree.Insert(boxes[i]);
+
+	std::vector<size_t> moving;
+	for (size_t i = 0; i < count; i += 10)
+		moving.push_back(i);
+
+	// Each step moves the same boxes back and forth along x, so the scene doesn't drift between measurements
+	auto stepBoxes = [&](int step)
+	{
+		float dx = (step & 1) ? -0.05f : 0.05f;
+		for (size_t i : moving)
+			boxes[i] = BoundingBoxA(boxes[i].Minima + Float3A(dx, 0, 0), boxes[i].Maxima + Float3A(dx, 0, 0));
+	};
+
+	std::vector<Pair> begun, ended;
+	int sapStep = 0;
+	double sapTime = Measure([&]
+	{
+		stepBoxes(sapStep++);
+		for (size_t i : moving)
+			sap.Move(sapIds[i], boxes[i]);
+		begun.clear();
+		ended.clear();
+		sap.TakePairChanges(&begun, &ended);
+	});
+
+	std::vector<int> movedIds, reinserted;
+	for (size_t i : moving)
+		movedIds.push_back(treeIds[i]);
+	std::vector<BoundingBoxA> movedBoxes(moving.size());
+	std::vector<Pair> treePairs;
+	int treeStep = 0;
+	double treeTime = Measure([&]
+	{
+		stepBoxes(treeStep++);
+		for (size_t j = 0; j < moving.size(); j++)
+			movedBoxes[j] = boxes[moving[j]];
+		reinserted.clear();
+		tree.MoveMany(movedIds.data(), movedBoxes.data(), movedIds.size(), &reinserted, false);
+		treePairs.clear();
+		tree.FindPairs(reinserted.data(), reinserted.size(), treePairs, false);
+	});
+
+	Report("SweepAndPrune step, 2000 of 20000 boxes moving", sapTime / 1000, "us");
+	Report("DynamicAabbTree step, same motion", treeTime / 1000, "us");
+	Report("DynamicAabbTree / SweepAndPrune", treeTime / sapTime, "x");
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+// A small self-contained test harness, so the tests build wherever the math layer does.
+//
+// TEST(Name) registers a test. CHECK, CHECK_NEAR and CHECK_THROWS record a failure and carry on, so one run
+// reports every broken case. BENCHMARK(Name) registers a measurement, which only runs with --bench. Any other
+// command-line argument selects the tests and benchmarks whose names start with it.
+
+#include "SharpishMath.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace SharpishTests
+{
+	typedef void (*TestFunction)();
+
+	struct Registrar
+	{
+		Registrar(const char* name, TestFunction run, bool isBenchmark);
+	};
+
+	void Fail(const char* file, int line, const std::string& what);
+	std::string Describe(double actual, double expected, double tolerance);
+
+	// Calls body until at least 200 ms have passed and returns the mean time per call in nanoseconds
+	double Measure(const std::function<void()>& body);
+	void Report(const char* what, double value, const char* unit);
+
+	// Runs f once at every SIMD level this build and CPU support, with that level active
+	template<typename F>
+	void ForEachSimdLevel(F f)
+	{
+		typedef CS::Help::Math::SimdLevel SimdLevel;
+		auto previous = CS::Help::Math::GetSimdLevel();
+		for (int level = 0; level <= (int)CS::Help::Math::GetSupportedSimdLevel(); level++)
+		{
+			CS::Help::Math::SetSimdLevel((SimdLevel)level);
+			f((SimdLevel)level);
+		}
+		CS::Help::Math::SetSimdLevel(previous);
+	}
+
+	const char* SimdLevelName(CS::Help::Math::SimdLevel level);
+
+	// Repeatable inputs: the same seed gives the same sequence on every platform
+	class Random
+	{
+		std::mt19937 _engine;
+
+	public:
+		explicit Random(uint32_t seed = 1) : _engine(seed) { }
+
+		float Next(float lo, float hi) { return lo + (hi - lo) * (float)((_engine() >> 8) * (1.0 / 16777216.0)); }
+		uint32_t Next(uint32_t bound) { return (uint32_t)(_engine() % bound); }
+		CS::Float3 NextFloat3(float lo, float hi) { return CS::Float3(Next(lo, hi), Next(lo, hi), Next(lo, hi)); }
+	};
+
+	// A box with its lower corner within extent of the origin and sides between a tenth of size and size
+	inline CS::BoundingBoxA RandomBox(Random& random, float extent, float size)
+	{
+		CS::Float3 corner = random.NextFloat3(-extent, extent);
+		CS::Float3 sides = random.NextFloat3(0.1f * size, size);
+		return CS::BoundingBoxA(CS::Float3A(corner), CS::Float3A(corner.X + sides.X, corner.Y + sides.Y, corner.Z + sides.Z));
+	}
+
+	// CHECK_NEAR on the first components of a vector, relative to the largest expected one, or to scale where the
+	// result comes from larger terms that cancel, and absolute below 1
+	void CheckNear(DirectX::FXMVECTOR actual, DirectX::FXMVECTOR expected, double tolerance, double scale = 0, int components = 3);
+	// Every element, relative to the largest expected one and absolute below 1
+	void CheckNear(const DirectX::XMMATRIX& actual, const DirectX::XMMATRIX& expected, double tolerance);
+	// Both corners, relative to the largest expected coordinate and absolute below 1
+	void CheckNear(const CS::BoundingBoxA& actual, const CS::BoundingBoxA& expected, double tolerance);
+}
+
+#define TEST(name) \
+	static void Test_##name(); \
+	static ::SharpishTests::Registrar Register_##name(#name, &Test_##name, false); \
+	static void Test_##name()
+
+#define BENCHMARK(name) \
+	static void Benchmark_##name(); \
+	static ::SharpishTests::Registrar Register_##name(#name, &Benchmark_##name, true); \
+	static void Benchmark_##name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) ::SharpishTests::Fail(__FILE__, __LINE__, #condition); } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+	do { double a_ = (double)(actual), e_ = (double)(expected), t_ = (double)(tolerance); \
+		if (!(std::fabs(a_ - e_) <= t_)) ::SharpishTests::Fail(__FILE__, __LINE__, #actual " == " #expected ": " + ::SharpishTests::Describe(a_, e_, t_)); } while (0)
+
+#define CHECK_THROWS(expression, exceptionType) \
+	do { bool thrown_ = false; try { expression; } catch (const exceptionType&) { thrown_ = true; } \
+		if (!thrown_) ::SharpishTests::Fail(__FILE__, __LINE__, #expression " throws " #exceptionType); } while (0)
@@ -0,0 +1,187 @@
+#include "Test.h"
+#include "MathLanes.h"
+
+// The span functions in Help::Math against double precision, at every SIMD level, within the bounds that
+// MathTranscendental.h documents.
+
+using namespace CS;
+using namespace SharpishTests;
+
+typedef Help::Math::SimdLevel SimdLevel;
+
+namespace
+{
+	const double Ulp = 1.0 / (1 << 23);
+
+	typedef void (*Span)(const float*, float*, size_t);
+
+	// Exponent and Mantissa of 16 values, a register at a time. A macro rather than a template, so each width's
+	// body is compiled inside its target region.
+#define LANE_PARTS(Name, L) \
+	void Name(const float* x, float* e, float* m) \
+	{ \
+		for (int i = 0; i < 16; i += L::Width) \
+		{ \
+			L::StoreUnaligned(e + i, L::Exponent(L::LoadUnaligned(x + i))); \
+			L::StoreUnaligned(m + i, L::Mantissa(L::LoadUnaligned(x + i))); \
+		} \
+	}
+
+	LANE_PARTS(LaneParts4, Details::Lanes4)
+#if defined(SHARPISH_LANES8)
+	SHARPISH_BEGIN_AVX2
+	LANE_PARTS(LaneParts8, Details::Lanes8)
+	SHARPISH_END_AVX2
+#endif
+#if defined(SHARPISH_LANES16)
+	SHARPISH_BEGIN_AVX512
+	LANE_PARTS(LaneParts16, Details::Lanes16)
+	SHARPISH_END_AVX512
+#endif
+
+#undef LANE_PARTS
+
+	// absolute applies where the expected result is below 1 in magnitude, relative above it
+	void CheckSpan(Span f, double (*reference)(double), float lo, float hi, double full, bool relative, uint32_t seed)
+	{
+		const size_t count = 2003;
+		Random random(seed);
+		std::vector<float> x(count), y(count);
+		for (auto& v : x)
+			v = random.Next(lo, hi);
+
+		ForEachSimdLevel([&](SimdLevel)
+		{
+			f(x.data(), y.data(), count);
+			for (size_t i = 0; i < count; i++)
+			{
+				double expected = reference(x[i]);
+				double bound = relative ? full * std::fmax(std::fabs(expected), 1e-30) : full;
+				CHECK_NEAR(y[i], expected, bound);
+			}
+		});
+	}
+}
+
+TEST(Transcendental_FullTier)
+{
+	CheckSpan(&Help::Math::Sin, [](double x) { return std::sin(x); }, -8192, 8192, 1.2e-7, false, 1);
+	CheckSpan(&Help::Math::Cos, [](double x) { return std::cos(x); }, -8192, 8192, 1.2e-7, false, 2);
+	CheckSpan(&Help::Math::ASin, [](double x) { return std::asin(x); }, -1, 1, 4 * Ulp, true, 3);
+	CheckSpan(&Help::Math::ACos, [](double x) { return std::acos(x); }, -1, 1, 4 * Ulp, true, 4);
+	CheckSpan(&Help::Math::ATan, [](double x) { return std::atan(x); }, -100, 100, 5 * Ulp, true, 5);
+	CheckSpan(&Help::Math::Exp, [](double x) { return std::exp(x); }, -87, 88, 2 * Ulp, true, 6);
+	CheckSpan(&Help::Math::Log, [](double x) { return std::log(x); }, 1e-30f, 1e30f, 2 * Ulp, true, 7);
+	CheckSpan(&Help::Math::Log, [](double x) { return std::log(x); }, 0.5f, 2, 2 * Ulp, true, 8);
+}
+
+TEST(Transcendental_EstTier)
+{
+	CheckSpan(&Help::Math::SinEst, [](double x) { return std::sin(x); }, -8192, 8192, 1.4e-5, false, 11);
+	CheckSpan(&Help::Math::CosEst, [](double x) { return std::cos(x); }, -8192, 8192, 1.4e-5, false, 12);
+	CheckSpan(&Help::Math::ASinEst, [](double x) { return std::asin(x); }, -1, 1, 3.8e-6, true, 13);
+	CheckSpan(&Help::Math::ACosEst, [](double x) { return std::acos(x); }, -1, 1, 3.8e-6, true, 14);
+	CheckSpan(&Help::Math::ATanEst, [](double x) { return std::atan(x); }, -100, 100, 3.2e-5, true, 15);
+	CheckSpan(&Help::Math::ExpEst, [](double x) { return std::exp(x); }, -87, 88, 5.5e-6, true, 16);
+	CheckSpan(&Help::Math::LogEst, [](double x) { return std::log(x); }, 1e-30f, 1e30f, 4e-6, true, 17);
+}
+
+TEST(Transcendental_SinCosAndATan2)
+{
+	const size_t count = 1001;
+	Random random(21);
+	std::vector<float> x(count), y(count), s(count), c(count), a(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		x[i] = random.Next(-100.0f, 100.0f);
+		y[i] = random.Next(-100.0f, 100.0f);
+	}
+
+	ForEachSimdLevel([&](SimdLevel)
+	{
+		Help::Math::SinCos(x.data(), s.data(), c.data(), count);
+		Help::Math::ATan2(y.data(), x.data(), a.data(), count);
+		for (size_t i = 0; i < count; i++)
+		{
+			CHECK_NEAR(s[i], std::sin((double)x[i]), 1.2e-7);
+			CHECK_NEAR(c[i], std::cos((double)x[i]), 1.2e-7);
+			double angle = std::atan2((double)y[i], (double)x[i]);
+			CHECK_NEAR(a[i], angle, 5 * Ulp * std::fabs(angle));
+		}
+	});
+}
+
+// Zero, denormals and the special values give the same results at every register width
+TEST(Transcendental_SpecialValuesMatchAcrossLevels)
+{
+	const float values[] = { 0.0f, -0.0f, 1e-40f, 1.4e-45f, FLT_MIN, 1.0f, -1.0f, INFINITY, -INFINITY, 1e-38f, 3e38f };
+	const size_t count = sizeof(values) / sizeof(values[0]);
+	std::vector<float> x;
+	for (int repeat = 0; repeat < 4; repeat++)
+		x.insert(x.end(), values, values + count);
+
+	std::vector<uint32_t> baseLog, baseExp;
+	ForEachSimdLevel([&](SimdLevel level)
+	{
+		std::vector<float> log(x.size()), exp(x.size());
+		Help::Math::Log(x.data(), log.data(), x.size());
+		Help::Math::Exp(x.data(), exp.data(), x.size());
+
+		std::vector<uint32_t> logBits(x.size()), expBits(x.size());
+		memcpy(logBits.data(), log.data(), x.size() * sizeof(float));
+		memcpy(expBits.data(), exp.data(), x.size() * sizeof(float));
+
+		if (level == SimdLevel::Baseline)
+		{
+			baseLog = logBits;
+			baseExp = expBits;
+			CHECK(std::isinf(log[0]) && log[0] < 0);
+			CHECK(std::isnan(log[6]));
+			CHECK(exp[0] == 1);
+			return;
+		}
+
+		CHECK(logBits == baseLog);
+		CHECK(expBits == baseExp);
+	});
+}
+
+// Log and Pow build on these, so every register width must split zero and denormals the same way
+TEST(Transcendental_LaneExponentAndMantissa)
+{
+	const float x[16] = { 0.0f, -0.0f, 1e-40f, 1.4e-45f, FLT_MIN, 1.0f, -1.0f, INFINITY, 1e-38f, 3e38f, 0.75f, -6.5f, 1024.0f, 3.0f, 1e-20f, 2.0f };
+	float e4[16], m4[16], e[16], m[16];
+	LaneParts4(x, e4, m4);
+	CHECK(e4[0] == -127 && m4[0] == 1);
+	CHECK(e4[12] == 10 && m4[12] == 1);
+
+	auto supported = Help::Math::GetSupportedSimdLevel();
+	(void)supported;
+	(void)e;
+	(void)m;
+#if defined(SHARPISH_LANES8)
+	if (supported >= SimdLevel::AVX2)
+	{
+		LaneParts8(x, e, m);
+		CHECK(!memcmp(e, e4, sizeof(e)) && !memcmp(m, m4, sizeof(m)));
+	}
+#endif
+#if defined(SHARPISH_LANES16)
+	if (supported >= SimdLevel::AVX512)
+	{
+		LaneParts16(x, e, m);
+		CHECK(!memcmp(e, e4, sizeof(e)) && !memcmp(m, m4, sizeof(m)));
+	}
+#endif
+}
+
+// The vector types keep DirectXMath's functions
+TEST(Transcendental_VectorMethodsUseDirectXMath)
+{
+	Float4A v(0.3f, -1.2f, 2.5f, 0.9f);
+	CHECK(v.Sin() == Float4A(XMVectorSin(v)));
+	CHECK(v.Cos() == Float4A(XMVectorCos(v)));
+	CHECK(v.ATan() == Float4A(XMVectorATan(v)));
+	CHECK(v.Exp() == Float4A(XMVectorExpE(v)));
+	CHECK(v.Abs().Ln() == Float4A(XMVectorLogE(XMVectorAbs(v))));
+}
@@ -0,0 +1,152 @@
+#include "Test.h"
+#include <algorithm>
+#include <map>
+
+// TransformHierarchy against world transforms composed directly from a copy of the tree, through edits, reparenting
+// and removals.
+
+using namespace CS;
+using namespace SharpishTests;
+
+namespace
+{
+	typedef TransformHierarchy::NodeId NodeId;
+
+	struct Model
+	{
+		std::map<NodeId, NodeId> Parents;
+		std::map<NodeId, Float4x3A> Locals;
+
+		XMMATRIX World(NodeId node) const
+		{
+			XMMATRIX world = Locals.at(node);
+			for (NodeId p = Parents.at(node); p != TransformHierarchy::None; p = Parents.at(p))
+				world = XMMatrixMultiply(world, Locals.at(p));
+			return world;
+		}
+
+		bool IsUnder(NodeId node, NodeId ancestor) const
+		{
+			for (; node != TransformHierarchy::None; node = Parents.at(node))
+				if (node == ancestor)
+					return true;
+			return false;
+		}
+
+		// node and everything under it
+		std::vector<NodeId> Subtree(NodeId node) const
+		{
+			std::vector<NodeId> nodes;
+			for (auto& entry : Parents)
+				if (IsUnder(entry.first, node))
+					nodes.push_back(entry.first);
+			return nodes;
+		}
+	};
+
+	Float4x3A RandomLocal(Random& random)
+	{
+		return XMMatrixAffineTransformation(XMVectorReplicate(random.Next(0.8f, 1.25f)), XMVectorZero(),
+			XMQuaternionRotationRollPitchYaw(random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f)),
+			XMVectorSet(random.Next(-2.0f, 2.0f), random.Next(-2.0f, 2.0f), random.Next(-2.0f, 2.0f), 0));
+	}
+
+	void CheckWorlds(TransformHierarchy& hierarchy, const Model& model)
+	{
+		CHECK(hierarchy.GetCount() == model.Parents.size());
+		for (auto& entry : model.Parents)
+		{
+			NodeId node = entry.first;
+			CHECK(hierarchy.GetParent(node) == entry.second);
+
+			CheckNear(hierarchy.GetWorld(node), model.World(node), 1e-3);
+
+			CHECK(hierarchy.GetWorldTransforms()[hierarchy.GetIndex(node)] == hierarchy.GetWorld(node));
+		}
+	}
+}
+
+TEST(TransformHierarchy_MatchesComposedWorlds)
+{
+	Random random(101);
+	TransformHierarchy hierarchy;
+	Model model;
+	std::vector<NodeId> nodes;
+
+	auto add = [&](NodeId parent)
+	{
+		auto local = RandomLocal(random);
+		NodeId node = hierarchy.AddNode(parent, local);
+		model.Parents[node] = parent;
+		model.Locals[node] = local;
+		nodes.push_back(node);
+	};
+
+	// A few roots, then children under random earlier nodes, so most additions are out of depth-first order
+	for (int i = 0; i < 4; i++)
+		add(TransformHierarchy::None);
+	for (int i = 0; i < 400; i++)
+		add(nodes[random.Next((uint32_t)nodes.size())]);
+
+	hierarchy.Update();
+	CheckWorlds(hierarchy, model);
+
+	for (int round = 0; round < 30; round++)
+	{
+		for (int i = 0; i < 10; i++)
+		{
+			NodeId node = nodes[random.Next((uint32_t)nodes.size())];
+			auto local = RandomLocal(random);
+			hierarchy.SetLocal(node, local);
+			model.Locals[node] = local;
+		}
+
+		NodeId moved = nodes[random.Next((uint32_t)nodes.size())];
+		NodeId parent = random.Next(5) == 0 ? TransformHierarchy::None : nodes[random.Next((uint32_t)nodes.size())];
+		if (parent != TransformHierarchy::None && model.IsUnder(parent, moved))
+		{
+			CHECK_THROWS(hierarchy.SetParent(moved, parent), ArgumentException);
+		}
+		else
+		{
+			hierarchy.SetParent(moved, parent);
+			model.Parents[moved] = parent;
+		}
+
+		if (round % 5 == 4)
+		{
+			NodeId removed = nodes[random.Next((uint32_t)nodes.size())];
+			for (NodeId node : model.Subtree(removed))
+			{
+				model.Parents.erase(node);
+				model.Locals.erase(node);
+				nodes.erase(std::find(nodes.begin(), nodes.end(), node));
+			}
+			hierarchy.RemoveNode(removed);
+			CHECK(!hierarchy.Contains(removed));
+			add(nodes.empty() ? TransformHierarchy::None : nodes[random.Next((uint32_t)nodes.size())]);
+		}
+
+		hierarchy.Update();
+		CheckWorlds(hierarchy, model);
+	}
+}
+
+TEST(TransformHierarchy_UpdatesOnlyDirtySubtrees)
+{
+	TransformHierarchy hierarchy;
+	auto root = hierarchy.AddNode(TransformHierarchy::None, Float4x3A::Identity);
+	auto a = hierarchy.AddNode(root, Float4x3A::Identity);
+	auto b = hierarchy.AddNode(a, Float4x3A::Identity);
+	hierarchy.AddNode(root, Float4x3A::Identity);
+
+	CHECK(hierarchy.Update() == 4);
+	CHECK(hierarchy.Update() == 0);
+
+	hierarchy.SetLocal(a, XMMatrixTranslation(1, 2, 3));
+	CHECK(hierarchy.Update() == 2);
+	CHECK(Float3A(hierarchy.GetWorld(b).GetRow(3)) == Float3A(1, 2, 3));
+
+	CHECK_THROWS(hierarchy.SetParent(root, b), ArgumentException);
+	CHECK_THROWS(hierarchy.GetWorld(TransformHierarchy::None), ArgumentException);
+}